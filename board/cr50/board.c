@@ -25,6 +25,9 @@
 #include "gpio_list.h"
 
 #ifdef CONFIG_USB_HID
+static void send_hid_event(void);
+DECLARE_DEFERRED(send_hid_event);
+
 static void send_hid_event(void)
 {
 #if !defined(CHIP_VARIANT_CR50_A1)
@@ -42,10 +45,9 @@ static void send_hid_event(void)
 	/* send the keyboard state over USB HID */
 	set_keyboard_report(rpt);
 	/* check release in the future */
-	hook_call_deferred(send_hid_event, 40);
+	hook_call_deferred(&send_hid_event_data, 40);
 #endif
 }
-DECLARE_DEFERRED(send_hid_event);
 #endif
 
 /* Interrupt handler for button pushes */
@@ -74,7 +74,7 @@ void hpd_event(enum gpio_signal signal)
 	hpd_prev_ts = now.val;
 
 	/* All previous hpd level events need to be re-triggered */
-	hook_call_deferred(hpd_lvl_deferred, -1);
+	hook_call_deferred(&hpd_lvl_deferred_data, -1);
 
 	/* It's a glitch.  Previous time moves but level is the same. */
 	if (cur_delta < HPD_USTREAM_DEBOUNCE_IRQ)
@@ -83,9 +83,10 @@ void hpd_event(enum gpio_signal signal)
 	if ((!hpd_prev_level && level) &&
 	    (cur_delta < HPD_USTREAM_DEBOUNCE_LVL))
 		/* It's an irq */
-		hook_call_deferred(hpd_irq_deferred, 0);
+		hook_call_deferred(&hpd_irq_deferred_data, 0);
 	else if (cur_delta >= HPD_USTREAM_DEBOUNCE_LVL)
-		hook_call_deferred(hpd_lvl_deferred, HPD_USTREAM_DEBOUNCE_LVL);
+		hook_call_deferred(&hpd_lvl_deferred_data,
+				   HPD_USTREAM_DEBOUNCE_LVL);
 
 	hpd_prev_level = level;
 }
@@ -70,7 +70,7 @@ void vbus0_evt(enum gpio_signal signal)
 
 	CPRINTF("VBUS C0, %d\n", vbus_level);
 	update_vbus_supplier(0, vbus_level);
-	task_wake(TASK_ID_PD_C0);
+	pd_task_set_event(0, TASK_EVENT_WAKE);
 }
 
 void vbus1_evt(enum gpio_signal signal)
@@ -80,7 +80,7 @@ void vbus1_evt(enum gpio_signal signal)
 
 	CPRINTF("VBUS C1, %d\n", vbus_level);
 	update_vbus_supplier(0, vbus_level);
-	task_wake(TASK_ID_PD_C1);
+	pd_task_set_event(1, TASK_EVENT_WAKE);
 }
 
 void usb0_evt(enum gpio_signal signal)
@@ -73,8 +73,8 @@ void pd_power_supply_reset(int port)
 	/* Not implemented */
 }
 
-void pd_set_input_current_limit(int port, uint32_t max_ma,
-				uint32_t supply_voltage)
+test_mockable void pd_set_input_current_limit(int port, uint32_t max_ma,
+					      uint32_t supply_voltage)
 {
 	/* Not implemented */
 }
@@ -102,7 +102,7 @@ int pd_check_data_swap(int port, int data_role)
 	return 1;
 }
 
-void pd_execute_data_swap(int port, int data_role)
+test_mockable void pd_execute_data_swap(int port, int data_role)
 {
 	/* Do nothing */
 }
@@ -115,7 +115,8 @@ void pd_check_dr_role(int port, int dr_role, int flags)
 {
 }
 
-int pd_custom_vdm(int port, int cnt, uint32_t *payload, uint32_t **rpayload)
+test_mockable int pd_custom_vdm(int port, int cnt, uint32_t *payload,
+				 uint32_t **rpayload)
 {
 	return 0;
 }
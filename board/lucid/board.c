@@ -17,6 +17,7 @@
 #include "registers.h"
 #include "task.h"
 #include "usb_charge.h"
+#include "usb_pd.h"
 #include "util.h"
 
 #define CPRINTS(format, args...) cprints(CC_USBCHARGE, format, ## args)
@@ -58,7 +59,7 @@ void vbus_evt(enum gpio_signal signal)
 	update_vbus_supplier(gpio_get_level(signal));
 
 	if (task_start_called())
-		task_wake(TASK_ID_PD);
+		pd_task_set_event(0, TASK_EVENT_WAKE);
 
 	/* trigger AC present interrupt */
 	extpower_interrupt(signal);
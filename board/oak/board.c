@@ -57,7 +57,7 @@ DECLARE_DEFERRED(ap_reset_deferred);
 void ap_reset_interrupt(enum gpio_signal signal)
 {
 	if (gpio_get_level(GPIO_AP_RESET_L) == 0)
-		hook_call_deferred(ap_reset_deferred, 0);
+		hook_call_deferred(&ap_reset_deferred_data, 0);
 }
 
 void vbus_wake_interrupt(enum gpio_signal signal)
@@ -73,8 +73,8 @@ void vbus_wake_interrupt(enum gpio_signal signal)
 	 *   hardware fix will be in rev3.
 	 *   enable TCPC POWER_STATUS ALERT1 can solve this issue too.
 	 */
-	task_wake(TASK_ID_PD_C0);
-	task_wake(TASK_ID_PD_C1);
+	pd_task_set_event(0, TASK_EVENT_WAKE);
+	pd_task_set_event(1, TASK_EVENT_WAKE);
 }
 
 void pd_mcu_interrupt(enum gpio_signal signal)
@@ -373,7 +373,7 @@ void board_typec_dp_on(int port)
 			gpio_set_level(GPIO_USB_DP_HPD, 1);
 		} else {
 			gpio_set_level(GPIO_USB_DP_HPD, 0);
-			hook_call_deferred(hpd_irq_deferred,
+			hook_call_deferred(&hpd_irq_deferred_data,
 					HPD_DSTREAM_DEBOUNCE_IRQ);
 		}
 	}
@@ -34,12 +34,12 @@ void pd_send_ec_int(void)
 
 void vbus0_evt(enum gpio_signal signal)
 {
-	task_wake(TASK_ID_PD_C0);
+	task_wake(TCPC_PORT_TO_TASK_ID(0));
 }
 
 void vbus1_evt(enum gpio_signal signal)
 {
-	task_wake(TASK_ID_PD_C1);
+	task_wake(TCPC_PORT_TO_TASK_ID(1));
 }
 
 void board_config_pre_init(void)
@@ -91,7 +91,7 @@ void hpd_event(enum gpio_signal signal)
 	hpd_prev_ts = now.val;
 
 	/* All previous hpd level events need to be re-triggered */
-	hook_call_deferred(hpd_lvl_deferred, HPD_USTREAM_DEBOUNCE_LVL);
+	hook_call_deferred(&hpd_lvl_deferred_data, HPD_USTREAM_DEBOUNCE_LVL);
 }
 
 /* Debounce time for voltage buttons */
@@ -186,9 +186,10 @@ static void set_usbc_action(enum usbc_action act)
 /* has Pull-up */
 static int prev_dbg20v = 1;
 static void button_dbg20v_deferred(void);
+DECLARE_DEFERRED(button_dbg20v_deferred);
 static void enable_dbg20v_poll(void)
 {
-	hook_call_deferred(button_dbg20v_deferred, 10 * MSEC);
+	hook_call_deferred(&button_dbg20v_deferred_data, 10 * MSEC);
 }
 
 /* Handle debounced button press */
@@ -239,7 +240,7 @@ void button_event(enum gpio_signal signal)
 {
 	button_pressed = signal;
 	/* reset debounce time */
-	hook_call_deferred(button_deferred, BUTTON_DEBOUNCE_US);
+	hook_call_deferred(&button_deferred_data, BUTTON_DEBOUNCE_US);
 }
 
 static void button_dbg20v_deferred(void)
@@ -249,12 +250,11 @@ static void button_dbg20v_deferred(void)
 	else
 		enable_dbg20v_poll();
 }
-DECLARE_DEFERRED(button_dbg20v_deferred);
 
 void vbus_event(enum gpio_signal signal)
 {
 	ccprintf("VBUS! =%d\n", gpio_get_level(signal));
-	task_wake(TASK_ID_PD);
+	pd_task_set_event(0, TASK_EVENT_WAKE);
 }
 
 /* ADC channels */
@@ -466,7 +466,8 @@ DECLARE_DEFERRED(board_usb_hub_reset_no_return);
 static void board_init_usb_hub(void)
 {
 	if (system_get_reset_flags() & RESET_FLAG_POWER_ON)
-		hook_call_deferred(board_usb_hub_reset_no_return, 500 * MSEC);
+		hook_call_deferred(&board_usb_hub_reset_no_return_data,
+				   500 * MSEC);
 }
 DECLARE_HOOK(HOOK_INIT, board_init_usb_hub, HOOK_PRIO_DEFAULT);
 
@@ -552,7 +553,7 @@ static void fake_disconnect_start(void)
 
 	fake_pd_disconnected = 1;
 
-	hook_call_deferred(fake_disconnect_end,
+	hook_call_deferred(&fake_disconnect_end_data,
 			   fake_pd_disconnect_duration_ms * MSEC);
 }
 DECLARE_DEFERRED(fake_disconnect_start);
@@ -573,11 +574,11 @@ static int cmd_fake_disconnect(int argc, char *argv[])
 		return EC_ERROR_PARAM2;
 
 	/* Cancel any pending function calls */
-	hook_call_deferred(fake_disconnect_start, -1);
-	hook_call_deferred(fake_disconnect_end, -1);
+	hook_call_deferred(&fake_disconnect_start_data, -1);
+	hook_call_deferred(&fake_disconnect_end_data, -1);
 
 	fake_pd_disconnect_duration_ms = duration_ms;
-	hook_call_deferred(fake_disconnect_start, delay_ms * MSEC);
+	hook_call_deferred(&fake_disconnect_start_data, delay_ms * MSEC);
 
 	ccprintf("Fake disconnect for %d ms starting in %d ms.\n",
 		 duration_ms, delay_ms);
@@ -600,7 +601,7 @@ static int cmd_trigger_dfu(int argc, char *argv[])
 	ccprintf("Asserting CASE_CLOSE_DFU_L.\n");
 	ccprintf("If you expect to see DFU debug but it doesn't show up,\n");
 	ccprintf("try flipping the USB type-C cable.\n");
-	hook_call_deferred(trigger_dfu_release, 1500 * MSEC);
+	hook_call_deferred(&trigger_dfu_release_data, 1500 * MSEC);
 	return EC_SUCCESS;
 }
 DECLARE_CONSOLE_COMMAND(dfu, cmd_trigger_dfu, NULL, NULL, NULL);
@@ -83,9 +83,9 @@ void vbus_evt(enum gpio_signal signal)
 		charge_manager_update_charge(CHARGE_SUPPLIER_VBUS, 0, &charge);
 	}
 
-	hook_call_deferred(vbus_log, 0);
+	hook_call_deferred(&vbus_log_data, 0);
 	if (task_start_called())
-		task_wake(TASK_ID_PD);
+		pd_task_set_event(0, TASK_EVENT_WAKE);
 }
 
 void usb_evt(enum gpio_signal signal)
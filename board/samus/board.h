@@ -64,6 +64,7 @@
 #define CONFIG_HOSTCMD_PD
 #define CONFIG_HOSTCMD_PD_CHG_CTRL
 #define CONFIG_HOSTCMD_PD_PANIC
+#define CONFIG_I2C_STATS
 #define CONFIG_PECI_TJMAX 105
 #define CONFIG_PWM
 #define CONFIG_PWM_KBLIGHT
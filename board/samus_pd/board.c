@@ -128,9 +128,9 @@ void vbus0_evt(enum gpio_signal signal)
 	 * registers in default state. TODO(crosbug.com/p/33823): Fix
 	 * these unwanted resets.
 	 */
-	hook_call_deferred(pericom_port0_reenable_interrupts, 0);
+	hook_call_deferred(&pericom_port0_reenable_interrupts_data, 0);
 	if (task_start_called())
-		task_wake(TASK_ID_PD_C0);
+		pd_task_set_event(0, TASK_EVENT_WAKE);
 }
 
 void vbus1_evt(enum gpio_signal signal)
@@ -154,9 +154,9 @@ void vbus1_evt(enum gpio_signal signal)
 	 * registers in default state. TODO(crosbug.com/p/33823): Fix
 	 * these unwanted resets.
 	 */
-	hook_call_deferred(pericom_port1_reenable_interrupts, 0);
+	hook_call_deferred(&pericom_port1_reenable_interrupts_data, 0);
 	if (task_start_called())
-		task_wake(TASK_ID_PD_C1);
+		pd_task_set_event(1, TASK_EVENT_WAKE);
 }
 
 static void wake_usb_charger_task(int port)
@@ -232,7 +232,7 @@ DECLARE_DEFERRED(pch_evt_deferred);
 
 void pch_evt(enum gpio_signal signal)
 {
-	hook_call_deferred(pch_evt_deferred, 0);
+	hook_call_deferred(&pch_evt_deferred_data, 0);
 }
 
 void board_config_pre_init(void)
@@ -58,6 +58,7 @@
 #define CONFIG_USB_PD_LOGGING
 #define CONFIG_USB_PD_LOG_SIZE 512
 #define CONFIG_USB_PD_PORT_COUNT 2
+#define CONFIG_USB_PD_RX_TABLE
 #define CONFIG_USB_PD_TCPC
 #define CONFIG_USB_PD_TCPM_STUB
 #define CONFIG_USB_SWITCH_PI3USB9281
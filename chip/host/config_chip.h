@@ -24,8 +24,11 @@ extern char __host_flash[CONFIG_FLASH_PHYSICAL_SIZE];
 
 #include "config_std_internal_flash.h"
 
+/* Number of emulated I2C ports */
+#define I2C_PORT_COUNT 2
+
 /* Maximum number of deferrable functions */
-#define DEFERRABLE_MAX_COUNT 8
+#define DEFERRABLE_MAX_COUNT 16
 
 /* Interval between HOOK_TICK notifications */
 #define HOOK_TICK_INTERVAL_MS 250
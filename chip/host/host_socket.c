@@ -0,0 +1,178 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/*
+ * Host command interface for the emulator.
+ *
+ * If EC_HOSTCMD_SOCKET is set in the environment, the emulator listens on a
+ * Unix socket at that path.  Each message on the socket is one protocol
+ * version 3 request packet, and is answered with one response packet, so
+ * host tools built with util/comm-socket.c can talk to the emulated EC.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "console.h"
+#include "hooks.h"
+#include "host_command.h"
+#include "task.h"
+#include "test_util.h"
+
+#define CPRINTS(format, args...) cprints(CC_HOSTCMD, format, ## args)
+
+/* Environment variable with the path of the socket to serve */
+#define HOST_SOCKET_ENV "EC_HOSTCMD_SOCKET"
+
+/* Max size of a request or response packet */
+#define HOST_SOCKET_PACKET_SIZE 512
+
+static uint8_t in_msg[HOST_SOCKET_PACKET_SIZE] __aligned(4);
+static uint8_t out_msg[HOST_SOCKET_PACKET_SIZE] __aligned(4);
+
+static struct host_packet socket_packet;
+static volatile int packet_taken;
+static sem_t response_sem;
+static pthread_t socket_thread;
+
+static void socket_send_response(struct host_packet *pkt)
+{
+	/* Wake the socket thread, which sends the response */
+	sem_post(&response_sem);
+}
+
+static void socket_interrupt(void)
+{
+	packet_taken = 1;
+	host_packet_receive(&socket_packet);
+}
+
+/**
+ * Pass a request to the host command task and send back its response.
+ *
+ * @param fd		Connected socket
+ * @param size		Size of request in in_msg, in bytes
+ */
+static void socket_process_packet(int fd, int size)
+{
+	const struct timespec retry = {0, 1000000};
+
+	/* An oversized request is rejected as truncated */
+	if (size > sizeof(in_msg))
+		size = sizeof(in_msg) + 1;
+
+	socket_packet.send_response = socket_send_response;
+	socket_packet.request = in_msg;
+	socket_packet.request_temp = NULL;
+	socket_packet.request_max = sizeof(in_msg);
+	socket_packet.request_size = size;
+	socket_packet.response = out_msg;
+	socket_packet.response_max = sizeof(out_msg);
+	socket_packet.response_size = 0;
+	socket_packet.driver_result = EC_RES_SUCCESS;
+
+	/*
+	 * Hand the packet over from interrupt context, as a real bus would.
+	 * The emulated interrupt is dropped while interrupts are disabled,
+	 * so retry until it has been taken.
+	 */
+	packet_taken = 0;
+	while (1) {
+		task_trigger_test_interrupt(socket_interrupt);
+		if (packet_taken)
+			break;
+		nanosleep(&retry, NULL);
+	}
+
+	sem_wait(&response_sem);
+	send(fd, out_msg, socket_packet.response_size, MSG_NOSIGNAL);
+}
+
+static void *socket_server(void *arg)
+{
+	const char *path = arg;
+	struct sockaddr_un addr;
+	int listen_fd, fd, rv;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		CPRINTS("hostcmd socket path too long");
+		return NULL;
+	}
+	strcpy(addr.sun_path, path);
+
+	/* Not inherited across the exec on emulator reboot */
+	listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0)
+		return NULL;
+
+	/* Remove a socket left behind by a previous run */
+	unlink(path);
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listen_fd, 1) < 0) {
+		CPRINTS("hostcmd socket %s unavailable", path);
+		close(listen_fd);
+		return NULL;
+	}
+	CPRINTS("hostcmd socket %s", path);
+
+	/* Serve one host at a time */
+	while (1) {
+		fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0)
+			continue;
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		/* MSG_TRUNC returns the full size of an oversized request */
+		while ((rv = recv(fd, in_msg, sizeof(in_msg), MSG_TRUNC)) > 0)
+			socket_process_packet(fd, rv);
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static void socket_init(void)
+{
+	const char *path = getenv(HOST_SOCKET_ENV);
+
+	if (!path || !*path)
+		return;
+
+	sem_init(&response_sem, 0, 0);
+	pthread_create(&socket_thread, NULL, socket_server, (void *)path);
+}
+DECLARE_HOOK(HOOK_INIT, socket_init, HOOK_PRIO_DEFAULT);
+
+/**
+ * Get protocol information
+ */
+static int socket_get_protocol_info(struct host_cmd_handler_args *args)
+{
+	struct ec_response_get_protocol_info *r = args->response;
+
+	memset(r, 0, sizeof(*r));
+	r->protocol_versions = (1 << 3);
+	r->max_request_packet_size = HOST_SOCKET_PACKET_SIZE;
+	r->max_response_packet_size = HOST_SOCKET_PACKET_SIZE;
+	r->flags = 0;
+
+	args->response_size = sizeof(*r);
+
+	return EC_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_GET_PROTOCOL_INFO,
+		     socket_get_protocol_info,
+		     EC_VER_MASK(0));
@@ -8,6 +8,7 @@
 #include "hooks.h"
 #include "i2c.h"
 #include "link_defs.h"
+#include "task.h"
 #include "test_util.h"
 
 #define MAX_DETACHED_DEV_COUNT 3
@@ -20,6 +21,8 @@ struct i2c_dev {
 
 static struct i2c_dev detached_devs[MAX_DETACHED_DEV_COUNT];
 
+static struct mutex port_mutex[I2C_PORT_COUNT];
+
 static void detach_init(void)
 {
 	int i;
@@ -181,6 +184,65 @@ int i2c_read_string(int port, int slave_addr, int offset, uint8_t *data,
 	return EC_ERROR_UNKNOWN;
 }
 
+void i2c_lock(int port, int lock)
+{
+	if (lock)
+		mutex_lock(port_mutex + port);
+	else
+		mutex_unlock(port_mutex + port);
+}
+
+int i2c_xfer_ops(int port, int slave_addr, struct i2c_op *ops, int count)
+{
+	int rv;
+
+	for (; count > 0; count--, ops++) {
+		switch (ops->type) {
+		case I2C_OP_READ8:
+			rv = i2c_read8(port, slave_addr, ops->offset,
+				       &ops->data);
+			break;
+		case I2C_OP_READ16:
+			rv = i2c_read16(port, slave_addr, ops->offset,
+					&ops->data);
+			break;
+		case I2C_OP_READ32:
+			rv = i2c_read32(port, slave_addr, ops->offset,
+					&ops->data);
+			break;
+		case I2C_OP_WRITE8:
+			rv = i2c_write8(port, slave_addr, ops->offset,
+					ops->data);
+			break;
+		case I2C_OP_WRITE16:
+			rv = i2c_write16(port, slave_addr, ops->offset,
+					 ops->data);
+			break;
+		case I2C_OP_WRITE32:
+			rv = i2c_write32(port, slave_addr, ops->offset,
+					 ops->data);
+			break;
+		default:
+			rv = EC_ERROR_INVAL;
+		}
+		if (rv)
+			return rv;
+	}
+
+	return EC_SUCCESS;
+}
+
+int i2c_batch(int port, int slave_addr, struct i2c_op *ops, int count)
+{
+	int rv;
+
+	i2c_lock(port, 1);
+	rv = i2c_xfer_ops(port, slave_addr, ops, count);
+	i2c_lock(port, 0);
+
+	return rv;
+}
+
 int smbus_write_word(uint8_t i2c_port, uint8_t slave_addr,
 			uint8_t smbus_cmd, uint16_t d16)
 {
@@ -5,20 +5,38 @@
 
 /* Persistence module for emulator */
 
-#include <unistd.h>
+#include <libgen.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define BUF_SIZE 1024
 
+/*
+ * If set, persistent storage is kept in this directory instead of next to
+ * the executable, so that several instances of the same test can run at
+ * once.  The variable is inherited across emulator reboots.
+ */
+#define PERSIST_DIR_ENV "EC_PERSIST_DIR"
+
 static void get_storage_path(char *out)
 {
 	char buf[BUF_SIZE];
+	const char *dir = getenv(PERSIST_DIR_ENV);
 	int sz;
 
-	sz = readlink("/proc/self/exe", buf, BUF_SIZE);
+	sz = readlink("/proc/self/exe", buf, BUF_SIZE - 1);
+	if (sz < 0)
+		sz = 0;
 	buf[sz] = '\0';
-	if (snprintf(out, BUF_SIZE, "%s_persist", buf) >= BUF_SIZE)
+
+	if (dir && *dir)
+		sz = snprintf(out, BUF_SIZE, "%s/%s_persist", dir,
+			      basename(buf));
+	else
+		sz = snprintf(out, BUF_SIZE, "%s_persist", buf);
+	if (sz >= BUF_SIZE)
 		out[BUF_SIZE - 1] = '\0';
 }
 
@@ -7,8 +7,10 @@
 #include "console.h"
 #include "crc.h"
 #include "task.h"
+#include "timer.h"
 #include "usb_pd.h"
 #include "usb_pd_config.h"
+#include "usb_pd_test_util.h"
 #include "util.h"
 
 #define PREAMBLE_OFFSET 60 /* Any number should do */
@@ -21,12 +23,16 @@
  */
 #define PD_BIT_LEN 429
 
+/* Messages on the loopback link waiting for the receiver to read them */
+#define RX_QUEUE_DEPTH 4
+
 static struct pd_physical {
 	int hw_init_done;
 
 	uint8_t bits[PD_BIT_LEN];
 	int total;
 	int has_preamble;
+	int has_hard_reset;
 	int rx_started;
 	int rx_monitoring;
 
@@ -35,14 +41,32 @@ static struct pd_physical {
 	int last_edge_written;
 	uint8_t out_msg[PD_BIT_LEN / 5];
 	int verified_idx;
+
+	/* Loopback link: messages not read yet, symbol count of each */
+	uint8_t rx_queue[RX_QUEUE_DEPTH][PD_BIT_LEN / 5];
+	int rx_queue_len[RX_QUEUE_DEPTH];
+	int rx_queue_head;
+	int rx_queue_count;
+	/* Time the last message was read, header of the last one sent */
+	timestamp_t rx_time;
+	int last_tx_head;
+	struct pd_loopback_stats stats;
 } pd_phy[CONFIG_USB_PD_PORT_COUNT];
 
+/* Port 0 and port 1 are wired to each other */
+static int loopback;
+
 static const uint16_t enc4b5b[] = {
 	0x1E, 0x09, 0x14, 0x15, 0x0A, 0x0B, 0x0E, 0x0F, 0x12, 0x13, 0x16,
 	0x17, 0x1A, 0x1B, 0x1C, 0x1D};
 
 /* Test utilities */
 
+void pd_test_rx_msg_reset(int port)
+{
+	pd_phy[port].total = 0;
+}
+
 void pd_test_rx_set_preamble(int port, int has_preamble)
 {
 	pd_phy[port].has_preamble = has_preamble;
@@ -101,6 +125,24 @@ void pd_test_rx_msg_append_word(int port, uint32_t val)
 	pd_test_rx_msg_append_short(port, val >> 16);
 }
 
+void pd_test_loopback(int enable)
+{
+	loopback = enable;
+}
+
+void pd_test_loopback_stats(int port, struct pd_loopback_stats *stats)
+{
+	*stats = pd_phy[port].stats;
+}
+
+void pd_test_loopback_clear_stats(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_USB_PD_PORT_COUNT; i++)
+		memset(&pd_phy[i].stats, 0, sizeof(pd_phy[i].stats));
+}
+
 void pd_simulate_rx(int port)
 {
 	if (!pd_phy[port].rx_monitoring)
@@ -184,6 +226,13 @@ int pd_dequeue_bits(int port, int off, int len, uint32_t *val)
 
 int pd_find_preamble(int port)
 {
+	/* Like the real receiver, wait a while for a message to arrive */
+	if (loopback && !pd_phy[port].has_preamble &&
+	    !pd_phy[port].has_hard_reset)
+		task_wait_event_mask(PD_EVENT_RX, USB_PD_RX_TMOUT_US);
+
+	if (pd_phy[port].has_hard_reset)
+		return PD_RX_ERR_HARD_RESET;
 	return pd_phy[port].has_preamble ? PREAMBLE_OFFSET : -1;
 }
 
@@ -235,6 +284,103 @@ void pd_tx_clear_circular_mode(int port)
 	/* Not implemented */
 }
 
+/* Decode a 4b/5b data symbol */
+static int decode_4b5b(uint8_t sym)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(enc4b5b); i++)
+		if (enc4b5b[i] == sym)
+			return i;
+	return 0;
+}
+
+/* Header of the message in out_msg, or -1 for a hard reset */
+static int tx_msg_header(int port)
+{
+	const uint8_t *sym = pd_phy[port].out_msg;
+
+	if (sym[0] == PD_RST1)
+		return -1;
+	/* Header follows the four SOP symbols, least significant first */
+	return decode_4b5b(sym[4]) | (decode_4b5b(sym[5]) << 4) |
+		(decode_4b5b(sym[6]) << 8) | (decode_4b5b(sym[7]) << 12);
+}
+
+/*
+ * Hand the oldest queued message to the receiver, if it is watching the line
+ * or has started a read, and is done with the previous message.
+ */
+static void loopback_rx_next(int port)
+{
+	struct pd_physical *rx = pd_phy + port;
+	const uint8_t *sym;
+	int i;
+
+	if (!rx->rx_queue_count || rx->has_preamble || rx->has_hard_reset ||
+	    !(rx->rx_monitoring || rx->rx_started))
+		return;
+
+	sym = rx->rx_queue[rx->rx_queue_head];
+	rx->total = 0;
+	if (sym[0] == PD_RST1) {
+		rx->has_hard_reset = 1;
+	} else {
+		for (i = 0; i < rx->rx_queue_len[rx->rx_queue_head]; i++)
+			pd_test_rx_msg_append_bits(port, sym[i], 5);
+		pd_test_rx_msg_append_last_edge(port);
+		rx->has_preamble = 1;
+	}
+	rx->rx_queue_head = (rx->rx_queue_head + 1) % RX_QUEUE_DEPTH;
+	rx->rx_queue_count--;
+	rx->rx_time = get_time();
+
+	if (rx->rx_monitoring)
+		pd_simulate_rx(port);
+	else
+		/* Wake the read waiting in pd_find_preamble() */
+		task_set_event(TCPC_PORT_TO_TASK_ID(port), PD_EVENT_RX, 0);
+}
+
+/* Send the message in out_msg to the other port */
+static void loopback_tx(int port, int bit_len)
+{
+	struct pd_physical *tx = pd_phy + port;
+	struct pd_physical *rx = pd_phy + (port ^ 1);
+	int head = tx_msg_header(port);
+	int i;
+
+	tx->stats.msgs++;
+	if (head < 0) {
+		tx->last_tx_head = -1;
+	} else if (PD_HEADER_TYPE(head) == PD_CTRL_GOOD_CRC &&
+		   !PD_HEADER_CNT(head)) {
+		i = get_time().val - tx->rx_time.val;
+		if (i > tx->stats.goodcrc_max_us)
+			tx->stats.goodcrc_max_us = i;
+	} else {
+		/* The same header again means the message is resent */
+		if (head == tx->last_tx_head)
+			tx->stats.retries++;
+		tx->last_tx_head = head;
+	}
+
+	/*
+	 * A real receiver reads a message well within the gap before the
+	 * next one, but here it may not have run yet; queue a few.
+	 */
+	if (!rx->hw_init_done || rx->rx_queue_count == RX_QUEUE_DEPTH) {
+		tx->stats.dropped++;
+		return;
+	}
+	i = (rx->rx_queue_head + rx->rx_queue_count) % RX_QUEUE_DEPTH;
+	memcpy(rx->rx_queue[i], tx->out_msg, bit_len);
+	rx->rx_queue_len[i] = bit_len;
+	rx->rx_queue_count++;
+
+	loopback_rx_next(port ^ 1);
+}
+
 int pd_start_tx(int port, int polarity, int bit_len)
 {
 	ASSERT(pd_phy[port].hw_init_done);
@@ -242,6 +388,11 @@ int pd_start_tx(int port, int polarity, int bit_len)
 	pd_phy[port].preamble_written = 0;
 	pd_phy[port].verified_idx = 0;
 
+	if (loopback) {
+		loopback_tx(port, bit_len);
+		return bit_len;
+	}
+
 	/*
 	 * Hand over to test runner. The test runner must wake us after
 	 * processing the packet.
@@ -261,12 +412,21 @@ void pd_rx_start(int port)
 {
 	ASSERT(pd_phy[port].hw_init_done);
 	pd_phy[port].rx_started = 1;
+	if (loopback)
+		loopback_rx_next(port);
 }
 
 void pd_rx_complete(int port)
 {
 	ASSERT(pd_phy[port].hw_init_done);
 	pd_phy[port].rx_started = 0;
+
+	/* The message has been read; the line is free for the next one */
+	if (loopback) {
+		pd_phy[port].has_preamble = 0;
+		pd_phy[port].has_hard_reset = 0;
+		pd_phy[port].total = 0;
+	}
 }
 
 int pd_rx_started(int port)
@@ -278,6 +438,8 @@ void pd_rx_enable_monitoring(int port)
 {
 	ASSERT(pd_phy[port].hw_init_done);
 	pd_phy[port].rx_monitoring = 1;
+	if (loopback)
+		loopback_rx_next(port);
 }
 
 void pd_rx_disable_monitoring(int port)
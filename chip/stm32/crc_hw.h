@@ -33,6 +33,24 @@ static inline void crc32_hash16(uint16_t val)
 	STM32_CRC_DR16 = val;
 }
 
+static inline void crc32_hash_buf(const void *buf, int size)
+{
+	const uint8_t *p = buf;
+
+	/* Feed the data register a byte at a time until word aligned */
+	while (size > 0 && ((uintptr_t)p & 3)) {
+		STM32_CRC_DR8 = *p++;
+		size--;
+	}
+
+	/* The bulk goes through the 32-bit data register */
+	for (; size >= 4; size -= 4, p += 4)
+		STM32_CRC_DR = *(const uint32_t *)p;
+
+	while (size-- > 0)
+		STM32_CRC_DR8 = *p++;
+}
+
 static inline uint32_t crc32_result(void)
 {
 	return STM32_CRC_DR ^ 0xFFFFFFFF;
@@ -87,6 +87,7 @@ void pd_init_dequeue(int port)
 	pd_phy[port].d_lastlen = 0;
 }
 
+/* Wait until at least nb samples are received; return how many there are */
 static int wait_bits(int port, int nb)
 {
 	int avail;
@@ -97,35 +98,39 @@ static int wait_bits(int port, int nb)
 		while ((dma_bytes_done(rx, PD_MAX_RAW_SIZE) < nb)
 			&& !(pd_phy[port].tim_rx->sr & 4))
 			; /* optimized for latency, not CPU usage ... */
-		if (dma_bytes_done(rx, PD_MAX_RAW_SIZE) < nb) {
-			CPRINTS("PD TMOUT RX %d/%d",
-				dma_bytes_done(rx, PD_MAX_RAW_SIZE), nb);
+		avail = dma_bytes_done(rx, PD_MAX_RAW_SIZE);
+		if (avail < nb) {
+			CPRINTS("PD TMOUT RX %d/%d", avail, nb);
 			return -1;
 		}
 	}
-	return nb;
+	return avail;
 }
 
 int pd_dequeue_bits(int port, int off, int len, uint32_t *val)
 {
-	int w;
 	uint8_t cnt = 0xff;
 	uint8_t *samples = (uint8_t *)pd_phy[port].raw_samples;
+	uint32_t last = pd_phy[port].d_last;
+	int lastlen = pd_phy[port].d_lastlen;
+	int avail = 0;
 
-	while ((pd_phy[port].d_lastlen < len) && (off < PD_MAX_RAW_SIZE - 1)) {
-		w = wait_bits(port, off + 2);
-		if (w < 0)
-			goto stream_err;
+	/*
+	 * Convert edges to bits in bulk: the DMA counter is only read again
+	 * once all the samples already received are used up.
+	 */
+	while ((lastlen < len) && (off < PD_MAX_RAW_SIZE - 1)) {
+		if (avail < off + 2) {
+			avail = wait_bits(port, off + 2);
+			if (avail < 0)
+				goto stream_err;
+		}
 		cnt = samples[off] - samples[off-1];
 		if (!cnt || (cnt > 3*PERIOD))
 			goto stream_err;
 		off++;
 		if (cnt <= PERIOD_THRESHOLD) {
-			/*
-			w = wait_bits(port, off + 1);
-			if (w < 0)
-				goto stream_err;
-			*/
+			/* second half of a 1, received with the first half */
 			cnt = samples[off] - samples[off-1];
 			if (cnt >  PERIOD_THRESHOLD)
 				goto stream_err;
@@ -133,14 +138,13 @@ int pd_dequeue_bits(int port, int off, int len, uint32_t *val)
 		}
 
 		/* enqueue the bit of the last period */
-		pd_phy[port].d_last = (pd_phy[port].d_last >> 1)
-		       | (cnt <= PERIOD_THRESHOLD ? 0x80000000 : 0);
-		pd_phy[port].d_lastlen++;
+		last = (last >> 1) | (cnt <= PERIOD_THRESHOLD ? 0x80000000 : 0);
+		lastlen++;
 	}
 	if (off < PD_MAX_RAW_SIZE) {
-		*val = (pd_phy[port].d_last << (pd_phy[port].d_lastlen - len))
-				>> (32 - len);
-		pd_phy[port].d_lastlen -= len;
+		*val = (last << (lastlen - len)) >> (32 - len);
+		pd_phy[port].d_last = last;
+		pd_phy[port].d_lastlen = lastlen - len;
 		return off;
 	} else {
 		return -1;
@@ -302,7 +306,7 @@ static void tx_dma_done(void *data)
 	pd_tx_disable(port, polarity);
 
 #if defined(CONFIG_COMMON_RUNTIME) && defined(CONFIG_DMA_DEFAULT_HANDLERS)
-	task_set_event(PD_PORT_TO_TASK_ID(port), TASK_EVENT_DMA_TC, 0);
+	task_set_event(TCPC_PORT_TO_TASK_ID(port), TASK_EVENT_DMA_TC, 0);
 #endif
 }
 
@@ -209,7 +209,7 @@ int acpi_ap_to_ec(int is_cmd, uint8_t value, uint8_t *resultptr)
 			 * interrupts and defer locking.
 			 */
 			lpc_disable_acpi_interrupts();
-			hook_call_deferred(deferred_host_lock_memmap, 0);
+			hook_call_deferred(&deferred_host_lock_memmap_data, 0);
 		} else {
 			host_lock_memmap();
 		}
@@ -220,14 +220,14 @@ int acpi_ap_to_ec(int is_cmd, uint8_t value, uint8_t *resultptr)
 		 * Unlock from deferred function in case burst mode is enabled
 		 * for an extremely long time  (ex. kernel bug / crash).
 		 */
-		hook_call_deferred(acpi_unlock_memmap_deferred, 1*SECOND);
+		hook_call_deferred(&acpi_unlock_memmap_deferred_data, 1*SECOND);
 
 		/* ACPI 5.0-12.3.3: Burst ACK */
 		*resultptr = 0x90;
 		retval = 1;
 	} else if (acpi_cmd == EC_CMD_ACPI_BURST_DISABLE && !acpi_data_count) {
 		/* Leave burst mode */
-		hook_call_deferred(acpi_unlock_memmap_deferred, -1);
+		hook_call_deferred(&acpi_unlock_memmap_deferred_data, -1);
 		lpc_clear_acpi_status_mask(EC_LPC_STATUS_BURST_MODE);
 		host_unlock_memmap();
 	}
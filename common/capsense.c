@@ -41,6 +41,9 @@ static void capsense_init(void)
 }
 DECLARE_HOOK(HOOK_INIT, capsense_init, HOOK_PRIO_DEFAULT);
 
+static void capsense_change_deferred(void);
+DECLARE_DEFERRED(capsense_change_deferred);
+
 /*
  * Keep checking polling the capsense until all the buttons are released.
  * We're not worrying about debouncing, since the capsense module should do
@@ -73,15 +76,14 @@ static void capsense_change_deferred(void)
 	}
 
 	if (cur_val)
-		hook_call_deferred(capsense_change_deferred,
+		hook_call_deferred(&capsense_change_deferred_data,
 				   CAPSENSE_POLL_INTERVAL);
 }
-DECLARE_DEFERRED(capsense_change_deferred);
 
 /*
  * Somebody's poking at us.
  */
 void capsense_interrupt(enum gpio_signal signal)
 {
-	hook_call_deferred(capsense_change_deferred, 0);
+	hook_call_deferred(&capsense_change_deferred_data, 0);
 }
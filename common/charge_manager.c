@@ -608,7 +608,7 @@ static void charge_manager_make_change(enum charge_manager_change_type change,
 				delayed_override_port);
 			delayed_override_port = OVERRIDE_OFF;
 			hook_call_deferred(
-				charge_override_timeout,
+				&charge_override_timeout_data,
 				-1);
 		}
 	}
@@ -635,7 +635,7 @@ static void charge_manager_make_change(enum charge_manager_change_type change,
 	 * attached.
 	 */
 	if (charge_manager_is_seeded())
-		hook_call_deferred(charge_manager_refresh, 0);
+		hook_call_deferred(&charge_manager_refresh_data, 0);
 }
 
 /**
@@ -689,7 +689,8 @@ void charge_manager_set_ceil(int port, int ceil)
 	if (charge_ceil[port] != ceil) {
 		charge_ceil[port] = ceil;
 		if (port == charge_port && charge_manager_is_seeded())
-				hook_call_deferred(charge_manager_refresh, 0);
+				hook_call_deferred(&charge_manager_refresh_data,
+						   0);
 	}
 }
 
@@ -718,7 +719,7 @@ int charge_manager_set_override(int port)
 
 		delayed_override_port = OVERRIDE_OFF;
 		hook_call_deferred(
-			charge_override_timeout, -1);
+			&charge_override_timeout_data, -1);
 	}
 
 	/* Set the override port if it's a sink. */
@@ -727,7 +728,8 @@ int charge_manager_set_override(int port)
 			charge_manager_cleanup_override_port(override_port);
 			override_port = port;
 			if (charge_manager_is_seeded())
-				hook_call_deferred(charge_manager_refresh, 0);
+				hook_call_deferred(&charge_manager_refresh_data,
+						   0);
 		}
 	}
 	/*
@@ -740,7 +742,7 @@ int charge_manager_set_override(int port)
 						POWER_SWAP_TIMEOUT;
 		delayed_override_port = port;
 		hook_call_deferred(
-			charge_override_timeout,
+			&charge_override_timeout_data,
 			POWER_SWAP_TIMEOUT);
 		pd_request_power_swap(port);
 	/* Can't charge from requested port -- return error. */
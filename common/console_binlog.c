@@ -0,0 +1,595 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Binary console log for Chrome EC */
+
+#include "atomic.h"
+#include "console.h"
+#include "hooks.h"
+#include "printf.h"
+#include "task.h"
+#include "timer.h"
+#include "uart.h"
+#include "usb_console.h"
+#include "util.h"
+
+/* Without the common runtime, printf cannot format 64-bit %T and %l */
+#ifndef CONFIG_COMMON_RUNTIME
+#error "CONFIG_CONSOLE_BINARY_LOG requires CONFIG_COMMON_RUNTIME"
+#endif
+
+/*
+ * Each record is a struct binlog_header followed by the raw arguments of the
+ * message, packed into 32-bit words in the order the format string consumes
+ * them:
+ *   - integers, characters, '*' widths and precisions: one word
+ *   - 64-bit ("%l") integers: two words, low word first
+ *   - "%s": the string itself, null-terminated and padded to a word
+ *   - "%h": the hex dump data itself, padded to a word
+ *   - "%T": nothing; the record timestamp is used instead
+ *
+ * Strings and hex dump data are copied because the caller's buffers may be
+ * gone by the time the record is formatted.
+ */
+struct binlog_header {
+	const char *format;	/* Format string; identifies the message */
+	uint32_t time_lo;	/* Time of the call in us */
+	uint32_t time_hi;
+	uint8_t channel;	/* enum console_channel */
+	uint8_t words;		/* Number of argument words after the header */
+	uint16_t reserved;
+};
+
+#define HEADER_WORDS (sizeof(struct binlog_header) / sizeof(uint32_t))
+#define LOG_WORDS (CONFIG_CONSOLE_BINARY_LOG_SIZE / sizeof(uint32_t))
+#define MAX_ARG_WORDS 255
+
+BUILD_ASSERT(sizeof(struct binlog_header) % sizeof(uint32_t) == 0);
+BUILD_ASSERT(POWER_OF_TWO(LOG_WORDS));
+
+/*
+ * The log is a ring of words.  "log_head" is where the next record will be
+ * written and "log_tail" is the oldest unread record; both are free-running
+ * word counts which are only wrapped when used, so head == tail means empty.
+ * Writers add a whole record with interrupts disabled, so records are never
+ * seen half-written.  Readers also remove a record with interrupts disabled,
+ * after copying it out.
+ */
+static uint32_t log_words[LOG_WORDS];
+static uint32_t log_head;
+static uint32_t log_tail;
+
+/* Records dropped because the log was full */
+static uint32_t log_dropped;
+
+/* If set, records are kept in binary form until dumped */
+static int log_paused;
+
+/* Set while a reader is formatting records */
+static int log_draining;
+
+/* Copy of the record being formatted */
+static uint32_t drain_buf[HEADER_WORDS + MAX_ARG_WORDS];
+
+/* Format segment being printed; room for some text and one conversion */
+#define SEGMENT_SIZE 64
+#define SPEC_SIZE 32
+
+DECLARE_DEFERRED(console_binlog_flush);
+
+/*****************************************************************************/
+/* Recording */
+
+struct log_writer {
+	uint32_t pos;
+	uint32_t end;
+};
+
+static int put_word(struct log_writer *w, uint32_t v)
+{
+	if (w->pos == w->end)
+		return EC_ERROR_OVERFLOW;
+	log_words[w->pos++ & (LOG_WORDS - 1)] = v;
+	return EC_SUCCESS;
+}
+
+static int put_bytes(struct log_writer *w, const char *src, int len)
+{
+	uint32_t v;
+
+	for (; len > 0; len -= sizeof(v), src += sizeof(v)) {
+		v = 0;
+		memcpy(&v, src, MIN(len, sizeof(v)));
+		if (put_word(w, v))
+			return EC_ERROR_OVERFLOW;
+	}
+	return EC_SUCCESS;
+}
+
+/*
+ * Check a conversion character the way vfnprintf() does.  A conversion it
+ * rejects is printed as "ERROR" and ends the format, so the same formats are
+ * cut short here, both when recording and when replaying.
+ */
+static int conversion_ok(int c, int is_64bit, int precision)
+{
+	switch (c) {
+	case 's':
+		return !is_64bit;
+	case 'h':
+		return !is_64bit && precision;
+	case 'd':
+	case 'u':
+	case 'T':
+	case 'x':
+	case 'X':
+	case 'p':
+	case 'b':
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Copy the arguments consumed by format into the log.  This walks the format
+ * string the same way vfnprintf() does, but only to learn the argument types;
+ * nothing is converted to text here.
+ */
+static int put_args(struct log_writer *w, const char *format, va_list args)
+{
+	const char *s;
+	int pad_width, precision, is_64bit;
+	int c;
+
+	while ((c = *format++) != '\0') {
+		if (c != '%')
+			continue;
+
+		c = *format++;
+		if (c == '%')
+			continue;
+		if (c == '\0')
+			break;
+		if (c == 'c') {
+			if (put_word(w, va_arg(args, int)))
+				return EC_ERROR_OVERFLOW;
+			continue;
+		}
+
+		if (c == '-')
+			c = *format++;
+		if (c == '0')
+			c = *format++;
+
+		pad_width = 0;
+		if (c == '*') {
+			pad_width = va_arg(args, int);
+			if (put_word(w, pad_width))
+				return EC_ERROR_OVERFLOW;
+			c = *format++;
+		} else {
+			while (c >= '0' && c <= '9') {
+				pad_width = 10 * pad_width + c - '0';
+				c = *format++;
+			}
+		}
+		if (pad_width < 0 || pad_width > MAX_FORMAT)
+			break;
+
+		precision = 0;
+		if (c == '.') {
+			c = *format++;
+			if (c == '*') {
+				precision = va_arg(args, int);
+				if (put_word(w, precision))
+					return EC_ERROR_OVERFLOW;
+				c = *format++;
+			} else {
+				while (c >= '0' && c <= '9') {
+					precision = 10 * precision + c - '0';
+					c = *format++;
+				}
+			}
+			if (precision < 0 || precision > MAX_FORMAT)
+				break;
+		}
+
+		is_64bit = 0;
+		if (c == 'l') {
+			is_64bit = 1;
+			c = *format++;
+		}
+
+		/* This also ends the walk at a truncated format string */
+		if (!conversion_ok(c, is_64bit, precision))
+			break;
+
+		if (c == 's') {
+			s = va_arg(args, const char *);
+			if (s == NULL)
+				s = "(NULL)";
+			if (put_bytes(w, s, strlen(s) + 1))
+				return EC_ERROR_OVERFLOW;
+		} else if (c == 'h') {
+			s = va_arg(args, const char *);
+			if (put_bytes(w, s, precision))
+				return EC_ERROR_OVERFLOW;
+		} else if (c == 'T') {
+			/* The record time is used instead */
+		} else if (is_64bit) {
+			uint64_t v = va_arg(args, uint64_t);
+
+			if (put_word(w, (uint32_t)v) ||
+			    put_word(w, (uint32_t)(v >> 32)))
+				return EC_ERROR_OVERFLOW;
+		} else {
+			if (put_word(w, va_arg(args, uint32_t)))
+				return EC_ERROR_OVERFLOW;
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+int console_binlog_vrecord(enum console_channel channel, const char *format,
+			   va_list args)
+{
+	struct binlog_header hdr;
+	struct log_writer w;
+	uint64_t t = get_time().val;
+	uint32_t free_words;
+	int was_empty;
+	int i;
+
+	interrupt_disable();
+
+	free_words = LOG_WORDS - (log_head - log_tail);
+	if (free_words < HEADER_WORDS) {
+		log_dropped++;
+		interrupt_enable();
+		return EC_ERROR_OVERFLOW;
+	}
+
+	w.pos = log_head + HEADER_WORDS;
+	w.end = log_head + MIN(free_words, HEADER_WORDS + MAX_ARG_WORDS);
+	if (put_args(&w, format, args)) {
+		log_dropped++;
+		interrupt_enable();
+		return EC_ERROR_OVERFLOW;
+	}
+
+	hdr.format = format;
+	hdr.time_lo = (uint32_t)t;
+	hdr.time_hi = (uint32_t)(t >> 32);
+	hdr.channel = channel;
+	hdr.words = w.pos - log_head - HEADER_WORDS;
+	hdr.reserved = 0;
+	for (i = 0; i < HEADER_WORDS; i++)
+		memcpy(log_words + ((log_head + i) & (LOG_WORDS - 1)),
+		       (uint32_t *)&hdr + i, sizeof(uint32_t));
+
+	was_empty = (log_head == log_tail);
+	log_head = w.pos;
+
+	interrupt_enable();
+
+	/* The drain routine empties the log, so only wake it for the first */
+	if (was_empty && !log_paused)
+		hook_call_deferred(&console_binlog_flush_data, 0);
+
+	return EC_SUCCESS;
+}
+
+/*****************************************************************************/
+/* Formatting */
+
+/**
+ * Remove the oldest record from the log into drain_buf.
+ *
+ * @return the record size in words, or 0 if the log is empty.
+ */
+static int log_pop(void)
+{
+	struct binlog_header hdr;
+	uint32_t tail;
+	int size, i;
+
+	interrupt_disable();
+	tail = log_tail;
+	if (tail == log_head) {
+		interrupt_enable();
+		return 0;
+	}
+	for (i = 0; i < HEADER_WORDS; i++)
+		drain_buf[i] = log_words[(tail + i) & (LOG_WORDS - 1)];
+	memcpy(&hdr, drain_buf, sizeof(hdr));
+	size = HEADER_WORDS + hdr.words;
+	for (; i < size; i++)
+		drain_buf[i] = log_words[(tail + i) & (LOG_WORDS - 1)];
+	log_tail = tail + size;
+	interrupt_enable();
+
+	return size;
+}
+
+/* Print to every console, like cprintf() but without channel filtering */
+static int binlog_printf(const char *format, ...)
+{
+	int rv1, rv2;
+	va_list args;
+
+	usb_va_start(args, format);
+	rv1 = usb_vprintf(format, args);
+	usb_va_end(args);
+
+	va_start(args, format);
+	rv2 = uart_vprintf(format, args);
+	va_end(args);
+
+	return rv1 == EC_SUCCESS ? rv2 : rv1;
+}
+
+/* Append a decimal number to a format segment */
+static int append_int(char *seg, int len, int v)
+{
+	snprintf(seg + len, SEGMENT_SIZE - len, "%d", v);
+	return len + strlen(seg + len);
+}
+
+/* Like vfnprintf(), replace a bad conversion and the rest of the format */
+static int format_error(char *seg, int len)
+{
+	memcpy(seg + len, "ERROR", 5);
+	return len + 5;
+}
+
+/**
+ * Print the record popped into drain_buf.
+ *
+ * The format string is replayed one conversion at a time: the literal text
+ * leading up to a conversion and the conversion itself are copied into a
+ * segment, with the width and precision rewritten as plain numbers, and the
+ * segment is printed with its single argument taken from the record.
+ */
+static void print_record(void)
+{
+	struct binlog_header hdr;
+	const uint32_t *arg = drain_buf + HEADER_WORDS;
+	const uint32_t *arg_end;
+	const char *format;
+	uint64_t t;
+	char seg[SEGMENT_SIZE];
+	int len = 0;
+	int spec, is_64bit;
+	int pad_width, precision;
+	int c;
+
+	memcpy(&hdr, drain_buf, sizeof(hdr));
+	arg_end = arg + hdr.words;
+	format = hdr.format;
+	t = ((uint64_t)hdr.time_hi << 32) | hdr.time_lo;
+
+	binlog_printf("[%.6lu ", t);
+
+	while ((c = *format++) != '\0') {
+		/* Make room for the next conversion */
+		if (len >= SEGMENT_SIZE - SPEC_SIZE) {
+			seg[len] = '\0';
+			binlog_printf(seg);
+			len = 0;
+		}
+
+		spec = len;
+		seg[len++] = c;
+		if (c != '%')
+			continue;
+
+		c = *format++;
+		if (c == '%' || c == '\0') {
+			seg[len++] = '%';
+			if (c == '\0')
+				break;
+			continue;
+		}
+		if (c == 'c') {
+			seg[len++] = c;
+			seg[len] = '\0';
+			binlog_printf(seg, arg < arg_end ? *arg++ : 0);
+			len = 0;
+			continue;
+		}
+
+		if (c == '-') {
+			seg[len++] = c;
+			c = *format++;
+		}
+		if (c == '0') {
+			seg[len++] = c;
+			c = *format++;
+		}
+
+		pad_width = 0;
+		if (c == '*') {
+			pad_width = arg < arg_end ? *arg++ : 0;
+			c = *format++;
+		} else {
+			while (c >= '0' && c <= '9') {
+				pad_width = 10 * pad_width + c - '0';
+				c = *format++;
+			}
+		}
+		if (pad_width < 0 || pad_width > MAX_FORMAT) {
+			len = format_error(seg, spec);
+			break;
+		}
+		if (pad_width)
+			len = append_int(seg, len, pad_width);
+
+		precision = 0;
+		if (c == '.') {
+			c = *format++;
+			if (c == '*') {
+				precision = arg < arg_end ? *arg++ : 0;
+				c = *format++;
+			} else {
+				while (c >= '0' && c <= '9') {
+					precision = 10 * precision + c - '0';
+					c = *format++;
+				}
+			}
+			if (precision < 0 || precision > MAX_FORMAT) {
+				len = format_error(seg, spec);
+				break;
+			}
+			/* %T always prints the precision it forces */
+			if (c != 'T' && !(c == 'l' && *format == 'T')) {
+				seg[len++] = '.';
+				len = append_int(seg, len, precision);
+			}
+		}
+
+		is_64bit = 0;
+		if (c == 'l') {
+			is_64bit = 1;
+			c = *format++;
+		}
+
+		if (!conversion_ok(c, is_64bit, precision)) {
+			len = format_error(seg, spec);
+			break;
+		}
+
+		if (c == 'T') {
+			memcpy(seg + len, ".6lu", 5);
+			binlog_printf(seg, t);
+			len = 0;
+			continue;
+		}
+
+		if (is_64bit)
+			seg[len++] = 'l';
+		seg[len++] = c;
+		seg[len] = '\0';
+		len = 0;
+
+		if (c == 's') {
+			binlog_printf(seg, (const char *)arg);
+			arg += strlen((const char *)arg) / 4 + 1;
+		} else if (c == 'h') {
+			binlog_printf(seg, (const char *)arg);
+			arg += DIV_ROUND_UP(precision, 4);
+		} else if (is_64bit) {
+			binlog_printf(seg, arg + 1 < arg_end ?
+				      arg[0] | ((uint64_t)arg[1] << 32) : 0ULL);
+			arg += 2;
+		} else {
+			binlog_printf(seg, arg < arg_end ? *arg : 0);
+			arg++;
+		}
+
+		/* Never read past the record, even for a bad format */
+		if (arg > arg_end)
+			arg = arg_end;
+	}
+
+	seg[len] = '\0';
+	binlog_printf(seg);
+	binlog_printf("]\n");
+}
+
+/**
+ * Claim drain_buf for a reader.
+ *
+ * The HOOKS task formatting the log and the console task dumping it both pop
+ * records into drain_buf, so only one of them may run at a time.
+ *
+ * @param paused	Required value of log_paused.
+ * @return 1 if claimed; release it by clearing log_draining.
+ */
+static int claim_drain(int paused)
+{
+	int claimed;
+
+	interrupt_disable();
+	claimed = !log_draining && log_paused == paused;
+	if (claimed)
+		log_draining = 1;
+	interrupt_enable();
+
+	return claimed;
+}
+
+void console_binlog_flush(void)
+{
+	uint32_t dropped;
+
+	if (!claim_drain(0))
+		return;
+
+	while (!log_paused && log_pop())
+		print_record();
+
+	dropped = atomic_read_clear(&log_dropped);
+	if (dropped)
+		binlog_printf("[%T binlog: %d dropped]\n", dropped);
+
+	log_draining = 0;
+}
+
+/*****************************************************************************/
+/* Console commands */
+
+/* Address of a known object, to relocate format addresses when decoding */
+static const char dump_anchor[] = "binlog";
+
+/* Print the records as text which util/binlog_decode.py understands */
+static void dump_log(void)
+{
+	struct binlog_header hdr;
+
+	ccprintf("BLANCHOR %08x\n", (uint32_t)(uintptr_t)dump_anchor);
+	while (log_pop()) {
+		memcpy(&hdr, drain_buf, sizeof(hdr));
+		ccprintf("BL %08x %lu %d", (uint32_t)(uintptr_t)hdr.format,
+			 ((uint64_t)hdr.time_hi << 32) | hdr.time_lo,
+			 hdr.channel);
+		if (hdr.words)
+			ccprintf(" %.*h", hdr.words * 4,
+				 (const char *)(drain_buf + HEADER_WORDS));
+		ccputs("\n");
+		cflush();
+	}
+}
+
+static int command_binlog(int argc, char **argv)
+{
+	if (argc > 1) {
+		if (!strcasecmp(argv[1], "off")) {
+			log_paused = 1;
+		} else if (!strcasecmp(argv[1], "on")) {
+			log_paused = 0;
+			hook_call_deferred(&console_binlog_flush_data, 0);
+		} else if (!strcasecmp(argv[1], "dump")) {
+			/* Formatting may still be finishing a record */
+			if (!claim_drain(1))
+				return EC_ERROR_BUSY;
+			dump_log();
+			log_draining = 0;
+		} else {
+			return EC_ERROR_PARAM1;
+		}
+	}
+
+	ccprintf("Formatting: %s\n", log_paused ? "off" : "on");
+	ccprintf("Used:       %d/%d bytes\n",
+		 (log_head - log_tail) * 4, CONFIG_CONSOLE_BINARY_LOG_SIZE);
+	ccprintf("Dropped:    %d\n", log_dropped);
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(binlog, command_binlog,
+			"[on | off | dump]",
+			"Control the binary console log",
+			NULL);
@@ -114,6 +114,13 @@ int cprints(enum console_channel channel, const char *format, ...)
 	if (!(CC_MASK(channel) & channel_mask))
 		return EC_SUCCESS;
 
+#ifdef CONFIG_CONSOLE_BINARY_LOG
+	va_start(args, format);
+	rv = console_binlog_vrecord(channel, format, args);
+	va_end(args);
+	return rv;
+#endif
+
 	rv = cprintf(channel, "[%T ");
 
 	va_start(args, format);
@@ -134,6 +141,7 @@ int cprints(enum console_channel channel, const char *format, ...)
 
 void cflush(void)
 {
+	console_binlog_flush();
 	uart_flush_output();
 }
 
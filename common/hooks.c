@@ -50,11 +50,25 @@ static const struct hook_ptrs hook_list[] = {
 	{__hooks_second, __hooks_second_end},
 };
 
+/*
+ * Set once __hook_order[] holds the dispatch order of every hook table.  For
+ * each hook type, the entries at the same offset as that type's hooks are
+ * indices into its table, sorted by priority.
+ */
+static int hooks_sorted;
+
 /* Times for deferrable functions */
 static uint64_t defer_until[DEFERRABLE_MAX_COUNT];
+/*
+ * Bitmap of deferrable functions which may have a call pending, so the hook
+ * task only needs to look at the routines which have actually been scheduled.
+ */
+static uint32_t defer_pending;
 static int defer_new_call;
 static int hook_task_started;
 
+BUILD_ASSERT(DEFERRABLE_MAX_COUNT <= 32);
+
 #ifdef CONFIG_HOOK_DEBUG
 /* Stats for hooks */
 static uint64_t max_hook_tick_delay;
@@ -65,6 +79,18 @@ static uint64_t avg_hook_tick_delay;
 static uint64_t avg_hook_second_delay;
 static uint64_t avg_hook_run_time[ARRAY_SIZE(hook_list)];
 
+/*
+ * Run time histograms for each hook, in __hook_hist[].  Bucket n counts runs
+ * shorter than 16 << (2 * n) us; the last bucket counts everything longer.
+ * The linker scripts reserve 8 buckets per hook.
+ */
+#define HOOK_HIST_BUCKETS 8
+
+/* Stats for deferred functions */
+static uint32_t deferred_call_count[DEFERRABLE_MAX_COUNT];
+static uint32_t max_deferred_delay[DEFERRABLE_MAX_COUNT];
+static uint32_t max_deferred_run_time[DEFERRABLE_MAX_COUNT];
+
 static inline void update_hook_average(uint64_t *avg, uint64_t time)
 {
 	*avg = (*avg * 7 + time) >> 3;
@@ -87,40 +113,87 @@ static void record_hook_delay(uint64_t now, uint64_t last, uint64_t interval,
 		CPRINTS("Hook at interval %d us delayed by %d us",
 			(uint32_t)interval, (uint32_t)delayed);
 }
+
+static void record_hook_run_time(const struct hook_data *p, uint64_t time)
+{
+	uint8_t *hist = __hook_hist + (p - __hooks_init) * HOOK_HIST_BUCKETS;
+	int b, i;
+
+	for (b = 0; b < HOOK_HIST_BUCKETS - 1; b++) {
+		if (time < (16 << (2 * b)))
+			break;
+	}
+
+	/* Halve the whole histogram rather than saturate, to keep its shape */
+	if (hist[b] == 0xff) {
+		for (i = 0; i < HOOK_HIST_BUCKETS; i++)
+			hist[i] >>= 1;
+	}
+	hist[b]++;
+}
 #endif
 
+/**
+ * Fill in __hook_order[] for every hook type.
+ *
+ * Priorities are arbitrary expressions, so the linker cannot sort the tables
+ * by them.  Instead, this computes each hook's rank once, and hook_notify()
+ * then needs only a single pass.  Hooks with equal priority keep their link
+ * order.  Every store writes its final value, so it does not matter if two
+ * contexts race to do this on their first hook_notify().
+ */
+static void hook_sort(void)
+{
+	const struct hook_data *start, *end, *p, *q;
+	int type, rank;
+
+	for (type = 0; type < ARRAY_SIZE(hook_list); type++) {
+		start = hook_list[type].start;
+		end = hook_list[type].end;
+
+		for (p = start; p < end; p++) {
+			rank = 0;
+			for (q = start; q < end; q++) {
+				if (q->priority < p->priority ||
+				    (q->priority == p->priority && q < p))
+					rank++;
+			}
+			__hook_order[start - __hooks_init + rank] = p - start;
+		}
+	}
+
+	hooks_sorted = 1;
+}
+
 void hook_notify(enum hook_type type)
 {
-	const struct hook_data *start, *end, *p;
-	int count, called = 0;
-	int last_prio = HOOK_PRIO_FIRST - 1, prio;
+	const struct hook_data *start, *p;
+	const uint16_t *order;
+	int count, i;
 #ifdef CONFIG_HOOK_DEBUG
 	uint64_t start_time = get_time().val;
+	uint64_t hook_time = start_time;
 	uint64_t run_time;
 #endif
 
 	CPRINTS("hook notify %d", type);
 
+	if (!hooks_sorted)
+		hook_sort();
+
 	start = hook_list[type].start;
-	end = hook_list[type].end;
-	count = end - start;
+	count = hook_list[type].end - start;
+	order = __hook_order + (start - __hooks_init);
 
 	/* Call all the hooks in priority order */
-	while (called < count) {
-		/* Find the lowest remaining priority */
-		for (p = start, prio = HOOK_PRIO_LAST + 1; p < end; p++) {
-			if (p->priority < prio && p->priority > last_prio)
-				prio = p->priority;
-		}
-		last_prio = prio;
-
-		/* Call all the hooks with that priority */
-		for (p = start; p < end; p++) {
-			if (p->priority == prio) {
-				called++;
-				p->routine();
-			}
-		}
+	for (i = 0; i < count; i++) {
+		p = start + order[i];
+		p->routine();
+#ifdef CONFIG_HOOK_DEBUG
+		run_time = get_time().val;
+		record_hook_run_time(p, run_time - hook_time);
+		hook_time = run_time;
+#endif
 	}
 
 #ifdef CONFIG_HOOK_DEBUG
@@ -131,27 +204,27 @@ void hook_notify(enum hook_type type)
 #endif
 }
 
-int hook_call_deferred(void (*routine)(void), int us)
+int hook_call_deferred(const struct deferred_data *data, int us)
 {
-	const struct deferred_data *p;
 	int i;
 
-	/* Find the index of the routine */
-	for (p = __deferred_funcs; p < __deferred_funcs_end; p++) {
-		if (p->routine == routine)
-			break;
-	}
-	if (p >= __deferred_funcs_end)
+	if (data < __deferred_funcs || data >= __deferred_funcs_end)
 		return EC_ERROR_INVAL;  /* Routine not registered */
 
-	i = p - __deferred_funcs;
+	i = data - __deferred_funcs;
+	if (i >= DEFERRABLE_MAX_COUNT)
+		return EC_ERROR_INVAL;  /* Table overflowed (see hooks.h) */
 
 	if (us == -1) {
 		/* Cancel */
+		atomic_clear(&defer_pending, 1 << i);
 		defer_until[i] = 0;
 	} else {
-		/* Set alarm */
+		/* Set alarm; zero means cancelled, so never use time zero */
 		defer_until[i] = get_time().val + us;
+		if (!defer_until[i])
+			defer_until[i] = 1;
+		atomic_or(&defer_pending, 1 << i);
 		/*
 		 * Flag that hook_call_deferred() has been called.  If the hook
 		 * task is already active, this will allow it to go through the
@@ -167,6 +240,87 @@ int hook_call_deferred(void (*routine)(void), int us)
 	return EC_SUCCESS;
 }
 
+/**
+ * Call the deferred routines which are due at or before time t.
+ */
+static void call_deferred(uint64_t t)
+{
+	/*
+	 * Take ownership of the pending routines.  Anything scheduled while
+	 * we run them sets its bit again and is picked up on the next pass.
+	 */
+	uint32_t pending = atomic_read_clear(&defer_pending);
+	uint32_t later = 0;
+	int i;
+#ifdef CONFIG_HOOK_DEBUG
+	uint64_t start_time;
+#endif
+
+	while (pending) {
+		i = 31 - __builtin_clz(pending);
+		pending &= ~(1 << i);
+
+		/* Cancelled since it was scheduled */
+		if (!defer_until[i])
+			continue;
+
+		if (defer_until[i] > t) {
+			later |= 1 << i;
+			continue;
+		}
+
+		CPRINTS("hook call deferred 0x%p", __deferred_funcs[i].routine);
+#ifdef CONFIG_HOOK_DEBUG
+		start_time = get_time().val;
+		if (start_time - defer_until[i] > max_deferred_delay[i])
+			max_deferred_delay[i] = start_time - defer_until[i];
+#endif
+		/*
+		 * Call deferred function.  Clear timer first, so it can
+		 * request itself be called later.
+		 */
+		defer_until[i] = 0;
+		__deferred_funcs[i].routine();
+#ifdef CONFIG_HOOK_DEBUG
+		deferred_call_count[i]++;
+		start_time = get_time().val - start_time;
+		if (start_time > max_deferred_run_time[i])
+			max_deferred_run_time[i] = start_time;
+#endif
+	}
+
+	if (later)
+		atomic_or(&defer_pending, later);
+}
+
+/**
+ * Return the time in us from t until the next pending deferred routine is
+ * due, capped at max_us.
+ */
+static int next_deferred(uint64_t t, int max_us)
+{
+	uint32_t pending = defer_pending;
+	uint64_t until;
+	int next = max_us;
+	int i;
+
+	while (pending && next > 0) {
+		i = 31 - __builtin_clz(pending);
+		pending &= ~(1 << i);
+
+		until = defer_until[i];
+		if (!until)
+			continue;
+
+		if (until <= t)
+			next = 0;
+		else if (until - t < next)
+			next = until - t;
+	}
+
+	return next;
+}
+
 void hook_task(void)
 {
 	/* Periodic hooks will be called first time through the loop */
@@ -184,21 +338,9 @@ void hook_task(void)
 	while (1) {
 		uint64_t t = get_time().val;
 		int next = 0;
-		int i;
 
 		/* Handle deferred routines */
-		for (i = 0; i < DEFERRED_FUNCS_COUNT; i++) {
-			if (defer_until[i] && defer_until[i] < t) {
-				CPRINTS("hook call deferred 0x%p",
-					__deferred_funcs[i].routine);
-				/*
-				 * Call deferred function.  Clear timer first,
-				 * so it can request itself be called later.
-				 */
-				defer_until[i] = 0;
-				__deferred_funcs[i].routine();
-			}
-		}
+		call_deferred(t);
 
 		if (t - last_tick >= HOOK_TICK_INTERVAL) {
 #ifdef CONFIG_HOOK_DEBUG
@@ -227,15 +369,7 @@ void hook_task(void)
 
 		/* Wake earlier if needed by a deferred routine */
 		defer_new_call = 0;
-		for (i = 0; i < DEFERRED_FUNCS_COUNT && next > 0; i++) {
-			if (!defer_until[i])
-				continue;
-
-			if (defer_until[i] < t)
-				next = 0;
-			else if (defer_until[i] - t < next)
-				next = defer_until[i] - t;
-		}
+		next = next_deferred(t, next);
 
 		/*
 		 * If nothing is immediately pending, and hook_call_deferred()
@@ -261,6 +395,33 @@ static void print_hook_delay(uint32_t interval, uint32_t delay, uint32_t avg)
 	ccprintf("  Average:     %7d us (%d%%)\n\n", avg, percent_avg);
 }
 
+static void print_hook_hist(void)
+{
+	const struct hook_data *p;
+	const uint8_t *hist;
+	int i, b;
+
+	ccprintf("\nRun time histogram for each hook that has run:\n");
+	ccprintf("type  prio    routine  <16us <64 <256 <1ms <4ms <16ms "
+		 "<64ms more\n");
+	for (i = 0; i < ARRAY_SIZE(hook_list); ++i) {
+		for (p = hook_list[i].start; p < hook_list[i].end; p++) {
+			hist = __hook_hist +
+				(p - __hooks_init) * HOOK_HIST_BUCKETS;
+			for (b = 0; b < HOOK_HIST_BUCKETS && !hist[b]; b++)
+				;
+			if (b == HOOK_HIST_BUCKETS)
+				continue;
+
+			ccprintf("%3d %5d 0x%p", i, p->priority, p->routine);
+			for (b = 0; b < HOOK_HIST_BUCKETS; b++)
+				ccprintf(" %4d", hist[b]);
+			ccprintf("\n");
+		}
+		cflush();
+	}
+}
+
 static int command_stats(int argc, char **argv)
 {
 	int i;
@@ -278,6 +439,15 @@ static int command_stats(int argc, char **argv)
 			 (uint32_t)max_hook_run_time[i],
 			 (uint32_t)avg_hook_run_time[i]);
 
+	print_hook_hist();
+
+	ccprintf("\nDeferred routines (pending 0x%08x):\n", defer_pending);
+	ccprintf("  #    routine   calls   max delay   max run\n");
+	for (i = 0; i < DEFERRED_FUNCS_COUNT && i < DEFERRABLE_MAX_COUNT; i++)
+		ccprintf("%3d 0x%p %6d %7d us %5d us\n", i,
+			 __deferred_funcs[i].routine, deferred_call_count[i],
+			 max_deferred_delay[i], max_deferred_run_time[i]);
+
 	return EC_SUCCESS;
 }
 DECLARE_CONSOLE_COMMAND(hookstats, command_stats,
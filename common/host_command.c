@@ -371,6 +371,42 @@ host_packet_bad:
 	host_packet_respond(&args0);
 }
 
+/*
+ * Set once __hcmd_order[] lists the indices of __hcmds[] sorted by command
+ * number, so commands can be found with a binary search.
+ */
+static int hcmds_sorted;
+
+/**
+ * Fill in __hcmd_order[].
+ *
+ * Each command is stored at its rank, with commands registered twice kept in
+ * link order so the first one still wins.  Every store writes its final value,
+ * so it does not matter if two contexts race to do this.
+ *
+ * __hcmd_order[] entries are bytes; the linker scripts refuse to link more
+ * than 256 host commands.
+ */
+static void host_command_sort(void)
+{
+	const struct host_command *cmd, *other;
+	int rank;
+
+	ASSERT(__hcmds_end - __hcmds <= 256);
+
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		rank = 0;
+		for (other = __hcmds; other < __hcmds_end; other++) {
+			if (other->command < cmd->command ||
+			    (other->command == cmd->command && other < cmd))
+				rank++;
+		}
+		__hcmd_order[rank] = cmd - __hcmds;
+	}
+
+	hcmds_sorted = 1;
+}
+
 /**
  * Find a command by command number.
  *
@@ -380,15 +416,42 @@ host_packet_bad:
 static const struct host_command *find_host_command(int command)
 {
 	const struct host_command *cmd;
+	int lo = 0, hi = __hcmds_end - __hcmds;
+	int mid;
 
-	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
-		if (command == cmd->command)
-			return cmd;
+	if (!hcmds_sorted)
+		host_command_sort();
+
+	/* Find the first entry not below command */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (__hcmds[__hcmd_order[mid]].command < command)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	return NULL;
+	if (lo == __hcmds_end - __hcmds)
+		return NULL;
+	cmd = __hcmds + __hcmd_order[lo];
+	return cmd->command == command ? cmd : NULL;
 }
 
+#ifdef CONFIG_HOST_COMMAND_STATS
+static void host_command_update_stats(const struct host_command *cmd,
+				      int rv, uint32_t run_time)
+{
+	struct host_command_stats *s = __hcmd_stats + (cmd - __hcmds);
+
+	s->count++;
+	if (rv != EC_RES_SUCCESS)
+		s->errors++;
+	if (run_time > s->max_us)
+		s->max_us = run_time;
+	s->total_us += run_time;
+}
+#endif
+
 static void host_command_init(void)
 {
 	/* Initialize memory map ID area */
@@ -543,6 +606,51 @@ DECLARE_HOST_COMMAND(EC_CMD_GET_CMD_VERSIONS,
 		     host_command_get_cmd_versions,
 		     EC_VER_MASK(0) | EC_VER_MASK(1));
 
+#ifdef CONFIG_HOST_COMMAND_STATS
+static int host_command_get_cmd_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_get_cmd_stats *p = args->params;
+	struct ec_response_get_cmd_stats *r = args->response;
+	struct ec_cmd_stats_entry *e;
+	const struct host_command_stats *s;
+	int total = __hcmds_end - __hcmds;
+	int max_count, i;
+
+	if (args->response_max < sizeof(*r))
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	if (!hcmds_sorted)
+		host_command_sort();
+
+	max_count = (args->response_max - sizeof(*r)) / sizeof(*e);
+	if (max_count > 255)
+		max_count = 255;
+
+	r->total = total;
+	r->count = 0;
+	r->reserved = 0;
+	for (i = p->index; i < total && r->count < max_count; i++) {
+		e = r->entries + r->count++;
+		s = __hcmd_stats + __hcmd_order[i];
+		e->command = __hcmds[__hcmd_order[i]].command;
+		e->reserved = 0;
+		e->count = s->count;
+		e->errors = s->errors;
+		e->max_us = s->max_us;
+		e->avg_us = s->count ? s->total_us / s->count : 0;
+	}
+	args->response_size = sizeof(*r) + r->count * sizeof(*e);
+
+	if (p->flags & EC_CMD_STATS_FLAG_RESET)
+		memset(__hcmd_stats, 0, total * sizeof(*s));
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_GET_CMD_STATS,
+		     host_command_get_cmd_stats,
+		     EC_VER_MASK(0));
+#endif
+
 /**
  * Print debug output for the host command request, before it's processed.
  *
@@ -604,12 +712,24 @@ enum ec_status host_command_process(struct host_cmd_handler_args *args)
 #endif
 	{
 		cmd = find_host_command(args->command);
-		if (!cmd)
+		if (!cmd) {
 			rv = EC_RES_INVALID_COMMAND;
-		else if (!(EC_VER_MASK(args->version) & cmd->version_mask))
+		} else if (!(EC_VER_MASK(args->version) & cmd->version_mask)) {
 			rv = EC_RES_INVALID_VERSION;
-		else
+#ifdef CONFIG_HOST_COMMAND_STATS
+			host_command_update_stats(cmd, rv, 0);
+#endif
+		} else {
+#ifdef CONFIG_HOST_COMMAND_STATS
+			uint32_t t = get_time().le.lo;
+
 			rv = cmd->handler(args);
+			host_command_update_stats(cmd, rv,
+						  get_time().le.lo - t);
+#else
+			rv = cmd->handler(args);
+#endif
+		}
 	}
 
 	if (rv != EC_RES_SUCCESS)
@@ -904,3 +1024,39 @@ DECLARE_CONSOLE_COMMAND(hcdebug, command_hcdebug,
 			"hcdebug [off | normal | every | params]",
 			"Set host command debug output mode",
 			NULL);
+
+#ifdef CONFIG_HOST_COMMAND_STATS
+static int command_hcstats(int argc, char **argv)
+{
+	const struct host_command_stats *s;
+	int total = __hcmds_end - __hcmds;
+	int i;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		memset(__hcmd_stats, 0, total * sizeof(*s));
+		return EC_SUCCESS;
+	}
+
+	if (!hcmds_sorted)
+		host_command_sort();
+
+	ccputs("Command   Count  Errors  Max us  Avg us\n");
+	for (i = 0; i < total; i++) {
+		s = __hcmd_stats + __hcmd_order[i];
+		if (!s->count)
+			continue;
+		ccprintf("0x%04x %8d %7d %7d %7d\n",
+			 __hcmds[__hcmd_order[i]].command, s->count,
+			 s->errors, s->max_us, s->total_us / s->count);
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(hcstats, command_hcstats,
+			"[reset]",
+			"Print or clear host command statistics",
+			NULL);
+#endif
@@ -13,6 +13,7 @@
 #include "i2c.h"
 #include "system.h"
 #include "task.h"
+#include "timer.h"
 #include "util.h"
 #include "watchdog.h"
 
@@ -33,11 +34,32 @@
 
 static struct mutex port_mutex[I2C_CONTROLLER_COUNT];
 
+#ifdef CONFIG_I2C_STATS
+struct i2c_stats {
+	uint32_t xfers;         /* Transfers, including failed ones */
+	uint32_t errors;        /* Failed transfers */
+	uint32_t bytes;         /* Bytes sent and received */
+	uint32_t xfer_max;      /* Longest transfer, in us */
+	uint32_t locks;         /* Times the port was locked */
+	uint32_t wait_max;      /* Longest wait for the port lock, in us */
+	uint64_t xfer_total;    /* Time spent in transfers, in us */
+	uint64_t wait_total;    /* Time spent waiting for the lock, in us */
+};
+
+static struct i2c_stats port_stats[I2C_PORT_COUNT];
+static uint64_t stats_start;    /* Time the stats were last cleared */
+#endif
+
 int i2c_xfer(int port, int slave_addr, const uint8_t *out, int out_size,
 	     uint8_t *in, int in_size, int flags)
 {
 	int i;
 	int ret = EC_SUCCESS;
+#ifdef CONFIG_I2C_STATS
+	uint64_t t0 = get_time().val;
+	struct i2c_stats *s;
+	uint32_t t;
+#endif
 
 	for (i = 0; i <= CONFIG_I2C_NACK_RETRY_COUNT; i++) {
 		ret = chip_i2c_xfer(port, slave_addr, out, out_size, in,
@@ -45,11 +67,31 @@ int i2c_xfer(int port, int slave_addr, const uint8_t *out, int out_size,
 		if (ret != EC_ERROR_BUSY)
 			break;
 	}
+
+#ifdef CONFIG_I2C_STATS
+	/* Called with the port locked, so no one else updates these */
+	if (port < I2C_PORT_COUNT) {
+		s = port_stats + port;
+		t = get_time().val - t0;
+		s->xfers++;
+		s->bytes += out_size + in_size;
+		s->xfer_total += t;
+		if (t > s->xfer_max)
+			s->xfer_max = t;
+		if (ret)
+			s->errors++;
+	}
+#endif
 	return ret;
 }
 
 void i2c_lock(int port, int lock)
 {
+#ifdef CONFIG_I2C_STATS
+	struct i2c_stats *s = port_stats + port;
+	uint64_t t0 = get_time().val;
+	uint32_t t;
+#endif
 #ifdef CONFIG_I2C_MULTI_PORT_CONTROLLER
 	/* Lock the controller, not the port */
 	port = i2c_port_to_controller(port);
@@ -60,6 +102,15 @@ void i2c_lock(int port, int lock)
 		disable_sleep(SLEEP_MASK_I2C);
 
 		mutex_lock(port_mutex + port);
+#ifdef CONFIG_I2C_STATS
+		if (s < port_stats + I2C_PORT_COUNT) {
+			t = get_time().val - t0;
+			s->locks++;
+			s->wait_total += t;
+			if (t > s->wait_max)
+				s->wait_max = t;
+		}
+#endif
 	} else {
 		mutex_unlock(port_mutex + port);
 
@@ -77,135 +128,126 @@ void i2c_prepare_sysjump(void)
 		i2c_lock(i2c_ports[i].port, 1);
 }
 
-int i2c_read32(int port, int slave_addr, int offset, int *data)
+int i2c_xfer_ops(int port, int slave_addr, struct i2c_op *ops, int count)
 {
-	int rv;
-	uint8_t reg, buf[sizeof(uint32_t)];
-
-	reg = offset & 0xff;
-	/* I2C read 32-bit word: transmit 8-bit offset, and read 32bits */
-	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, &reg, 1, buf, sizeof(uint32_t),
-		      I2C_XFER_SINGLE);
-	i2c_lock(port, 0);
-
-	if (rv)
-		return rv;
+	uint8_t out[1 + sizeof(uint32_t)];
+	/* Separate buffer so it's aligned for DMA on STM32 */
+	uint8_t in[sizeof(uint32_t)] __aligned(4);
+	int i, size, rv;
+	uint32_t v;
+
+	for (; count > 0; count--, ops++) {
+		size = ops->type & ~I2C_OP_WRITE;
+		out[0] = ops->offset;
+
+		if (ops->type & I2C_OP_WRITE) {
+			v = ops->data;
+			for (i = 0; i < size; i++, v >>= 8) {
+				if (slave_addr & I2C_FLAG_BIG_ENDIAN)
+					out[size - i] = v & 0xff;
+				else
+					out[1 + i] = v & 0xff;
+			}
+			rv = i2c_xfer(port, slave_addr, out, 1 + size, NULL, 0,
+				      I2C_XFER_SINGLE);
+		} else {
+			/* Transmit 8-bit offset, and read the register */
+			rv = i2c_xfer(port, slave_addr, out, 1, in, size,
+				      I2C_XFER_SINGLE);
+			for (i = 0, v = 0; i < size; i++) {
+				if (slave_addr & I2C_FLAG_BIG_ENDIAN)
+					v = (v << 8) | in[i];
+				else
+					v |= (uint32_t)in[i] << (8 * i);
+			}
+			if (!rv)
+				ops->data = v;
+		}
 
-	if (slave_addr & I2C_FLAG_BIG_ENDIAN)
-		*data = ((int)buf[0] << 24) | ((int)buf[1] << 16) |
-			((int)buf[0] << 8) | buf[1];
-	else
-		*data = ((int)buf[3] << 24) | ((int)buf[2] << 16) |
-			((int)buf[1] << 8) | buf[0];
+		if (rv)
+			return rv;
+	}
 
 	return EC_SUCCESS;
 }
 
-int i2c_write32(int port, int slave_addr, int offset, int data)
+int i2c_batch(int port, int slave_addr, struct i2c_op *ops, int count)
 {
 	int rv;
-	uint8_t buf[1 + sizeof(uint32_t)];
-
-	buf[0] = offset & 0xff;
-
-	if (slave_addr & I2C_FLAG_BIG_ENDIAN) {
-		buf[1] = (data >> 24) & 0xff;
-		buf[2] = (data >> 16) & 0xff;
-		buf[3] = (data >> 8) & 0xff;
-		buf[4] = data & 0xff;
-	} else {
-		buf[1] = data & 0xff;
-		buf[2] = (data >> 8) & 0xff;
-		buf[3] = (data >> 16) & 0xff;
-		buf[4] = (data >> 24) & 0xff;
-	}
 
 	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, buf, sizeof(uint32_t) + 1, NULL, 0,
-		      I2C_XFER_SINGLE);
+	rv = i2c_xfer_ops(port, slave_addr, ops, count);
 	i2c_lock(port, 0);
 
 	return rv;
 }
 
-int i2c_read16(int port, int slave_addr, int offset, int *data)
+/**
+ * Read one register.
+ *
+ * @param type		I2C_OP_READ8/16/32
+ * @return EC_SUCCESS, or non-zero if error; *data is only set on success.
+ */
+static int i2c_read_reg(int port, int slave_addr, int type, int offset,
+			int *data)
 {
+	struct i2c_op op;
 	int rv;
-	uint8_t reg, buf[sizeof(uint16_t)];
 
-	reg = offset & 0xff;
-	/* I2C read 16-bit word: transmit 8-bit offset, and read 16bits */
-	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, &reg, 1, buf, sizeof(uint16_t),
-		      I2C_XFER_SINGLE);
-	i2c_lock(port, 0);
-
-	if (rv)
-		return rv;
-
-	if (slave_addr & I2C_FLAG_BIG_ENDIAN)
-		*data = ((int)buf[0] << 8) | buf[1];
-	else
-		*data = ((int)buf[1] << 8) | buf[0];
+	op.type = type;
+	op.offset = offset;
+	rv = i2c_batch(port, slave_addr, &op, 1);
+	if (!rv)
+		*data = op.data;
 
-	return EC_SUCCESS;
+	return rv;
 }
 
-int i2c_write16(int port, int slave_addr, int offset, int data)
+/**
+ * Write one register.
+ *
+ * @param type		I2C_OP_WRITE8/16/32
+ */
+static int i2c_write_reg(int port, int slave_addr, int type, int offset,
+			 int data)
 {
-	int rv;
-	uint8_t buf[1 + sizeof(uint16_t)];
-
-	buf[0] = offset & 0xff;
-
-	if (slave_addr & I2C_FLAG_BIG_ENDIAN) {
-		buf[1] = (data >> 8) & 0xff;
-		buf[2] = data & 0xff;
-	} else {
-		buf[1] = data & 0xff;
-		buf[2] = (data >> 8) & 0xff;
-	}
+	struct i2c_op op;
 
-	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, buf, 1 + sizeof(uint16_t), NULL, 0,
-		      I2C_XFER_SINGLE);
-	i2c_lock(port, 0);
+	op.type = type;
+	op.offset = offset;
+	op.data = data;
 
-	return rv;
+	return i2c_batch(port, slave_addr, &op, 1);
 }
 
-int i2c_read8(int port, int slave_addr, int offset, int *data)
+int i2c_read32(int port, int slave_addr, int offset, int *data)
 {
-	int rv;
-	/* We use buf[1] here so it's aligned for DMA on STM32 */
-	uint8_t reg, buf[1];
+	return i2c_read_reg(port, slave_addr, I2C_OP_READ32, offset, data);
+}
 
-	reg = offset;
+int i2c_write32(int port, int slave_addr, int offset, int data)
+{
+	return i2c_write_reg(port, slave_addr, I2C_OP_WRITE32, offset, data);
+}
 
-	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, &reg, 1, buf, 1, I2C_XFER_SINGLE);
-	i2c_lock(port, 0);
+int i2c_read16(int port, int slave_addr, int offset, int *data)
+{
+	return i2c_read_reg(port, slave_addr, I2C_OP_READ16, offset, data);
+}
 
-	if (!rv)
-		*data = buf[0];
+int i2c_write16(int port, int slave_addr, int offset, int data)
+{
+	return i2c_write_reg(port, slave_addr, I2C_OP_WRITE16, offset, data);
+}
 
-	return rv;
+int i2c_read8(int port, int slave_addr, int offset, int *data)
+{
+	return i2c_read_reg(port, slave_addr, I2C_OP_READ8, offset, data);
 }
 
 int i2c_write8(int port, int slave_addr, int offset, int data)
 {
-	int rv;
-	uint8_t buf[2];
-
-	buf[0] = offset;
-	buf[1] = data;
-
-	i2c_lock(port, 1);
-	rv = i2c_xfer(port, slave_addr, buf, 2, 0, 0, I2C_XFER_SINGLE);
-	i2c_lock(port, 0);
-
-	return rv;
+	return i2c_write_reg(port, slave_addr, I2C_OP_WRITE8, offset, data);
 }
 
 int i2c_read_string(int port, int slave_addr, int offset, uint8_t *data,
@@ -815,3 +857,45 @@ DECLARE_CONSOLE_COMMAND(i2cxfer, command_i2cxfer,
 			"Read write I2C",
 			NULL);
 #endif
+
+#ifdef CONFIG_I2C_STATS
+static int command_i2cstats(int argc, char **argv)
+{
+	uint64_t elapsed = get_time().val - stats_start;
+	struct i2c_stats *s;
+	int i, port;
+
+	if (argc == 2 && !strcasecmp(argv[1], "clear")) {
+		memset(port_stats, 0, sizeof(port_stats));
+		stats_start = get_time().val;
+		return EC_SUCCESS;
+	} else if (argc > 1) {
+		return EC_ERROR_PARAM1;
+	}
+
+	ccprintf("Stats over %.6ld s\n", elapsed);
+	ccputs("Port Name         Xfers  Errors   Bytes  Busy%  "
+	       "Xfer avg/max (us)  Lock wait avg/max (us)\n");
+	for (i = 0; i < i2c_ports_used; i++) {
+		port = i2c_ports[i].port;
+		if (port >= I2C_PORT_COUNT)
+			continue;
+		s = port_stats + port;
+		ccprintf("%4d %-10s %7d %7d %7d %5d  %8d/%-8d  %10d/%d\n",
+			 port, i2c_ports[i].name, s->xfers, s->errors,
+			 s->bytes,
+			 elapsed ? (int)(s->xfer_total * 100 / elapsed) : 0,
+			 s->xfers ? (int)(s->xfer_total / s->xfers) : 0,
+			 s->xfer_max,
+			 s->locks ? (int)(s->wait_total / s->locks) : 0,
+			 s->wait_max);
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(i2cstats, command_i2cstats,
+			"[clear]",
+			"Show I2C bus utilization and latency",
+			NULL);
+#endif
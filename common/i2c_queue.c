@@ -0,0 +1,86 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Background queue of I2C register accesses for Chrome EC */
+
+#include "common.h"
+#include "hooks.h"
+#include "i2c.h"
+#include "task.h"
+#include "util.h"
+
+/* Requests pending on each port, oldest first */
+static struct i2c_request *queue_head[I2C_PORT_COUNT];
+static struct i2c_request *queue_tail[I2C_PORT_COUNT];
+
+/**
+ * Run all requests pending on a port.
+ *
+ * @return non-zero if any requests were run.
+ */
+static int i2c_queue_run_port(int port)
+{
+	struct i2c_request *req, *next;
+
+	/* Take the whole queue; new requests start a new one */
+	interrupt_disable();
+	req = queue_head[port];
+	queue_head[port] = queue_tail[port] = NULL;
+	interrupt_enable();
+
+	if (!req)
+		return 0;
+
+	/* Back-to-back, under one lock of the port */
+	i2c_lock(port, 1);
+	for (next = req; next; next = next->next)
+		next->rv = i2c_xfer_ops(port, next->slave_addr, next->ops,
+					next->count);
+	i2c_lock(port, 0);
+
+	/* A done() routine may submit its request again, so get next first */
+	for (; req; req = next) {
+		next = req->next;
+		if (req->done)
+			req->done(req);
+	}
+
+	return 1;
+}
+
+static void i2c_queue_run(void)
+{
+	int port, busy;
+
+	do {
+		busy = 0;
+		for (port = 0; port < I2C_PORT_COUNT; port++)
+			busy |= i2c_queue_run_port(port);
+	} while (busy);
+}
+DECLARE_DEFERRED(i2c_queue_run);
+
+int i2c_submit(struct i2c_request *req)
+{
+	int port = req->port;
+
+	if (port < 0 || port >= I2C_PORT_COUNT)
+		return EC_ERROR_INVAL;
+
+	req->next = NULL;
+	req->rv = EC_ERROR_BUSY;
+
+	interrupt_disable();
+	if (queue_tail[port])
+		queue_tail[port]->next = req;
+	else
+		queue_head[port] = req;
+	queue_tail[port] = req;
+	interrupt_enable();
+
+	hook_call_deferred(&i2c_queue_run_data, 0);
+
+	return EC_SUCCESS;
+}
@@ -144,15 +144,27 @@ static inline uint8_t scale(int val, int max)
 /* Helper function to set one LED color and remember it for later */
 static void setrgb(int led, int red, int green, int blue)
 {
+	struct i2c_op ops[3];
 	int ctrl, bank;
 	current[led][0] = red;
 	current[led][1] = green;
 	current[led][2] = blue;
 	ctrl = led_to_ctrl[led];
 	bank = led_to_isc[led];
-	controller_write(ctrl, bank, scale(blue, MAX_BLUE));
-	controller_write(ctrl, bank+1, scale(red, MAX_RED));
-	controller_write(ctrl, bank+2, scale(green, MAX_GREEN));
+
+	/*
+	 * One batch: the port is locked once for the LED, but these are
+	 * still three separate I2C writes, so the color changes one channel
+	 * at a time.
+	 */
+	ops[0].type = ops[1].type = ops[2].type = I2C_OP_WRITE8;
+	ops[0].offset = bank;
+	ops[0].data = scale(blue, MAX_BLUE);
+	ops[1].offset = bank + 1;
+	ops[1].data = scale(red, MAX_RED);
+	ops[2].offset = bank + 2;
+	ops[2].data = scale(green, MAX_GREEN);
+	i2c_batch(I2C_PORT_LIGHTBAR, i2c_addr[ctrl], ops, ARRAY_SIZE(ops));
 }
 
 /* LEDs are numbered 0-3, RGB values should be in 0-255.
@@ -38,7 +38,7 @@ BUILD_ASSERT(ARRAY_SIZE(cos_lut) == COSINE_LUT_SIZE);
 
 fp_t arc_cos(fp_t x)
 {
-	int i;
+	int lo = 0, hi = COSINE_LUT_SIZE - 1, mid;
 
 	/* Cap x if out of range. */
 	if (x < FLOAT_TO_FP(-1.0))
@@ -46,70 +46,70 @@ fp_t arc_cos(fp_t x)
 	else if (x > FLOAT_TO_FP(1.0))
 		x = FLOAT_TO_FP(1.0);
 
-	/*
-	 * Increment through lookup table to find index and then linearly
-	 * interpolate for precision.
-	 */
-	/* TODO(crosbug.com/p/25600): Optimize with binary search. */
-	for (i = 0; i < COSINE_LUT_SIZE-1; i++) {
-		if (x >= cos_lut[i+1]) {
-			const fp_t interp = fp_div(cos_lut[i] - x,
-						   cos_lut[i] - cos_lut[i + 1]);
-
-			return fp_mul(INT_TO_FP(COSINE_LUT_INCR_DEG),
-				      INT_TO_FP(i) + interp);
-		}
+	/* Binary search for the entries around x; cos_lut[] is decreasing */
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (x >= cos_lut[mid])
+			hi = mid;
+		else
+			lo = mid;
 	}
 
 	/*
-	 * Shouldn't be possible to get here because inputs are clipped to
-	 * [-1, 1] and the cos_lut[] table goes over the same range. If we
-	 * are here, throw an assert.
+	 * Linearly interpolate for precision.  Entries are at most 0.0872
+	 * apart, so the product fits in 32 bits and needs no 64-bit divide.
 	 */
-	ASSERT(0);
-
-	return 0;
+	return INT_TO_FP(COSINE_LUT_INCR_DEG * lo) +
+		(cos_lut[lo] - x) * INT_TO_FP(COSINE_LUT_INCR_DEG) /
+		(cos_lut[lo] - cos_lut[hi]);
 }
 
 /**
- * Integer square root.
+ * Integer square root of a 32-bit value, one bit of the result at a time.
  */
-int int_sqrtf(int64_t x)
+static uint32_t int_sqrt32(uint32_t x)
 {
-	int rmax = 0x7fffffff;
-	int rmin = 0;
+	uint32_t r = 0;
+	/* Highest power of 4 not greater than x */
+	uint32_t bit = (1u << 30) >> (__builtin_clz(x) & ~1);
+
+	while (bit) {
+		if (x >= r + bit) {
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
 
-	/* Short cut if x is 32-bit value */
-	if (x < rmax)
-		rmax = 0x7fff;
+	return r;
+}
+
+int int_sqrtf(int64_t x)
+{
+	uint64_t v = x, r = 0, bit;
 
-	/*
-	 * Just binary-search.  There are better algorithms, but we call this
-	 * infrequently enough it doesn't matter.
-	 */
 	if (x <= 0)
 		return 0;  /* Yeah, for imaginary numbers too */
-	else if (x > (int64_t)rmax * rmax)
-		return rmax;
-
-	while (1) {
-		int r = (rmax + rmin) / 2;
-		int64_t r2 = (int64_t)r * r;
-
-		if (r2 > x) {
-			/* Guessed too high */
-			rmax = r;
-		} else if (r2 < x) {
-			/* Guessed too low.  Watch out for rounding! */
-			if (rmin == r)
-				return r;
-
-			rmin = r;
+	if (x <= 0xffffffff)
+		return int_sqrt32(x);
+	if (x >= 0x7fffffffll * 0x7fffffffll)
+		return 0x7fffffff;
+
+	/* Same as int_sqrt32(), on 64 bits */
+	bit = (1ull << 62) >> (__builtin_clzll(v) & ~1);
+	while (bit) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
 		} else {
-			/* Bullseye! */
-			return r;
+			r >>= 1;
 		}
+		bit >>= 2;
 	}
+
+	return r;
 }
 
 int vector_magnitude(const vector_3_t v)
@@ -164,21 +164,73 @@ fp_t cosine_of_angle_diff(const vector_3_t v1, const vector_3_t v2)
  */
 void rotate(const vector_3_t v, const matrix_3x3_t R, vector_3_t res)
 {
+	rotate_n((const vector_3_t *)v, R, (vector_3_t *)res, 1);
+}
+
+void rotate_n(const vector_3_t *v, const matrix_3x3_t R, vector_3_t *res,
+	      int n)
+{
+	/* Load the matrix once for all the vectors */
+	const fp_t r00 = R[0][0], r01 = R[0][1], r02 = R[0][2];
+	const fp_t r10 = R[1][0], r11 = R[1][1], r12 = R[1][2];
+	const fp_t r20 = R[2][0], r21 = R[2][1], r22 = R[2][2];
 	int64_t t[3];
 
-	/* Rotate */
-	t[0] =	(int64_t)v[0] * R[0][0] +
-		(int64_t)v[1] * R[1][0] +
-		(int64_t)v[2] * R[2][0];
-	t[1] =	(int64_t)v[0] * R[0][1] +
-		(int64_t)v[1] * R[1][1] +
-		(int64_t)v[2] * R[2][1];
-	t[2] =	(int64_t)v[0] * R[0][2] +
-		(int64_t)v[1] * R[1][2] +
-		(int64_t)v[2] * R[2][2];
-
-	/* Scale by fixed point shift when writing back to result */
-	res[0] = t[0] >> FP_BITS;
-	res[1] = t[1] >> FP_BITS;
-	res[2] = t[2] >> FP_BITS;
+	for (; n > 0; n--, v++, res++) {
+		/* Rotate */
+		t[0] =	(int64_t)(*v)[0] * r00 +
+			(int64_t)(*v)[1] * r10 +
+			(int64_t)(*v)[2] * r20;
+		t[1] =	(int64_t)(*v)[0] * r01 +
+			(int64_t)(*v)[1] * r11 +
+			(int64_t)(*v)[2] * r21;
+		t[2] =	(int64_t)(*v)[0] * r02 +
+			(int64_t)(*v)[1] * r12 +
+			(int64_t)(*v)[2] * r22;
+
+		/* Scale by fixed point shift when writing back to result */
+		(*res)[0] = t[0] >> FP_BITS;
+		(*res)[1] = t[1] >> FP_BITS;
+		(*res)[2] = t[2] >> FP_BITS;
+	}
+}
+
+void unit_vectors(const vector_3_t *v, vector_3_t *res, int n)
+{
+	int64_t sumsq, inv;
+	int i, mag, shift;
+
+	for (; n > 0; n--, v++, res++) {
+		sumsq =	(int64_t)(*v)[0] * (*v)[0] +
+			(int64_t)(*v)[1] * (*v)[1] +
+			(int64_t)(*v)[2] * (*v)[2];
+		if (!sumsq) {
+			(*res)[0] = (*res)[1] = (*res)[2] = 0;
+			continue;
+		}
+
+		/*
+		 * Scale short vectors up so the magnitude keeps at least 15
+		 * significant bits, while still taking the 32-bit square root.
+		 */
+		shift = sumsq <= 0xffffffff ?
+			(__builtin_clzll(sumsq) - 32) / 2 : 0;
+		mag = int_sqrtf(sumsq << (2 * shift));
+
+		/* One divide per vector; then multiply by 2^38 / |v| */
+		inv = (1ll << (38 + shift)) / mag;
+		for (i = 0; i < 3; i++)
+			(*res)[i] = ((*v)[i] * inv) >>
+				(38 - UNIT_VECTOR_BITS);
+	}
+}
+
+fp_t cosine_of_unit_vectors(const vector_3_t u1, const vector_3_t u2)
+{
+	/*
+	 * Each product, and every partial sum, is at most |u1|*|u2| = 2^30,
+	 * so this fits in 32 bits.
+	 */
+	return (u1[0] * u2[0] + u1[1] * u2[1] + u1[2] * u2[2]) >>
+		(2 * UNIT_VECTOR_BITS - FP_BITS);
 }
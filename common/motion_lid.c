@@ -60,7 +60,8 @@ struct motion_sensor_t *accel_lid =
 static int calculate_lid_angle(const vector_3_t base, const vector_3_t lid,
 			       int *lid_angle)
 {
-	vector_3_t v;
+	/* Unit vectors of base, lid and hinge, then rotated base */
+	vector_3_t u[4];
 	fp_t ang_lid_to_base, cos_lid_90, cos_lid_270;
 	fp_t lid_to_base, base_to_hinge;
 	fp_t denominator;
@@ -72,9 +73,17 @@ static int calculate_lid_angle(const vector_3_t base, const vector_3_t lid,
 	 * where cad() is the cosine_of_angle_diff() function.
 	 *
 	 * Make sure to check for divide by 0.
+	 *
+	 * Scale all the vectors to unit length once, so each cosine is just a
+	 * dot product.
 	 */
-	lid_to_base = cosine_of_angle_diff(base, lid);
-	base_to_hinge = cosine_of_angle_diff(base, p_acc_orient->hinge_axis);
+	memcpy(u[0], base, sizeof(vector_3_t));
+	memcpy(u[1], lid, sizeof(vector_3_t));
+	memcpy(u[2], p_acc_orient->hinge_axis, sizeof(vector_3_t));
+	unit_vectors(u, u, 3);
+
+	lid_to_base = cosine_of_unit_vectors(u[0], u[1]);
+	base_to_hinge = cosine_of_unit_vectors(u[0], u[2]);
 
 	/*
 	 * If hinge aligns too closely with gravity, then result may be
@@ -106,10 +115,10 @@ static int calculate_lid_angle(const vector_3_t base, const vector_3_t lid,
 	 * closer. If the lid is closer to the estimated 270 degree vector then
 	 * the result is negative, otherwise it is positive.
 	 */
-	rotate(base, p_acc_orient->rot_hinge_90, v);
-	cos_lid_90 = cosine_of_angle_diff(v, lid);
-	rotate(v, p_acc_orient->rot_hinge_180, v);
-	cos_lid_270 = cosine_of_angle_diff(v, lid);
+	rotate(u[0], p_acc_orient->rot_hinge_90, u[3]);
+	cos_lid_90 = cosine_of_unit_vectors(u[3], u[1]);
+	rotate(u[3], p_acc_orient->rot_hinge_180, u[3]);
+	cos_lid_270 = cosine_of_unit_vectors(u[3], u[1]);
 
 	/*
 	 * Note that cos_lid_90 and cos_lid_270 are not in degrees, because
@@ -0,0 +1,95 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Mutex statistics for Chrome EC */
+
+#include "common.h"
+#include "console.h"
+#include "task.h"
+#include "timer.h"
+#include "util.h"
+
+/* Mutexes which have been locked at least once, most recent first */
+static struct mutex *mutex_list;
+
+void mutex_stats_locked(struct mutex *mtx, uint64_t wait_start,
+			int contended)
+{
+	struct mutex_stats *s = &mtx->stats;
+	uint64_t t = get_time().val;
+	uint32_t wait = t - wait_start;
+
+	/* Add the mutex to the list the first time it is locked */
+	if (!s->locks) {
+		interrupt_disable();
+		s->next = mutex_list;
+		mutex_list = mtx;
+		interrupt_enable();
+	}
+
+	s->locks++;
+	if (contended) {
+		s->contentions++;
+		s->wait_total += wait;
+		if (wait > s->wait_max)
+			s->wait_max = wait;
+	}
+	s->locked_at = t;
+}
+
+void mutex_stats_unlocked(struct mutex *mtx)
+{
+	struct mutex_stats *s = &mtx->stats;
+	uint32_t hold = get_time().val - s->locked_at;
+
+	s->hold_total += hold;
+	if (hold > s->hold_max)
+		s->hold_max = hold;
+}
+
+void mutex_stats_timeout(struct mutex *mtx)
+{
+	mtx->stats.timeouts++;
+}
+
+static int command_mutex_stats(int argc, char **argv)
+{
+	struct mutex *mtx;
+	struct mutex_stats *s;
+
+	if (argc == 2 && !strcasecmp(argv[1], "clear")) {
+		for (mtx = mutex_list; mtx; mtx = mtx->stats.next) {
+			s = &mtx->stats;
+			s->contentions = s->timeouts = 0;
+			s->wait_max = s->hold_max = 0;
+			s->wait_total = s->hold_total = 0;
+			/* Non-zero, so the mutex is not added to the list again */
+			s->locks = 1;
+		}
+		return EC_SUCCESS;
+	} else if (argc > 1) {
+		return EC_ERROR_PARAM1;
+	}
+
+	ccputs("Mutex      Owner Locks  Contended Timeouts  "
+	       "Wait avg/max (us)  Hold avg/max (us)\n");
+	for (mtx = mutex_list; mtx; mtx = mtx->stats.next) {
+		s = &mtx->stats;
+		ccprintf("%08x %5d %6d %9d %8d %9d/%-8d %9d/%d\n",
+			 (uint32_t)(uintptr_t)mtx, mtx->lock ? mtx->owner : -1,
+			 s->locks, s->contentions, s->timeouts,
+			 s->contentions ?
+			 (int)(s->wait_total / s->contentions) : 0,
+			 s->wait_max,
+			 (int)(s->hold_total / s->locks), s->hold_max);
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(mutexstats, command_mutex_stats,
+			"[clear]",
+			"Print or clear mutex statistics",
+			NULL);
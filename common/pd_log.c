@@ -12,79 +12,124 @@
 #include "usb_pd.h"
 #include "util.h"
 
-/* Event log FIFO */
-#define UNIT_SIZE sizeof(struct ec_response_pd_log)
-#define LOG_SIZE (CONFIG_USB_PD_LOG_SIZE/UNIT_SIZE)
-static struct ec_response_pd_log log_events[LOG_SIZE];
+/* Event log FIFO, in bytes */
+#define LOG_SIZE CONFIG_USB_PD_LOG_SIZE
+static uint8_t log_events[LOG_SIZE];
 BUILD_ASSERT(POWER_OF_TWO(LOG_SIZE));
 /*
- * The FIFO pointers are defined as following :
+ * Each entry is stored as the time elapsed since the previous entry,
+ * followed by the type, size_port and data fields of the event and its
+ * payload, without any padding.  The time is zigzag then varint encoded, so
+ * the close events of a burst only take 1 or 2 bytes of timestamp.
+ *
+ * The FIFO pointers are byte offsets, defined as following :
  * "log_head" is the next available event to dequeue.
- * "log_tail" is marking the end of the FIFO content (after last commited event)
- * "log_tail_next" is the next available spot to enqueue events.
+ * "log_tail" is marking the end of the FIFO content.
  * The pointers are not wrapped until they are used, so we don't need an extra
- * entry to disambiguate between full and empty FIFO.
+ * byte to disambiguate between full and empty FIFO.
+ * "log_head_time" is the timestamp the first entry is relative to, and
+ * "log_tail_time" the timestamp of the last entry.
  *
  * For concurrency, several tasks might try to enqueue events in parallel with
  * pd_log_event(). Only one task is dequeuing events (host commands or VDM).
- * When the FIFO is full, pd_log_event() will discard the oldest events,
- * so "log_head" is incremented/decremented in a critical section since it is
- * accessed from both pd_log_event() and pd_log_dequeue().
- * log_tail_next is also protected as several writers can race to add an event
- * to the queue.
- * When a writer is done adding its event, it is updating log_tail,
- * so the event can be consumed by pd_log_dequeue().
+ * When the FIFO is full, pd_log_event() discards the oldest events and
+ * counts them in "log_dropped".  As each entry depends on the one before
+ * it, the FIFO is only updated in critical sections, which are short since
+ * an entry is at most DELTA_MAX_SIZE + HEADER_SIZE + 31 bytes.
  */
 static size_t log_head;
 static size_t log_tail;
-static size_t log_tail_next;
+static uint32_t log_head_time;
+static uint32_t log_tail_time;
+static uint32_t log_dropped;
+
+/* Longest encoding of a timestamp delta */
+#define DELTA_MAX_SIZE 5
+/* Size of the type, size_port and data fields of an entry */
+#define HEADER_SIZE 4
+/* Dropping old entries must be able to make room for the largest one */
+BUILD_ASSERT(LOG_SIZE >= DELTA_MAX_SIZE + HEADER_SIZE + PD_LOG_SIZE_MASK);
+
+static void log_write(size_t pos, const uint8_t *data, size_t size)
+{
+	while (size--)
+		log_events[pos++ & (LOG_SIZE - 1)] = *data++;
+}
+
+static void log_read(size_t pos, uint8_t *data, size_t size)
+{
+	while (size--)
+		*data++ = log_events[pos++ & (LOG_SIZE - 1)];
+}
+
+/* Encode a timestamp delta, return its size */
+static int delta_encode(uint8_t *buf, int32_t delta)
+{
+	/* Zigzag, so small negative deltas are short too */
+	uint32_t v = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+	int n = 0;
+
+	while (v >= 0x80) {
+		buf[n++] = v | 0x80;
+		v >>= 7;
+	}
+	buf[n++] = v;
+	return n;
+}
+
+/* Decode the timestamp delta of the entry at pos, return its size */
+static int delta_decode(size_t pos, int32_t *delta)
+{
+	uint32_t v = 0;
+	uint8_t b;
+	int n = 0;
+
+	do {
+		b = log_events[(pos + n) & (LOG_SIZE - 1)];
+		v |= (uint32_t)(b & 0x7f) << (7 * n);
+		n++;
+	} while (b & 0x80);
+	*delta = (v >> 1) ^ -(v & 1);
+	return n;
+}
 
-/* Size of one FIFO entry */
-#define ENTRY_SIZE(payload_sz) (1+DIV_ROUND_UP((payload_sz), UNIT_SIZE))
+/* Discard the oldest entry, called with interrupts disabled */
+static void log_drop_oldest(void)
+{
+	int32_t delta;
+	size_t pos = log_head + delta_decode(log_head, &delta);
+	uint8_t size_port = log_events[(pos + 1) & (LOG_SIZE - 1)];
+
+	log_head_time += delta;
+	log_head = pos + HEADER_SIZE + PD_LOG_SIZE(size_port);
+	log_dropped++;
+}
 
 static void log_add_event(uint8_t type, uint8_t size_port, uint16_t data,
 			  void *payload, uint32_t timestamp)
 {
-	struct ec_response_pd_log *r;
-	size_t payload_size = PD_LOG_SIZE(size_port);
-	size_t total_size = ENTRY_SIZE(payload_size);
-	size_t current_tail, first;
+	uint8_t entry[HEADER_SIZE + PD_LOG_SIZE_MASK];
+	uint8_t delta[DELTA_MAX_SIZE];
+	size_t entry_size = HEADER_SIZE + PD_LOG_SIZE(size_port);
+	int delta_size;
 
-	/* --- critical section : reserve queue space --- */
+	entry[0] = type;
+	entry[1] = size_port;
+	memcpy(entry + 2, &data, sizeof(data));
+	memcpy(entry + HEADER_SIZE, payload, PD_LOG_SIZE(size_port));
+
+	/* --- critical section : append the entry --- */
 	interrupt_disable();
-	current_tail = log_tail_next;
-	log_tail_next = current_tail + total_size;
+	delta_size = delta_encode(delta, timestamp - log_tail_time);
+	/* Out of space : discard the oldest entries */
+	while (LOG_SIZE - (log_tail - log_head) < delta_size + entry_size)
+		log_drop_oldest();
+	log_write(log_tail, delta, delta_size);
+	log_write(log_tail + delta_size, entry, entry_size);
+	log_tail += delta_size + entry_size;
+	log_tail_time = timestamp;
 	interrupt_enable();
 	/* --- end of critical section --- */
-
-	/* Out of space : discard the oldest entry */
-	while ((LOG_SIZE - (current_tail - log_head)) < total_size) {
-		struct ec_response_pd_log *oldest;
-		/* --- critical section : atomically free-up space --- */
-		interrupt_disable();
-		oldest = log_events + (log_head & (LOG_SIZE - 1));
-		log_head += ENTRY_SIZE(PD_LOG_SIZE(oldest->size_port));
-		interrupt_enable();
-		/* --- end of critical section --- */
-	}
-
-	r = log_events + (current_tail & (LOG_SIZE - 1));
-
-	r->timestamp = timestamp;
-	r->type = type;
-	r->size_port = size_port;
-	r->data = data;
-	/* copy the payload into the FIFO */
-	first = MIN(total_size - 1, (LOG_SIZE -
-		    (current_tail & (LOG_SIZE - 1))) - 1);
-	if (first)
-		memcpy(r->payload, payload, first * UNIT_SIZE);
-	if (first < total_size - 1)
-		memcpy(log_events, ((uint8_t *)payload) + first * UNIT_SIZE,
-			(total_size - first) * UNIT_SIZE);
-	/* mark the entry available in the queue if nobody is behind us */
-	if (current_tail == log_tail)
-		log_tail = log_tail_next;
 }
 
 void pd_log_event(uint8_t type, uint8_t size_port,
@@ -95,43 +140,56 @@ void pd_log_event(uint8_t type, uint8_t size_port,
 	log_add_event(type, size_port, data, payload, timestamp);
 }
 
-static int pd_log_dequeue(struct ec_response_pd_log *r)
+/**
+ * Remove the oldest entry from the FIFO.
+ *
+ * @param r		Entry, with its absolute timestamp
+ * @param max_payload	Room for the payload of the entry
+ * @return 1 if an entry was removed, 0 if the FIFO is empty or the payload
+ *	   of the oldest entry is larger than max_payload.
+ */
+static int log_remove(struct ec_response_pd_log *r, size_t max_payload)
 {
-	uint32_t now = get_time().val >> PD_LOG_TIMESTAMP_SHIFT;
-	unsigned total_size, first;
-	struct ec_response_pd_log *entry;
-	size_t current_head;
-
-retry:
-	current_head = log_head;
-	/* The log FIFO is empty */
-	if (log_tail == current_head) {
-		memset(r, 0, UNIT_SIZE);
-		r->type = PD_EVENT_NO_ENTRY;
-		return UNIT_SIZE;
-	}
-
-	entry = log_events + (current_head & (LOG_SIZE - 1));
-	total_size = ENTRY_SIZE(PD_LOG_SIZE(entry->size_port));
-	first = MIN(total_size, LOG_SIZE - (current_head & (LOG_SIZE - 1)));
-	memcpy(r, entry, first * UNIT_SIZE);
-	if (first < total_size)
-		memcpy(r + first, log_events, (total_size-first) * UNIT_SIZE);
+	int32_t delta;
+	size_t pos;
+	int ret = 0;
 
 	/* --- critical section : remove the entry from the queue --- */
 	interrupt_disable();
-	if (log_head != current_head) { /* our entry was thrown away */
-		interrupt_enable();
-		goto retry;
+	if (log_tail != log_head) {
+		pos = log_head + delta_decode(log_head, &delta);
+		log_read(pos, &r->type, HEADER_SIZE);
+		if (PD_LOG_SIZE(r->size_port) <= max_payload) {
+			log_read(pos + HEADER_SIZE, r->payload,
+				 PD_LOG_SIZE(r->size_port));
+			log_head_time += delta;
+			log_head = pos + HEADER_SIZE +
+				   PD_LOG_SIZE(r->size_port);
+			r->timestamp = log_head_time;
+			ret = 1;
+		}
 	}
-	log_head += total_size;
 	interrupt_enable();
 	/* --- end of critical section --- */
 
+	return ret;
+}
+
+static int pd_log_dequeue(struct ec_response_pd_log *r)
+{
+	uint32_t now = get_time().val >> PD_LOG_TIMESTAMP_SHIFT;
+
+	/* The log FIFO is empty */
+	if (!log_remove(r, PD_LOG_SIZE_MASK)) {
+		memset(r, 0, sizeof(*r));
+		r->type = PD_EVENT_NO_ENTRY;
+		return sizeof(*r);
+	}
+
 	/* fixup the timestamp : number of milliseconds in the past */
 	r->timestamp = now - r->timestamp;
 
-	return total_size * UNIT_SIZE;
+	return sizeof(*r) + PD_LOG_SIZE(r->size_port);
 }
 
 #ifdef HAS_TASK_HOSTCMD
@@ -162,6 +220,24 @@ void pd_log_recv_vdm(int port, int cnt, uint32_t *payload)
 	}
 }
 
+/* Ask the connected accessories for one entry of their log */
+static int pd_log_fetch_accessories(void)
+{
+	int i, res;
+
+	incoming_logs = 0;
+	for (i = 0; i < CONFIG_USB_PD_PORT_COUNT; ++i) {
+		/* only accessories who knows Google logging format */
+		if (pd_get_identity_vid(i) != USB_VID_GOOGLE)
+			continue;
+		res = pd_fetch_acc_log_entry(i);
+		if (res == EC_RES_BUSY) /* host should retry */
+			return EC_RES_BUSY;
+	}
+
+	return EC_RES_SUCCESS;
+}
+
 /* we are a PD MCU/EC, send back the events to the host */
 static int hc_pd_get_log_entry(struct host_cmd_handler_args *args)
 {
@@ -171,16 +247,8 @@ dequeue_retry:
 	args->response_size = pd_log_dequeue(r);
 	/* if the MCU log no longer has entries, try connected accessories */
 	if (r->type == PD_EVENT_NO_ENTRY) {
-		int i, res;
-		incoming_logs = 0;
-		for (i = 0; i < CONFIG_USB_PD_PORT_COUNT; ++i) {
-			/* only accessories who knows Google logging format */
-			if (pd_get_identity_vid(i) != USB_VID_GOOGLE)
-				continue;
-			res = pd_fetch_acc_log_entry(i);
-			if (res == EC_RES_BUSY) /* host should retry */
-				return EC_RES_BUSY;
-		}
+		if (pd_log_fetch_accessories() == EC_RES_BUSY)
+			return EC_RES_BUSY;
 		/* we have received new entries from an accessory */
 		if (incoming_logs)
 			goto dequeue_retry;
@@ -193,6 +261,57 @@ DECLARE_HOST_COMMAND(EC_CMD_PD_GET_LOG_ENTRY,
 		     hc_pd_get_log_entry,
 		     EC_VER_MASK(0));
 
+/* send back as many events as fit in the response */
+static int hc_pd_get_log_entries(struct host_cmd_handler_args *args)
+{
+	struct ec_response_pd_log_entries *r = args->response;
+	struct ec_response_pd_log *e;
+	uint32_t now = get_time().val >> PD_LOG_TIMESTAMP_SHIFT;
+	size_t size = sizeof(*r);
+	int fetched = 0;
+
+	/* Leave room for the largest entry */
+	if (args->response_max < size + sizeof(*e) + PD_LOG_SIZE_MASK)
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	r->count = 0;
+	r->reserved = 0;
+	while (size + sizeof(*e) <= args->response_max &&
+	       r->count < 0xff) {
+		e = (void *)((uint8_t *)r + size);
+		if (log_remove(e, args->response_max - size - sizeof(*e))) {
+			/* number of milliseconds in the past */
+			e->timestamp = now - e->timestamp;
+			size += sizeof(*e) + PD_LOG_SIZE(e->size_port);
+			r->count++;
+			continue;
+		}
+
+		/* the response is full, or the MCU log is empty */
+		if (r->count || fetched)
+			break;
+		/* an empty MCU log : try connected accessories once */
+		if (pd_log_fetch_accessories() == EC_RES_BUSY)
+			return EC_RES_BUSY;
+		if (!incoming_logs)
+			break;
+		fetched = 1;
+	}
+
+	/* --- critical section : read and clear the dropped count --- */
+	interrupt_disable();
+	r->dropped = MIN(log_dropped, 0xffff);
+	log_dropped = 0;
+	interrupt_enable();
+	/* --- end of critical section --- */
+
+	args->response_size = size;
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_PD_GET_LOG_ENTRIES,
+		     hc_pd_get_log_entries,
+		     EC_VER_MASK(0));
+
 static int hc_pd_write_log_entry(struct host_cmd_handler_args *args)
 {
 	const struct ec_params_pd_write_log_entry *p = args->params;
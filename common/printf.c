@@ -11,8 +11,6 @@
 
 static const char error_str[] = "ERROR";
 
-#define MAX_FORMAT 1024  /* Maximum chars in a single format field */
-
 #ifdef CONFIG_COMMON_RUNTIME
 static inline int divmod(uint64_t *n, int d)
 {
@@ -7,6 +7,12 @@
 #include "queue.h"
 #include "util.h"
 
+/*
+ * Keep buffer accesses on the correct side of the head and tail accesses
+ * which hand units between producer and consumer; see struct queue_state.
+ */
+#define queue_barrier() asm volatile("" : : : "memory")
+
 static void queue_action_null(struct queue_policy const *policy, size_t count)
 {
 }
@@ -54,6 +60,7 @@ size_t queue_add_unit(struct queue const *q, const void *src)
 	else
 		memcpy(q->buffer + tail * q->unit_bytes, src, q->unit_bytes);
 
+	queue_barrier();
 	q->state->tail += 1;
 
 	q->policy->add(q->policy, 1);
@@ -86,6 +93,7 @@ size_t queue_add_memcpy(struct queue const *q,
 		       ((uint8_t const *) src) + first * q->unit_bytes,
 		       (transfer - first) * q->unit_bytes);
 
+	queue_barrier();
 	q->state->tail += transfer;
 
 	q->policy->add(q->policy, transfer);
@@ -120,11 +128,13 @@ size_t queue_remove_unit(struct queue const *q, void *dest)
 	if (queue_count(q) == 0)
 		return 0;
 
+	queue_barrier();
 	if (q->unit_bytes == 1)
 		*((uint8_t *) dest) = q->buffer[head];
 	else
 		memcpy(dest, q->buffer + head * q->unit_bytes, q->unit_bytes);
 
+	queue_barrier();
 	q->state->head += 1;
 
 	q->policy->remove(q->policy, 1);
@@ -147,8 +157,62 @@ size_t queue_remove_memcpy(struct queue const *q,
 	size_t transfer = MIN(count, queue_count(q));
 	size_t head     = q->state->head & (q->buffer_units - 1);
 
+	queue_barrier();
 	queue_read_safe(q, dest, head, transfer, memcpy);
 
+	queue_barrier();
+	q->state->head += transfer;
+
+	q->policy->remove(q->policy, transfer);
+
+	return transfer;
+}
+
+struct queue_chunk queue_begin_write(struct queue const *q)
+{
+	struct queue_chunk chunk = { .length = 0, .buffer = NULL };
+	size_t tail = q->state->tail & (q->buffer_units - 1);
+
+	chunk.length = MIN(queue_space(q), q->buffer_units - tail);
+
+	if (chunk.length)
+		chunk.buffer = q->buffer + tail * q->unit_bytes;
+
+	return chunk;
+}
+
+size_t queue_commit_write(struct queue const *q, size_t count)
+{
+	size_t transfer = MIN(count, queue_space(q));
+
+	queue_barrier();
+	q->state->tail += transfer;
+
+	q->policy->add(q->policy, transfer);
+
+	return transfer;
+}
+
+struct queue_chunk queue_begin_read(struct queue const *q)
+{
+	struct queue_chunk chunk = { .length = 0, .buffer = NULL };
+	size_t head = q->state->head & (q->buffer_units - 1);
+
+	chunk.length = MIN(queue_count(q), q->buffer_units - head);
+
+	if (chunk.length)
+		chunk.buffer = q->buffer + head * q->unit_bytes;
+
+	queue_barrier();
+
+	return chunk;
+}
+
+size_t queue_commit_read(struct queue const *q, size_t count)
+{
+	size_t transfer = MIN(count, queue_count(q));
+
+	queue_barrier();
 	q->state->head += transfer;
 
 	q->policy->remove(q->policy, transfer);
@@ -178,6 +242,7 @@ size_t queue_peek_memcpy(struct queue const *q,
 	if (i < available) {
 		size_t head = (q->state->head + i) & (q->buffer_units - 1);
 
+		queue_barrier();
 		queue_read_safe(q, dest, head, transfer, memcpy);
 	}
 
@@ -85,6 +85,97 @@ static void mont_mul(const struct rsa_public_key *key,
 		mont_mul_add(key, c, a[i], b);
 }
 
+#ifdef CONFIG_RSA_OPTIMIZED
+/**
+ * Montgomery c[] = a[] * a[] / R % mod
+ *
+ * The full 2 x RSANUMWORDS square is computed first, evaluating each cross
+ * product a[i] * a[j] (i != j) only once and doubling the sum, then reduced
+ * one word at a time. c[] may be the same buffer as a[].
+ *
+ * @param t	Scratch buffer; caller must verify this is
+ *		2 x RSANUMWORDS elements long.
+ */
+static void mont_sqr(const struct rsa_public_key *key,
+		     uint32_t *c,
+		     const uint32_t *a,
+		     uint32_t *t)
+{
+	uint64_t A;
+	uint32_t carry, d0;
+	uint32_t i, j;
+
+	/* t[] = sum of a[i] * a[j] for i < j */
+	for (i = 0; i < 2 * RSANUMWORDS; ++i)
+		t[i] = 0;
+
+	for (i = 0; i < RSANUMWORDS - 1; ++i) {
+		A = 0;
+		for (j = i + 1; j < RSANUMWORDS; ++j) {
+			A = (A >> 32) + (uint64_t)a[i] * a[j] + t[i + j];
+			t[i + j] = (uint32_t)A;
+		}
+		t[i + RSANUMWORDS] = (uint32_t)(A >> 32);
+	}
+
+	/* t[] *= 2 */
+	carry = 0;
+	for (i = 0; i < 2 * RSANUMWORDS; ++i) {
+		d0 = t[i] >> 31;
+		t[i] = (t[i] << 1) | carry;
+		carry = d0;
+	}
+
+	/* t[] += a[i] * a[i] */
+	A = 0;
+	for (i = 0; i < RSANUMWORDS; ++i) {
+		uint64_t sq = (uint64_t)a[i] * a[i];
+
+		A = (A >> 32) + (uint32_t)sq + t[2 * i];
+		t[2 * i] = (uint32_t)A;
+		A = (A >> 32) + (sq >> 32) + t[2 * i + 1];
+		t[2 * i + 1] = (uint32_t)A;
+	}
+
+	/* Montgomery reduction: t[] = t[] / R % mod */
+	carry = 0;
+	for (i = 0; i < RSANUMWORDS; ++i) {
+		d0 = t[i] * key->n0inv;
+		A = 0;
+		for (j = 0; j < RSANUMWORDS; ++j) {
+			A = (A >> 32) + (uint64_t)d0 * key->n[j] + t[i + j];
+			t[i + j] = (uint32_t)A;
+		}
+		A = (A >> 32) + t[i + RSANUMWORDS] + carry;
+		t[i + RSANUMWORDS] = (uint32_t)A;
+		carry = (uint32_t)(A >> 32);
+	}
+
+	for (i = 0; i < RSANUMWORDS; ++i)
+		c[i] = t[i + RSANUMWORDS];
+
+	if (carry)
+		sub_mod(key, c);
+}
+#endif
+
+/**
+ * Convert from big endian byte array to little endian word array.
+ */
+static void load_words(uint32_t *a, const uint8_t *in)
+{
+	int i;
+
+	for (i = 0; i < RSANUMWORDS; ++i) {
+		uint32_t tmp =
+			(in[((RSANUMWORDS - 1 - i) * 4) + 0] << 24) |
+			(in[((RSANUMWORDS - 1 - i) * 4) + 1] << 16) |
+			(in[((RSANUMWORDS - 1 - i) * 4) + 2] << 8) |
+			(in[((RSANUMWORDS - 1 - i) * 4) + 3] << 0);
+		a[i] = tmp;
+	}
+}
+
 /**
  * In-place public exponentiation.
  *
@@ -96,27 +187,37 @@ static void mont_mul(const struct rsa_public_key *key,
 static void mod_pow_F4(const struct rsa_public_key *key, uint8_t *inout,
 		    uint32_t *workbuf32)
 {
+#ifdef CONFIG_RSA_OPTIMIZED
+	/*
+	 * The squarings need a double-width scratch buffer, so don't keep a
+	 * copy of the input around: reload it from inout, which is left
+	 * untouched until the end, for the final multiply.
+	 */
+	uint32_t *a_r = workbuf32;
+	uint32_t *t = a_r + RSANUMWORDS;
+	uint32_t *a = t;
+	uint32_t *aaa = t + RSANUMWORDS;
+#else
 	uint32_t *a = workbuf32;
 	uint32_t *a_r = a + RSANUMWORDS;
 	uint32_t *aa_r = a_r + RSANUMWORDS;
 	uint32_t *aaa = aa_r;  /* Re-use location. */
+#endif
 	int i;
 
-	/* Convert from big endian byte array to little endian word array. */
-	for (i = 0; i < RSANUMWORDS; ++i) {
-		uint32_t tmp =
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 0] << 24) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 1] << 16) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 2] << 8) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 3] << 0);
-		a[i] = tmp;
-	}
+	load_words(a, inout);
 
 	mont_mul(key, a_r, a, key->rr);  /* a_r = a * RR / R mod M */
+#ifdef CONFIG_RSA_OPTIMIZED
+	for (i = 0; i < 16; i++)
+		mont_sqr(key, a_r, a_r, t); /* a_r = a_r * a_r / R mod M */
+	load_words(a, inout);
+#else
 	for (i = 0; i < 16; i += 2) {
 		mont_mul(key, aa_r, a_r, a_r); /* aa_r = a_r * a_r / R mod M */
 		mont_mul(key, a_r, aa_r, aa_r);/* a_r = aa_r * aa_r / R mod M */
 	}
+#endif
 	mont_mul(key, aaa, a_r, a);  /* aaa = a_r * a / R mod M */
 
 	/* Make sure aaa < mod; aaa is at most 1x mod too large. */
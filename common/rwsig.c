@@ -13,6 +13,7 @@
 #include "sha256.h"
 #include "shared_mem.h"
 #include "system.h"
+#include "timer.h"
 #include "usb_pd.h"
 #include "util.h"
 
@@ -38,6 +39,7 @@ void check_rw_signature(void)
 	int good, res;
 	uint8_t *hash;
 	uint32_t *rsa_workbuf;
+	timestamp_t start;
 
 	/* Only the Read-Only firmware needs to do the signature check */
 	if (system_get_image_copy() != SYSTEM_IMAGE_RO)
@@ -56,6 +58,8 @@ void check_rw_signature(void)
 		return;
 	}
 
+	start = get_time();
+
 	/* SHA-256 Hash of the RW firmware */
 	SHA256_init(&ctx);
 	SHA256_update(&ctx, (void *)CONFIG_FLASH_BASE + CONFIG_RW_MEM_OFF,
@@ -64,7 +68,8 @@ void check_rw_signature(void)
 
 	good = rsa_verify(&pkey, (void *)rw_sig, (void *)hash, rsa_workbuf);
 	if (good) {
-		CPRINTS("RW image verified");
+		CPRINTS("RW image verified in %d us",
+			(int)(get_time().val - start.val));
 		/* Jump to the RW firmware */
 		system_run_image_copy(SYSTEM_IMAGE_RW);
 	} else {
@@ -36,7 +36,12 @@
  */
 
 #include "sha256.h"
+#ifdef HOST_TOOLS_BUILD
+#include <string.h>
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#else
 #include "util.h"
+#endif
 
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -104,14 +109,6 @@ static const uint32_t sha256_k[64] = {
 	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
 	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
 
-#define SHA256_DIGESTINFO_LEN 19
-
-static const uint8_t SHA256_digestinfo[] = {
-	0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86,
-	0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05,
-	0x00, 0x04, 0x20
-};
-
 void SHA256_init(struct sha256_ctx *ctx)
 {
 	int i;
@@ -123,6 +120,101 @@ void SHA256_init(struct sha256_ctx *ctx)
 	ctx->tot_len = 0;
 }
 
+#ifdef CONFIG_SHA256_UNROLLED
+
+/*
+ * Rolling 16-word message schedule: w[j & 15] holds W[j] and is overwritten
+ * in place with W[j + 16] = F4(W[j + 14]) + W[j + 9] + F3(W[j + 1]) + W[j].
+ */
+#define SHA256_SCR16(j)							\
+	(w[(j) & 15] += SHA256_F4(w[((j) + 14) & 15]) + w[((j) + 9) & 15] \
+			+ SHA256_F3(w[((j) + 1) & 15]))
+
+/*
+ * One round with the working variables passed by name, so that the caller
+ * can rotate them by renaming instead of moving eight words per round.
+ */
+#define SHA256_RND(a, b, c, d, e, f, g, h, j, wj)			\
+	{								\
+		t1 = h + SHA256_F2(e) + CH(e, f, g) + sha256_k[j] + (wj); \
+		t2 = SHA256_F1(a) + MAJ(a, b, c);			\
+		d += t1;						\
+		h = t1 + t2;						\
+	}
+
+#define SHA256_RND16(j, WJ)						\
+	{								\
+		SHA256_RND(a, b, c, d, e, f, g, h, (j) +  0, WJ(0));	\
+		SHA256_RND(h, a, b, c, d, e, f, g, (j) +  1, WJ(1));	\
+		SHA256_RND(g, h, a, b, c, d, e, f, (j) +  2, WJ(2));	\
+		SHA256_RND(f, g, h, a, b, c, d, e, (j) +  3, WJ(3));	\
+		SHA256_RND(e, f, g, h, a, b, c, d, (j) +  4, WJ(4));	\
+		SHA256_RND(d, e, f, g, h, a, b, c, (j) +  5, WJ(5));	\
+		SHA256_RND(c, d, e, f, g, h, a, b, (j) +  6, WJ(6));	\
+		SHA256_RND(b, c, d, e, f, g, h, a, (j) +  7, WJ(7));	\
+		SHA256_RND(a, b, c, d, e, f, g, h, (j) +  8, WJ(8));	\
+		SHA256_RND(h, a, b, c, d, e, f, g, (j) +  9, WJ(9));	\
+		SHA256_RND(g, h, a, b, c, d, e, f, (j) + 10, WJ(10));	\
+		SHA256_RND(f, g, h, a, b, c, d, e, (j) + 11, WJ(11));	\
+		SHA256_RND(e, f, g, h, a, b, c, d, (j) + 12, WJ(12));	\
+		SHA256_RND(d, e, f, g, h, a, b, c, (j) + 13, WJ(13));	\
+		SHA256_RND(c, d, e, f, g, h, a, b, (j) + 14, WJ(14));	\
+		SHA256_RND(b, c, d, e, f, g, h, a, (j) + 15, WJ(15));	\
+	}
+
+/* Schedule word accessors for the first 16 rounds and for the rest */
+#define SHA256_WLOAD(k) w[k]
+#define SHA256_WNEXT(k) SHA256_SCR16(k)
+
+static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
+			     unsigned int block_nb)
+{
+	uint32_t w[16];
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t t1, t2;
+	const uint8_t *sub_block;
+	int i, j;
+
+	for (i = 0; i < (int) block_nb; i++) {
+		sub_block = message + (i << 6);
+
+		if (((uintptr_t)sub_block & 3) == 0) {
+			/* Aligned data: load words and swap to big-endian */
+			const uint32_t *p = (const uint32_t *)sub_block;
+
+			for (j = 0; j < 16; j++)
+				w[j] = __builtin_bswap32(p[j]);
+		} else {
+			for (j = 0; j < 16; j++)
+				PACK32(&sub_block[j << 2], &w[j]);
+		}
+
+		a = ctx->h[0];
+		b = ctx->h[1];
+		c = ctx->h[2];
+		d = ctx->h[3];
+		e = ctx->h[4];
+		f = ctx->h[5];
+		g = ctx->h[6];
+		h = ctx->h[7];
+
+		SHA256_RND16(0, SHA256_WLOAD);
+		for (j = 16; j < 64; j += 16)
+			SHA256_RND16(j, SHA256_WNEXT);
+
+		ctx->h[0] += a;
+		ctx->h[1] += b;
+		ctx->h[2] += c;
+		ctx->h[3] += d;
+		ctx->h[4] += e;
+		ctx->h[5] += f;
+		ctx->h[6] += g;
+		ctx->h[7] += h;
+	}
+}
+
+#else  /* !CONFIG_SHA256_UNROLLED */
+
 static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 			     unsigned int block_nb)
 {
@@ -164,36 +256,41 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 	}
 }
 
+#endif  /* CONFIG_SHA256_UNROLLED */
+
 void SHA256_update(struct sha256_ctx *ctx, const uint8_t *data, uint32_t len)
 {
 	unsigned int block_nb;
-	unsigned int new_len, rem_len, tmp_len;
-	const uint8_t *shifted_data;
-
-	tmp_len = SHA256_BLOCK_SIZE - ctx->len;
-	rem_len = len < tmp_len ? len : tmp_len;
-
-	memcpy(&ctx->block[ctx->len], data, rem_len);
-
-	if (ctx->len + len < SHA256_BLOCK_SIZE) {
-		ctx->len += len;
-		return;
+	unsigned int rem_len;
+
+	/* Top up a partially filled block first */
+	if (ctx->len) {
+		rem_len = MIN(len, SHA256_BLOCK_SIZE - ctx->len);
+		memcpy(&ctx->block[ctx->len], data, rem_len);
+		ctx->len += rem_len;
+		data += rem_len;
+		len -= rem_len;
+
+		if (ctx->len < SHA256_BLOCK_SIZE)
+			return;
+
+		SHA256_transform(ctx, ctx->block, 1);
+		ctx->tot_len += SHA256_BLOCK_SIZE;
+		ctx->len = 0;
 	}
 
-	new_len = len - rem_len;
-	block_nb = new_len / SHA256_BLOCK_SIZE;
-
-	shifted_data = data + rem_len;
-
-	SHA256_transform(ctx, ctx->block, 1);
-	SHA256_transform(ctx, shifted_data, block_nb);
-
-	rem_len = new_len % SHA256_BLOCK_SIZE;
-
-	memcpy(ctx->block, &shifted_data[block_nb << 6], rem_len);
-
+	/*
+	 * Hash whole blocks straight from the caller's buffer, so that large
+	 * updates (e.g. memory-mapped flash) are never copied into ctx->block.
+	 */
+	block_nb = len / SHA256_BLOCK_SIZE;
+	SHA256_transform(ctx, data, block_nb);
+	ctx->tot_len += block_nb << 6;
+
+	/* Keep the tail for the next update or for SHA256_final() */
+	rem_len = len % SHA256_BLOCK_SIZE;
+	memcpy(ctx->block, &data[block_nb << 6], rem_len);
 	ctx->len = rem_len;
-	ctx->tot_len += (block_nb + 1) << 6;
 }
 
 uint8_t *SHA256_final(struct sha256_ctx *ctx)
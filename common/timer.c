@@ -20,22 +20,90 @@
 /* High word of the 64-bit timestamp counter  */
 static volatile uint32_t clksrc_high;
 
+#ifdef CONFIG_SW_TIMER_COUNT
+#define SW_TIMER_COUNT CONFIG_SW_TIMER_COUNT
+#else
+#define SW_TIMER_COUNT 0
+#endif
+
+#ifdef CONFIG_TIMER_SLACK_US
+#define TIMER_SLACK_US CONFIG_TIMER_SLACK_US
+#else
+#define TIMER_SLACK_US 0
+#endif
+
+/*
+ * Timer ids: each task owns the timer whose id is its task id, software
+ * timers from sw_timer_alloc() come after those.
+ */
+#define TIMER_COUNT (TASK_ID_COUNT + SW_TIMER_COUNT)
+
+/* Heap position of a timer which is not queued */
+#define TIMER_NOT_QUEUED 0xff
+
 /* Bitmap of currently running timers */
 static uint32_t timer_running;
 
+/* Bitmap of timers armed or cancelled since process_timers() last ran */
+static uint32_t timer_changed;
+
 /* Deadlines of all timers */
-static timestamp_t timer_deadline[TASK_ID_COUNT];
+static timestamp_t timer_deadline[TIMER_COUNT];
 static uint32_t next_deadline = 0xffffffff;
 
+/*
+ * Min-heap of running timers ordered by deadline. It is only ever modified
+ * from process_timers(); timer_arm() and timer_cancel() just flag the timer
+ * in timer_changed and the heap is brought up to date on the next interrupt.
+ * The heap keeps its own copy of each deadline so that re-arming a timer
+ * cannot break the heap ordering before that happens.
+ */
+static struct {
+	timestamp_t deadline;
+	uint8_t id;
+} timer_heap[TIMER_COUNT];
+static uint8_t timer_heap_pos[TIMER_COUNT];
+static int timer_heap_size;
+
+#if SW_TIMER_COUNT
+/* Owners of the software timers */
+static struct {
+	task_id_t task;
+	uint32_t event;
+} sw_timers[SW_TIMER_COUNT];
+static int sw_timers_used;
+#endif
+
 /* Hardware timer routine IRQ number */
 static int timer_irq;
 
-static void expire_timer(task_id_t tskid)
+static void expire_timer(int id, const timestamp_t *now)
 {
+	/*
+	 * The heap entry may be stale: the timer can have been cancelled or
+	 * armed again since it was queued, from a context which preempted
+	 * us.  Leave those to the next requeue rather than lose the new
+	 * deadline.
+	 */
+	interrupt_disable();
+	if ((timer_changed & (1 << id)) || !(timer_running & (1 << id)) ||
+	    timer_deadline[id].val > now->val) {
+		atomic_or(&timer_changed, 1 << id);
+		interrupt_enable();
+		return;
+	}
 	/* we are done with this timer */
-	atomic_clear(&timer_running, 1 << tskid);
-	/* wake up the taks waiting for this timer */
-	task_set_event(tskid, TASK_EVENT_TIMER, 0);
+	atomic_clear(&timer_running, 1 << id);
+	interrupt_enable();
+	/* wake up the task waiting for this timer */
+#if SW_TIMER_COUNT
+	if (id >= TASK_ID_COUNT) {
+		id -= TASK_ID_COUNT;
+		task_set_event(sw_timers[id].task, sw_timers[id].event, 0);
+		return;
+	}
+#endif
+	task_set_event(id, TASK_EVENT_TIMER, 0);
 }
 
 int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
@@ -50,48 +118,141 @@ int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
 	return ((int64_t)(now->val - deadline.val) >= 0);
 }
 
+static void heap_swap(int i, int j)
+{
+	timestamp_t deadline = timer_heap[i].deadline;
+	uint8_t id = timer_heap[i].id;
+
+	timer_heap[i] = timer_heap[j];
+	timer_heap[j].deadline = deadline;
+	timer_heap[j].id = id;
+
+	timer_heap_pos[timer_heap[i].id] = i;
+	timer_heap_pos[id] = j;
+}
+
+static void heap_sift_up(int i)
+{
+	int parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (timer_heap[parent].deadline.val <=
+		    timer_heap[i].deadline.val)
+			break;
+		heap_swap(i, parent);
+		i = parent;
+	}
+}
+
+static void heap_sift_down(int i)
+{
+	int child;
+
+	while ((child = 2 * i + 1) < timer_heap_size) {
+		if (child + 1 < timer_heap_size &&
+		    timer_heap[child + 1].deadline.val <
+		    timer_heap[child].deadline.val)
+			child++;
+		if (timer_heap[i].deadline.val <= timer_heap[child].deadline.val)
+			break;
+		heap_swap(i, child);
+		i = child;
+	}
+}
+
+static void heap_remove(int id)
+{
+	int i = timer_heap_pos[id];
+
+	if (i == TIMER_NOT_QUEUED)
+		return;
+
+	timer_heap_pos[id] = TIMER_NOT_QUEUED;
+	if (--timer_heap_size == i)
+		return;
+
+	/* Move the last entry into the hole and restore the ordering */
+	timer_heap[i] = timer_heap[timer_heap_size];
+	timer_heap_pos[timer_heap[i].id] = i;
+	heap_sift_up(i);
+	heap_sift_down(i);
+}
+
+static void heap_insert(int id)
+{
+	int i = timer_heap_size++;
+
+	timer_heap[i].deadline = timer_deadline[id];
+	timer_heap[i].id = id;
+	timer_heap_pos[id] = i;
+	heap_sift_up(i);
+}
+
 void process_timers(int overflow)
 {
-	uint32_t check_timer, running_t0;
+	uint32_t changed;
 	timestamp_t next;
 	timestamp_t now;
+	int id;
 
 	if (overflow)
 		clksrc_high++;
 
 	do {
-		next.val = -1ull;
+		/* Requeue timers which were armed or cancelled */
+		changed = atomic_read_clear(&timer_changed);
+		while (changed) {
+			id = 31 - __builtin_clz(changed);
+			heap_remove(id);
+			if (timer_running & (1 << id))
+				heap_insert(id);
+			changed &= ~(1 << id);
+		}
+
+		/* Expire everything which is due */
 		now = get_time();
-		do {
-			/* read atomically the current state of timer running */
-			check_timer = running_t0 = timer_running;
-			while (check_timer) {
-				int tskid = 31 - __builtin_clz(check_timer);
-
-				/* timer has expired ? */
-				if (timer_deadline[tskid].val <= now.val)
-					expire_timer(tskid);
-				else if ((timer_deadline[tskid].le.hi ==
-					  now.le.hi) &&
-					 (timer_deadline[tskid].le.lo <
-					  next.le.lo))
-					next.val = timer_deadline[tskid].val;
-
-				check_timer &= ~(1 << tskid);
-			}
-		/* if there is a new timer, let's retry */
-		} while (timer_running & ~running_t0);
-
-		if (next.le.hi == 0xffffffff) {
-			/* no deadline to set */
+		while (timer_heap_size &&
+		       timer_heap[0].deadline.val <= now.val) {
+			id = timer_heap[0].id;
+			heap_remove(id);
+			expire_timer(id, &now);
+		}
+
+		/*
+		 * Let the earliest timer run late by up to TIMER_SLACK_US, so
+		 * that timers due within that window share a single interrupt.
+		 */
+		next.val = timer_heap_size ?
+			timer_heap[0].deadline.val + TIMER_SLACK_US : -1ull;
+
+		if (next.le.hi != now.le.hi) {
+			/*
+			 * No deadline to set in this epoch; the overflow
+			 * interrupt will get us back here if needed.
+			 */
 			__hw_clock_event_clear();
 			next_deadline = 0xffffffff;
-			return;
+			if (!timer_changed)
+				return;
+			continue;
 		}
 
 		__hw_clock_event_set(next.le.lo);
 		next_deadline = next.le.lo;
-	} while (next.val <= get_time().val);
+	} while (timer_changed || next.val <= get_time().val);
+}
+
+static void arm_timer(int id, timestamp_t tstamp)
+{
+	timer_deadline[id] = tstamp;
+	atomic_or(&timer_running, 1 << id);
+	atomic_or(&timer_changed, 1 << id);
+
+	/* Modify the next event if needed */
+	if ((tstamp.le.hi < clksrc_high) ||
+	    ((tstamp.le.hi == clksrc_high) && (tstamp.le.lo <= next_deadline)))
+		task_trigger_irq(timer_irq);
 }
 
 #ifndef CONFIG_HW_SPECIFIC_UDELAY
@@ -121,13 +282,7 @@ int timer_arm(timestamp_t tstamp, task_id_t tskid)
 	if (timer_running & (1<<tskid))
 		return EC_ERROR_BUSY;
 
-	timer_deadline[tskid] = tstamp;
-	atomic_or(&timer_running, 1<<tskid);
-
-	/* Modify the next event if needed */
-	if ((tstamp.le.hi < clksrc_high) ||
-	    ((tstamp.le.hi == clksrc_high) && (tstamp.le.lo <= next_deadline)))
-		task_trigger_irq(timer_irq);
+	arm_timer(tskid, tstamp);
 
 	return EC_SUCCESS;
 }
@@ -139,10 +294,46 @@ void timer_cancel(task_id_t tskid)
 	atomic_clear(&timer_running, 1 << tskid);
 	/*
 	 * Don't need to cancel the interrupt: it would be slow, just do it on
-	 * the next IT
+	 * the next IT, which will also drop the timer from the heap.
 	 */
+	atomic_or(&timer_changed, 1 << tskid);
+}
+
+#if SW_TIMER_COUNT
+int sw_timer_alloc(task_id_t tskid, uint32_t event)
+{
+	int id;
+
+	ASSERT(tskid < TASK_ID_COUNT && event);
+
+	interrupt_disable();
+	id = sw_timers_used < SW_TIMER_COUNT ? sw_timers_used++ : -1;
+	interrupt_enable();
+
+	if (id < 0)
+		return -1;
+
+	sw_timers[id].task = tskid;
+	sw_timers[id].event = event;
+	return TASK_ID_COUNT + id;
 }
 
+void sw_timer_arm(int timer, timestamp_t tstamp)
+{
+	ASSERT(timer >= TASK_ID_COUNT && timer < TIMER_COUNT);
+
+	arm_timer(timer, tstamp);
+}
+
+void sw_timer_cancel(int timer)
+{
+	ASSERT(timer >= TASK_ID_COUNT && timer < TIMER_COUNT);
+
+	atomic_clear(&timer_running, 1 << timer);
+	atomic_or(&timer_changed, 1 << timer);
+}
+#endif
+
 /*
  * For us < (2^31 - task scheduling latency)(~ 2147 sec), this function will
  * sleep for at least us, and no more than 2*us. As us approaches 2^32-1, the
@@ -206,9 +397,12 @@ void timer_print_info(void)
 		 t, deadline, deadline - t);
 	cflush();
 
-	for (tskid = 0; tskid < TASK_ID_COUNT; tskid++) {
+	for (tskid = 0; tskid < TIMER_COUNT; tskid++) {
 		if (timer_running & (1<<tskid)) {
-			ccprintf("  Tsk %2d  0x%016lx -> %11.6ld\n", tskid,
+			ccprintf("  %s %2d  0x%016lx -> %11.6ld\n",
+				 tskid < TASK_ID_COUNT ? "Tsk" : "Tmr",
+				 tskid < TASK_ID_COUNT ? tskid :
+				 tskid - TASK_ID_COUNT,
 				 timer_deadline[tskid].val,
 				 timer_deadline[tskid].val - t);
 			cflush();
@@ -224,7 +418,10 @@ void timer_init(void)
 	const timestamp_t *ts;
 	int size, version;
 
-	BUILD_ASSERT(TASK_ID_COUNT < sizeof(timer_running) * 8);
+	BUILD_ASSERT(TIMER_COUNT < sizeof(timer_running) * 8);
+	BUILD_ASSERT(TIMER_COUNT < TIMER_NOT_QUEUED);
+
+	memset(timer_heap_pos, TIMER_NOT_QUEUED, sizeof(timer_heap_pos));
 
 	/* Restore time from before sysjump */
 	ts = (const timestamp_t *)system_get_jump_tag(TIMER_SYSJUMP_TAG,
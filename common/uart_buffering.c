@@ -30,6 +30,13 @@
 /* ASCII control character; for example, CTRL('C') = ^C */
 #define CTRL(c) ((c) - '@')
 
+/*
+ * Characters of formatted output staged on the caller's stack, so they can be
+ * added to the transmit buffer in one operation instead of one at a time.
+ * Kept small because console output is printed from tasks with small stacks.
+ */
+#define TX_BATCH_SIZE 32
+
 /*
  * Interval between rechecking the receive DMA head pointer, after a character
  * of input has been detected by the normal tick task.  There will be
@@ -42,6 +49,10 @@
 static volatile char tx_buf[CONFIG_UART_TX_BUF_SIZE];
 static volatile int tx_buf_head;
 static volatile int tx_buf_tail;
+/* End of the space claimed by tx_buf_add(), which may still be copying */
+static int tx_buf_reserved;
+/* Number of tx_buf_add() calls between reserving space and copying into it */
+static int tx_buf_writers;
 static volatile char rx_buf[CONFIG_UART_RX_BUF_SIZE];
 static volatile int rx_buf_head;
 static volatile int rx_buf_tail;
@@ -51,26 +62,47 @@ static int tx_last_snapshot_head;
 static int tx_next_snapshot_head;
 static int uart_suspended;
 
+/* Output staged by uart_vprintf() */
+struct tx_batch {
+	int len;
+	char buf[TX_BATCH_SIZE];
+};
+
+static void tx_buf_copy(volatile char *dest, const char *src, int len)
+{
+	while (len--)
+		*dest++ = *src++;
+}
+
 /**
- * Put a single character into the transmit buffer.
+ * Add characters to the transmit buffer.
  *
- * Does not enable the transmit interrupt; assumes that happens elsewhere.
+ * Does no newline translation, and does not enable the transmit interrupt;
+ * assumes those happen elsewhere.
  *
- * @param context	Context; ignored.
- * @param c		Character to write.
- * @return 0 if the character was transmitted, 1 if it was dropped.
+ * @param src		Characters to write.
+ * @param len		Number of characters.
+ * @return 0 if all the characters were added, 1 if any were dropped.
  */
-static int __tx_char(void *context, int c)
+static int tx_buf_add(const char *src, int len)
 {
-	int tx_buf_next, tx_buf_new_tail;
-
-	/* Do newline to CRLF translation */
-	if (c == '\n' && __tx_char(NULL, '\r'))
-		return 1;
+	int head, count, new_head, i;
 
-	tx_buf_next = TX_BUF_NEXT(tx_buf_head);
-	if (tx_buf_next == tx_buf_tail)
-		return 1;
+	/*
+	 * Reserve the space with interrupts off, so that output from a task
+	 * or interrupt which preempts the copy below goes after ours instead
+	 * of over it.
+	 */
+	interrupt_disable();
+	head = tx_buf_reserved;
+	count = MIN(len, TX_BUF_DIFF(tx_buf_tail, TX_BUF_NEXT(head)));
+	new_head = (head + count) & (CONFIG_UART_TX_BUF_SIZE - 1);
+	if (!count) {
+		interrupt_enable();
+		return len != 0;
+	}
+	tx_buf_reserved = new_head;
+	tx_buf_writers++;
 
 	/*
 	 * If we do a READ_RECENT, the buffer may have wrapped around, and
@@ -80,15 +112,58 @@ static int __tx_char(void *context, int c)
 	 * We also want to make sure that the next time we snapshot and want
 	 * to READ_RECENT, we don't start reading from a stale tail.
 	 */
-	tx_buf_new_tail = TX_BUF_NEXT(tx_buf_next);
-	if (tx_buf_next == tx_last_snapshot_head &&
+	if (TX_BUF_DIFF(tx_last_snapshot_head - 1, head) < count &&
 	    tx_last_snapshot_head != tx_snapshot_head)
-		tx_last_snapshot_head = tx_buf_new_tail;
-	if (tx_buf_next == tx_next_snapshot_head)
-		tx_next_snapshot_head = tx_buf_new_tail;
+		tx_last_snapshot_head = TX_BUF_NEXT(new_head);
+	if (TX_BUF_DIFF(tx_next_snapshot_head - 1, head) < count)
+		tx_next_snapshot_head = TX_BUF_NEXT(new_head);
+	interrupt_enable();
+
+	/* Copy up to the end of the buffer, then from its start */
+	i = MIN(count, CONFIG_UART_TX_BUF_SIZE - head);
+	tx_buf_copy(tx_buf + head, src, i);
+	tx_buf_copy(tx_buf, src + i, count - i);
+
+	/*
+	 * Writers nest, since none of them can block while copying; the
+	 * outermost one to finish makes everything reserved so far visible.
+	 */
+	interrupt_disable();
+	if (!--tx_buf_writers)
+		tx_buf_head = tx_buf_reserved;
+	interrupt_enable();
+
+	return count < len;
+}
 
-	tx_buf[tx_buf_head] = c;
-	tx_buf_head = tx_buf_next;
+/**
+ * Stage a character of formatted output; vfnprintf() callback.
+ *
+ * Called for every character printed, so it only stores the character and
+ * its CR if any, and leaves the transmit buffer alone until the batch fills.
+ *
+ * @param context	Batch to add to.
+ * @param c		Character to write.
+ * @return 0 if the character was accepted, 1 if output has been dropped.
+ */
+static int tx_batch_char(void *context, int c)
+{
+	struct tx_batch *batch = context;
+	char *p;
+
+	/* Always leave room for a CRLF pair */
+	if (batch->len > TX_BATCH_SIZE - 2) {
+		if (tx_buf_add(batch->buf, batch->len))
+			return 1;
+		batch->len = 0;
+	}
+
+	p = batch->buf + batch->len;
+	/* Do newline to CRLF translation */
+	if (c == '\n')
+		*p++ = '\r';
+	*p++ = c;
+	batch->len = p - batch->buf;
 	return 0;
 }
 
@@ -160,6 +235,8 @@ void uart_process_output(void)
 
 #ifdef CONFIG_UART_RX_DMA
 
+DECLARE_DEFERRED(uart_process_input);
+
 void uart_process_input(void)
 {
 	static int fast_rechecks;
@@ -201,11 +278,11 @@ void uart_process_input(void)
 	 */
 	if (fast_rechecks) {
 		fast_rechecks--;
-		hook_call_deferred(uart_process_input, RX_DMA_RECHECK_INTERVAL);
+		hook_call_deferred(&uart_process_input_data,
+				   RX_DMA_RECHECK_INTERVAL);
 	}
 }
 DECLARE_HOOK(HOOK_TICK, uart_process_input, HOOK_PRIO_DEFAULT);
-DECLARE_DEFERRED(uart_process_input);
 
 #else /* !CONFIG_UART_RX_DMA */
 
@@ -248,7 +325,8 @@ void uart_process_input(void)
 
 int uart_putc(int c)
 {
-	int rv = __tx_char(NULL, c);
+	char ch = c;
+	int rv = (c == '\n') ? tx_buf_add("\r\n", 2) : tx_buf_add(&ch, 1);
 
 	if (!uart_suspended)
 		uart_tx_start();
@@ -258,22 +336,37 @@ int uart_putc(int c)
 
 int uart_puts(const char *outstr)
 {
-	/* Put all characters in the output buffer */
-	while (*outstr) {
-		if (__tx_char(NULL, *outstr++) != 0)
-			break;
+	const char *end;
+	int rv = 0;
+
+	/* Put each line in the output buffer, translating newlines to CRLF */
+	while (*outstr && !rv) {
+		for (end = outstr; *end && *end != '\n'; end++)
+			;
+		rv = tx_buf_add(outstr, end - outstr);
+		if (*end && !rv) {
+			rv = tx_buf_add("\r\n", 2);
+			end++;
+		}
+		outstr = end;
 	}
 
 	if (!uart_suspended)
 		uart_tx_start();
 
 	/* Successful if we consumed all output */
-	return *outstr ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_vprintf(const char *format, va_list args)
 {
-	int rv = vfnprintf(__tx_char, NULL, format, args);
+	struct tx_batch batch;
+	int rv;
+
+	batch.len = 0;
+	rv = vfnprintf(tx_batch_char, &batch, format, args);
+	if (!rv && tx_buf_add(batch.buf, batch.len))
+		rv = EC_ERROR_OVERFLOW;
 
 	if (!uart_suspended)
 		uart_tx_start();
@@ -359,6 +452,9 @@ DECLARE_HOOK(HOOK_INIT, uart_rx_dma_init, HOOK_PRIO_DEFAULT);
 
 static int host_command_console_snapshot(struct host_cmd_handler_args *args)
 {
+	/* Include messages still waiting in the binary log */
+	console_binlog_flush();
+
 	/* Assume the whole circular buffer is full */
 	tx_snapshot_head = tx_buf_head;
 	tx_snapshot_tail = TX_BUF_NEXT(tx_snapshot_head);
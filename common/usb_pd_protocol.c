@@ -3,6 +3,7 @@
  * found in the LICENSE file.
  */
 
+#include "atomic.h"
 #include "battery.h"
 #include "board.h"
 #include "case_closed_debug.h"
@@ -122,7 +123,24 @@ static struct pd_protocol {
 
 	/* last requested voltage PDO index */
 	int requested_idx;
+	/* Hard resets since the last successful negotiation */
+	uint8_t hard_reset_count;
+	/* Source caps sent without an answer */
+	uint8_t caps_count;
+	/* Hard reset of the current HARD_RESET_SEND state is out */
+	uint8_t hard_reset_sent;
 #ifdef CONFIG_USB_PD_DUAL_ROLE
+	/* Time of the next DRP role toggle */
+	uint64_t next_role_swap;
+#ifndef CONFIG_USB_PD_NO_VBUS_DETECT
+	/* VBUS dropped during sink hard reset recovery */
+	uint8_t snk_hard_reset_vbus_off;
+#endif
+#ifdef CONFIG_CHARGE_MANAGER
+	/* Type-C current limit, and a change of it being debounced */
+	int typec_curr;
+	uint8_t typec_curr_change;
+#endif
 	/* Current limit / voltage based on the last request message */
 	uint32_t curr_limit;
 	uint32_t supply_voltage;
@@ -185,6 +203,197 @@ BUILD_ASSERT(ARRAY_SIZE(pd_state_names) == PD_STATE_COUNT);
 static struct ec_params_usb_pd_rw_hash_entry rw_hash_table[RW_HASH_ENTRIES];
 #endif
 
+#ifdef CONFIG_USB_PD_TIMING
+/* Protocol timing of each port, see EC_CMD_USB_PD_TIMING */
+static struct pd_timing {
+	uint16_t rx_goodcrc[EC_USB_PD_TIMING_BUCKETS];
+	uint16_t rx_reply[EC_USB_PD_TIMING_BUCKETS];
+	uint32_t rx_goodcrc_max_us;
+	uint32_t rx_reply_max_us;
+	uint16_t state_timeouts;
+	uint16_t vdm_timeouts;
+	uint16_t tx_retries;
+	uint16_t tx_errors;
+	struct ec_usb_pd_timing_state states[PD_STATE_COUNT];
+
+	/*
+	 * Start of the message being received, set by the RX interrupt.  Only
+	 * the low word of the time is kept, so that tasks read it in one go.
+	 */
+	uint32_t rx_time;
+	/* Start of the last message the TCPC sent a GoodCRC for, or 0 */
+	uint32_t msg_time;
+	/* Start of a received message still waiting for its reply, or 0 */
+	uint32_t reply_time;
+	/* Time the current state was entered, or 0 */
+	uint64_t state_time;
+} pd_timing[CONFIG_USB_PD_PORT_COUNT];
+
+static void timing_inc(uint16_t *count)
+{
+	if (*count < 0xffff)
+		(*count)++;
+}
+
+/* Add the time since start to a histogram */
+static void timing_record(uint16_t *hist, uint32_t *max_us, uint32_t start)
+{
+	uint32_t us = get_time().le.lo - start;
+	int bucket = 0;
+
+	if (us >= 16)
+		bucket = MIN(31 - __builtin_clz(us) - 3,
+			     EC_USB_PD_TIMING_BUCKETS - 1);
+	timing_inc(&hist[bucket]);
+	if (us > *max_us)
+		*max_us = us;
+}
+
+void pd_timing_rx(int port)
+{
+	pd_timing[port].rx_time = get_time().le.lo;
+}
+
+void pd_timing_goodcrc(int port)
+{
+	struct pd_timing *t = &pd_timing[port];
+
+	if (!t->rx_time)
+		return;
+	timing_record(t->rx_goodcrc, &t->rx_goodcrc_max_us, t->rx_time);
+	t->msg_time = t->rx_time;
+	t->rx_time = 0;
+}
+
+void pd_timing_tx_retry(int port)
+{
+	timing_inc(&pd_timing[port].tx_retries);
+}
+
+/* Return non-zero if the protocol answers this message */
+static int timing_needs_reply(uint16_t head, const uint32_t *payload)
+{
+	int type = PD_HEADER_TYPE(head);
+
+	if (PD_HEADER_CNT(head)) {
+		if (type == PD_DATA_VENDOR_DEF)
+			return PD_VDO_SVDM(payload[0]) &&
+			       PD_VDO_CMDT(payload[0]) == CMDT_INIT &&
+			       PD_VDO_CMD(payload[0]) != CMD_ATTENTION;
+		return type == PD_DATA_SOURCE_CAP || type == PD_DATA_REQUEST;
+	}
+
+	switch (type) {
+	case PD_CTRL_GET_SOURCE_CAP:
+	case PD_CTRL_GET_SINK_CAP:
+	case PD_CTRL_DR_SWAP:
+	case PD_CTRL_PR_SWAP:
+	case PD_CTRL_VCONN_SWAP:
+	case PD_CTRL_SOFT_RESET:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* A message reached the protocol layer */
+static void timing_rx_message(int port, uint16_t head, const uint32_t *payload)
+{
+	struct pd_timing *t = &pd_timing[port];
+	/* Without a TCPC on this chip, start from when the message is read */
+	uint32_t start = t->msg_time ? t->msg_time : get_time().le.lo;
+
+	t->msg_time = 0;
+	t->reply_time = timing_needs_reply(head, payload) ? start : 0;
+}
+
+/* The protocol layer starts sending a message */
+static void timing_tx(int port)
+{
+	struct pd_timing *t = &pd_timing[port];
+
+	if (!t->reply_time)
+		return;
+	timing_record(t->rx_reply, &t->rx_reply_max_us, t->reply_time);
+	t->reply_time = 0;
+}
+
+static void timing_tx_error(int port)
+{
+	timing_inc(&pd_timing[port].tx_errors);
+}
+
+static void timing_state_timeout(int port)
+{
+	timing_inc(&pd_timing[port].state_timeouts);
+}
+
+static void timing_vdm_timeout(int port)
+{
+	timing_inc(&pd_timing[port].vdm_timeouts);
+}
+
+static void timing_set_state(int port, enum pd_states last_state,
+			     enum pd_states next_state)
+{
+	struct pd_timing *t = &pd_timing[port];
+	struct ec_usb_pd_timing_state *s = &t->states[last_state];
+	uint64_t now = get_time().val;
+	uint32_t ms;
+
+	if (t->state_time) {
+		ms = (now - t->state_time) / MSEC;
+		s->total_ms += ms;
+		if (ms > s->max_ms)
+			s->max_ms = MIN(ms, 0xffff);
+	}
+	s = &t->states[next_state];
+	if (s->entries < 0xffff)
+		s->entries++;
+	t->state_time = now;
+
+	/* A reply still pending is lost with the connection */
+	if (next_state == PD_STATE_HARD_RESET_EXECUTE ||
+	    !pd_is_connected(port))
+		t->reply_time = 0;
+}
+
+#ifdef CONFIG_COMMON_RUNTIME
+/* Get the residency of a state, counting the stay in progress */
+static void timing_get_state(int port, enum pd_states state,
+			     struct ec_usb_pd_timing_state *s)
+{
+	struct pd_timing *t = &pd_timing[port];
+	uint32_t ms;
+
+	*s = t->states[state];
+	if (state != pd[port].task_state || !t->state_time)
+		return;
+
+	ms = (get_time().val - t->state_time) / MSEC;
+	s->total_ms += ms;
+	if (ms > s->max_ms)
+		s->max_ms = MIN(ms, 0xffff);
+}
+
+/* Clear the statistics of a port, keeping the timestamps in progress */
+static void timing_reset(int port)
+{
+	memset(&pd_timing[port], 0, offsetof(struct pd_timing, rx_time));
+	pd_timing[port].state_time = get_time().val;
+}
+#endif
+#else
+static inline void timing_rx_message(int port, uint16_t head,
+				     const uint32_t *payload) {}
+static inline void timing_tx(int port) {}
+static inline void timing_tx_error(int port) {}
+static inline void timing_state_timeout(int port) {}
+static inline void timing_vdm_timeout(int port) {}
+static inline void timing_set_state(int port, enum pd_states last_state,
+				    enum pd_states next_state) {}
+#endif /* CONFIG_USB_PD_TIMING */
+
 static inline void set_state_timeout(int port,
 				     uint64_t timeout,
 				     enum pd_states timeout_state)
@@ -247,6 +456,8 @@ static inline void set_state(int port, enum pd_states next_state)
 
 	if (last_state == next_state)
 		return;
+
+	timing_set_state(port, last_state, next_state);
 #ifdef CONFIG_USB_PD_DUAL_ROLE
 	/* Ignore dual-role toggling between sink and source */
 	if ((last_state == PD_STATE_SNK_DISCONNECTED &&
@@ -283,8 +494,9 @@ static inline void set_state(int port, enum pd_states next_state)
 		usb_mux_set(port, TYPEC_MUX_NONE, USB_SWITCH_DISCONNECT,
 			    pd[port].polarity);
 #endif
-		/* Disable TCPC RX */
-		tcpm_set_rx_enable(port, 0);
+		/* Disable TCPC RX, suspend did it before releasing the port */
+		if (last_state != PD_STATE_SUSPENDED)
+			tcpm_set_rx_enable(port, 0);
 	}
 
 #ifdef CONFIG_LOW_POWER_IDLE
@@ -308,13 +520,50 @@ static void inc_id(int port)
 	pd[port].msg_id = (pd[port].msg_id + 1) & PD_MESSAGE_ID_COUNT;
 }
 
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+/* Events posted to each port and not yet seen by its state machine */
+static uint32_t pd_port_events[CONFIG_USB_PD_PORT_COUNT];
+
+void pd_task_set_event(int port, uint32_t event)
+{
+	atomic_or(&pd_port_events[port], event);
+	task_set_event(TASK_ID_PD, event, 0);
+}
+
+/*
+ * Wait for events posted to one port.  The same event bits of the other
+ * ports stay pending, for the PD task to run them afterwards.
+ */
+static uint32_t pd_port_wait_event(int port, uint32_t mask, int timeout)
+{
+	uint64_t deadline = get_time().val + timeout;
+	uint32_t evt;
+	int64_t left;
+
+	while (1) {
+		evt = pd_port_events[port] & mask;
+		if (evt) {
+			atomic_clear(&pd_port_events[port], evt);
+			return evt;
+		}
+		left = deadline - get_time().val;
+		if (left <= 0)
+			return TASK_EVENT_TIMER;
+		task_wait_event_mask(mask, left);
+	}
+}
+#else
+#define pd_port_wait_event(port, mask, timeout) \
+	task_wait_event_mask(mask, timeout)
+#endif
+
 void pd_transmit_complete(int port, int status)
 {
 	if (status == TCPC_TX_COMPLETE_SUCCESS)
 		inc_id(port);
 
 	pd[port].tx_status = status;
-	task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_TX, 0);
+	pd_task_set_event(port, PD_EVENT_TX);
 }
 
 static int pd_transmit(int port, enum tcpm_transmit_type type,
@@ -326,16 +575,22 @@ static int pd_transmit(int port, enum tcpm_transmit_type type,
 	if (!pd_comm_enabled)
 		return -1;
 
+	if (type == TCPC_TX_SOP)
+		timing_tx(port);
+
 	tcpm_transmit(port, type, header, data);
 
 	/* Wait until TX is complete */
-	evt = task_wait_event_mask(PD_EVENT_TX, PD_T_TCPC_TX_TIMEOUT);
+	evt = pd_port_wait_event(port, PD_EVENT_TX, PD_T_TCPC_TX_TIMEOUT);
 
-	if (evt & TASK_EVENT_TIMER)
+	/* TODO: give different error condition for failed vs discarded */
+	if ((evt & TASK_EVENT_TIMER) ||
+	    pd[port].tx_status != TCPC_TX_COMPLETE_SUCCESS) {
+		timing_tx_error(port);
 		return -1;
+	}
 
-	/* TODO: give different error condition for failed vs discarded */
-	return pd[port].tx_status == TCPC_TX_COMPLETE_SUCCESS ? 1 : -1;
+	return 1;
 }
 
 static void pd_update_roles(int port)
@@ -538,7 +793,7 @@ void pd_soft_reset(void)
 	for (i = 0; i < CONFIG_USB_PD_PORT_COUNT; ++i)
 		if (pd_is_connected(i)) {
 			set_state(i, PD_STATE_SOFT_RESET);
-			task_wake(PD_PORT_TO_TASK_ID(i));
+			pd_task_set_event(i, TASK_EVENT_WAKE);
 		}
 }
 
@@ -768,7 +1023,7 @@ void pd_request_power_swap(int port)
 		set_state(port, PD_STATE_SRC_SWAP_INIT);
 	else if (pd[port].task_state == PD_STATE_SNK_READY)
 		set_state(port, PD_STATE_SNK_SWAP_INIT);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 #endif
 
@@ -778,7 +1033,7 @@ void pd_request_data_swap(int port)
 				pd[port].task_state == PD_STATE_SNK_READY,
 				pd[port].task_state == PD_STATE_SRC_READY))
 		set_state(port, PD_STATE_DR_SWAP);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 static void pd_set_data_role(int port, int role)
@@ -997,6 +1252,8 @@ static void handle_request(int port, uint16_t head,
 		CPRINTF("\n");
 	}
 
+	timing_rx_message(port, head, payload);
+
 	/*
 	 * If we are in disconnected state, we shouldn't get a request. Do
 	 * a hard reset if we get one.
@@ -1023,7 +1280,7 @@ void pd_send_vdm(int port, uint32_t vid, int cmd, const uint32_t *data,
 				   1 : (PD_VDO_CMD(cmd) < CMD_ATTENTION), cmd);
 	queue_vdm(port, pd[port].vdo_data, data, count);
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 static inline int pdo_busy(int port)
@@ -1113,6 +1370,7 @@ static void pd_vdm_send_state_machine(int port)
 		if (pd[port].vdm_timeout.val &&
 		    (get_time().val > pd[port].vdm_timeout.val)) {
 			pd[port].vdm_state = VDM_STATE_ERR_TMOUT;
+			timing_vdm_timeout(port);
 		}
 		break;
 	default:
@@ -1198,7 +1456,7 @@ void pd_set_dual_role(enum pd_dual_role_states state)
 			pd[i].power_role = PD_ROLE_SINK;
 			set_state(i, PD_STATE_SNK_DISCONNECTED);
 			tcpm_set_cc(i, TYPEC_CC_RD);
-			task_wake(PD_PORT_TO_TASK_ID(i));
+			pd_task_set_event(i, TASK_EVENT_WAKE);
 		}
 
 		/*
@@ -1210,7 +1468,7 @@ void pd_set_dual_role(enum pd_dual_role_states state)
 			pd[i].power_role = PD_ROLE_SOURCE;
 			set_state(i, PD_STATE_SRC_DISCONNECTED);
 			tcpm_set_cc(i, TYPEC_CC_RP);
-			task_wake(PD_PORT_TO_TASK_ID(i));
+			pd_task_set_event(i, TASK_EVENT_WAKE);
 		}
 	}
 }
@@ -1304,7 +1562,7 @@ static inline int get_typec_current_limit(int cc)
 void pd_set_new_power_request(int port)
 {
 	pd[port].new_power_request = 1;
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 #endif /* CONFIG_CHARGE_MANAGER */
 
@@ -1317,30 +1575,9 @@ void pd_set_new_power_request(int port)
 #error "Backwards compatible DFP does not support USB"
 #endif
 
-void pd_task(void)
+/* Reset the protocol state of a port and bring up its port controller */
+static void pd_port_init(int port)
 {
-	int head;
-	int port = TASK_ID_TO_PD_PORT(task_get_current());
-	uint32_t payload[7];
-	int timeout = 10*MSEC;
-	int cc1, cc2;
-	int res, incoming_packet = 0;
-	int hard_reset_count = 0;
-#ifdef CONFIG_USB_PD_DUAL_ROLE
-	uint64_t next_role_swap = PD_T_DRP_SNK;
-#ifndef CONFIG_USB_PD_NO_VBUS_DETECT
-	int snk_hard_reset_vbus_off = 0;
-#endif
-#ifdef CONFIG_CHARGE_MANAGER
-	int typec_curr = 0, typec_curr_change = 0;
-#endif /* CONFIG_CHARGE_MANAGER */
-#endif /* CONFIG_USB_PD_DUAL_ROLE */
-	enum pd_states this_state;
-	enum pd_cc_states new_cc_state;
-	timestamp_t now;
-	int caps_count = 0, hard_reset_sent = 0;
-	int evt;
-
 	/* Ensure the power supply is in the default state */
 	pd_power_supply_reset(port);
 
@@ -1376,1107 +1613,1240 @@ void pd_task(void)
 	charge_manager_update_dualrole(port, CAP_UNKNOWN);
 #endif
 
-	while (1) {
-		/* process VDM messages last */
-		pd_vdm_send_state_machine(port);
+#ifdef CONFIG_USB_PD_DUAL_ROLE
+	/* First DRP toggle */
+	pd[port].next_role_swap = PD_T_DRP_SNK;
+#endif
+}
 
-		/* Verify board specific health status : current, voltages... */
-		res = pd_board_checks();
-		if (res != EC_SUCCESS) {
-			/* cut the power */
-			pd_execute_hard_reset(port);
-			/* notify the other side of the issue */
-			pd_transmit(port, TCPC_TX_HARD_RESET, 0, NULL);
-		}
+/*
+ * Work done at the end of each pass of the state machine, before the port
+ * waits for its next event.
+ */
+static void pd_port_finish_pass(int port)
+{
+	/* process VDM messages last */
+	pd_vdm_send_state_machine(port);
 
-		/* wait for next event/packet or timeout expiration */
-		evt = task_wait_event(timeout);
+	/* Verify board specific health status : current, voltages... */
+	if (pd_board_checks() != EC_SUCCESS) {
+		/* cut the power */
+		pd_execute_hard_reset(port);
+		/* notify the other side of the issue */
+		pd_transmit(port, TCPC_TX_HARD_RESET, 0, NULL);
+	}
+}
 
-#ifdef CONFIG_USB_PD_TCPC
-		/*
-		 * run port controller task to check CC and/or read incoming
-		 * messages
-		 */
-		tcpc_run(port, evt);
-#endif
-
-		/* process any potential incoming message */
-		incoming_packet = evt & PD_EVENT_RX;
-		if (incoming_packet) {
-			tcpm_get_message(port, payload, &head);
-			if (head > 0)
-				handle_request(port, head, payload);
-		}
-		/* if nothing to do, verify the state of the world in 500ms */
-		this_state = pd[port].task_state;
-		timeout = 500*MSEC;
-		switch (this_state) {
-		case PD_STATE_DISABLED:
-			/* Nothing to do */
-			break;
-		case PD_STATE_SRC_DISCONNECTED:
-			timeout = 10*MSEC;
-			tcpm_get_cc(port, &cc1, &cc2);
+/**
+ * Run one pass of the state machine of a port.
+ *
+ * @param port		USB-C port number
+ * @param evt		Events which woke the port, or TASK_EVENT_TIMER
+ * @return How long the port can sleep before its next pass, in us, or -1
+ */
+static int pd_port_run(int port, int evt)
+{
+	int head;
+	uint32_t payload[7];
+	int timeout;
+	int cc1, cc2;
+	int res, incoming_packet;
+	enum pd_states this_state;
+	enum pd_cc_states new_cc_state;
+	timestamp_t now;
+
+#if defined(CONFIG_USB_PD_SINGLE_TASK) && defined(CONFIG_USB_PD_TCPC)
+	if (pd[port].last_state == PD_STATE_SUSPENDED) {
+		/* The hardware is released until pd_set_suspend() resumes */
+		if (pd[port].task_state == PD_STATE_SUSPENDED)
+			return -1;
+		pd_hw_init(port, PD_ROLE_DEFAULT);
+	}
+#endif
+
+#if defined(CONFIG_USB_PD_TCPC) && !defined(CONFIG_USB_PD_SINGLE_TASK)
+	/*
+	 * run port controller task to check CC and/or read incoming
+	 * messages
+	 */
+	tcpc_run(port, evt);
+#endif
 
-			/* Vnc monitoring */
-			if ((cc1 == TYPEC_CC_VOLT_RD ||
-			     cc2 == TYPEC_CC_VOLT_RD) ||
-			    (cc1 == TYPEC_CC_VOLT_RA &&
-			     cc2 == TYPEC_CC_VOLT_RA)) {
+	/* process any potential incoming message */
+	incoming_packet = evt & PD_EVENT_RX;
+	if (incoming_packet) {
+		tcpm_get_message(port, payload, &head);
+		if (head > 0)
+			handle_request(port, head, payload);
+	}
+	/* if nothing to do, verify the state of the world in 500ms */
+	this_state = pd[port].task_state;
+	timeout = 500*MSEC;
+	switch (this_state) {
+	case PD_STATE_DISABLED:
+		/* Nothing to do */
+		break;
+	case PD_STATE_SRC_DISCONNECTED:
+		timeout = 10*MSEC;
+		tcpm_get_cc(port, &cc1, &cc2);
+
+		/* Vnc monitoring */
+		if ((cc1 == TYPEC_CC_VOLT_RD ||
+		     cc2 == TYPEC_CC_VOLT_RD) ||
+		    (cc1 == TYPEC_CC_VOLT_RA &&
+		     cc2 == TYPEC_CC_VOLT_RA)) {
 #ifdef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
-				/* Enable VBUS */
-				if (pd_set_power_supply_ready(port))
-					break;
+			/* Enable VBUS */
+			if (pd_set_power_supply_ready(port))
+				break;
 #endif
-				pd[port].cc_state = PD_CC_NONE;
-				set_state(port,
-					PD_STATE_SRC_DISCONNECTED_DEBOUNCE);
-			}
+			pd[port].cc_state = PD_CC_NONE;
+			set_state(port,
+				PD_STATE_SRC_DISCONNECTED_DEBOUNCE);
+		}
 #ifdef CONFIG_USB_PD_DUAL_ROLE
-			/*
-			 * Try.SRC state is embedded here. Wait for SNK
-			 * detect, or if timer expires, transition to
-			 * SNK_DISCONNETED.
-			 *
-			 * If Try.SRC state is not active, then this block
-			 * handles the normal DRP toggle from SRC->SNK
-			 */
-			else if ((pd[port].flags & PD_FLAGS_TRY_SRC &&
-				 get_time().val >= pd[port].try_src_marker) ||
-				 (!(pd[port].flags & PD_FLAGS_TRY_SRC) &&
-				  drp_state != PD_DRP_FORCE_SOURCE &&
-				 get_time().val >= next_role_swap)) {
-				pd[port].power_role = PD_ROLE_SINK;
-				set_state(port, PD_STATE_SNK_DISCONNECTED);
-				tcpm_set_cc(port, TYPEC_CC_RD);
-				next_role_swap = get_time().val + PD_T_DRP_SNK;
-				pd[port].try_src_marker = get_time().val
-					+ PD_T_TRY_WAIT;
+		/*
+		 * Try.SRC state is embedded here. Wait for SNK
+		 * detect, or if timer expires, transition to
+		 * SNK_DISCONNETED.
+		 *
+		 * If Try.SRC state is not active, then this block
+		 * handles the normal DRP toggle from SRC->SNK
+		 */
+		else if ((pd[port].flags & PD_FLAGS_TRY_SRC &&
+			 get_time().val >= pd[port].try_src_marker) ||
+			 (!(pd[port].flags & PD_FLAGS_TRY_SRC) &&
+			  drp_state != PD_DRP_FORCE_SOURCE &&
+			 get_time().val >= pd[port].next_role_swap)) {
+			pd[port].power_role = PD_ROLE_SINK;
+			set_state(port, PD_STATE_SNK_DISCONNECTED);
+			tcpm_set_cc(port, TYPEC_CC_RD);
+			pd[port].next_role_swap = get_time().val + PD_T_DRP_SNK;
+			pd[port].try_src_marker = get_time().val
+				+ PD_T_TRY_WAIT;
 
-				/* Swap states quickly */
-				timeout = 2*MSEC;
-			}
+			/* Swap states quickly */
+			timeout = 2*MSEC;
+		}
 #endif
-			break;
-		case PD_STATE_SRC_DISCONNECTED_DEBOUNCE:
-			timeout = 20*MSEC;
-			tcpm_get_cc(port, &cc1, &cc2);
-
-			if (cc1 == TYPEC_CC_VOLT_RD &&
-			    cc2 == TYPEC_CC_VOLT_RD) {
-				/* Debug accessory */
-				new_cc_state = PD_CC_DEBUG_ACC;
-			} else if (cc1 == TYPEC_CC_VOLT_RD ||
-				   cc2 == TYPEC_CC_VOLT_RD) {
-				/* UFP attached */
-				new_cc_state = PD_CC_UFP_ATTACHED;
-			} else if (cc1 == TYPEC_CC_VOLT_RA &&
-				   cc2 == TYPEC_CC_VOLT_RA) {
-				/* Audio accessory */
-				new_cc_state = PD_CC_AUDIO_ACC;
-			} else {
-				/* No UFP */
+		break;
+	case PD_STATE_SRC_DISCONNECTED_DEBOUNCE:
+		timeout = 20*MSEC;
+		tcpm_get_cc(port, &cc1, &cc2);
+
+		if (cc1 == TYPEC_CC_VOLT_RD &&
+		    cc2 == TYPEC_CC_VOLT_RD) {
+			/* Debug accessory */
+			new_cc_state = PD_CC_DEBUG_ACC;
+		} else if (cc1 == TYPEC_CC_VOLT_RD ||
+			   cc2 == TYPEC_CC_VOLT_RD) {
+			/* UFP attached */
+			new_cc_state = PD_CC_UFP_ATTACHED;
+		} else if (cc1 == TYPEC_CC_VOLT_RA &&
+			   cc2 == TYPEC_CC_VOLT_RA) {
+			/* Audio accessory */
+			new_cc_state = PD_CC_AUDIO_ACC;
+		} else {
+			/* No UFP */
 #ifdef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
-				/* No connection any more, remove VBUS */
-				pd_power_supply_reset(port);
+			/* No connection any more, remove VBUS */
+			pd_power_supply_reset(port);
 #endif
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
-				timeout = 5*MSEC;
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
+			timeout = 5*MSEC;
+			break;
+		}
+		/* If in Try.SRC state, then don't need to debounce */
+		if (!(pd[port].flags & PD_FLAGS_TRY_SRC)) {
+			/* Debounce the cc state */
+			if (new_cc_state != pd[port].cc_state) {
+				pd[port].cc_debounce = get_time().val +
+					PD_T_CC_DEBOUNCE;
+				pd[port].cc_state = new_cc_state;
+				break;
+			} else if (get_time().val <
+				   pd[port].cc_debounce) {
 				break;
 			}
-			/* If in Try.SRC state, then don't need to debounce */
-			if (!(pd[port].flags & PD_FLAGS_TRY_SRC)) {
-				/* Debounce the cc state */
-				if (new_cc_state != pd[port].cc_state) {
-					pd[port].cc_debounce = get_time().val +
-						PD_T_CC_DEBOUNCE;
-					pd[port].cc_state = new_cc_state;
-					break;
-				} else if (get_time().val <
-					   pd[port].cc_debounce) {
-					break;
-				}
-			}
+		}
 
-			/* Debounce complete */
-			/* UFP is attached */
-			if (new_cc_state == PD_CC_UFP_ATTACHED) {
-				pd[port].polarity = (cc2 == TYPEC_CC_VOLT_RD);
-				tcpm_set_polarity(port, pd[port].polarity);
+		/* Debounce complete */
+		/* UFP is attached */
+		if (new_cc_state == PD_CC_UFP_ATTACHED) {
+			pd[port].polarity = (cc2 == TYPEC_CC_VOLT_RD);
+			tcpm_set_polarity(port, pd[port].polarity);
 
-				/* initial data role for source is DFP */
-				pd_set_data_role(port, PD_ROLE_DFP);
+			/* initial data role for source is DFP */
+			pd_set_data_role(port, PD_ROLE_DFP);
 
 #ifndef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
-				/* Enable VBUS */
-				if (pd_set_power_supply_ready(port)) {
+			/* Enable VBUS */
+			if (pd_set_power_supply_ready(port)) {
 #ifdef CONFIG_USBC_SS_MUX
-					usb_mux_set(port, TYPEC_MUX_NONE,
-						    USB_SWITCH_DISCONNECT,
-						    pd[port].polarity);
+				usb_mux_set(port, TYPEC_MUX_NONE,
+					    USB_SWITCH_DISCONNECT,
+					    pd[port].polarity);
 #endif
-					break;
-				}
+				break;
+			}
 #endif
-				/* If PD comm is enabled, enable TCPC RX */
-				if (pd_comm_enabled)
-					tcpm_set_rx_enable(port, 1);
+			/* If PD comm is enabled, enable TCPC RX */
+			if (pd_comm_enabled)
+				tcpm_set_rx_enable(port, 1);
 
 #ifdef CONFIG_USBC_VCONN
-				tcpm_set_vconn(port, 1);
-				pd[port].flags |= PD_FLAGS_VCONN_ON;
+			tcpm_set_vconn(port, 1);
+			pd[port].flags |= PD_FLAGS_VCONN_ON;
 #endif
 
-				pd[port].flags |= PD_FLAGS_CHECK_PR_ROLE |
-						  PD_FLAGS_CHECK_DR_ROLE;
-				hard_reset_count = 0;
-				timeout = 5*MSEC;
-				set_state(port, PD_STATE_SRC_STARTUP);
-			}
-			/* Accessory is attached */
-			else if (new_cc_state == PD_CC_AUDIO_ACC ||
-				 new_cc_state == PD_CC_DEBUG_ACC) {
+			pd[port].flags |= PD_FLAGS_CHECK_PR_ROLE |
+					  PD_FLAGS_CHECK_DR_ROLE;
+			pd[port].hard_reset_count = 0;
+			timeout = 5*MSEC;
+			set_state(port, PD_STATE_SRC_STARTUP);
+		}
+		/* Accessory is attached */
+		else if (new_cc_state == PD_CC_AUDIO_ACC ||
+			 new_cc_state == PD_CC_DEBUG_ACC) {
 #ifdef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
-				/* Remove VBUS */
-				pd_power_supply_reset(port);
+			/* Remove VBUS */
+			pd_power_supply_reset(port);
 #endif
 
-				/* Set the USB muxes and the default USB role */
-				pd_set_data_role(port, CONFIG_USB_PD_DEBUG_DR);
+			/* Set the USB muxes and the default USB role */
+			pd_set_data_role(port, CONFIG_USB_PD_DEBUG_DR);
 
 #ifdef CONFIG_CASE_CLOSED_DEBUG
-				if (new_cc_state == PD_CC_DEBUG_ACC) {
-					ccd_set_mode(CCD_MODE_ENABLED);
-					typec_set_input_current_limit(
-						port, 3000, TYPE_C_VOLTAGE);
-					charge_manager_update_dualrole(
-						port, CAP_DEDICATED);
-				}
-#endif
-				set_state(port, PD_STATE_SRC_ACCESSORY);
+			if (new_cc_state == PD_CC_DEBUG_ACC) {
+				ccd_set_mode(CCD_MODE_ENABLED);
+				typec_set_input_current_limit(
+					port, 3000, TYPE_C_VOLTAGE);
+				charge_manager_update_dualrole(
+					port, CAP_DEDICATED);
 			}
-			break;
-		case PD_STATE_SRC_ACCESSORY:
-			/* Combined audio / debug accessory state */
-			timeout = 100*MSEC;
-
-			tcpm_get_cc(port, &cc1, &cc2);
-
-			/* If accessory becomes detached */
-			if ((pd[port].cc_state == PD_CC_AUDIO_ACC &&
-			     (cc1 != TYPEC_CC_VOLT_RA ||
-			      cc2 != TYPEC_CC_VOLT_RA)) ||
-			    (pd[port].cc_state == PD_CC_DEBUG_ACC &&
-			     (cc1 != TYPEC_CC_VOLT_RD ||
-			      cc2 != TYPEC_CC_VOLT_RD))) {
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
+#endif
+			set_state(port, PD_STATE_SRC_ACCESSORY);
+		}
+		break;
+	case PD_STATE_SRC_ACCESSORY:
+		/* Combined audio / debug accessory state */
+		timeout = 100*MSEC;
+
+		tcpm_get_cc(port, &cc1, &cc2);
+
+		/* If accessory becomes detached */
+		if ((pd[port].cc_state == PD_CC_AUDIO_ACC &&
+		     (cc1 != TYPEC_CC_VOLT_RA ||
+		      cc2 != TYPEC_CC_VOLT_RA)) ||
+		    (pd[port].cc_state == PD_CC_DEBUG_ACC &&
+		     (cc1 != TYPEC_CC_VOLT_RD ||
+		      cc2 != TYPEC_CC_VOLT_RD))) {
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
 #ifdef CONFIG_CASE_CLOSED_DEBUG
-				ccd_set_mode(CCD_MODE_DISABLED);
+			ccd_set_mode(CCD_MODE_DISABLED);
 #endif
-				timeout = 10*MSEC;
-			}
+			timeout = 10*MSEC;
+		}
+		break;
+	case PD_STATE_SRC_HARD_RESET_RECOVER:
+		/* Do not continue until hard reset recovery time */
+		if (get_time().val < pd[port].src_recover) {
+			timeout = 50*MSEC;
 			break;
-		case PD_STATE_SRC_HARD_RESET_RECOVER:
-			/* Do not continue until hard reset recovery time */
-			if (get_time().val < pd[port].src_recover) {
-				timeout = 50*MSEC;
-				break;
-			}
+		}
 
-			/* Enable VBUS */
-			timeout = 10*MSEC;
-			if (pd_set_power_supply_ready(port)) {
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
-				break;
-			}
-			set_state(port, PD_STATE_SRC_STARTUP);
+		/* Enable VBUS */
+		timeout = 10*MSEC;
+		if (pd_set_power_supply_ready(port)) {
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
 			break;
-		case PD_STATE_SRC_STARTUP:
-			/* Wait for power source to enable */
-			if (pd[port].last_state != pd[port].task_state) {
+		}
+		set_state(port, PD_STATE_SRC_STARTUP);
+		break;
+	case PD_STATE_SRC_STARTUP:
+		/* Wait for power source to enable */
+		if (pd[port].last_state != pd[port].task_state) {
+			/*
+			 * fake set data role swapped flag so we send
+			 * discover identity when we enter SRC_READY
+			 */
+			pd[port].flags |= PD_FLAGS_DATA_SWAPPED;
+			/* reset various counters */
+			pd[port].caps_count = 0;
+			pd[port].msg_id = 0;
+			set_state_timeout(
+				port,
+#ifdef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
 				/*
-				 * fake set data role swapped flag so we send
-				 * discover identity when we enter SRC_READY
+				 * delay for power supply to start up.
+				 * subtract out debounce time if coming
+				 * from debounce state since vbus is
+				 * on during debounce.
 				 */
-				pd[port].flags |= PD_FLAGS_DATA_SWAPPED;
-				/* reset various counters */
-				caps_count = 0;
-				pd[port].msg_id = 0;
-				set_state_timeout(
-					port,
-#ifdef CONFIG_USBC_BACKWARDS_COMPATIBLE_DFP
-					/*
-					 * delay for power supply to start up.
-					 * subtract out debounce time if coming
-					 * from debounce state since vbus is
-					 * on during debounce.
-					 */
-					get_time().val +
-					PD_POWER_SUPPLY_TURN_ON_DELAY -
-					  (pd[port].last_state ==
-					   PD_STATE_SRC_DISCONNECTED_DEBOUNCE
-						? PD_T_CC_DEBOUNCE : 0),
+				get_time().val +
+				PD_POWER_SUPPLY_TURN_ON_DELAY -
+				  (pd[port].last_state ==
+				   PD_STATE_SRC_DISCONNECTED_DEBOUNCE
+					? PD_T_CC_DEBOUNCE : 0),
 #else
-					get_time().val +
-					PD_POWER_SUPPLY_TURN_ON_DELAY,
+				get_time().val +
+				PD_POWER_SUPPLY_TURN_ON_DELAY,
 #endif
-					PD_STATE_SRC_DISCOVERY);
-			}
-			break;
-		case PD_STATE_SRC_DISCOVERY:
-			if (pd[port].last_state != pd[port].task_state) {
-				/*
-				 * If we have had PD connection with this port
-				 * partner, then start NoResponseTimer.
-				 */
-				if (pd[port].flags & PD_FLAGS_PREVIOUS_PD_CONN)
-					set_state_timeout(port,
-						get_time().val +
-						PD_T_NO_RESPONSE,
-						hard_reset_count <
-						  PD_HARD_RESET_COUNT ?
-						    PD_STATE_HARD_RESET_SEND :
-						    PD_STATE_SRC_DISCONNECTED);
-			}
+				PD_STATE_SRC_DISCOVERY);
+		}
+		break;
+	case PD_STATE_SRC_DISCOVERY:
+		if (pd[port].last_state != pd[port].task_state) {
+			/*
+			 * If we have had PD connection with this port
+			 * partner, then start NoResponseTimer.
+			 */
+			if (pd[port].flags & PD_FLAGS_PREVIOUS_PD_CONN)
+				set_state_timeout(port,
+					get_time().val +
+					PD_T_NO_RESPONSE,
+					pd[port].hard_reset_count <
+					  PD_HARD_RESET_COUNT ?
+					    PD_STATE_HARD_RESET_SEND :
+					    PD_STATE_SRC_DISCONNECTED);
+		}
 
-			/* Send source cap some minimum number of times */
-			if (caps_count < PD_CAPS_COUNT) {
-				/* Query capabilites of the other side */
-				res = send_source_cap(port);
-				/* packet was acked => PD capable device) */
-				if (res >= 0) {
-					set_state(port,
-						  PD_STATE_SRC_NEGOCIATE);
-					timeout = 10*MSEC;
-					hard_reset_count = 0;
-					caps_count = 0;
-					/* Port partner is PD capable */
-					pd[port].flags |=
-						PD_FLAGS_PREVIOUS_PD_CONN;
-				} else { /* failed, retry later */
-					timeout = PD_T_SEND_SOURCE_CAP;
-					caps_count++;
-				}
-			}
-			break;
-		case PD_STATE_SRC_NEGOCIATE:
-			/* wait for a "Request" message */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  PD_STATE_HARD_RESET_SEND);
-			break;
-		case PD_STATE_SRC_ACCEPTED:
-			/* Accept sent, wait for enabling the new voltage */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(
-					port,
-					get_time().val +
-					PD_T_SINK_TRANSITION,
-					PD_STATE_SRC_POWERED);
-			break;
-		case PD_STATE_SRC_POWERED:
-			/* Switch to the new requested voltage */
-			if (pd[port].last_state != pd[port].task_state) {
-				pd_transition_voltage(pd[port].requested_idx);
-				set_state_timeout(
-					port,
-					get_time().val +
-					PD_POWER_SUPPLY_TURN_ON_DELAY,
-					PD_STATE_SRC_TRANSITION);
-			}
-			break;
-		case PD_STATE_SRC_TRANSITION:
-			/* the voltage output is good, notify the source */
-			res = send_control(port, PD_CTRL_PS_RDY);
+		/* Send source cap some minimum number of times */
+		if (pd[port].caps_count < PD_CAPS_COUNT) {
+			/* Query capabilites of the other side */
+			res = send_source_cap(port);
+			/* packet was acked => PD capable device) */
 			if (res >= 0) {
+				set_state(port,
+					  PD_STATE_SRC_NEGOCIATE);
 				timeout = 10*MSEC;
-				/* it'a time to ping regularly the sink */
-				set_state(port, PD_STATE_SRC_READY);
-			} else {
-				/* The sink did not ack, cut the power... */
-				pd_power_supply_reset(port);
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
+				pd[port].hard_reset_count = 0;
+				pd[port].caps_count = 0;
+				/* Port partner is PD capable */
+				pd[port].flags |=
+					PD_FLAGS_PREVIOUS_PD_CONN;
+			} else { /* failed, retry later */
+				timeout = PD_T_SEND_SOURCE_CAP;
+				pd[port].caps_count++;
 			}
-			break;
-		case PD_STATE_SRC_READY:
-			timeout = PD_T_SOURCE_ACTIVITY;
+		}
+		break;
+	case PD_STATE_SRC_NEGOCIATE:
+		/* wait for a "Request" message */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  PD_STATE_HARD_RESET_SEND);
+		break;
+	case PD_STATE_SRC_ACCEPTED:
+		/* Accept sent, wait for enabling the new voltage */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(
+				port,
+				get_time().val +
+				PD_T_SINK_TRANSITION,
+				PD_STATE_SRC_POWERED);
+		break;
+	case PD_STATE_SRC_POWERED:
+		/* Switch to the new requested voltage */
+		if (pd[port].last_state != pd[port].task_state) {
+			pd_transition_voltage(pd[port].requested_idx);
+			set_state_timeout(
+				port,
+				get_time().val +
+				PD_POWER_SUPPLY_TURN_ON_DELAY,
+				PD_STATE_SRC_TRANSITION);
+		}
+		break;
+	case PD_STATE_SRC_TRANSITION:
+		/* the voltage output is good, notify the source */
+		res = send_control(port, PD_CTRL_PS_RDY);
+		if (res >= 0) {
+			timeout = 10*MSEC;
+			/* it'a time to ping regularly the sink */
+			set_state(port, PD_STATE_SRC_READY);
+		} else {
+			/* The sink did not ack, cut the power... */
+			pd_power_supply_reset(port);
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
+		}
+		break;
+	case PD_STATE_SRC_READY:
+		timeout = PD_T_SOURCE_ACTIVITY;
 
-			if (pd[port].last_state != pd[port].task_state)
-				pd[port].flags |= PD_FLAGS_GET_SNK_CAP_SENT;
+		if (pd[port].last_state != pd[port].task_state)
+			pd[port].flags |= PD_FLAGS_GET_SNK_CAP_SENT;
 
-			/*
-			 * Don't send any PD traffic if we woke up due to
-			 * incoming packet or if VDO response pending to avoid
-			 * collisions.
-			 */
-			if (incoming_packet ||
-			    (pd[port].vdm_state == VDM_STATE_BUSY))
-				break;
+		/*
+		 * Don't send any PD traffic if we woke up due to
+		 * incoming packet or if VDO response pending to avoid
+		 * collisions.
+		 */
+		if (incoming_packet ||
+		    (pd[port].vdm_state == VDM_STATE_BUSY))
+			break;
 
-			/* Send get sink cap if haven't received it yet */
-			if ((pd[port].flags & PD_FLAGS_GET_SNK_CAP_SENT) &&
-			    !(pd[port].flags & PD_FLAGS_SNK_CAP_RECVD)) {
-				/* Get sink cap to know if dual-role device */
-				send_control(port, PD_CTRL_GET_SINK_CAP);
-				set_state(port, PD_STATE_SRC_GET_SINK_CAP);
-				pd[port].flags &= ~PD_FLAGS_GET_SNK_CAP_SENT;
-				break;
-			}
+		/* Send get sink cap if haven't received it yet */
+		if ((pd[port].flags & PD_FLAGS_GET_SNK_CAP_SENT) &&
+		    !(pd[port].flags & PD_FLAGS_SNK_CAP_RECVD)) {
+			/* Get sink cap to know if dual-role device */
+			send_control(port, PD_CTRL_GET_SINK_CAP);
+			set_state(port, PD_STATE_SRC_GET_SINK_CAP);
+			pd[port].flags &= ~PD_FLAGS_GET_SNK_CAP_SENT;
+			break;
+		}
 
-			/* Check power role policy, which may trigger a swap */
-			if (pd[port].flags & PD_FLAGS_CHECK_PR_ROLE) {
-				pd_check_pr_role(port, PD_ROLE_SOURCE,
-						 pd[port].flags);
-				pd[port].flags &= ~PD_FLAGS_CHECK_PR_ROLE;
-				break;
-			}
+		/* Check power role policy, which may trigger a swap */
+		if (pd[port].flags & PD_FLAGS_CHECK_PR_ROLE) {
+			pd_check_pr_role(port, PD_ROLE_SOURCE,
+					 pd[port].flags);
+			pd[port].flags &= ~PD_FLAGS_CHECK_PR_ROLE;
+			break;
+		}
 
-			/* Check data role policy, which may trigger a swap */
-			if (pd[port].flags & PD_FLAGS_CHECK_DR_ROLE) {
-				pd_check_dr_role(port, pd[port].data_role,
-						 pd[port].flags);
-				pd[port].flags &= ~PD_FLAGS_CHECK_DR_ROLE;
-				break;
-			}
+		/* Check data role policy, which may trigger a swap */
+		if (pd[port].flags & PD_FLAGS_CHECK_DR_ROLE) {
+			pd_check_dr_role(port, pd[port].data_role,
+					 pd[port].flags);
+			pd[port].flags &= ~PD_FLAGS_CHECK_DR_ROLE;
+			break;
+		}
 
-			/* Send discovery SVDMs last */
-			if (pd[port].data_role == PD_ROLE_DFP &&
-			    (pd[port].flags & PD_FLAGS_DATA_SWAPPED)) {
+		/* Send discovery SVDMs last */
+		if (pd[port].data_role == PD_ROLE_DFP &&
+		    (pd[port].flags & PD_FLAGS_DATA_SWAPPED)) {
 #ifndef CONFIG_USB_PD_SIMPLE_DFP
-				pd_send_vdm(port, USB_SID_PD,
-					    CMD_DISCOVER_IDENT, NULL, 0);
+			pd_send_vdm(port, USB_SID_PD,
+				    CMD_DISCOVER_IDENT, NULL, 0);
 #endif
-				pd[port].flags &= ~PD_FLAGS_DATA_SWAPPED;
-				break;
-			}
-
-			if (!(pd[port].flags & PD_FLAGS_PING_ENABLED))
-				break;
-
-			/* Verify that the sink is alive */
-			res = send_control(port, PD_CTRL_PING);
-			if (res >= 0)
-				break;
+			pd[port].flags &= ~PD_FLAGS_DATA_SWAPPED;
+			break;
+		}
 
-			/* Ping dropped. Try soft reset. */
-			set_state(port, PD_STATE_SOFT_RESET);
-			timeout = 10 * MSEC;
+		if (!(pd[port].flags & PD_FLAGS_PING_ENABLED))
 			break;
-		case PD_STATE_SRC_GET_SINK_CAP:
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  PD_STATE_SRC_READY);
+
+		/* Verify that the sink is alive */
+		res = send_control(port, PD_CTRL_PING);
+		if (res >= 0)
 			break;
-		case PD_STATE_DR_SWAP:
-			if (pd[port].last_state != pd[port].task_state) {
-				res = send_control(port, PD_CTRL_DR_SWAP);
-				if (res < 0) {
-					timeout = 10*MSEC;
-					/*
-					 * If failed to get goodCRC, send
-					 * soft reset, otherwise ignore
-					 * failure.
-					 */
-					set_state(port, res == -1 ?
-						   PD_STATE_SOFT_RESET :
-						   READY_RETURN_STATE(port));
-					break;
-				}
-				/* Wait for accept or reject */
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  READY_RETURN_STATE(port));
+
+		/* Ping dropped. Try soft reset. */
+		set_state(port, PD_STATE_SOFT_RESET);
+		timeout = 10 * MSEC;
+		break;
+	case PD_STATE_SRC_GET_SINK_CAP:
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  PD_STATE_SRC_READY);
+		break;
+	case PD_STATE_DR_SWAP:
+		if (pd[port].last_state != pd[port].task_state) {
+			res = send_control(port, PD_CTRL_DR_SWAP);
+			if (res < 0) {
+				timeout = 10*MSEC;
+				/*
+				 * If failed to get goodCRC, send
+				 * soft reset, otherwise ignore
+				 * failure.
+				 */
+				set_state(port, res == -1 ?
+					   PD_STATE_SOFT_RESET :
+					   READY_RETURN_STATE(port));
+				break;
 			}
-			break;
+			/* Wait for accept or reject */
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  READY_RETURN_STATE(port));
+		}
+		break;
 #ifdef CONFIG_USB_PD_DUAL_ROLE
-		case PD_STATE_SRC_SWAP_INIT:
-			if (pd[port].last_state != pd[port].task_state) {
-				res = send_control(port, PD_CTRL_PR_SWAP);
-				if (res < 0) {
-					timeout = 10*MSEC;
-					/*
-					 * If failed to get goodCRC, send
-					 * soft reset, otherwise ignore
-					 * failure.
-					 */
-					set_state(port, res == -1 ?
-						   PD_STATE_SOFT_RESET :
-						   PD_STATE_SRC_READY);
-					break;
-				}
-				/* Wait for accept or reject */
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  PD_STATE_SRC_READY);
-			}
-			break;
-		case PD_STATE_SRC_SWAP_SNK_DISABLE:
-			/* Give time for sink to stop drawing current */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SINK_TRANSITION,
-						  PD_STATE_SRC_SWAP_SRC_DISABLE);
-			break;
-		case PD_STATE_SRC_SWAP_SRC_DISABLE:
-			/* Turn power off */
-			if (pd[port].last_state != pd[port].task_state) {
-				pd_power_supply_reset(port);
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_POWER_SUPPLY_TURN_OFF_DELAY,
-						  PD_STATE_SRC_SWAP_STANDBY);
+	case PD_STATE_SRC_SWAP_INIT:
+		if (pd[port].last_state != pd[port].task_state) {
+			res = send_control(port, PD_CTRL_PR_SWAP);
+			if (res < 0) {
+				timeout = 10*MSEC;
+				/*
+				 * If failed to get goodCRC, send
+				 * soft reset, otherwise ignore
+				 * failure.
+				 */
+				set_state(port, res == -1 ?
+					   PD_STATE_SOFT_RESET :
+					   PD_STATE_SRC_READY);
+				break;
 			}
-			break;
-		case PD_STATE_SRC_SWAP_STANDBY:
-			/* Send PS_RDY to let sink know our power is off */
-			if (pd[port].last_state != pd[port].task_state) {
-				/* Send PS_RDY */
-				res = send_control(port, PD_CTRL_PS_RDY);
-				if (res < 0) {
-					timeout = 10*MSEC;
-					set_state(port,
-						  PD_STATE_SRC_DISCONNECTED);
-					break;
-				}
-				/* Switch to Rd and swap roles to sink */
-				tcpm_set_cc(port, TYPEC_CC_RD);
-				pd[port].power_role = PD_ROLE_SINK;
-				/* Wait for PS_RDY from new source */
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_PS_SOURCE_ON,
-						  PD_STATE_SNK_DISCONNECTED);
+			/* Wait for accept or reject */
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  PD_STATE_SRC_READY);
+		}
+		break;
+	case PD_STATE_SRC_SWAP_SNK_DISABLE:
+		/* Give time for sink to stop drawing current */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SINK_TRANSITION,
+					  PD_STATE_SRC_SWAP_SRC_DISABLE);
+		break;
+	case PD_STATE_SRC_SWAP_SRC_DISABLE:
+		/* Turn power off */
+		if (pd[port].last_state != pd[port].task_state) {
+			pd_power_supply_reset(port);
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_POWER_SUPPLY_TURN_OFF_DELAY,
+					  PD_STATE_SRC_SWAP_STANDBY);
+		}
+		break;
+	case PD_STATE_SRC_SWAP_STANDBY:
+		/* Send PS_RDY to let sink know our power is off */
+		if (pd[port].last_state != pd[port].task_state) {
+			/* Send PS_RDY */
+			res = send_control(port, PD_CTRL_PS_RDY);
+			if (res < 0) {
+				timeout = 10*MSEC;
+				set_state(port,
+					  PD_STATE_SRC_DISCONNECTED);
+				break;
 			}
-			break;
-		case PD_STATE_SUSPENDED:
-			/*
-			 * TODO: Suspend state only supported if we are also
-			 * the TCPC.
-			 */
+			/* Switch to Rd and swap roles to sink */
+			tcpm_set_cc(port, TYPEC_CC_RD);
+			pd[port].power_role = PD_ROLE_SINK;
+			/* Wait for PS_RDY from new source */
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_PS_SOURCE_ON,
+					  PD_STATE_SNK_DISCONNECTED);
+		}
+		break;
+	case PD_STATE_SUSPENDED:
+		/*
+		 * TODO: Suspend state only supported if we are also
+		 * the TCPC.
+		 */
 #ifdef CONFIG_USB_PD_TCPC
-			pd_rx_disable_monitoring(port);
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+		/*
+		 * The task also runs the other ports, so it cannot block
+		 * here.  Release the port once and sleep until resumed;
+		 * pd_port_run() brings the hardware back up.
+		 */
+		if (pd[port].last_state != this_state) {
+			tcpm_set_rx_enable(port, 0);
 			pd_hw_release(port);
 			pd_power_supply_reset(port);
+		}
+		pd[port].last_state = this_state;
+		return -1;
+#else
+		tcpm_set_rx_enable(port, 0);
+		pd_hw_release(port);
+		pd_power_supply_reset(port);
 
-			/* Wait for resume */
-			while (pd[port].task_state == PD_STATE_SUSPENDED)
-				task_wait_event(-1);
+		/* Wait for resume */
+		while (pd[port].task_state == PD_STATE_SUSPENDED)
+			task_wait_event(-1);
 
-			pd_hw_init(port, PD_ROLE_DEFAULT);
+		pd_hw_init(port, PD_ROLE_DEFAULT);
 #endif
+#endif
+		break;
+	case PD_STATE_SNK_DISCONNECTED:
+		timeout = 10*MSEC;
+		tcpm_get_cc(port, &cc1, &cc2);
+
+		/* Source connection monitoring */
+		if (cc1 != TYPEC_CC_VOLT_OPEN ||
+		    cc2 != TYPEC_CC_VOLT_OPEN) {
+			pd[port].cc_state = PD_CC_NONE;
+			pd[port].hard_reset_count = 0;
+			new_cc_state = PD_CC_DFP_ATTACHED;
+			pd[port].cc_debounce = get_time().val +
+						PD_T_CC_DEBOUNCE;
+			set_state(port,
+				PD_STATE_SNK_DISCONNECTED_DEBOUNCE);
 			break;
-		case PD_STATE_SNK_DISCONNECTED:
-			timeout = 10*MSEC;
-			tcpm_get_cc(port, &cc1, &cc2);
-
-			/* Source connection monitoring */
-			if (cc1 != TYPEC_CC_VOLT_OPEN ||
-			    cc2 != TYPEC_CC_VOLT_OPEN) {
-				pd[port].cc_state = PD_CC_NONE;
-				hard_reset_count = 0;
-				new_cc_state = PD_CC_DFP_ATTACHED;
-				pd[port].cc_debounce = get_time().val +
-							PD_T_CC_DEBOUNCE;
-				set_state(port,
-					PD_STATE_SNK_DISCONNECTED_DEBOUNCE);
-				break;
-			}
+		}
 
-			/*
-			 * If Try.SRC is active and failed to detect a SNK,
-			 * then it transitions to TryWait.SNK. Need to prevent
-			 * normal dual role toggle until tDRPTryWait timer
-			 * expires.
-			 */
-			if (pd[port].flags & PD_FLAGS_TRY_SRC) {
-				if (get_time().val > pd[port].try_src_marker)
-					pd[port].flags &= ~PD_FLAGS_TRY_SRC;
-				break;
-			}
+		/*
+		 * If Try.SRC is active and failed to detect a SNK,
+		 * then it transitions to TryWait.SNK. Need to prevent
+		 * normal dual role toggle until tDRPTryWait timer
+		 * expires.
+		 */
+		if (pd[port].flags & PD_FLAGS_TRY_SRC) {
+			if (get_time().val > pd[port].try_src_marker)
+				pd[port].flags &= ~PD_FLAGS_TRY_SRC;
+			break;
+		}
 
-			/*
-			 * If no source detected, check for role toggle.
-			 * If VBUS is detected, and we are in the debug
-			 * accessory toggle state, then allow toggling.
-			 */
-			if ((drp_state == PD_DRP_TOGGLE_ON &&
-			     get_time().val >= next_role_swap) ||
-			    pd_snk_debug_acc_toggle(port)) {
-				/* Swap roles to source */
-				pd[port].power_role = PD_ROLE_SOURCE;
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
-				tcpm_set_cc(port, TYPEC_CC_RP);
-				next_role_swap = get_time().val + PD_T_DRP_SRC;
-
-				/* Swap states quickly */
-				timeout = 2*MSEC;
-			}
+		/*
+		 * If no source detected, check for role toggle.
+		 * If VBUS is detected, and we are in the debug
+		 * accessory toggle state, then allow toggling.
+		 */
+		if ((drp_state == PD_DRP_TOGGLE_ON &&
+		     get_time().val >= pd[port].next_role_swap) ||
+		    pd_snk_debug_acc_toggle(port)) {
+			/* Swap roles to source */
+			pd[port].power_role = PD_ROLE_SOURCE;
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
+			tcpm_set_cc(port, TYPEC_CC_RP);
+			pd[port].next_role_swap = get_time().val + PD_T_DRP_SRC;
+
+			/* Swap states quickly */
+			timeout = 2*MSEC;
+		}
+		break;
+	case PD_STATE_SNK_DISCONNECTED_DEBOUNCE:
+		tcpm_get_cc(port, &cc1, &cc2);
+		if (cc1 == TYPEC_CC_VOLT_OPEN &&
+		    cc2 == TYPEC_CC_VOLT_OPEN) {
+			/* No connection any more */
+			set_state(port, PD_STATE_SNK_DISCONNECTED);
+			timeout = 5*MSEC;
 			break;
-		case PD_STATE_SNK_DISCONNECTED_DEBOUNCE:
-			tcpm_get_cc(port, &cc1, &cc2);
-			if (cc1 == TYPEC_CC_VOLT_OPEN &&
-			    cc2 == TYPEC_CC_VOLT_OPEN) {
-				/* No connection any more */
-				set_state(port, PD_STATE_SNK_DISCONNECTED);
-				timeout = 5*MSEC;
-				break;
-			}
+		}
 
-			timeout = 20*MSEC;
+		timeout = 20*MSEC;
 
-			/* Wait for CC debounce and VBUS present */
-			if (get_time().val < pd[port].cc_debounce ||
-			    !pd_snk_is_vbus_provided(port))
-				break;
+		/* Wait for CC debounce and VBUS present */
+		if (get_time().val < pd[port].cc_debounce ||
+		    !pd_snk_is_vbus_provided(port))
+			break;
 
-			if (pd_try_src_enable &&
-			    !(pd[port].flags & PD_FLAGS_TRY_SRC)) {
-				/*
-				 * If TRY_SRC is enabled, but not active,
-				 * then force attempt to connect as source.
-				 */
-				pd[port].try_src_marker = get_time().val
-					+ PD_T_TRY_SRC;
-				/* Swap roles to source */
-				pd[port].power_role = PD_ROLE_SOURCE;
-				tcpm_set_cc(port, TYPEC_CC_RP);
-				timeout = 2*MSEC;
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
-				/* Set flag after the state change */
-				pd[port].flags |= PD_FLAGS_TRY_SRC;
-				break;
-			}
+		if (pd_try_src_enable &&
+		    !(pd[port].flags & PD_FLAGS_TRY_SRC)) {
+			/*
+			 * If TRY_SRC is enabled, but not active,
+			 * then force attempt to connect as source.
+			 */
+			pd[port].try_src_marker = get_time().val
+				+ PD_T_TRY_SRC;
+			/* Swap roles to source */
+			pd[port].power_role = PD_ROLE_SOURCE;
+			tcpm_set_cc(port, TYPEC_CC_RP);
+			timeout = 2*MSEC;
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
+			/* Set flag after the state change */
+			pd[port].flags |= PD_FLAGS_TRY_SRC;
+			break;
+		}
 
-			/* We are attached */
-			pd[port].polarity = (cc2 != TYPEC_CC_VOLT_OPEN);
-			tcpm_set_polarity(port, pd[port].polarity);
-			/* reset message ID  on connection */
-			pd[port].msg_id = 0;
-			/* initial data role for sink is UFP */
-			pd_set_data_role(port, PD_ROLE_UFP);
+		/* We are attached */
+		pd[port].polarity = (cc2 != TYPEC_CC_VOLT_OPEN);
+		tcpm_set_polarity(port, pd[port].polarity);
+		/* reset message ID  on connection */
+		pd[port].msg_id = 0;
+		/* initial data role for sink is UFP */
+		pd_set_data_role(port, PD_ROLE_UFP);
 #ifdef CONFIG_CHARGE_MANAGER
-			typec_curr = get_typec_current_limit(
-				pd[port].polarity ? cc2 : cc1);
-			typec_set_input_current_limit(
-				port, typec_curr, TYPE_C_VOLTAGE);
+		pd[port].typec_curr = get_typec_current_limit(
+			pd[port].polarity ? cc2 : cc1);
+		typec_set_input_current_limit(
+			port, pd[port].typec_curr, TYPE_C_VOLTAGE);
 #endif
-			/* If PD comm is enabled, enable TCPC RX */
-			if (pd_comm_enabled)
-				tcpm_set_rx_enable(port, 1);
+		/* If PD comm is enabled, enable TCPC RX */
+		if (pd_comm_enabled)
+			tcpm_set_rx_enable(port, 1);
 
-			/*
-			 * fake set data role swapped flag so we send
-			 * discover identity when we enter SRC_READY
-			 */
-			pd[port].flags |= PD_FLAGS_CHECK_PR_ROLE |
-					  PD_FLAGS_CHECK_DR_ROLE |
-					  PD_FLAGS_DATA_SWAPPED;
+		/*
+		 * fake set data role swapped flag so we send
+		 * discover identity when we enter SRC_READY
+		 */
+		pd[port].flags |= PD_FLAGS_CHECK_PR_ROLE |
+				  PD_FLAGS_CHECK_DR_ROLE |
+				  PD_FLAGS_DATA_SWAPPED;
+		set_state(port, PD_STATE_SNK_DISCOVERY);
+		timeout = 10*MSEC;
+		hook_call_deferred(
+			&pd_usb_billboard_deferred_data,
+			PD_T_AME);
+		break;
+	case PD_STATE_SNK_HARD_RESET_RECOVER:
+		if (pd[port].last_state != pd[port].task_state)
+			pd[port].flags |= PD_FLAGS_DATA_SWAPPED;
+#ifdef CONFIG_USB_PD_NO_VBUS_DETECT
+		/*
+		 * Can't measure vbus state so this is the maximum
+		 * recovery time for the source.
+		 */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port, get_time().val +
+					  PD_T_SAFE_0V +
+					  PD_T_SRC_RECOVER_MAX +
+					  PD_T_SRC_TURN_ON,
+					  PD_STATE_SNK_DISCONNECTED);
+#else
+		/* Wait for VBUS to go low and then high*/
+		if (pd[port].last_state != pd[port].task_state) {
+			pd[port].snk_hard_reset_vbus_off = 0;
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SAFE_0V,
+					  pd[port].hard_reset_count <
+					    PD_HARD_RESET_COUNT ?
+					     PD_STATE_HARD_RESET_SEND :
+					     PD_STATE_SNK_DISCOVERY);
+		}
+
+		if (!pd_snk_is_vbus_provided(port) &&
+		    !pd[port].snk_hard_reset_vbus_off) {
+			/* VBUS has gone low, reset timeout */
+			pd[port].snk_hard_reset_vbus_off = 1;
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SRC_RECOVER_MAX +
+					  PD_T_SRC_TURN_ON,
+					  PD_STATE_SNK_DISCONNECTED);
+		}
+		if (pd_snk_is_vbus_provided(port) &&
+		    pd[port].snk_hard_reset_vbus_off) {
+			/* VBUS went high again */
 			set_state(port, PD_STATE_SNK_DISCOVERY);
 			timeout = 10*MSEC;
-			hook_call_deferred(
-				pd_usb_billboard_deferred,
-				PD_T_AME);
-			break;
-		case PD_STATE_SNK_HARD_RESET_RECOVER:
-			if (pd[port].last_state != pd[port].task_state)
-				pd[port].flags |= PD_FLAGS_DATA_SWAPPED;
-#ifdef CONFIG_USB_PD_NO_VBUS_DETECT
+		}
+
+		/*
+		 * Don't need to set timeout because VBUS changing
+		 * will trigger an interrupt and wake us up.
+		 */
+#endif
+		break;
+	case PD_STATE_SNK_DISCOVERY:
+		/* Wait for source cap expired only if we are enabled */
+		if ((pd[port].last_state != pd[port].task_state)
+		    && pd_comm_enabled) {
 			/*
-			 * Can't measure vbus state so this is the maximum
-			 * recovery time for the source.
+			 * If we haven't passed hard reset counter,
+			 * start SinkWaitCapTimer, otherwise start
+			 * NoResponseTimer.
 			 */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port, get_time().val +
-						  PD_T_SAFE_0V +
-						  PD_T_SRC_RECOVER_MAX +
-						  PD_T_SRC_TURN_ON,
-						  PD_STATE_SNK_DISCONNECTED);
-#else
-			/* Wait for VBUS to go low and then high*/
-			if (pd[port].last_state != pd[port].task_state) {
-				snk_hard_reset_vbus_off = 0;
+			if (pd[port].hard_reset_count < PD_HARD_RESET_COUNT)
 				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SAFE_0V,
-						  hard_reset_count <
-						    PD_HARD_RESET_COUNT ?
-						     PD_STATE_HARD_RESET_SEND :
-						     PD_STATE_SNK_DISCOVERY);
-			}
-
-			if (!pd_snk_is_vbus_provided(port) &&
-			    !snk_hard_reset_vbus_off) {
-				/* VBUS has gone low, reset timeout */
-				snk_hard_reset_vbus_off = 1;
+					  get_time().val +
+					  PD_T_SINK_WAIT_CAP,
+					  PD_STATE_HARD_RESET_SEND);
+			else if (pd[port].flags &
+				 PD_FLAGS_PREVIOUS_PD_CONN)
+				/* ErrorRecovery */
 				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SRC_RECOVER_MAX +
-						  PD_T_SRC_TURN_ON,
-						  PD_STATE_SNK_DISCONNECTED);
-			}
-			if (pd_snk_is_vbus_provided(port) &&
-			    snk_hard_reset_vbus_off) {
-				/* VBUS went high again */
-				set_state(port, PD_STATE_SNK_DISCOVERY);
-				timeout = 10*MSEC;
-			}
-
+					  get_time().val +
+					  PD_T_NO_RESPONSE,
+					  PD_STATE_SNK_DISCONNECTED);
+#ifdef CONFIG_CHARGE_MANAGER
 			/*
-			 * Don't need to set timeout because VBUS changing
-			 * will trigger an interrupt and wake us up.
+			 * If we didn't come from disconnected, must
+			 * have come from some path that did not set
+			 * typec current limit. So, set to 0 so that
+			 * we guarantee this is revised below.
 			 */
+			if (pd[port].last_state !=
+			    PD_STATE_SNK_DISCONNECTED_DEBOUNCE)
+				pd[port].typec_curr = 0;
 #endif
-			break;
-		case PD_STATE_SNK_DISCOVERY:
-			/* Wait for source cap expired only if we are enabled */
-			if ((pd[port].last_state != pd[port].task_state)
-			    && pd_comm_enabled) {
-				/*
-				 * If we haven't passed hard reset counter,
-				 * start SinkWaitCapTimer, otherwise start
-				 * NoResponseTimer.
-				 */
-				if (hard_reset_count < PD_HARD_RESET_COUNT)
-					set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SINK_WAIT_CAP,
-						  PD_STATE_HARD_RESET_SEND);
-				else if (pd[port].flags &
-					 PD_FLAGS_PREVIOUS_PD_CONN)
-					/* ErrorRecovery */
-					set_state_timeout(port,
-						  get_time().val +
-						  PD_T_NO_RESPONSE,
-						  PD_STATE_SNK_DISCONNECTED);
-#ifdef CONFIG_CHARGE_MANAGER
-				/*
-				 * If we didn't come from disconnected, must
-				 * have come from some path that did not set
-				 * typec current limit. So, set to 0 so that
-				 * we guarantee this is revised below.
-				 */
-				if (pd[port].last_state !=
-				    PD_STATE_SNK_DISCONNECTED_DEBOUNCE)
-					typec_curr = 0;
-#endif
-			}
+		}
 
 #ifdef CONFIG_CHARGE_MANAGER
-			timeout = PD_T_SINK_ADJ - PD_T_DEBOUNCE;
-
-			/* Check if CC pull-up has changed */
-			tcpm_get_cc(port, &cc1, &cc2);
-			if (pd[port].polarity)
-				cc1 = cc2;
-			if (typec_curr != get_typec_current_limit(cc1)) {
-				/* debounce signal by requiring two reads */
-				if (typec_curr_change) {
-					/* set new input current limit */
-					typec_curr = get_typec_current_limit(
-							cc1);
-					typec_set_input_current_limit(
-					  port, typec_curr, TYPE_C_VOLTAGE);
-				} else {
-					/* delay for debounce */
-					timeout = PD_T_DEBOUNCE;
-				}
-				typec_curr_change = !typec_curr_change;
+		timeout = PD_T_SINK_ADJ - PD_T_DEBOUNCE;
+
+		/* Check if CC pull-up has changed */
+		tcpm_get_cc(port, &cc1, &cc2);
+		if (pd[port].polarity)
+			cc1 = cc2;
+		if (pd[port].typec_curr != get_typec_current_limit(cc1)) {
+			/* debounce signal by requiring two reads */
+			if (pd[port].typec_curr_change) {
+				/* set new input current limit */
+				pd[port].typec_curr = get_typec_current_limit(
+						cc1);
+				typec_set_input_current_limit(
+				  port, pd[port].typec_curr, TYPE_C_VOLTAGE);
 			} else {
-				typec_curr_change = 0;
+				/* delay for debounce */
+				timeout = PD_T_DEBOUNCE;
 			}
+			pd[port].typec_curr_change ^= 1;
+		} else {
+			pd[port].typec_curr_change = 0;
+		}
 #endif
+		break;
+	case PD_STATE_SNK_REQUESTED:
+		/* Wait for ACCEPT or REJECT */
+		if (pd[port].last_state != pd[port].task_state) {
+			pd[port].hard_reset_count = 0;
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  PD_STATE_HARD_RESET_SEND);
+		}
+		break;
+	case PD_STATE_SNK_TRANSITION:
+		/* Wait for PS_RDY */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_PS_TRANSITION,
+					  PD_STATE_HARD_RESET_SEND);
+		break;
+	case PD_STATE_SNK_READY:
+		timeout = 20*MSEC;
+
+		/*
+		 * Don't send any PD traffic if we woke up due to
+		 * incoming packet or if VDO response pending to avoid
+		 * collisions.
+		 */
+		if (incoming_packet ||
+		    (pd[port].vdm_state == VDM_STATE_BUSY))
 			break;
-		case PD_STATE_SNK_REQUESTED:
-			/* Wait for ACCEPT or REJECT */
-			if (pd[port].last_state != pd[port].task_state) {
-				hard_reset_count = 0;
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  PD_STATE_HARD_RESET_SEND);
-			}
-			break;
-		case PD_STATE_SNK_TRANSITION:
-			/* Wait for PS_RDY */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_PS_TRANSITION,
-						  PD_STATE_HARD_RESET_SEND);
-			break;
-		case PD_STATE_SNK_READY:
-			timeout = 20*MSEC;
 
-			/*
-			 * Don't send any PD traffic if we woke up due to
-			 * incoming packet or if VDO response pending to avoid
-			 * collisions.
-			 */
-			if (incoming_packet ||
-			    (pd[port].vdm_state == VDM_STATE_BUSY))
-				break;
+		/* Check for new power to request */
+		if (pd[port].new_power_request) {
+			pd_send_request_msg(port, 0);
+			break;
+		}
 
-			/* Check for new power to request */
-			if (pd[port].new_power_request) {
-				pd_send_request_msg(port, 0);
-				break;
-			}
+		/* Check power role policy, which may trigger a swap */
+		if (pd[port].flags & PD_FLAGS_CHECK_PR_ROLE) {
+			pd_check_pr_role(port, PD_ROLE_SINK,
+					 pd[port].flags);
+			pd[port].flags &= ~PD_FLAGS_CHECK_PR_ROLE;
+			break;
+		}
 
-			/* Check power role policy, which may trigger a swap */
-			if (pd[port].flags & PD_FLAGS_CHECK_PR_ROLE) {
-				pd_check_pr_role(port, PD_ROLE_SINK,
-						 pd[port].flags);
-				pd[port].flags &= ~PD_FLAGS_CHECK_PR_ROLE;
-				break;
-			}
+		/* Check data role policy, which may trigger a swap */
+		if (pd[port].flags & PD_FLAGS_CHECK_DR_ROLE) {
+			pd_check_dr_role(port, pd[port].data_role,
+					 pd[port].flags);
+			pd[port].flags &= ~PD_FLAGS_CHECK_DR_ROLE;
+			break;
+		}
 
-			/* Check data role policy, which may trigger a swap */
-			if (pd[port].flags & PD_FLAGS_CHECK_DR_ROLE) {
-				pd_check_dr_role(port, pd[port].data_role,
-						 pd[port].flags);
-				pd[port].flags &= ~PD_FLAGS_CHECK_DR_ROLE;
-				break;
-			}
+		/* If DFP, send discovery SVDMs */
+		if (pd[port].data_role == PD_ROLE_DFP &&
+		     (pd[port].flags & PD_FLAGS_DATA_SWAPPED)) {
+			pd_send_vdm(port, USB_SID_PD,
+				    CMD_DISCOVER_IDENT, NULL, 0);
+			pd[port].flags &= ~PD_FLAGS_DATA_SWAPPED;
+			break;
+		}
 
-			/* If DFP, send discovery SVDMs */
-			if (pd[port].data_role == PD_ROLE_DFP &&
-			     (pd[port].flags & PD_FLAGS_DATA_SWAPPED)) {
-				pd_send_vdm(port, USB_SID_PD,
-					    CMD_DISCOVER_IDENT, NULL, 0);
-				pd[port].flags &= ~PD_FLAGS_DATA_SWAPPED;
+		/* Sent all messages, don't need to wake very often */
+		timeout = 200*MSEC;
+		break;
+	case PD_STATE_SNK_SWAP_INIT:
+		if (pd[port].last_state != pd[port].task_state) {
+			res = send_control(port, PD_CTRL_PR_SWAP);
+			if (res < 0) {
+				timeout = 10*MSEC;
+				/*
+				 * If failed to get goodCRC, send
+				 * soft reset, otherwise ignore
+				 * failure.
+				 */
+				set_state(port, res == -1 ?
+					   PD_STATE_SOFT_RESET :
+					   PD_STATE_SNK_READY);
 				break;
 			}
-
-			/* Sent all messages, don't need to wake very often */
-			timeout = 200*MSEC;
-			break;
-		case PD_STATE_SNK_SWAP_INIT:
-			if (pd[port].last_state != pd[port].task_state) {
-				res = send_control(port, PD_CTRL_PR_SWAP);
-				if (res < 0) {
-					timeout = 10*MSEC;
-					/*
-					 * If failed to get goodCRC, send
-					 * soft reset, otherwise ignore
-					 * failure.
-					 */
-					set_state(port, res == -1 ?
-						   PD_STATE_SOFT_RESET :
-						   PD_STATE_SNK_READY);
-					break;
-				}
-				/* Wait for accept or reject */
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  PD_STATE_SNK_READY);
-			}
-			break;
-		case PD_STATE_SNK_SWAP_SNK_DISABLE:
-			/* Stop drawing power */
-			pd_set_input_current_limit(port, 0, 0);
+			/* Wait for accept or reject */
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  PD_STATE_SNK_READY);
+		}
+		break;
+	case PD_STATE_SNK_SWAP_SNK_DISABLE:
+		/* Stop drawing power */
+		pd_set_input_current_limit(port, 0, 0);
 #ifdef CONFIG_CHARGE_MANAGER
-			typec_set_input_current_limit(port, 0, 0);
-			charge_manager_set_ceil(port, CHARGE_CEIL_NONE);
+		typec_set_input_current_limit(port, 0, 0);
+		charge_manager_set_ceil(port, CHARGE_CEIL_NONE);
 #endif
-			set_state(port, PD_STATE_SNK_SWAP_SRC_DISABLE);
-			timeout = 10*MSEC;
-			break;
-		case PD_STATE_SNK_SWAP_SRC_DISABLE:
-			/* Wait for PS_RDY */
-			if (pd[port].last_state != pd[port].task_state)
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_PS_SOURCE_OFF,
-						  PD_STATE_HARD_RESET_SEND);
-			break;
-		case PD_STATE_SNK_SWAP_STANDBY:
-			if (pd[port].last_state != pd[port].task_state) {
-				/* Switch to Rp and enable power supply */
-				tcpm_set_cc(port, TYPEC_CC_RP);
-				if (pd_set_power_supply_ready(port)) {
-					/* Restore Rd */
-					tcpm_set_cc(port, TYPEC_CC_RD);
-					timeout = 10*MSEC;
-					set_state(port,
-						  PD_STATE_SNK_DISCONNECTED);
-					break;
-				}
-				/* Wait for power supply to turn on */
-				set_state_timeout(
-					port,
-					get_time().val +
-					PD_POWER_SUPPLY_TURN_ON_DELAY,
-					PD_STATE_SNK_SWAP_COMPLETE);
-			}
-			break;
-		case PD_STATE_SNK_SWAP_COMPLETE:
-			/* Send PS_RDY and change to source role */
-			res = send_control(port, PD_CTRL_PS_RDY);
-			if (res < 0) {
+		set_state(port, PD_STATE_SNK_SWAP_SRC_DISABLE);
+		timeout = 10*MSEC;
+		break;
+	case PD_STATE_SNK_SWAP_SRC_DISABLE:
+		/* Wait for PS_RDY */
+		if (pd[port].last_state != pd[port].task_state)
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_PS_SOURCE_OFF,
+					  PD_STATE_HARD_RESET_SEND);
+		break;
+	case PD_STATE_SNK_SWAP_STANDBY:
+		if (pd[port].last_state != pd[port].task_state) {
+			/* Switch to Rp and enable power supply */
+			tcpm_set_cc(port, TYPEC_CC_RP);
+			if (pd_set_power_supply_ready(port)) {
 				/* Restore Rd */
 				tcpm_set_cc(port, TYPEC_CC_RD);
-				pd_power_supply_reset(port);
-				timeout = 10 * MSEC;
-				set_state(port, PD_STATE_SNK_DISCONNECTED);
+				timeout = 10*MSEC;
+				set_state(port,
+					  PD_STATE_SNK_DISCONNECTED);
 				break;
 			}
-
-			caps_count = 0;
-			pd[port].msg_id = 0;
-			pd[port].power_role = PD_ROLE_SOURCE;
-			pd_update_roles(port);
-			set_state(port, PD_STATE_SRC_DISCOVERY);
-			timeout = 10*MSEC;
+			/* Wait for power supply to turn on */
+			set_state_timeout(
+				port,
+				get_time().val +
+				PD_POWER_SUPPLY_TURN_ON_DELAY,
+				PD_STATE_SNK_SWAP_COMPLETE);
+		}
+		break;
+	case PD_STATE_SNK_SWAP_COMPLETE:
+		/* Send PS_RDY and change to source role */
+		res = send_control(port, PD_CTRL_PS_RDY);
+		if (res < 0) {
+			/* Restore Rd */
+			tcpm_set_cc(port, TYPEC_CC_RD);
+			pd_power_supply_reset(port);
+			timeout = 10 * MSEC;
+			set_state(port, PD_STATE_SNK_DISCONNECTED);
 			break;
+		}
+
+		pd[port].caps_count = 0;
+		pd[port].msg_id = 0;
+		pd[port].power_role = PD_ROLE_SOURCE;
+		pd_update_roles(port);
+		set_state(port, PD_STATE_SRC_DISCOVERY);
+		timeout = 10*MSEC;
+		break;
 #ifdef CONFIG_USBC_VCONN_SWAP
-		case PD_STATE_VCONN_SWAP_SEND:
-			if (pd[port].last_state != pd[port].task_state) {
-				res = send_control(port, PD_CTRL_VCONN_SWAP);
-				if (res < 0) {
+	case PD_STATE_VCONN_SWAP_SEND:
+		if (pd[port].last_state != pd[port].task_state) {
+			res = send_control(port, PD_CTRL_VCONN_SWAP);
+			if (res < 0) {
+				timeout = 10*MSEC;
+				/*
+				 * If failed to get goodCRC, send
+				 * soft reset, otherwise ignore
+				 * failure.
+				 */
+				set_state(port, res == -1 ?
+					   PD_STATE_SOFT_RESET :
+					   READY_RETURN_STATE(port));
+				break;
+			}
+			/* Wait for accept or reject */
+			set_state_timeout(port,
+					  get_time().val +
+					  PD_T_SENDER_RESPONSE,
+					  READY_RETURN_STATE(port));
+		}
+		break;
+	case PD_STATE_VCONN_SWAP_INIT:
+		if (pd[port].last_state != pd[port].task_state) {
+			if (!(pd[port].flags & PD_FLAGS_VCONN_ON)) {
+				/* Turn VCONN on and wait for it */
+				tcpm_set_vconn(port, 1);
+				set_state_timeout(port,
+				  get_time().val + PD_VCONN_SWAP_DELAY,
+				  PD_STATE_VCONN_SWAP_READY);
+			} else {
+				set_state_timeout(port,
+				  get_time().val + PD_T_VCONN_SOURCE_ON,
+				  READY_RETURN_STATE(port));
+			}
+		}
+		break;
+	case PD_STATE_VCONN_SWAP_READY:
+		if (pd[port].last_state != pd[port].task_state) {
+			if (!(pd[port].flags & PD_FLAGS_VCONN_ON)) {
+				/* VCONN is now on, send PS_RDY */
+				pd[port].flags |= PD_FLAGS_VCONN_ON;
+				res = send_control(port,
+						   PD_CTRL_PS_RDY);
+				if (res == -1) {
 					timeout = 10*MSEC;
 					/*
-					 * If failed to get goodCRC, send
-					 * soft reset, otherwise ignore
-					 * failure.
+					 * If failed to get goodCRC,
+					 * send soft reset
 					 */
-					set_state(port, res == -1 ?
-						   PD_STATE_SOFT_RESET :
-						   READY_RETURN_STATE(port));
+					set_state(port,
+						  PD_STATE_SOFT_RESET);
 					break;
 				}
-				/* Wait for accept or reject */
-				set_state_timeout(port,
-						  get_time().val +
-						  PD_T_SENDER_RESPONSE,
-						  READY_RETURN_STATE(port));
-			}
-			break;
-		case PD_STATE_VCONN_SWAP_INIT:
-			if (pd[port].last_state != pd[port].task_state) {
-				if (!(pd[port].flags & PD_FLAGS_VCONN_ON)) {
-					/* Turn VCONN on and wait for it */
-					tcpm_set_vconn(port, 1);
-					set_state_timeout(port,
-					  get_time().val + PD_VCONN_SWAP_DELAY,
-					  PD_STATE_VCONN_SWAP_READY);
-				} else {
-					set_state_timeout(port,
-					  get_time().val + PD_T_VCONN_SOURCE_ON,
-					  READY_RETURN_STATE(port));
-				}
-			}
-			break;
-		case PD_STATE_VCONN_SWAP_READY:
-			if (pd[port].last_state != pd[port].task_state) {
-				if (!(pd[port].flags & PD_FLAGS_VCONN_ON)) {
-					/* VCONN is now on, send PS_RDY */
-					pd[port].flags |= PD_FLAGS_VCONN_ON;
-					res = send_control(port,
-							   PD_CTRL_PS_RDY);
-					if (res == -1) {
-						timeout = 10*MSEC;
-						/*
-						 * If failed to get goodCRC,
-						 * send soft reset
-						 */
-						set_state(port,
-							  PD_STATE_SOFT_RESET);
-						break;
-					}
-					set_state(port,
-						  READY_RETURN_STATE(port));
-				} else {
-					/* Turn VCONN off and wait for it */
-					tcpm_set_vconn(port, 0);
-					pd[port].flags &= ~PD_FLAGS_VCONN_ON;
-					set_state_timeout(port,
-					  get_time().val + PD_VCONN_SWAP_DELAY,
+				set_state(port,
 					  READY_RETURN_STATE(port));
-				}
+			} else {
+				/* Turn VCONN off and wait for it */
+				tcpm_set_vconn(port, 0);
+				pd[port].flags &= ~PD_FLAGS_VCONN_ON;
+				set_state_timeout(port,
+				  get_time().val + PD_VCONN_SWAP_DELAY,
+				  READY_RETURN_STATE(port));
 			}
-			break;
+		}
+		break;
 #endif /* CONFIG_USBC_VCONN_SWAP */
 #endif /* CONFIG_USB_PD_DUAL_ROLE */
-		case PD_STATE_SOFT_RESET:
-			if (pd[port].last_state != pd[port].task_state) {
-				res = send_control(port, PD_CTRL_SOFT_RESET);
+	case PD_STATE_SOFT_RESET:
+		if (pd[port].last_state != pd[port].task_state) {
+			res = send_control(port, PD_CTRL_SOFT_RESET);
 
-				/* if soft reset failed, try hard reset. */
-				if (res < 0) {
-					set_state(port,
-						  PD_STATE_HARD_RESET_SEND);
-					timeout = 5*MSEC;
-					break;
-				}
-
-				set_state_timeout(
-					port,
-					get_time().val + PD_T_SENDER_RESPONSE,
-					PD_STATE_HARD_RESET_SEND);
+			/* if soft reset failed, try hard reset. */
+			if (res < 0) {
+				set_state(port,
+					  PD_STATE_HARD_RESET_SEND);
+				timeout = 5*MSEC;
+				break;
 			}
-			break;
-		case PD_STATE_HARD_RESET_SEND:
-			hard_reset_count++;
-			if (pd[port].last_state != pd[port].task_state)
-				hard_reset_sent = 0;
+
+			set_state_timeout(
+				port,
+				get_time().val + PD_T_SENDER_RESPONSE,
+				PD_STATE_HARD_RESET_SEND);
+		}
+		break;
+	case PD_STATE_HARD_RESET_SEND:
+		pd[port].hard_reset_count++;
+		if (pd[port].last_state != pd[port].task_state)
+			pd[port].hard_reset_sent = 0;
 #ifdef CONFIG_CHARGE_MANAGER
-			if (pd[port].last_state == PD_STATE_SNK_DISCOVERY) {
-				/*
-				 * If discovery timed out, assume that we
-				 * have a dedicated charger attached. This
-				 * may not be a correct assumption according
-				 * to the specification, but it generally
-				 * works in practice and the harmful
-				 * effects of a wrong assumption here
-				 * are minimal.
-				 */
-				charge_manager_update_dualrole(port,
-							       CAP_DEDICATED);
-			}
+		if (pd[port].last_state == PD_STATE_SNK_DISCOVERY) {
+			/*
+			 * If discovery timed out, assume that we
+			 * have a dedicated charger attached. This
+			 * may not be a correct assumption according
+			 * to the specification, but it generally
+			 * works in practice and the harmful
+			 * effects of a wrong assumption here
+			 * are minimal.
+			 */
+			charge_manager_update_dualrole(port,
+						       CAP_DEDICATED);
+		}
 #endif
 
-			/* try sending hard reset until it succeeds */
-			if (!hard_reset_sent) {
-				if (pd_transmit(port, TCPC_TX_HARD_RESET,
-						0, NULL) < 0) {
-					timeout = 10*MSEC;
-					break;
-				}
+		/* try sending hard reset until it succeeds */
+		if (!pd[port].hard_reset_sent) {
+			if (pd_transmit(port, TCPC_TX_HARD_RESET,
+					0, NULL) < 0) {
+				timeout = 10*MSEC;
+				break;
+			}
 
-				/* successfully sent hard reset */
-				hard_reset_sent = 1;
-				/*
-				 * If we are source, delay before cutting power
-				 * to allow sink time to get hard reset.
-				 */
-				if (pd[port].power_role == PD_ROLE_SOURCE) {
-					set_state_timeout(port,
-					  get_time().val + PD_T_PS_HARD_RESET,
+			/* successfully sent hard reset */
+			pd[port].hard_reset_sent = 1;
+			/*
+			 * If we are source, delay before cutting power
+			 * to allow sink time to get hard reset.
+			 */
+			if (pd[port].power_role == PD_ROLE_SOURCE) {
+				set_state_timeout(port,
+				  get_time().val + PD_T_PS_HARD_RESET,
+				  PD_STATE_HARD_RESET_EXECUTE);
+			} else {
+				set_state(port,
 					  PD_STATE_HARD_RESET_EXECUTE);
-				} else {
-					set_state(port,
-						  PD_STATE_HARD_RESET_EXECUTE);
-					timeout = 10*MSEC;
-				}
+				timeout = 10*MSEC;
 			}
-			break;
-		case PD_STATE_HARD_RESET_EXECUTE:
+		}
+		break;
+	case PD_STATE_HARD_RESET_EXECUTE:
 #ifdef CONFIG_USB_PD_DUAL_ROLE
-			/*
-			 * If hard reset while in the last stages of power
-			 * swap, then we need to restore our CC resistor.
-			 */
-			if (pd[port].last_state == PD_STATE_SNK_SWAP_STANDBY)
-				tcpm_set_cc(port, TYPEC_CC_RD);
+		/*
+		 * If hard reset while in the last stages of power
+		 * swap, then we need to restore our CC resistor.
+		 */
+		if (pd[port].last_state == PD_STATE_SNK_SWAP_STANDBY)
+			tcpm_set_cc(port, TYPEC_CC_RD);
 #endif
 
-			/* reset our own state machine */
-			pd_execute_hard_reset(port);
-			timeout = 10*MSEC;
-			break;
+		/* reset our own state machine */
+		pd_execute_hard_reset(port);
+		timeout = 10*MSEC;
+		break;
 #ifdef CONFIG_COMMON_RUNTIME
-		case PD_STATE_BIST_RX:
-			send_bist_cmd(port);
-			/* Delay at least enough for partner to finish BIST */
-			timeout = PD_T_BIST_RECEIVE + 20*MSEC;
-			/* Set to appropriate port disconnected state */
-			set_state(port, DUAL_ROLE_IF_ELSE(port,
-						PD_STATE_SNK_DISCONNECTED,
-						PD_STATE_SRC_DISCONNECTED));
-			break;
-		case PD_STATE_BIST_TX:
-			pd_transmit(port, TCPC_TX_BIST_MODE_2, 0, NULL);
-			/* Delay at least enough to finish sending BIST */
-			timeout = PD_T_BIST_TRANSMIT + 20*MSEC;
-			/* Set to appropriate port disconnected state */
-			set_state(port, DUAL_ROLE_IF_ELSE(port,
-						PD_STATE_SNK_DISCONNECTED,
-						PD_STATE_SRC_DISCONNECTED));
-			break;
+	case PD_STATE_BIST_RX:
+		send_bist_cmd(port);
+		/* Delay at least enough for partner to finish BIST */
+		timeout = PD_T_BIST_RECEIVE + 20*MSEC;
+		/* Set to appropriate port disconnected state */
+		set_state(port, DUAL_ROLE_IF_ELSE(port,
+					PD_STATE_SNK_DISCONNECTED,
+					PD_STATE_SRC_DISCONNECTED));
+		break;
+	case PD_STATE_BIST_TX:
+		pd_transmit(port, TCPC_TX_BIST_MODE_2, 0, NULL);
+		/* Delay at least enough to finish sending BIST */
+		timeout = PD_T_BIST_TRANSMIT + 20*MSEC;
+		/* Set to appropriate port disconnected state */
+		set_state(port, DUAL_ROLE_IF_ELSE(port,
+					PD_STATE_SNK_DISCONNECTED,
+					PD_STATE_SRC_DISCONNECTED));
+		break;
 #endif
-		default:
-			break;
-		}
+	default:
+		break;
+	}
 
-		pd[port].last_state = this_state;
+	pd[port].last_state = this_state;
 
-		/*
-		 * Check for state timeout, and if not check if need to adjust
-		 * timeout value to wake up on the next state timeout.
-		 */
-		now = get_time();
-		if (pd[port].timeout) {
-			if (now.val >= pd[port].timeout) {
-				set_state(port, pd[port].timeout_state);
-				/* On a state timeout, run next state soon */
-				timeout = timeout < 10*MSEC ? timeout : 10*MSEC;
-			} else if (pd[port].timeout - now.val < timeout) {
-				timeout = pd[port].timeout - now.val;
-			}
+	/*
+	 * Check for state timeout, and if not check if need to adjust
+	 * timeout value to wake up on the next state timeout.
+	 */
+	now = get_time();
+	if (pd[port].timeout) {
+		if (now.val >= pd[port].timeout) {
+			timing_state_timeout(port);
+			set_state(port, pd[port].timeout_state);
+			/* On a state timeout, run next state soon */
+			timeout = timeout < 10*MSEC ? timeout : 10*MSEC;
+		} else if (pd[port].timeout - now.val < timeout) {
+			timeout = pd[port].timeout - now.val;
 		}
+	}
 
-		/* Check for disconnection */
+	/* Check for disconnection */
 #ifdef CONFIG_USB_PD_DUAL_ROLE
-		if (!pd_is_connected(port) || pd_is_power_swapping(port))
-			continue;
-#endif
-		if (pd[port].power_role == PD_ROLE_SOURCE) {
-			/* Source: detect disconnect by monitoring CC */
-			tcpm_get_cc(port, &cc1, &cc2);
-			if (pd[port].polarity)
-				cc1 = cc2;
-			if (cc1 == TYPEC_CC_VOLT_OPEN) {
-				pd_power_supply_reset(port);
-				set_state(port, PD_STATE_SRC_DISCONNECTED);
-				/* Debouncing */
-				timeout = 10*MSEC;
+	if (!pd_is_connected(port) || pd_is_power_swapping(port))
+		return timeout;
+#endif
+	if (pd[port].power_role == PD_ROLE_SOURCE) {
+		/* Source: detect disconnect by monitoring CC */
+		tcpm_get_cc(port, &cc1, &cc2);
+		if (pd[port].polarity)
+			cc1 = cc2;
+		if (cc1 == TYPEC_CC_VOLT_OPEN) {
+			pd_power_supply_reset(port);
+			set_state(port, PD_STATE_SRC_DISCONNECTED);
+			/* Debouncing */
+			timeout = 10*MSEC;
 #ifdef CONFIG_USB_PD_DUAL_ROLE
-				/*
-				 * If Try.SRC is configured, then ATTACHED_SRC
-				 * needs to transition to TryWait.SNK. Change
-				 * power role to SNK and start state timer.
-				 */
-				if (pd_try_src_enable) {
-					/* Swap roles to sink */
-					pd[port].power_role = PD_ROLE_SINK;
-					tcpm_set_cc(port, TYPEC_CC_RD);
-					/* Set timer for TryWait.SNK state */
-					pd[port].try_src_marker = get_time().val
-						+ PD_T_TRY_WAIT;
-					/* Advance to TryWait.SNK state */
-					set_state(port,
-						  PD_STATE_SNK_DISCONNECTED);
-					/* Mark state as TryWait.SNK */
-					pd[port].flags |= PD_FLAGS_TRY_SRC;
-				}
-#endif
+			/*
+			 * If Try.SRC is configured, then ATTACHED_SRC
+			 * needs to transition to TryWait.SNK. Change
+			 * power role to SNK and start state timer.
+			 */
+			if (pd_try_src_enable) {
+				/* Swap roles to sink */
+				pd[port].power_role = PD_ROLE_SINK;
+				tcpm_set_cc(port, TYPEC_CC_RD);
+				/* Set timer for TryWait.SNK state */
+				pd[port].try_src_marker = get_time().val
+					+ PD_T_TRY_WAIT;
+				/* Advance to TryWait.SNK state */
+				set_state(port,
+					  PD_STATE_SNK_DISCONNECTED);
+				/* Mark state as TryWait.SNK */
+				pd[port].flags |= PD_FLAGS_TRY_SRC;
 			}
+#endif
 		}
+	}
 #ifdef CONFIG_USB_PD_DUAL_ROLE
+	/*
+	 * Sink disconnect if VBUS is low and we are not recovering
+	 * a hard reset.
+	 */
+	if (pd[port].power_role == PD_ROLE_SINK &&
+	    !pd_snk_is_vbus_provided(port) &&
+	    pd[port].task_state != PD_STATE_SNK_HARD_RESET_RECOVER &&
+	    pd[port].task_state != PD_STATE_HARD_RESET_EXECUTE) {
+		/* Sink: detect disconnect by monitoring VBUS */
+		set_state(port, PD_STATE_SNK_DISCONNECTED);
+		/* set timeout small to reconnect fast */
+		timeout = 5*MSEC;
+	}
+#endif /* CONFIG_USB_PD_DUAL_ROLE */
+
+	return timeout;
+}
+
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+/*
+ * One task runs the state machines of all the ports.  Each port has a
+ * deadline for its next pass, and runs early when an event is posted to it.
+ * The task sleeps until the earliest deadline or the next event.
+ */
+void pd_task(void)
+{
+	uint64_t deadline[CONFIG_USB_PD_PORT_COUNT];
+	uint64_t next, now;
+	uint32_t evt;
+	int port, timeout, pending;
+
+	for (port = 0; port < CONFIG_USB_PD_PORT_COUNT; port++) {
+		pd_port_init(port);
+		pd_port_finish_pass(port);
+		deadline[port] = get_time().val + 10*MSEC;
+	}
+
+	while (1) {
+		for (port = 0; port < CONFIG_USB_PD_PORT_COUNT; port++) {
+			evt = atomic_read_clear(&pd_port_events[port]);
+			if (!evt) {
+				if (get_time().val < deadline[port])
+					continue;
+				evt = TASK_EVENT_TIMER;
+			}
+
+			timeout = pd_port_run(port, evt);
+			/* A suspended port has released its hardware */
+			if (pd[port].last_state != PD_STATE_SUSPENDED)
+				pd_port_finish_pass(port);
+			deadline[port] = timeout < 0 ? -1ull :
+					 get_time().val + timeout;
+		}
+
 		/*
-		 * Sink disconnect if VBUS is low and we are not recovering
-		 * a hard reset.
+		 * A port may have been posted an event while another one
+		 * ran; a wait inside that pass can also have taken the
+		 * task event, so check the ports rather than the task.
 		 */
-		if (pd[port].power_role == PD_ROLE_SINK &&
-		    !pd_snk_is_vbus_provided(port) &&
-		    pd[port].task_state != PD_STATE_SNK_HARD_RESET_RECOVER &&
-		    pd[port].task_state != PD_STATE_HARD_RESET_EXECUTE) {
-			/* Sink: detect disconnect by monitoring VBUS */
-			set_state(port, PD_STATE_SNK_DISCONNECTED);
-			/* set timeout small to reconnect fast */
-			timeout = 5*MSEC;
+		next = -1ull;
+		pending = 0;
+		for (port = 0; port < CONFIG_USB_PD_PORT_COUNT; port++) {
+			pending |= pd_port_events[port];
+			next = MIN(next, deadline[port]);
 		}
-#endif /* CONFIG_USB_PD_DUAL_ROLE */
+		if (pending)
+			continue;
+
+		/*
+		 * Every event of a port comes with its bits in
+		 * pd_port_events[], the task event only wakes us up.
+		 */
+		now = get_time().val;
+		if (next == -1ull)
+			task_wait_event(-1);
+		else if (next > now)
+			task_wait_event(next - now);
+	}
+}
+#else
+void pd_task(void)
+{
+	int port = TASK_ID_TO_PD_PORT(task_get_current());
+	int timeout = 10*MSEC;
+	int evt;
+
+	pd_port_init(port);
+
+	while (1) {
+		pd_port_finish_pass(port);
+
+		/* wait for next event/packet or timeout expiration */
+		evt = task_wait_event(timeout);
+
+		timeout = pd_port_run(port, evt);
 	}
 }
+#endif
 
 #ifdef CONFIG_USB_PD_DUAL_ROLE
 static void dual_role_on(void)
@@ -2531,7 +2901,7 @@ void pd_set_suspend(int port, int enable)
 {
 	set_state(port, enable ? PD_STATE_SUSPENDED : PD_DEFAULT_STATE);
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 #if defined(CONFIG_CMD_PD) && defined(CONFIG_CMD_PD_FLASH)
@@ -2676,10 +3046,52 @@ void pd_request_source_voltage(int port, int mv)
 		set_state(port, PD_STATE_SNK_DISCONNECTED);
 	}
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 #endif /* CONFIG_USB_PD_DUAL_ROLE */
 
+#ifdef CONFIG_USB_PD_TIMING
+static void print_timing_hist(const char *name, const uint16_t *hist,
+			      uint32_t max_us)
+{
+	int i;
+
+	ccprintf("%s, max %d us\n", name, max_us);
+	for (i = 0; i < EC_USB_PD_TIMING_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (i == EC_USB_PD_TIMING_BUCKETS - 1)
+			ccprintf("  >= %6d us %5d\n", 8 << i, hist[i]);
+		else
+			ccprintf("  <  %6d us %5d\n", 16 << i, hist[i]);
+	}
+}
+
+static void print_timing(int port)
+{
+	struct pd_timing *t = &pd_timing[port];
+	struct ec_usb_pd_timing_state s;
+	int i;
+
+	print_timing_hist("RX to GoodCRC", t->rx_goodcrc,
+			  t->rx_goodcrc_max_us);
+	print_timing_hist("RX to reply", t->rx_reply, t->rx_reply_max_us);
+	ccprintf("Timeouts: state %d, VDM %d  TX: retries %d, errors %d\n",
+		 t->state_timeouts, t->vdm_timeouts, t->tx_retries,
+		 t->tx_errors);
+	cflush();
+
+	ccprintf("State                      Entries  Total ms  Max ms\n");
+	for (i = 0; i < PD_STATE_COUNT; i++) {
+		timing_get_state(port, i, &s);
+		if (!s.entries)
+			continue;
+		ccprintf("%-26s %7d %9d %7d\n", pd_state_names[i],
+			 s.entries, s.total_ms, s.max_ms);
+	}
+}
+#endif
+
 static int command_pd(int argc, char **argv)
 {
 	int port;
@@ -2786,20 +3198,20 @@ static int command_pd(int argc, char **argv)
 
 	if (!strcasecmp(argv[2], "tx")) {
 		set_state(port, PD_STATE_SNK_DISCOVERY);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strcasecmp(argv[2], "bist_rx")) {
 		set_state(port, PD_STATE_BIST_RX);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strcasecmp(argv[2], "bist_tx")) {
 		if (*e)
 			return EC_ERROR_PARAM3;
 		set_state(port, PD_STATE_BIST_TX);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strcasecmp(argv[2], "charger")) {
 		pd[port].power_role = PD_ROLE_SOURCE;
 		tcpm_set_cc(port, TYPEC_CC_RP);
 		set_state(port, PD_STATE_SRC_DISCONNECTED);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strncasecmp(argv[2], "dev", 3)) {
 		int max_volt;
 		if (argc >= 4)
@@ -2811,7 +3223,7 @@ static int command_pd(int argc, char **argv)
 		ccprintf("max req: %dmV\n", max_volt);
 	} else if (!strncasecmp(argv[2], "hard", 4)) {
 		set_state(port, PD_STATE_HARD_RESET_SEND);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strncasecmp(argv[2], "info", 4)) {
 		int i;
 		ccprintf("Hash ");
@@ -2821,7 +3233,7 @@ static int command_pd(int argc, char **argv)
 						pd[port].current_image));
 	} else if (!strncasecmp(argv[2], "soft", 4)) {
 		set_state(port, PD_STATE_SOFT_RESET);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	} else if (!strncasecmp(argv[2], "swap", 4)) {
 		if (argc < 4)
 			return EC_ERROR_PARAM_COUNT;
@@ -2833,7 +3245,7 @@ static int command_pd(int argc, char **argv)
 #ifdef CONFIG_USBC_VCONN_SWAP
 		} else if (!strncasecmp(argv[3], "vconn", 5)) {
 			set_state(port, PD_STATE_VCONN_SWAP_SEND);
-			task_wake(PD_PORT_TO_TASK_ID(port));
+			pd_task_set_event(port, TASK_EVENT_WAKE);
 #endif
 		} else {
 			return EC_ERROR_PARAM3;
@@ -2878,6 +3290,15 @@ static int command_pd(int argc, char **argv)
 		return remote_flashing(argc, argv);
 #endif
 	} else
+#endif
+#ifdef CONFIG_USB_PD_TIMING
+	if (!strcasecmp(argv[2], "timing")) {
+		if (argc > 3 && strcasecmp(argv[3], "clear"))
+			return EC_ERROR_PARAM3;
+		print_timing(port);
+		if (argc > 3)
+			timing_reset(port);
+	} else
 #endif
 	if (!strncasecmp(argv[2], "state", 5)) {
 		ccprintf("Port C%d, %s - Role: %s-%s%s Polarity: CC%d "
@@ -2900,12 +3321,55 @@ DECLARE_CONSOLE_COMMAND(pd, command_pd,
 			"trysrc [0|1]\n\t<port> "
 			"[tx|bist_rx|bist_tx|charger|clock|dev"
 			"|soft|hash|hard|ping|state|swap [power|data]|"
-			"vdm [ping | curr | vers]]",
+			"timing [clear]|vdm [ping | curr | vers]]",
 			"USB PD",
 			NULL);
 
 #ifdef HAS_TASK_HOSTCMD
 
+#ifdef CONFIG_USB_PD_TIMING
+static int hc_usb_pd_timing(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_usb_pd_timing *p = args->params;
+	struct ec_response_usb_pd_timing *r = args->response;
+	struct pd_timing *t;
+	int i, max;
+
+	if (p->port >= CONFIG_USB_PD_PORT_COUNT)
+		return EC_RES_INVALID_PARAM;
+	if (args->response_max < sizeof(*r))
+		return EC_RES_RESPONSE_TOO_BIG;
+	t = &pd_timing[p->port];
+
+	memcpy(r->rx_goodcrc, t->rx_goodcrc, sizeof(r->rx_goodcrc));
+	memcpy(r->rx_reply, t->rx_reply, sizeof(r->rx_reply));
+	r->rx_goodcrc_max_us = t->rx_goodcrc_max_us;
+	r->rx_reply_max_us = t->rx_reply_max_us;
+	r->state_timeouts = t->state_timeouts;
+	r->vdm_timeouts = t->vdm_timeouts;
+	r->tx_retries = t->tx_retries;
+	r->tx_errors = t->tx_errors;
+	r->state_total = PD_STATE_COUNT;
+	r->state_count = 0;
+	r->reserved = 0;
+
+	/* As many states as fit in the response */
+	max = (args->response_max - sizeof(*r)) / sizeof(r->states[0]);
+	for (i = p->state; i < PD_STATE_COUNT && r->state_count < max; i++)
+		timing_get_state(p->port, i, &r->states[r->state_count++]);
+
+	if (p->flags & EC_USB_PD_TIMING_FLAG_RESET)
+		timing_reset(p->port);
+
+	args->response_size = sizeof(*r) +
+			      r->state_count * sizeof(r->states[0]);
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_USB_PD_TIMING,
+		     hc_usb_pd_timing,
+		     EC_VER_MASK(0));
+#endif
+
 static int hc_pd_ports(struct host_cmd_handler_args *args)
 {
 	struct ec_response_usb_pd_ports *r = args->response;
@@ -35,12 +35,24 @@
  */
 static int debug_level;
 
+#ifdef CONFIG_HW_CRC
+/* The hardware CRC unit is shared by all the ports */
 static struct mutex pd_crc_lock;
+#endif
 #else
 #define CPRINTF(format, args...)
 static const int debug_level;
 #endif
 
+/*
+ * With the TCPM on the same chip, the TCPC runs from the PD task of its port.
+ * When one task runs the PD protocol of all the ports, each TCPC keeps a task
+ * of its own, so that GoodCRC does not wait for another port.
+ */
+#if defined(CONFIG_USB_POWER_DELIVERY) && !defined(CONFIG_USB_PD_SINGLE_TASK)
+#define TCPC_IN_PD_TASK
+#endif
+
 /* Encode 5 bits using Biphase Mark Coding */
 #define BMC(x)   ((x &  1 ? 0x001 : 0x3FF) \
 		^ (x &  2 ? 0x004 : 0x3FC) \
@@ -84,6 +96,7 @@ static const uint16_t bmc4b5b[] = {
 /* Reserved    Error        11111 */
 };
 
+#ifndef CONFIG_USB_PD_RX_TABLE
 static const uint8_t dec4b5b[] = {
 /* Error    */ 0x10 /* 00000 */,
 /* Error    */ 0x10 /* 00001 */,
@@ -118,6 +131,35 @@ static const uint8_t dec4b5b[] = {
 /* 0 = 0000 */ 0x00 /* 11110 */,
 /* Error    */ 0x10 /* 11111 */,
 };
+#endif
+
+#ifdef CONFIG_USB_PD_RX_TABLE
+/* 4b/5b decoding of one data symbol; other symbols decode to 0 */
+#define DEC5(s) ((s) == 0x1E ? 0x0 : (s) == 0x09 ? 0x1 : \
+		 (s) == 0x14 ? 0x2 : (s) == 0x15 ? 0x3 : \
+		 (s) == 0x0A ? 0x4 : (s) == 0x0B ? 0x5 : \
+		 (s) == 0x0E ? 0x6 : (s) == 0x0F ? 0x7 : \
+		 (s) == 0x12 ? 0x8 : (s) == 0x13 ? 0x9 : \
+		 (s) == 0x16 ? 0xA : (s) == 0x17 ? 0xB : \
+		 (s) == 0x1A ? 0xC : (s) == 0x1B ? 0xD : \
+		 (s) == 0x1C ? 0xE : (s) == 0x1D ? 0xF : 0)
+
+/* Two symbols, first received in the low bits, to one byte */
+#define DEC10(x)	(DEC5((x) & 0x1f) | (DEC5((x) >> 5) << 4))
+#define DEC10_4(x)	DEC10(x), DEC10((x) + 1), DEC10((x) + 2), \
+			DEC10((x) + 3)
+#define DEC10_16(x)	DEC10_4(x), DEC10_4((x) + 4), DEC10_4((x) + 8), \
+			DEC10_4((x) + 12)
+#define DEC10_64(x)	DEC10_16(x), DEC10_16((x) + 16), \
+			DEC10_16((x) + 32), DEC10_16((x) + 48)
+#define DEC10_256(x)	DEC10_64(x), DEC10_64((x) + 64), \
+			DEC10_64((x) + 128), DEC10_64((x) + 192)
+
+/* 10 received bits to one byte, for decoding two symbols at a time */
+static const uint8_t dec10b8b[1024] = {
+	DEC10_256(0), DEC10_256(256), DEC10_256(512), DEC10_256(768)
+};
+#endif
 
 /* Start of Packet sequence : three Sync-1 K-codes, then one Sync-2 K-code */
 #define PD_SOP (PD_SYNC1 | (PD_SYNC1<<5) | (PD_SYNC1<<10) | (PD_SYNC2<<15))
@@ -237,6 +279,41 @@ int encode_word(int port, int off, uint32_t val32)
 	return encode_short(port, off, (val32 >> 16) & 0xFFFF);
 }
 
+/* CRC of a PD message: its header, then its data objects */
+static uint32_t pd_msg_crc(uint16_t header, const uint32_t *data, int cnt)
+{
+	int i;
+#ifdef CONFIG_HW_CRC
+	uint32_t crc;
+
+	/*
+	 * There is a single CRC unit, so the ports still take turns here,
+	 * though only for the few words of the message.
+	 */
+#ifdef CONFIG_COMMON_RUNTIME
+	mutex_lock(&pd_crc_lock);
+#endif
+	crc32_init();
+	crc32_hash16(header);
+	for (i = 0; i < cnt; i++)
+		crc32_hash32(data[i]);
+	crc = crc32_result();
+#ifdef CONFIG_COMMON_RUNTIME
+	mutex_unlock(&pd_crc_lock);
+#endif
+	return crc;
+#else
+	/* Each caller has its own context, so ports never wait on each other */
+	uint32_t ctx;
+
+	crc32_ctx_init(&ctx);
+	crc32_ctx_hash16(&ctx, header);
+	for (i = 0; i < cnt; i++)
+		crc32_ctx_hash32(&ctx, data[i]);
+	return crc32_ctx_result(&ctx);
+#endif
+}
+
 /* prepare a 4b/5b-encoded PD message to send */
 int prepare_message(int port, uint16_t header, uint8_t cnt,
 		   const uint32_t *data)
@@ -251,24 +328,11 @@ int prepare_message(int port, uint16_t header, uint8_t cnt,
 	off = pd_write_sym(port, off, BMC(PD_SYNC2));
 	/* header */
 	off = encode_short(port, off, header);
-
-#ifdef CONFIG_COMMON_RUNTIME
-	mutex_lock(&pd_crc_lock);
-#endif
-
-	crc32_init();
-	crc32_hash16(header);
 	/* data payload */
-	for (i = 0; i < cnt; i++) {
+	for (i = 0; i < cnt; i++)
 		off = encode_word(port, off, data[i]);
-		crc32_hash32(data[i]);
-	}
 	/* CRC */
-	off = encode_word(port, off, crc32_result());
-
-#ifdef CONFIG_COMMON_RUNTIME
-	mutex_unlock(&pd_crc_lock);
-#endif
+	off = encode_word(port, off, pd_msg_crc(header, data, cnt));
 
 	/* End Of Packet */
 	off = pd_write_sym(port, off, BMC(PD_EOP));
@@ -312,6 +376,9 @@ static int send_validate_message(int port, uint16_t header,
 	/* retry 3 times if we are not getting a valid answer */
 	for (r = 0; r <= PD_RETRY_COUNT; r++) {
 		int bit_len, head;
+
+		if (r)
+			pd_timing_tx_retry(port);
 		/* write the encoded packet in the transmission buffer */
 		bit_len = prepare_message(port, header, cnt, data);
 		/* Transmit the packet */
@@ -390,6 +457,7 @@ static void send_goodcrc(int port, int id)
 		/* another packet recvd before we could send goodCRC */
 		return;
 	pd_tx_done(port, pd[port].polarity);
+	pd_timing_goodcrc(port);
 	/* Keep RX monitoring on */
 	pd_rx_enable_monitoring(port);
 }
@@ -485,10 +553,14 @@ static inline int decode_short(int port, int off, uint16_t *val16)
 		dec4b5b[(w >> 15) & 0x1f], dec4b5b[(w >> 10) & 0x1f],
 		dec4b5b[(w >>  5) & 0x1f], dec4b5b[(w >>  0) & 0x1f]);
 #endif
+#ifdef CONFIG_USB_PD_RX_TABLE
+	*val16 = dec10b8b[w & 0x3ff] | (dec10b8b[w >> 10] << 8);
+#else
 	*val16 = dec4b5b[w & 0x1f] |
 		(dec4b5b[(w >>  5) & 0x1f] << 4) |
 		(dec4b5b[(w >> 10) & 0x1f] << 8) |
 		(dec4b5b[(w >> 15) & 0x1f] << 12);
+#endif
 	return end;
 }
 
@@ -597,31 +669,20 @@ int pd_analyze_rx(int port, uint32_t *payload)
 
 	/* read header */
 	bit = decode_short(port, bit, &header);
-
-#ifdef CONFIG_COMMON_RUNTIME
-	mutex_lock(&pd_crc_lock);
-#endif
-
-	crc32_init();
-	crc32_hash16(header);
 	cnt = PD_HEADER_CNT(header);
 
 	/* read payload data */
-	for (p = 0; p < cnt && bit > 0; p++) {
+	for (p = 0; p < cnt && bit > 0; p++)
 		bit = decode_word(port, bit, payload+p);
-		crc32_hash32(payload[p]);
-	}
-	ccrc = crc32_result();
-
-#ifdef CONFIG_COMMON_RUNTIME
-	mutex_unlock(&pd_crc_lock);
-#endif
 
 	if (bit < 0) {
 		msg = "len";
 		goto packet_err;
 	}
 
+	/* CRC the whole message once it is decoded */
+	ccrc = pd_msg_crc(header, payload, cnt);
+
 	/* check transmitted CRC */
 	bit = decode_word(port, bit, &pcrc);
 	if (bit < 0 || pcrc != ccrc) {
@@ -724,6 +785,11 @@ void tcpc_init(int port)
 		pd[port].cc_status[i] = cc_voltage_to_status(port,
 						pd_adc_read(port, i));
 	}
+
+#if defined(CONFIG_USB_POWER_DELIVERY) && !defined(TCPC_IN_PD_TASK)
+	/* The TCPC task can start sampling the port */
+	task_wake(TCPC_PORT_TO_TASK_ID(port));
+#endif
 }
 
 int tcpc_run(int port, int evt)
@@ -800,7 +866,15 @@ int tcpc_run(int port, int evt)
 	return 10*MSEC;
 }
 
-#ifndef CONFIG_USB_POWER_DELIVERY
+#ifndef TCPC_IN_PD_TASK
+#ifdef CONFIG_USB_POWER_DELIVERY
+void tcpc_task(void)
+{
+	int port = TASK_ID_TO_TCPC_PORT(task_get_current());
+	/* The PD task initializes the port, from tcpm_init() */
+	int timeout = -1;
+	int evt;
+#else
 void pd_task(void)
 {
 	int port = TASK_ID_TO_PD_PORT(task_get_current());
@@ -812,6 +886,7 @@ void pd_task(void)
 
 	/* we are now initialized */
 	alert(port, TCPC_REG_ALERT_TCPC_INITED);
+#endif
 
 	while (1) {
 		/* wait for next event/packet or timeout expiration */
@@ -825,7 +900,12 @@ void pd_task(void)
 
 void pd_rx_event(int port)
 {
-	task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_RX, 0);
+	pd_timing_rx(port);
+#ifdef TCPC_IN_PD_TASK
+	pd_task_set_event(port, PD_EVENT_RX);
+#else
+	task_set_event(TCPC_PORT_TO_TASK_ID(port), PD_EVENT_RX, 0);
+#endif
 }
 
 int tcpc_alert_status(int port, int *alert)
@@ -877,10 +957,10 @@ int tcpc_set_cc(int port, int pull)
 
 	/* Wake the PD phy task with special CC event mask */
 	/* TODO: use top case if no TCPM on same CPU */
-#ifdef CONFIG_USB_POWER_DELIVERY
+#ifdef TCPC_IN_PD_TASK
 	tcpc_run(port, PD_EVENT_CC);
 #else
-	task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_CC, 0);
+	task_set_event(TCPC_PORT_TO_TASK_ID(port), PD_EVENT_CC, 0);
 #endif
 	return EC_SUCCESS;
 }
@@ -927,10 +1007,10 @@ int tcpc_transmit(int port, enum tcpm_transmit_type type, uint16_t header,
 	pd[port].tx_head = header;
 	pd[port].tx_data = data;
 	/* TODO: use top case if no TCPM on same CPU */
-#ifdef CONFIG_USB_POWER_DELIVERY
+#ifdef TCPC_IN_PD_TASK
 	tcpc_run(port, PD_EVENT_TX);
 #else
-	task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_TX, 0);
+	task_set_event(TCPC_PORT_TO_TASK_ID(port), PD_EVENT_TX, 0);
 #endif
 	return EC_SUCCESS;
 }
@@ -147,6 +147,21 @@ static uint32_t tasks_ready = (1 << TASK_ID_HOOKS);
 
 static int start_called;  /* Has task swapping started */
 
+/* Bitmap of tasks waiting for a mutex */
+static uint32_t tasks_mutex_wait;
+
+/* Mutex each task is waiting for; valid if its bit is in tasks_mutex_wait */
+static struct mutex *mutex_wait[TASK_ID_COUNT];
+
+/*
+ * A locked mutex holds the ID of its owner in its lock field, stored with the
+ * same exclusive store which takes the lock, so that the scheduler never sees
+ * a locked mutex without its owner.  The offset keeps it clear of 0 (unlocked)
+ * and 1 (exclusive store failed).
+ */
+#define MUTEX_LOCKED_BY(id)  ((id) + 2)
+#define MUTEX_OWNER(lock)    ((lock) - 2)
+
 static inline task_ *__task_id_to_ptr(task_id_t id)
 {
 	return tasks + id;
@@ -197,6 +212,43 @@ int task_start_called(void)
 	return start_called;
 }
 
+/**
+ * Return the ID of the task to run next.
+ *
+ * This is the highest priority ready task, unless a higher priority task is
+ * waiting for a mutex whose owner is ready.  Then the owner runs in its place,
+ * inheriting its priority; this follows chains of mutexes too.
+ */
+static task_id_t task_get_next(void)
+{
+	uint32_t candidates = tasks_ready | tasks_mutex_wait;
+	task_id_t id, t;
+	uint32_t lock;
+	int n;
+
+	/* Nothing to inherit in the common case */
+	if (!tasks_mutex_wait)
+		return 31 - __builtin_clz(tasks_ready);
+
+	/* Terminates since tasks_ready is never empty */
+	while (1) {
+		id = 31 - __builtin_clz(candidates);
+		for (t = id, n = 0; n < TASK_ID_COUNT; n++) {
+			if (tasks_ready & (1 << t))
+				return t;
+			if (!(tasks_mutex_wait & (1 << t)))
+				break;
+			lock = mutex_wait[t]->lock;
+			if (!lock)
+				break;
+			t = MUTEX_OWNER(lock);
+			if (t >= TASK_ID_COUNT)
+				break;
+		}
+		candidates &= ~(1 << id);
+	}
+}
+
 /**
  * Scheduling system call
  */
@@ -248,7 +300,7 @@ void svc_handler(int desched, task_id_t resched)
 	tasks_ready |= 1 << resched;
 
 	ASSERT(tasks_ready);
-	next = __task_id_to_ptr(31 - __builtin_clz(tasks_ready));
+	next = __task_id_to_ptr(task_get_next());
 
 #ifdef CONFIG_TASK_PROFILING
 	/* Track time in interrupts */
@@ -479,32 +531,69 @@ static void __nvic_init_irqs(void)
 	}
 }
 
-void mutex_lock(struct mutex *mtx)
+int mutex_lock_timeout(struct mutex *mtx, int timeout_us)
 {
 	uint32_t value;
-	uint32_t id = 1 << task_get_current();
+	task_id_t me = task_get_current();
+	uint32_t id = 1 << me;
+	uint64_t start = 0;
+	int contended = 0;
+	int remaining = 0;
 
-	ASSERT(id != TASK_ID_INVALID);
+	ASSERT(me < TASK_ID_COUNT);
 	atomic_or(&mtx->waiters, id);
 
-	do {
-		/* Try to get the lock (set 1 into the lock field) */
+	while (1) {
+		/* Try to get the lock (set our ID into the lock field) */
 		__asm__ __volatile__("   ldrex   %0, [%1]\n"
 				     "   teq     %0, #0\n"
 				     "   it eq\n"
 				     "   strexeq %0, %2, [%1]\n"
 				     : "=&r" (value)
-				     : "r" (&mtx->lock), "r" (2) : "cc");
+				     : "r" (&mtx->lock), "r" (MUTEX_LOCKED_BY(me))
+				     : "cc");
 		/*
 		 * "value" is equals to 1 if the store conditional failed,
-		 * 2 if somebody else owns the mutex, 0 else.
+		 * the lock field of the owner if somebody else owns the mutex,
+		 * 0 else.
 		 */
-		if (value == 2)
-			/* Contention on the mutex */
-			task_wait_event_mask(TASK_EVENT_MUTEX, 0);
-	} while (value);
+		if (!value)
+			break;
+		if (value == 1)
+			continue;
+
+		/* Contention on the mutex */
+		if (!contended) {
+			contended = 1;
+			start = get_time().val;
+		}
+		if (timeout_us > 0)
+			remaining = start + timeout_us - get_time().val;
+		if (timeout_us == 0 || (timeout_us > 0 && remaining <= 0)) {
+			atomic_clear(&mtx->waiters, id);
+			/* Don't leave a wake-up for the next mutex_lock() */
+			atomic_clear(&current_task->events, TASK_EVENT_MUTEX);
+			mutex_stats_timeout(mtx);
+			return EC_ERROR_TIMEOUT;
+		}
+
+		/* Lend our priority to the owner while we wait */
+		mutex_wait[me] = mtx;
+		atomic_or(&tasks_mutex_wait, id);
+		task_wait_event_mask(TASK_EVENT_MUTEX, remaining);
+		atomic_clear(&tasks_mutex_wait, id);
+	}
 
+	mtx->owner = me;
 	atomic_clear(&mtx->waiters, id);
+	mutex_stats_locked(mtx, start, contended);
+
+	return EC_SUCCESS;
+}
+
+void mutex_lock(struct mutex *mtx)
+{
+	mutex_lock_timeout(mtx, -1);
 }
 
 void mutex_unlock(struct mutex *mtx)
@@ -512,6 +601,9 @@ void mutex_unlock(struct mutex *mtx)
 	uint32_t waiters;
 	task_ *tsk = current_task;
 
+	mutex_stats_unlocked(mtx);
+	mtx->owner = TASK_ID_INVALID;
+
 	__asm__ __volatile__("   ldr     %0, [%2]\n"
 			     "   str     %3, [%1]\n"
 			     : "=&r" (waiters)
@@ -497,11 +497,15 @@ static void __nvic_init_irqs(void)
 	}
 }
 
-void mutex_lock(struct mutex *mtx)
+int mutex_lock_timeout(struct mutex *mtx, int timeout_us)
 {
-	uint32_t id = 1 << task_get_current();
+	task_id_t me = task_get_current();
+	uint32_t id = 1 << me;
+	uint64_t start = 0;
+	int contended = 0;
+	int remaining = 0;
 
-	ASSERT(id != TASK_ID_INVALID);
+	ASSERT(me < TASK_ID_COUNT);
 	atomic_or(&mtx->waiters, id);
 
 	while (1) {
@@ -510,14 +514,36 @@ void mutex_lock(struct mutex *mtx)
 		if (mtx->lock == 0)
 			break;
 		__asm__ __volatile__("cpsie i");
-		/* TODO(crbug.com/435612, crbug.com/435611)
-		 * This discards any pending events! */
-		task_wait_event(0);  /* Contention on the mutex */
+
+		/* Contention on the mutex */
+		if (!contended) {
+			contended = 1;
+			start = get_time().val;
+		}
+		if (timeout_us > 0)
+			remaining = start + timeout_us - get_time().val;
+		if (timeout_us == 0 || (timeout_us > 0 && remaining <= 0)) {
+			atomic_clear(&mtx->waiters, id);
+			/* Don't leave a wake-up for the next mutex_lock() */
+			atomic_clear(&current_task->events, TASK_EVENT_MUTEX);
+			mutex_stats_timeout(mtx);
+			return EC_ERROR_TIMEOUT;
+		}
+		task_wait_event_mask(TASK_EVENT_MUTEX, remaining);
 	}
 	mtx->lock = 2;
+	mtx->owner = me;
 	__asm__ __volatile__("cpsie i");
 
 	atomic_clear(&mtx->waiters, id);
+	mutex_stats_locked(mtx, start, contended);
+
+	return EC_SUCCESS;
+}
+
+void mutex_lock(struct mutex *mtx)
+{
+	mutex_lock_timeout(mtx, -1);
 }
 
 void mutex_unlock(struct mutex *mtx)
@@ -525,6 +551,9 @@ void mutex_unlock(struct mutex *mtx)
 	uint32_t waiters;
 	task_ *tsk = current_task;
 
+	mutex_stats_unlocked(mtx);
+	mtx->owner = TASK_ID_INVALID;
+
 	__asm__ __volatile__("   ldr     %0, [%2]\n"
 			     "   str     %3, [%1]\n"
 			     : "=&r" (waiters)
@@ -23,4 +23,18 @@ pthread_t task_get_thread(task_id_t tskid);
  */
 task_id_t task_get_running(void);
 
+#ifdef CONFIG_TASK_TRACE
+/**
+ * Save the scheduling trace in Chrome trace event format.
+ *
+ * The file can be loaded in chrome://tracing to show a timeline of task
+ * switches, interrupts and events.
+ *
+ * @param path		File to write
+ *
+ * @return EC_SUCCESS, or non-zero if the file could not be written.
+ */
+int task_trace_save(const char *path);
+#endif
+
 #endif  /* __CROS_EC_HOST_TASK_H */
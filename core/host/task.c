@@ -5,6 +5,7 @@
 
 /* Task scheduling / events module for Chrome EC operating system */
 
+#include <inttypes.h>
 #include <malloc.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -31,6 +32,14 @@ struct emu_task_t {
 	uint32_t event;
 	timestamp_t wake_time;
 	uint8_t started;
+#ifdef CONFIG_TASK_PROFILING
+	uint64_t runtime;      /* Time spent running, less interrupts */
+	uint64_t ready_time;   /* Time an event made the task ready, or ~0 */
+	uint64_t wake_total;   /* Total time from ready to running */
+	uint32_t wake_max;     /* Longest time from ready to running */
+	uint32_t wakeups;      /* Number of times the task was made ready */
+	uint32_t runs;         /* Number of times the task was switched to */
+#endif
 };
 
 struct task_args {
@@ -56,6 +65,47 @@ static int has_interrupt_generator = 1;
 
 static __thread task_id_t my_task_id; /* thread local task id */
 
+/* Mutex each task is waiting for, or NULL */
+static struct mutex *mutex_wait[TASK_ID_COUNT];
+
+#ifdef CONFIG_TASK_PROFILING
+static uint64_t task_start_time; /* Time task scheduling started */
+static uint64_t resume_time;     /* Time the running task was resumed */
+static uint64_t resume_exc_time; /* exc_total_time at that point */
+static uint64_t yield_time;      /* Time the last task yielded */
+static uint64_t exc_total_time;  /* Total time in interrupts */
+static uint32_t irq_count;       /* Number of interrupts */
+static uint32_t task_switches;   /* Number of times active task changed */
+#endif
+
+#ifdef CONFIG_TASK_TRACE
+#ifndef CONFIG_TASK_PROFILING
+#error "CONFIG_TASK_TRACE requires CONFIG_TASK_PROFILING"
+#endif
+
+enum task_trace_type {
+	TRACE_SWITCH_IN,
+	TRACE_SWITCH_OUT,
+	TRACE_EVENT_SET,
+	TRACE_IRQ_ENTER,
+	TRACE_IRQ_EXIT,
+};
+
+struct task_trace_entry {
+	uint64_t time;
+	uint32_t event;  /* Events set, for TRACE_EVENT_SET */
+	uint8_t type;    /* enum task_trace_type */
+	uint8_t task;    /* Task switched, signalled or interrupted */
+	uint8_t from;    /* Setter of the event; TASK_ID_COUNT if interrupt */
+};
+
+static struct task_trace_entry trace_buf[CONFIG_TASK_TRACE_SIZE];
+static uint32_t trace_count; /* Entries recorded since the last clear */
+
+/* Trace timeline used for interrupts and the interrupt generator */
+#define TRACE_IRQ_TID TASK_ID_COUNT
+#endif
+
 static void task_enable_all_tasks_callback(void);
 
 #define TASK(n, r, d, s) void r(void *);
@@ -93,6 +143,24 @@ static const char * const task_names[] = {
 };
 #undef TASK
 
+#ifdef CONFIG_TASK_TRACE
+static void task_trace(int type, int task, int from, uint64_t time,
+		       uint32_t event)
+{
+	/* Tasks and interrupts may race for a slot, so claim it atomically */
+	uint32_t i = __sync_fetch_and_add(&trace_count, 1);
+	struct task_trace_entry *e = trace_buf + i % CONFIG_TASK_TRACE_SIZE;
+
+	e->time = time;
+	e->event = event;
+	e->type = type;
+	e->task = task;
+	e->from = from;
+}
+#else
+#define task_trace(type, task, from, time, event)
+#endif
+
 void task_pre_init(void)
 {
 	/* Nothing */
@@ -119,8 +187,20 @@ void interrupt_enable(void)
 
 static void _task_execute_isr(int sig)
 {
+#ifdef CONFIG_TASK_PROFILING
+	uint64_t t = get_time().val;
+#endif
+
 	in_interrupt = 1;
+	task_trace(TRACE_IRQ_ENTER, running_task_id, TRACE_IRQ_TID,
+		   get_time().val, 0);
 	pending_isr();
+	task_trace(TRACE_IRQ_EXIT, running_task_id, TRACE_IRQ_TID,
+		   get_time().val, 0);
+#ifdef CONFIG_TASK_PROFILING
+	exc_total_time += get_time().val - t;
+	irq_count++;
+#endif
 	sem_post(&interrupt_sem);
 	in_interrupt = 0;
 }
@@ -173,7 +253,18 @@ pthread_t task_get_thread(task_id_t tskid)
 
 uint32_t task_set_event(task_id_t tskid, uint32_t event, int wait)
 {
-	tasks[tskid].event = event;
+#ifdef CONFIG_TASK_TRACE
+	task_id_t from = task_get_current();
+
+	if (in_interrupt_context() || from >= TASK_ID_COUNT)
+		from = TRACE_IRQ_TID;
+	task_trace(TRACE_EVENT_SET, tskid, from, get_time().val, event);
+#endif
+#ifdef CONFIG_TASK_PROFILING
+	if (tasks[tskid].ready_time == ~0ull)
+		tasks[tskid].ready_time = get_time().val;
+#endif
+	atomic_or(&tasks[tskid].event, event);
 	if (wait)
 		return task_wait_event(-1);
 	return 0;
@@ -226,40 +317,59 @@ uint32_t task_wait_event_mask(uint32_t event_mask, int timeout_us)
 	return events & event_mask;
 }
 
-void mutex_lock(struct mutex *mtx)
+int mutex_lock_timeout(struct mutex *mtx, int timeout_us)
 {
-	int value = 0;
-	int id = 1 << task_get_current();
+	task_id_t id = task_get_current();
+	uint64_t start = get_time().val;
+	int contended = 0;
+	int remaining;
+
+	while (mtx->lock) {
+		remaining = start + timeout_us - get_time().val;
+		if (timeout_us == 0 || (timeout_us > 0 && remaining <= 0)) {
+			mutex_wait[id] = NULL;
+			mtx->waiters &= ~(1 << id);
+			/* Don't leave a wake-up for the next mutex_lock() */
+			atomic_clear(&tasks[id].event, TASK_EVENT_MUTEX);
+			mutex_stats_timeout(mtx);
+			return EC_ERROR_TIMEOUT;
+		}
 
-	mtx->waiters |= id;
+		/* Lend our priority to the owner while we wait */
+		mtx->waiters |= 1 << id;
+		mutex_wait[id] = mtx;
+		contended = 1;
+		task_wait_event_mask(TASK_EVENT_MUTEX,
+				     timeout_us > 0 ? remaining : -1);
+	}
 
-	do {
-		if (mtx->lock == 0) {
-			mtx->lock = 1;
-			value = 1;
-		}
+	mutex_wait[id] = NULL;
+	mtx->waiters &= ~(1 << id);
+	mtx->lock = 1;
+	mtx->owner = id;
+	mutex_stats_locked(mtx, start, contended);
 
-		if (!value)
-			/* Contention on the mutex */
-			/* TODO(crbug.com/435612, crbug.com/435611)
-			 * This discards any pending events! */
-			task_wait_event(-1);
-	} while (!value);
+	return EC_SUCCESS;
+}
 
-	mtx->waiters &= ~id;
+void mutex_lock(struct mutex *mtx)
+{
+	mutex_lock_timeout(mtx, -1);
 }
 
 void mutex_unlock(struct mutex *mtx)
 {
+	uint32_t waiters = mtx->waiters;
 	int v;
+
+	mutex_stats_unlocked(mtx);
+	mtx->owner = TASK_ID_INVALID;
 	mtx->lock = 0;
 
+	/* Waiters clear their own bit once they have the lock */
 	for (v = 31; v >= 0; --v)
-		if ((1ul << v) & mtx->waiters) {
-			mtx->waiters &= ~(1ul << v);
+		if ((1ul << v) & waiters)
 			task_set_event(v, TASK_EVENT_MUTEX, 0);
-			break;
-		}
 }
 
 task_id_t task_get_current(void)
@@ -272,6 +382,51 @@ task_id_t task_get_running(void)
 	return running_task_id;
 }
 
+void task_print_list(void)
+{
+	int i;
+
+	ccputs("Task Ready Name         Events");
+#ifdef CONFIG_TASK_PROFILING
+	ccputs("      Time (s)     Runs  Wake avg/max (us)");
+#endif
+	ccputs("\n");
+
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		ccprintf("%4d %c %-16s %08x", i, tasks[i].event ? 'R' : ' ',
+			 task_names[i], tasks[i].event);
+#ifdef CONFIG_TASK_PROFILING
+		ccprintf(" %11.6ld %8d %8d/%d", tasks[i].runtime,
+			 tasks[i].runs,
+			 tasks[i].wakeups ?
+			 (int)(tasks[i].wake_total / tasks[i].wakeups) : 0,
+			 tasks[i].wake_max);
+#endif
+		ccputs("\n");
+		cflush();
+	}
+}
+
+int command_task_info(int argc, char **argv)
+{
+	task_print_list();
+
+#ifdef CONFIG_TASK_PROFILING
+	ccprintf("Interrupts:             %11d\n", irq_count);
+	ccprintf("Task switches:          %11d\n", task_switches);
+	ccprintf("Task switching started: %11.6ld s\n", task_start_time);
+	ccprintf("Time in tasks:          %11.6ld s\n",
+		 get_time().val - task_start_time);
+	ccprintf("Time in exceptions:     %11.6ld s\n", exc_total_time);
+#endif
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(taskinfo, command_task_info,
+			NULL,
+			"Print task info",
+			NULL);
+
 void wait_for_task_started(void)
 {
 	int i, ok;
@@ -348,36 +503,211 @@ int task_start_called(void)
 	return task_started;
 }
 
+#ifdef CONFIG_TASK_PROFILING
+/**
+ * Account for the scheduler resuming a task.
+ *
+ * Must be called before the task's wake time is cleared, since reaching it
+ * may be what made the task ready.
+ */
+static void task_profile_resume(task_id_t id)
+{
+	struct emu_task_t *task = tasks + id;
+	uint64_t t = get_time().val;
+	uint64_t ready = task->ready_time;
+
+	if (task->wake_time.val <= t && task->wake_time.val < ready)
+		ready = task->wake_time.val;
+
+	if (ready <= t) {
+		task->wakeups++;
+		task->wake_total += t - ready;
+		if (t - ready > task->wake_max)
+			task->wake_max = t - ready;
+	}
+	task->ready_time = ~0ull;
+
+	resume_time = t;
+	resume_exc_time = exc_total_time;
+
+	/*
+	 * The scheduler often resumes the task which just yielded, idle in
+	 * particular; that is not a task switch.
+	 */
+	if (task_switches) {
+		if (id == running_task_id)
+			return;
+		task_trace(TRACE_SWITCH_OUT, running_task_id,
+			   running_task_id, yield_time, 0);
+	}
+	task_trace(TRACE_SWITCH_IN, id, id, t, 0);
+	task->runs++;
+	task_switches++;
+}
+
+/**
+ * Account for a task handing control back to the scheduler.
+ */
+static void task_profile_yield(task_id_t id)
+{
+	yield_time = get_time().val;
+
+	/* Interrupts ran on the task's thread, but aren't its time */
+	tasks[id].runtime += (yield_time - resume_time) -
+			     (exc_total_time - resume_exc_time);
+}
+#endif
+
+#ifdef CONFIG_TASK_TRACE
+int task_trace_save(const char *path)
+{
+	uint32_t count = trace_count;
+	uint32_t first = 0;
+	const struct task_trace_entry *e;
+	const char *sep = "";
+	FILE *f;
+	uint32_t i;
+
+	f = fopen(path, "w");
+	if (!f)
+		return EC_ERROR_UNKNOWN;
+
+	/* Oldest entries have been overwritten once the buffer wraps */
+	if (count > CONFIG_TASK_TRACE_SIZE)
+		first = count - CONFIG_TASK_TRACE_SIZE;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	/* Name each timeline after its task */
+	for (i = 0; i <= TRACE_IRQ_TID; i++) {
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+			"\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			sep, i, i == TRACE_IRQ_TID ? "<< interrupts >>" :
+			task_get_name(i));
+		sep = ",\n";
+	}
+
+	for (i = first; i < count; i++) {
+		e = trace_buf + i % CONFIG_TASK_TRACE_SIZE;
+
+		switch (e->type) {
+		case TRACE_SWITCH_IN:
+		case TRACE_SWITCH_OUT:
+			fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%s\","
+				"\"pid\":0,\"tid\":%d,\"ts\":%" PRIu64 "}",
+				sep, task_get_name(e->task),
+				e->type == TRACE_SWITCH_IN ? "B" : "E",
+				e->task, e->time);
+			break;
+		case TRACE_IRQ_ENTER:
+		case TRACE_IRQ_EXIT:
+			fprintf(f, "%s{\"name\":\"irq\",\"ph\":\"%s\","
+				"\"pid\":0,\"tid\":%d,\"ts\":%" PRIu64 ","
+				"\"args\":{\"task\":\"%s\"}}",
+				sep, e->type == TRACE_IRQ_ENTER ? "B" : "E",
+				TRACE_IRQ_TID, e->time,
+				task_get_name(e->task));
+			break;
+		case TRACE_EVENT_SET:
+			fprintf(f, "%s{\"name\":\"set %s\",\"ph\":\"i\","
+				"\"s\":\"t\",\"pid\":0,\"tid\":%d,"
+				"\"ts\":%" PRIu64 ",\"args\":{\"event\":"
+				"\"0x%08x\"}}",
+				sep, task_get_name(e->task), e->from,
+				e->time, e->event);
+			break;
+		}
+	}
+
+	fprintf(f, "\n],\"otherData\":{\"dropped\":%u}}\n", first);
+	fclose(f);
+
+	return EC_SUCCESS;
+}
+
+static int command_task_trace(int argc, char **argv)
+{
+	uint32_t count = trace_count;
+
+	if (argc == 2 && !strcmp(argv[1], "clear")) {
+		trace_count = 0;
+		return EC_SUCCESS;
+	} else if (argc == 2) {
+		return task_trace_save(argv[1]);
+	}
+
+	ccprintf("%u entries, %u dropped\n", count,
+		 count > CONFIG_TASK_TRACE_SIZE ?
+		 count - CONFIG_TASK_TRACE_SIZE : 0);
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(tasktrace, command_task_trace,
+			"[clear | <file>]",
+			"Print, clear or save scheduling trace",
+			NULL);
+#endif
+
+static int task_is_ready(int i, timestamp_t now)
+{
+	/* Only tasks with spawned threads are valid to be resumed. */
+	return tasks[i].thread &&
+	       (tasks[i].event || now.val >= tasks[i].wake_time.val);
+}
+
+/**
+ * Return the task to run at the priority of task i, or -1 if none.
+ *
+ * This is task i if it is ready.  If it is waiting for a mutex, the owner of
+ * the mutex inherits its priority, and so on along a chain of mutexes.
+ */
+static int task_get_runnable(int i, timestamp_t now)
+{
+	int n;
+
+	for (n = 0; n < TASK_ID_COUNT; n++) {
+		if (task_is_ready(i, now))
+			return i;
+		if (!mutex_wait[i] || !mutex_wait[i]->lock)
+			return -1;
+		i = mutex_wait[i]->owner;
+	}
+
+	return -1;
+}
+
 void task_scheduler(void)
 {
-	int i;
+	int i, run = 0;
 	timestamp_t now;
 
 	task_started = 1;
+#ifdef CONFIG_TASK_PROFILING
+	/* Wake-up latency is measured from here on */
+	task_start_time = get_time().val;
+	for (i = 0; i < TASK_ID_COUNT; i++)
+		tasks[i].ready_time = ~0ull;
+#endif
 
 	while (1) {
 		now = get_time();
-		i = TASK_ID_COUNT - 1;
-		while (i >= 0) {
-			/*
-			 * Only tasks with spawned threads are valid to be
-			 * resumed.
-			 */
-			if (tasks[i].thread) {
-				if (tasks[i].event ||
-				    now.val >= tasks[i].wake_time.val)
-					break;
-			}
-			--i;
+		for (i = TASK_ID_COUNT - 1; i >= 0; --i) {
+			run = task_get_runnable(i, now);
+			if (run >= 0)
+				break;
 		}
-		if (i < 0)
-			i = fast_forward();
+		i = i < 0 ? fast_forward() : run;
 
+#ifdef CONFIG_TASK_PROFILING
+		task_profile_resume(i);
+#endif
 		tasks[i].wake_time.val = ~0ull;
 		running_task_id = i;
 		tasks[i].started = 1;
 		pthread_cond_signal(&tasks[i].resume);
 		pthread_cond_wait(&scheduler_cond, &run_lock);
+#ifdef CONFIG_TASK_PROFILING
+		task_profile_yield(i);
+#endif
 	}
 }
 
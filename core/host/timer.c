@@ -34,6 +34,18 @@
  */
 #define TEST_TIME_SLOW_DOWN 10
 
+/*
+ * Unit tests run on a virtual clock. Time only advances when udelay() is
+ * called or when the scheduler fast forwards to the next wake-up, so a test
+ * runs as fast as the host allows and takes the same path on every run.
+ * Tests which measure real execution time, or which race an interrupt
+ * generator against busy-waiting tasks, use the host clock instead by
+ * specifying <test_name>-real-time=y in test/build.mk.
+ */
+#ifdef TEST_VIRTUAL_TIME
+static volatile uint64_t virtual_time;
+#endif
+
 static timestamp_t boot_time;
 static int time_set;
 
@@ -52,12 +64,18 @@ void usleep(unsigned us)
 
 timestamp_t _get_time(void)
 {
+#ifdef TEST_VIRTUAL_TIME
+	timestamp_t ret;
+	ret.val = virtual_time;
+	return ret;
+#else
 	struct timespec ts;
 	timestamp_t ret;
 	clock_gettime(CLOCK_MONOTONIC, &ts);
 	ret.val = (1000000000 * (uint64_t)ts.tv_sec + ts.tv_nsec) *
 		  TEST_TIME_SCALE / 1000 / TEST_TIME_SLOW_DOWN;
 	return ret;
+#endif
 }
 
 timestamp_t get_time(void)
@@ -69,7 +87,14 @@ timestamp_t get_time(void)
 
 void force_time(timestamp_t ts)
 {
-	timestamp_t now = _get_time();
+	timestamp_t now;
+
+#ifdef TEST_VIRTUAL_TIME
+	/* Virtual time never runs backwards; move the boot time instead */
+	if (ts.val > get_time().val)
+		virtual_time += ts.val - get_time().val;
+#endif
+	now = _get_time();
 	boot_time.val = now.val - ts.val;
 	time_set = 1;
 }
@@ -84,8 +109,12 @@ void udelay(unsigned us)
 	}
 
 	deadline.val = get_time().val + us;
+#ifdef TEST_VIRTUAL_TIME
+	force_time(deadline);
+#else
 	while (get_time().val < deadline.val)
 		;
+#endif
 }
 
 int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
@@ -291,6 +291,34 @@ uint32_t task_wait_event(int timeout_us)
 	return __wait_evt(timeout_us, TASK_ID_IDLE);
 }
 
+uint32_t task_wait_event_mask(uint32_t event_mask, int timeout_us)
+{
+	uint64_t deadline = get_time().val + timeout_us;
+	uint32_t events = 0;
+	int time_remaining_us = timeout_us;
+
+	/* Add the timer event to the mask so we can indicate a timeout */
+	event_mask |= TASK_EVENT_TIMER;
+
+	while (!(events & event_mask)) {
+		/* Collect events to re-post later */
+		events |= __wait_evt(time_remaining_us, TASK_ID_IDLE);
+
+		time_remaining_us = deadline - get_time().val;
+		if (timeout_us > 0 && time_remaining_us <= 0) {
+			/* Ensure we return a TIMER event if we timeout */
+			events |= TASK_EVENT_TIMER;
+			break;
+		}
+	}
+
+	/* Re-post any other events collected */
+	if (events & ~event_mask)
+		atomic_or(&current_task->events, events & ~event_mask);
+
+	return events & event_mask;
+}
+
 static uint32_t get_int_mask(void)
 {
 	uint32_t ret;
@@ -375,11 +403,15 @@ static void ivic_init_irqs(void)
 	set_int_priority(all_priorities);
 }
 
-void mutex_lock(struct mutex *mtx)
+int mutex_lock_timeout(struct mutex *mtx, int timeout_us)
 {
-	uint32_t id = 1 << task_get_current();
+	task_id_t me = task_get_current();
+	uint32_t id = 1 << me;
+	uint64_t start = 0;
+	int contended = 0;
+	int remaining = 0;
 
-	ASSERT(id != TASK_ID_INVALID);
+	ASSERT(me < TASK_ID_COUNT);
 
 	/* critical section with interrupts off */
 	asm volatile ("setgie.d ; dsb");
@@ -387,28 +419,52 @@ void mutex_lock(struct mutex *mtx)
 	while (1) {
 		if (!mtx->lock) { /* we got it ! */
 			mtx->lock = 2;
+			mtx->owner = me;
 			mtx->waiters &= ~id;
 			/* end of critical section : re-enable interrupts */
 			asm volatile ("setgie.e");
-			return;
-		} else { /* Contention on the mutex */
-			/* end of critical section : re-enable interrupts */
+			mutex_stats_locked(mtx, start, contended);
+			return EC_SUCCESS;
+		}
+
+		/* Contention on the mutex */
+		if (!contended) {
+			contended = 1;
+			start = get_time().val;
+		}
+		if (timeout_us > 0)
+			remaining = start + timeout_us - get_time().val;
+		if (timeout_us == 0 || (timeout_us > 0 && remaining <= 0)) {
+			mtx->waiters &= ~id;
 			asm volatile ("setgie.e");
-			/* Sleep waiting for our turn */
-			/* TODO(crbug.com/435612, crbug.com/435611)
-			 * This discards any pending events! */
-			task_wait_event(0);
-			/* re-enter critical section */
-			asm volatile ("setgie.d ; dsb");
+			/* Don't leave a wake-up for the next mutex_lock() */
+			atomic_clear(&current_task->events, TASK_EVENT_MUTEX);
+			mutex_stats_timeout(mtx);
+			return EC_ERROR_TIMEOUT;
 		}
+
+		/* end of critical section : re-enable interrupts */
+		asm volatile ("setgie.e");
+		/* Sleep waiting for our turn, keeping other events pending */
+		task_wait_event_mask(TASK_EVENT_MUTEX, remaining);
+		/* re-enter critical section */
+		asm volatile ("setgie.d ; dsb");
 	}
 }
 
+void mutex_lock(struct mutex *mtx)
+{
+	mutex_lock_timeout(mtx, -1);
+}
+
 void mutex_unlock(struct mutex *mtx)
 {
 	uint32_t waiters;
 	task_ *tsk = current_task;
 
+	mutex_stats_unlocked(mtx);
+	mtx->owner = TASK_ID_INVALID;
+
 	waiters = mtx->waiters;
 	/* give back the lock */
 	mtx->lock = 0;
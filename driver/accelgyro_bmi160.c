@@ -14,6 +14,7 @@
 #include "driver/accelgyro_bmi160.h"
 #include "driver/mag_bmm150.h"
 #include "hooks.h"
+#include "hwtimer.h"
 #include "i2c.h"
 #include "task.h"
 #include "timer.h"
@@ -52,6 +53,11 @@ const struct accel_param_pair dps_ranges[] = {
 	{2000, BMI160_DPS_SEL_2000}
 };
 
+#ifdef CONFIG_ACCEL_FIFO
+/* Time of the last FIFO drain; frames read since are spread over the gap */
+static uint32_t last_drain_time;
+#endif
+
 static inline const struct accel_param_pair *get_range_table(
 		enum motionsensor_type type, int *psize)
 {
@@ -390,6 +396,9 @@ static int set_interrupt(const struct motion_sensor_t *s,
 
 	mutex_lock(s->mutex);
 	raw_write8(s->i2c_addr, BMI160_CMD_REG, BMI160_CMD_FIFO_FLUSH);
+#ifdef CONFIG_ACCEL_FIFO
+	last_drain_time = 0;
+#endif
 	msleep(30);
 	raw_write8(s->i2c_addr, BMI160_CMD_REG, BMI160_CMD_INT_RESET);
 
@@ -470,146 +479,220 @@ int irq_handler(const struct motion_sensor_t *s)
 #endif  /* CONFIG_ACCEL_INTERRUPTS */
 
 #ifdef CONFIG_ACCEL_FIFO
-enum fifo_state {
-	FIFO_HEADER,
-	FIFO_DATA_SKIP,
-	FIFO_DATA_TIME,
-	FIFO_DATA_CONFIG,
-};
+/* Big enough for the whole hardware FIFO, so a drain is one I2C transfer */
+static uint8_t bmi160_buffer[BMI160_FIFO_SIZE];
+
+#ifdef CONFIG_CMD_ACCEL_FIFO
+static struct {
+	uint32_t drains;        /* Times the FIFO was read */
+	uint32_t bytes;         /* Bytes moved over I2C */
+	uint32_t samples[MOTIONSENSE_TYPE_MAG + 1];
+	uint64_t start;         /* Time the stats were cleared */
+} fifo_stats;
+#endif
 
+#define BMI160_IS_DATA_FRAME(_hdr) \
+	(((_hdr) & BMI160_FH_MODE_MASK) == BMI160_EMPTY && \
+	 ((_hdr) & BMI160_FH_PARM_MASK) != 0)
 
-#define BMI160_FIFO_BUFFER 64
-static uint8_t bmi160_buffer[BMI160_FIFO_BUFFER];
-#define BUFFER_END(_buffer) ((_buffer) + sizeof(_buffer))
-/*
- * Decode the header from the fifo.
- * Return 0 if we need further processing.
- * Sensor mutex must be held during processing, to protect the fifos.
- *
- * @s: base sensor
- * @hdr: the header to decode
- * @bp: current pointer in the buffer, updated when processing the header.
+/**
+ * Return the size of a FIFO frame, header included, or 0 if the FIFO is empty.
  */
-static int bmi160_decode_header(struct motion_sensor_t *s,
-		enum fifo_header hdr, uint8_t **bp)
+static int bmi160_frame_size(uint8_t hdr)
 {
-	if ((hdr & BMI160_FH_MODE_MASK) == BMI160_EMPTY &&
-			(hdr & BMI160_FH_PARM_MASK) != 0) {
-		int i, size = 0;
-		/* Check if there is enough space for the data frame */
-		for (i = MOTIONSENSE_TYPE_MAG; i >= MOTIONSENSE_TYPE_ACCEL;
-		     i--) {
+	int i, size = 1;
+
+	if (BMI160_IS_DATA_FRAME(hdr)) {
+		for (i = MOTIONSENSE_TYPE_ACCEL; i <= MOTIONSENSE_TYPE_MAG; i++)
 			if (hdr & (1 << (i + BMI160_FH_PARM_OFFSET)))
 				size += (i == MOTIONSENSE_TYPE_MAG ? 8 : 6);
-		}
-		if (*bp + size > BUFFER_END(bmi160_buffer)) {
-			/* frame is not complete, it
-			 * will be retransmitted.
-			 */
-			*bp = BUFFER_END(bmi160_buffer);
-			return 1;
-		}
-		for (i = MOTIONSENSE_TYPE_MAG; i >= MOTIONSENSE_TYPE_ACCEL;
-		     i--) {
-			if (hdr & (1 << (i + BMI160_FH_PARM_OFFSET))) {
-				struct ec_response_motion_sensor_data vector;
-				int *v = (s + i)->raw_xyz;
+		return size;
+	}
+
+	switch (hdr & 0xdc) {
+	case BMI160_EMPTY:
+		return 0;
+	case BMI160_SKIP:
+	case BMI160_CONFIG:
+		return 2;
+	case BMI160_TIME:
+		return 4;
+	default:
+		/* Unknown; skip the header */
+		return 1;
+	}
+}
+
+/**
+ * Decode the frames of a FIFO dump.
+ *
+ * Each data frame goes into the motion sense FIFO preceded by a timestamp,
+ * the first one at t0 and the next ones period us apart.
+ * motion_sense_fifo_add_unit() takes the sensor mutex itself, so this must be
+ * called without it, and without the I2C port locked.
+ *
+ * @param s		Base sensor, or NULL to only count the data frames
+ * @param bp		FIFO dump
+ * @param len		Size of the dump, in bytes
+ * @param t0		Time of the first data frame
+ * @param period	Time between data frames, in us
+ * @return the number of data frames.
+ */
+test_export_static int bmi160_decode_fifo(struct motion_sensor_t *s,
+					  uint8_t *bp, int len, uint32_t t0,
+					  uint32_t period)
+{
+	struct ec_response_motion_sensor_data vector;
+	uint8_t *end = bp + len;
+	int i, size, frames = 0;
+	uint8_t hdr;
+	int *v;
+
+	while (bp < end) {
+		hdr = *bp;
+		size = bmi160_frame_size(hdr);
+		/*
+		 * Stop when the FIFO is empty.  A frame which is not complete
+		 * will be retransmitted on the next read.
+		 */
+		if (!size || bp + size > end)
+			break;
+
+		if (BMI160_IS_DATA_FRAME(hdr) && s) {
+			vector.flags = MOTIONSENSE_SENSOR_FLAG_TIMESTAMP;
+			vector.timestamp = t0 + frames * period;
+			motion_sense_fifo_add_unit(&vector, s);
+
+			/* Magnetometer data comes first */
+			bp++;
+			for (i = MOTIONSENSE_TYPE_MAG;
+			     i >= MOTIONSENSE_TYPE_ACCEL; i--) {
+				if (!(hdr & (1 << (i + BMI160_FH_PARM_OFFSET))))
+					continue;
+				v = (s + i)->raw_xyz;
 				vector.flags = 0;
-				normalize(s + i, v, *bp);
+				normalize(s + i, v, bp);
 				vector.data[X] = v[X];
 				vector.data[Y] = v[Y];
 				vector.data[Z] = v[Z];
 				motion_sense_fifo_add_unit(&vector, s + i);
-				*bp += (i == MOTIONSENSE_TYPE_MAG ? 8 : 6);
+				bp += (i == MOTIONSENSE_TYPE_MAG ? 8 : 6);
+#ifdef CONFIG_CMD_ACCEL_FIFO
+				fifo_stats.samples[i]++;
+#endif
 			}
+			frames++;
+			continue;
 		}
-#if 0
-		if (hdr & BMI160_FH_EXT_MASK)
-			CPRINTF("%s%s\n",
-				(hdr & 0x1 ? "INT1" : ""),
-				(hdr & 0x2 ? "INT2" : ""));
-#endif
-		return 1;
-	} else {
-		return 0;
+
+		if (BMI160_IS_DATA_FRAME(hdr)) {
+			frames++;
+		} else if (s) {
+			switch (hdr & 0xdc) {
+			case BMI160_SKIP:
+				CPRINTF("skipped %d frames\n", bp[1]);
+				break;
+			case BMI160_CONFIG:
+				CPRINTF("config change: 0x%02x\n", bp[1]);
+				break;
+			case BMI160_TIME:
+				/* We are not requesting timestamp */
+				break;
+			default:
+				CPRINTS("Unknown header: 0x%02x", hdr);
+			}
+		}
+		bp += size;
 	}
+
+	return frames;
 }
 
 static int load_fifo(struct motion_sensor_t *s)
 {
-	int done = 0;
-	int fifo_length;
+	uint8_t fifo_reg = BMI160_FIFO_DATA;
+	uint32_t now, period = 0;
+	int fifo_length, frames, ret;
 
 	if (s->type != MOTIONSENSE_TYPE_ACCEL)
 		return EC_SUCCESS;
 
 	/* Read fifo length */
-	raw_read16(s->i2c_addr, BMI160_FIFO_LENGTH_0, &fifo_length);
+	ret = raw_read16(s->i2c_addr, BMI160_FIFO_LENGTH_0, &fifo_length);
+	now = __hw_clock_source_read();
+	if (ret != EC_SUCCESS)
+		return ret;
 	fifo_length &= BMI160_FIFO_LENGTH_MASK;
-	if (fifo_length == 0)
+	if (fifo_length == 0) {
+		last_drain_time = now;
 		return EC_SUCCESS;
-	do {
-		enum fifo_state state = FIFO_HEADER;
-		uint8_t fifo_reg = BMI160_FIFO_DATA;
-		uint8_t *bp = bmi160_buffer;
-		i2c_lock(I2C_PORT_ACCEL, 1);
-		i2c_xfer(I2C_PORT_ACCEL, s->i2c_addr,
-				&fifo_reg, 1, bmi160_buffer,
-				sizeof(bmi160_buffer), I2C_XFER_SINGLE);
-		i2c_lock(I2C_PORT_ACCEL, 0);
-		while (!done && bp != BUFFER_END(bmi160_buffer)) {
-			switch (state) {
-			case FIFO_HEADER: {
-				enum fifo_header hdr = *bp++;
-				if (bmi160_decode_header(s, hdr, &bp))
-					continue;
-				/* Other cases */
-				hdr &= 0xdc;
-				switch (hdr) {
-				case BMI160_EMPTY:
-					done = 1;
-					break;
-				case BMI160_SKIP:
-					state = FIFO_DATA_SKIP;
-					break;
-				case BMI160_TIME:
-					state = FIFO_DATA_TIME;
-					break;
-				case BMI160_CONFIG:
-					state = FIFO_DATA_CONFIG;
-					break;
-				default:
-					CPRINTS("Unknown header: 0x%02x", hdr);
-				}
-				break;
-			}
-			case FIFO_DATA_SKIP:
-				CPRINTF("skipped %d frames\n", *bp++);
-				state = FIFO_HEADER;
-				break;
-			case FIFO_DATA_CONFIG:
-				CPRINTF("config change: 0x%02x\n", *bp++);
-				state = FIFO_HEADER;
-				break;
-			case FIFO_DATA_TIME:
-				if (bp + 3 > BUFFER_END(bmi160_buffer)) {
-					bp = BUFFER_END(bmi160_buffer);
-					continue;
-				}
-				/* We are not requesting timestamp */
-				CPRINTF("timestamp %d\n", (bp[2] << 16) |
-					(bp[1] << 8) | bp[0]);
-				state = FIFO_HEADER;
-				bp += 3;
-				break;
-			default:
-				CPRINTS("Unknown data: 0x%02x\n", *bp++);
-				state = FIFO_HEADER;
-			}
-		}
-	} while (!done);
+	}
+
+	/*
+	 * Read it all in one burst.  Anything past the buffer stays in the
+	 * FIFO for the next round.
+	 */
+	fifo_length = MIN(fifo_length, sizeof(bmi160_buffer));
+	i2c_lock(I2C_PORT_ACCEL, 1);
+	ret = i2c_xfer(I2C_PORT_ACCEL, s->i2c_addr, &fifo_reg, 1,
+		       bmi160_buffer, fifo_length, I2C_XFER_SINGLE);
+	i2c_lock(I2C_PORT_ACCEL, 0);
+	if (ret != EC_SUCCESS)
+		return ret;
+
+	/* Interpolate frame times between the last drain and now */
+	frames = bmi160_decode_fifo(NULL, bmi160_buffer, fifo_length, 0, 0);
+	if (frames && last_drain_time)
+		period = (now - last_drain_time) / frames;
+	bmi160_decode_fifo(s, bmi160_buffer, fifo_length,
+			   now - (frames - 1) * period, period);
+	last_drain_time = now;
+
+#ifdef CONFIG_CMD_ACCEL_FIFO
+	fifo_stats.drains++;
+	/* Length register address and value, then FIFO address and data */
+	fifo_stats.bytes += 3 + 1 + fifo_length;
+#endif
+	return EC_SUCCESS;
+}
+
+#ifdef CONFIG_CMD_ACCEL_FIFO
+static int command_bmi160_fifo(int argc, char **argv)
+{
+	static const char * const names[] = {"accel", "gyro", "mag"};
+	uint64_t elapsed = get_time().val - fifo_stats.start;
+	uint32_t samples = 0;
+	int i;
+
+	if (argc == 2 && !strcasecmp(argv[1], "clear")) {
+		memset(&fifo_stats, 0, sizeof(fifo_stats));
+		fifo_stats.start = get_time().val;
+		return EC_SUCCESS;
+	} else if (argc > 1) {
+		return EC_ERROR_PARAM1;
+	}
+
+	ccprintf("Over %.6ld s: %d drains, %d I2C bytes\n", elapsed,
+		 fifo_stats.drains, fifo_stats.bytes);
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		samples += fifo_stats.samples[i];
+		ccprintf("%-5s %8d samples, ODR %d mHz\n", names[i],
+			 fifo_stats.samples[i], elapsed ?
+			 (int)(fifo_stats.samples[i] * 1000000000ULL /
+			       elapsed) : 0);
+	}
+	if (samples)
+		ccprintf("I2C bytes per sample: %d.%02d\n",
+			 fifo_stats.bytes / samples,
+			 fifo_stats.bytes * 100 / samples % 100);
+
 	return EC_SUCCESS;
 }
+DECLARE_CONSOLE_COMMAND(bmi160fifo, command_bmi160_fifo,
+			"[clear]",
+			"Show BMI160 FIFO rates and I2C cost",
+			NULL);
+#endif
 #endif  /* CONFIG_ACCEL_FIFO */
 
 
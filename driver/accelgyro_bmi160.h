@@ -103,6 +103,8 @@
 #define BMI160_FIFO_LENGTH_1   0x23
 #define BMI160_FIFO_LENGTH_MASK    ((1 << 11) - 1)
 #define BMI160_FIFO_DATA       0x24
+/* Size of the hardware FIFO, in bytes */
+#define BMI160_FIFO_SIZE       1024
 enum fifo_header {
 	BMI160_EMPTY = 0x80,
 	BMI160_SKIP = 0x40,
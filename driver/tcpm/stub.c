@@ -114,20 +114,25 @@ void tcpc_alert(int port)
 
 	if (status & TCPC_REG_ALERT_CC_STATUS) {
 		/* CC status changed, wake task */
-		task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_CC, 0);
+		pd_task_set_event(port, PD_EVENT_CC);
 	}
 	if (status & TCPC_REG_ALERT_RX_STATUS) {
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+		/* message received by the TCPC task, pass it on */
+		pd_task_set_event(port, PD_EVENT_RX);
+#else
 		/*
 		 * message received. since TCPC is compiled in, we
 		 * already received PD_EVENT_RX from phy layer in
 		 * pd_rx_event(), so we don't need to set another
 		 * event.
 		 */
+#endif
 	}
 	if (status & TCPC_REG_ALERT_RX_HARD_RST) {
 		/* hard reset received */
 		pd_execute_hard_reset(port);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 	if (status & TCPC_REG_ALERT_TX_COMPLETE) {
 		/* transmit complete */
@@ -406,6 +406,7 @@
  */
 
 #undef CONFIG_CMD_ACCELS
+#undef CONFIG_CMD_ACCEL_FIFO
 #undef CONFIG_CMD_ACCEL_INFO
 #undef CONFIG_CMD_BATDEBUG
 #undef CONFIG_CMD_CHGRAMP
@@ -485,6 +486,18 @@
 /* Provide common core code to handle the operating system timers. */
 #define CONFIG_COMMON_TIMER
 
+/*
+ * Number of software timers available through sw_timer_alloc(), in addition
+ * to the one timer each task has. The total must stay below 32.
+ */
+#undef CONFIG_SW_TIMER_COUNT
+
+/*
+ * Allow timers to expire up to this many microseconds late, so that timers
+ * due close to each other are handled by a single timer interrupt.
+ */
+#undef CONFIG_TIMER_SLACK_US
+
 /*****************************************************************************/
 
 /*
@@ -505,6 +518,18 @@
 /* Max length of a single line of input */
 #define CONFIG_CONSOLE_INPUT_LINE_SIZE 80
 
+/*
+ * Record CPRINTS() messages in a binary log instead of formatting them at the
+ * call site.  Only the format string address, a timestamp and the arguments
+ * are saved; the text is produced later by the HOOKS task, or when the console
+ * is flushed or snapshotted by the host.  Messages printed by cprintf() and
+ * cputs() are not delayed, so they may appear ahead of older CPRINTS() lines.
+ */
+#undef CONFIG_CONSOLE_BINARY_LOG
+
+/* Size of the binary console log in bytes; must be a power of 2 */
+#define CONFIG_CONSOLE_BINARY_LOG_SIZE 1024
+
 /*
  * Disable EC console input if the system is locked.  This is needed for
  * security on platforms where the EC console is accessible from outside the
@@ -815,6 +840,13 @@
  */
 #undef CONFIG_HOST_COMMAND_STATUS
 
+/*
+ * Count the calls, errors and handler run times of each host command, and
+ * report them through EC_CMD_GET_CMD_STATS and the hcstats console command.
+ * Costs 16 bytes of RAM per host command.
+ */
+#undef CONFIG_HOST_COMMAND_STATS
+
 /* If we have host command task, assume we also are using host events. */
 #ifdef HAS_TASK_HOSTCMD
 #define CONFIG_HOSTCMD_EVENTS
@@ -871,6 +903,13 @@
 /* Enable the software routine for CRC computation */
 #undef CONFIG_SW_CRC
 
+/*
+ * Use slice-by-8 lookup tables in the software CRC routine. This costs 7 KB
+ * of extra read-only tables but processes 8 bytes per iteration on word
+ * aligned buffers instead of one.
+ */
+#undef CONFIG_SW_CRC_SLICE8
+
 /*****************************************************************************/
 
 /* Enable system hibernate */
@@ -905,6 +944,18 @@
 #undef CONFIG_I2C_PASSTHROUGH
 #undef CONFIG_I2C_PASSTHRU_RESTRICTED
 
+/*
+ * Queue batches of register accesses to run in the background; see
+ * i2c_submit().
+ */
+#undef CONFIG_I2C_QUEUE
+
+/*
+ * Count transfers, bus time and lock waits per I2C port, shown by the
+ * i2cstats console command.
+ */
+#undef CONFIG_I2C_STATS
+
 /* Defines I2C operation retry count when slave nack'd(EC_ERROR_BUSY) */
 #define CONFIG_I2C_NACK_RETRY_COUNT 0
 /*
@@ -1151,6 +1202,13 @@
 /* Support memory protection unit (MPU) */
 #undef CONFIG_MPU
 
+/*
+ * Keep lock, contention, wait time and hold time statistics for each mutex,
+ * shown by the mutexstats console command.  Costs a timer read per lock and
+ * unlock, and 48 bytes per mutex.
+ */
+#undef CONFIG_MUTEX_STATS
+
 /* Support one-wire interface */
 #undef CONFIG_ONEWIRE
 
@@ -1262,9 +1320,16 @@
 /* Support verifying 2048-bit RSA signature */
 #undef CONFIG_RSA
 
-/* Define the RSA key size. */
+/* Define the RSA key size (2048, 3072, 4096 or 8192). */
 #undef CONFIG_RSA_KEY_SIZE
 
+/*
+ * Use a dedicated Montgomery squaring routine for RSA verification, which
+ * does roughly 25% fewer word multiplies per squaring than the generic
+ * multiply at the cost of a few hundred bytes of code.
+ */
+#undef CONFIG_RSA_OPTIMIZED
+
 /* Flash address of the RO image. */
 #undef CONFIG_RO_IMAGE_FLASHADDR
 
@@ -1295,6 +1360,13 @@
 /* Support computing SHA-256 hash (without the VBOOT code) */
 #undef CONFIG_SHA256
 
+/*
+ * Use the unrolled SHA-256 core, with a 16-word rolling message schedule.
+ * Faster and lighter on stack than the default loop, at the cost of a few
+ * KB of extra code.
+ */
+#undef CONFIG_SHA256_UNROLLED
+
 /* Emulate the CLZ (Count Leading Zeros) in software for CPU lacking support */
 #undef CONFIG_SOFTWARE_CLZ
 
@@ -1388,6 +1460,16 @@
  */
 #define CONFIG_TASK_PROFILING
 
+/*
+ * Record task switches, interrupts and task events in a trace buffer, which
+ * can be saved in Chrome trace event format with the tasktrace console
+ * command.  Emulator only; requires CONFIG_TASK_PROFILING.
+ */
+#undef CONFIG_TASK_TRACE
+
+/* Number of entries in the task trace buffer */
+#define CONFIG_TASK_TRACE_SIZE 4096
+
 /*****************************************************************************/
 /* Temperature sensor config */
 
@@ -1534,9 +1616,26 @@
 /* Simple DFP, such as power adapter, will not send discovery VDM on connect */
 #undef CONFIG_USB_PD_SIMPLE_DFP
 
+/*
+ * Run the PD protocol of all the USB PD ports from one task, named PD in the
+ * task list, instead of one pd_task per port (PD_C0, PD_C1).  With an
+ * external TCPC, this saves a task stack per extra port, but a port waiting
+ * on a transmit delays the others.  With CONFIG_USB_PD_TCPC, each port keeps
+ * a tcpc_task (TCPC_C0, TCPC_C1) so that GoodCRC never waits for another
+ * port, which costs more RAM than per-port PD tasks; that supports at most
+ * two ports.
+ */
+#undef CONFIG_USB_PD_SINGLE_TASK
+
 /* Use comparator module for PD RX interrupt */
 #define CONFIG_USB_PD_RX_COMP_IRQ
 
+/*
+ * Decode received PD messages two 4b/5b symbols at a time, through a 1 KB
+ * lookup table, instead of one symbol at a time.
+ */
+#undef CONFIG_USB_PD_RX_TABLE
+
 /* Use TCPC module (type-C port controller) */
 #undef CONFIG_USB_PD_TCPC
 
@@ -1551,6 +1650,13 @@
 /* Define the type-c port controller I2C base address. */
 #undef CONFIG_TCPC_I2C_BASE_ADDR
 
+/*
+ * Keep per-port histograms of PD message turnaround times, the time spent in
+ * each PD state, and timeout and retry counts.  Read them with
+ * EC_CMD_USB_PD_TIMING or 'pd <port> timing'.
+ */
+#undef CONFIG_USB_PD_TIMING
+
 /* Use this option to enable Try.SRC mode for Dual Role devices */
 #undef CONFIG_USB_PD_TRY_SRC
 
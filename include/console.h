@@ -8,6 +8,7 @@
 #ifndef __CROS_EC_CONSOLE_H
 #define __CROS_EC_CONSOLE_H
 
+#include <stdarg.h>  /* For va_list */
 #include "common.h"
 
 /* Console command; used by DECLARE_CONSOLE_COMMAND macro. */
@@ -104,6 +105,30 @@ int cprints(enum console_channel channel, const char *format, ...);
  */
 void cflush(void);
 
+#ifdef CONFIG_CONSOLE_BINARY_LOG
+/**
+ * Record a timestamped message in the binary console log.
+ *
+ * Only the format string address, the time and the arguments are saved; the
+ * message is formatted later by console_binlog_flush().
+ *
+ * @param channel	Output channel
+ * @param format	Format string; see printf.h for valid formatting codes
+ * @param args		Arguments for the format string
+ *
+ * @return non-zero if the message was dropped because the log was full.
+ */
+int console_binlog_vrecord(enum console_channel channel, const char *format,
+			   va_list args);
+
+/**
+ * Format and print all messages waiting in the binary console log.
+ */
+void console_binlog_flush(void);
+#else
+static inline void console_binlog_flush(void) { }
+#endif
+
 /* Convenience macros for printing to the command channel.
  *
  * Modules may define similar macros in their .c files for their own use; it is
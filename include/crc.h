@@ -20,8 +20,28 @@ void crc32_hash32(uint32_t val);
 
 void crc32_hash16(uint16_t val);
 
+/**
+ * Add a buffer of arbitrary length and alignment to the running CRC.
+ *
+ * @param buf		Data to hash
+ * @param size		Number of bytes in buf
+ */
+void crc32_hash_buf(const void *buf, int size);
+
 uint32_t crc32_result(void);
 
+/*
+ * The same CRC with its state kept by the caller, for users which may run
+ * at the same time as each other.
+ */
+void crc32_ctx_init(uint32_t *ctx);
+
+void crc32_ctx_hash32(uint32_t *ctx, uint32_t val);
+
+void crc32_ctx_hash16(uint32_t *ctx, uint16_t val);
+
+uint32_t crc32_ctx_result(const uint32_t *ctx);
+
 #endif /* CONFIG_HW_CRC */
 
 #endif /* __CROS_EC_CRC_H */
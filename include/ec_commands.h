@@ -945,6 +945,40 @@ struct ec_response_get_features {
 	uint32_t flags[2];
 } __packed;
 
+/*****************************************************************************/
+/* Host command statistics */
+
+/*
+ * Read per-command counters and handler latencies.  Entries are returned in
+ * command number order, starting at params.index; the host reads again from
+ * index + count until it has read all the entries.
+ */
+#define EC_CMD_GET_CMD_STATS 0x0e
+
+/* Clear all the counters after reading */
+#define EC_CMD_STATS_FLAG_RESET (1 << 0)
+
+struct ec_params_get_cmd_stats {
+	uint16_t index;		/* First entry to return */
+	uint16_t flags;		/* EC_CMD_STATS_FLAG_* */
+} __packed;
+
+struct ec_cmd_stats_entry {
+	uint16_t command;	/* Command number */
+	uint16_t reserved;
+	uint32_t count;		/* Times the handler was called */
+	uint32_t errors;	/* Calls which did not return EC_RES_SUCCESS */
+	uint32_t max_us;	/* Longest handler run time */
+	uint32_t avg_us;	/* Average handler run time */
+} __packed;
+
+struct ec_response_get_cmd_stats {
+	uint16_t total;		/* Total number of entries */
+	uint8_t count;		/* Number of entries in this response */
+	uint8_t reserved;
+	struct ec_cmd_stats_entry entries[0];
+} __packed;
+
 /*****************************************************************************/
 /* Flash commands */
 
@@ -3378,6 +3412,69 @@ struct ec_params_pd_write_log_entry {
 	uint8_t port; /* port#, or 0 for events unrelated to a given port */
 } __packed;
 
+/*
+ * Read the protocol timing of a PD port: turnaround histograms, error
+ * counters and the time spent in each PD state.  States are returned in
+ * state number order, starting at params.state; the host reads again from
+ * state + state_count until it has read state_total of them.
+ */
+#define EC_CMD_USB_PD_TIMING 0x119
+
+/* Clear the timing of the port after reading */
+#define EC_USB_PD_TIMING_FLAG_RESET (1 << 0)
+
+/*
+ * Histogram bucket n counts times in [2^(n+3), 2^(n+4)) us.  Bucket 0 also
+ * counts shorter times, and the last bucket longer ones.
+ */
+#define EC_USB_PD_TIMING_BUCKETS 16
+
+struct ec_params_usb_pd_timing {
+	uint8_t port;
+	uint8_t flags;		/* EC_USB_PD_TIMING_FLAG_* */
+	uint8_t state;		/* First state to return */
+	uint8_t reserved;
+} __packed;
+
+struct ec_usb_pd_timing_state {
+	uint16_t entries;	/* Times the state was entered */
+	uint16_t max_ms;	/* Longest stay in the state */
+	uint32_t total_ms;	/* Total time in the state */
+} __packed;
+
+struct ec_response_usb_pd_timing {
+	/* Message received to GoodCRC sent */
+	uint16_t rx_goodcrc[EC_USB_PD_TIMING_BUCKETS];
+	/* Message which needs a reply received to the reply sent */
+	uint16_t rx_reply[EC_USB_PD_TIMING_BUCKETS];
+	uint32_t rx_goodcrc_max_us;
+	uint32_t rx_reply_max_us;
+	uint16_t state_timeouts;	/* States left on their timeout */
+	uint16_t vdm_timeouts;		/* VDMs which got no response */
+	uint16_t tx_retries;		/* Messages resent for lack of GoodCRC */
+	uint16_t tx_errors;		/* Messages never acknowledged */
+	uint8_t state_total;		/* Number of PD states */
+	uint8_t state_count;		/* Number of entries in states[] */
+	uint16_t reserved;
+	struct ec_usb_pd_timing_state states[0];
+} __packed;
+
+/*
+ * Read (and delete) as many entries of the PD event log as fit in the
+ * response.  The entries are struct ec_response_pd_log, as returned by
+ * EC_CMD_PD_GET_LOG_ENTRY, packed back to back: each one is directly
+ * followed by its payload.  A response without entries means the log is
+ * empty.
+ */
+#define EC_CMD_PD_GET_LOG_ENTRIES 0x11a
+
+struct ec_response_pd_log_entries {
+	uint16_t dropped;   /* entries lost to a full log since last read */
+	uint8_t count;      /* number of entries */
+	uint8_t reserved;
+	uint8_t entries[0]; /* packed struct ec_response_pd_log */
+} __packed;
+
 #endif  /* !__ACPI__ */
 
 
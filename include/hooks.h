@@ -167,6 +167,11 @@ struct hook_data {
 	int priority;
 };
 
+struct deferred_data {
+	/* Deferred function pointer */
+	void (*routine)(void);
+};
+
 /**
  * Call all the hook routines of a specified type.
  *
@@ -187,8 +192,8 @@ void hook_notify(enum hook_type type);
  * The routine will be called after at least the specified delay, in the
  * context of the hook task.
  *
- * @param routine	Routine to call; must have been declared with
- *			DECLARE_DEFERRED().
+ * @param data		Deferred routine data, as declared by
+ *			DECLARE_DEFERRED(routine); pass &routine_data.
  * @param us		Delay in microseconds until routine will be called.
  *			If the routine is already pending, subsequent calls
  *			will change the delay.  Pass us=0 to call as soon as
@@ -196,7 +201,7 @@ void hook_notify(enum hook_type type);
  *
  * @return non-zero if error.
  */
-int hook_call_deferred(void (*routine)(void), int us);
+int hook_call_deferred(const struct deferred_data *data, int us);
 
 #ifdef CONFIG_COMMON_RUNTIME
 /**
@@ -230,12 +235,6 @@ int hook_call_deferred(void (*routine)(void), int us);
 	__attribute__((section(".rodata." STRINGIFY(hooktype))))	\
 	     = {routine, priority}
 
-
-struct deferred_data {
-	/* Deferred function pointer */
-	void (*routine)(void);
-};
-
 /**
  * Register a deferred function call.
  *
@@ -248,10 +247,16 @@ struct deferred_data {
  * functions are called from the same hook task.  See DECLARE_HOOK() for an
  * example.
  *
+ * This defines routine_data, which is the handle passed to
+ * hook_call_deferred().  Its position in the deferred function table is fixed
+ * at link time, so scheduling a call does not need to search for the routine.
+ * If the routine needs to schedule itself, forward-declare it and place
+ * DECLARE_DEFERRED() ahead of its definition.
+ *
  * @param routine	Function pointer, with prototype void routine(void)
  */
 #define DECLARE_DEFERRED(routine)					\
-	const struct deferred_data CONCAT2(__deferred_, routine)	\
+	const struct deferred_data CONCAT2(routine, _data)		\
 	__attribute__((section(".rodata.deferred")))			\
 	     = {routine}
 
@@ -259,7 +264,7 @@ struct deferred_data {
 #define DECLARE_HOOK(t, func, p)				\
 	void CONCAT2(unused_hook_, func)(void) { func(); }
 #define DECLARE_DEFERRED(func)					\
-	void CONCAT2(unused_deferred_, func)(void) { func(); }
+	const struct deferred_data CONCAT2(func, _data) = {func}
 #endif /* CONFIG_COMMON_RUNTIME */
 
 #endif  /* __CROS_EC_HOOKS_H */
@@ -112,6 +112,14 @@ struct host_command {
 	int version_mask;
 };
 
+/* Counters for one host command; see CONFIG_HOST_COMMAND_STATS */
+struct host_command_stats {
+	uint32_t count;		/* Times the handler was called */
+	uint32_t errors;	/* Calls which did not return EC_RES_SUCCESS */
+	uint32_t max_us;	/* Longest handler run time */
+	uint32_t total_us;	/* Sum of handler run times */
+};
+
 /**
  * Return a pointer to the memory-mapped buffer.
  *
@@ -197,6 +197,73 @@ int i2c_read8(int port, int slave_addr, int offset, int *data);
  */
 int i2c_write8(int port, int slave_addr, int offset, int data);
 
+/* Types of register access for struct i2c_op; the low bits are the size */
+#define I2C_OP_READ8    1
+#define I2C_OP_READ16   2
+#define I2C_OP_READ32   4
+#define I2C_OP_WRITE    0x80
+#define I2C_OP_WRITE8   (I2C_OP_WRITE | I2C_OP_READ8)
+#define I2C_OP_WRITE16  (I2C_OP_WRITE | I2C_OP_READ16)
+#define I2C_OP_WRITE32  (I2C_OP_WRITE | I2C_OP_READ32)
+
+/* One register access in a batch */
+struct i2c_op {
+	uint8_t type;           /* I2C_OP_* */
+	uint8_t offset;         /* Register offset in the slave's space */
+	int data;               /* Value to write, or value read */
+};
+
+/**
+ * Access several registers of a slave, in order.
+ *
+ * Like i2c_read8() etc., but for a list of registers, so it can run
+ * back-to-back without giving up the port in between.  Must be called between
+ * i2c_lock(port, 1) and i2c_lock(port, 0).
+ *
+ * @param port		Port to access
+ * @param slave_addr	Slave device address, with I2C_FLAG_* flags
+ * @param ops		Register accesses; reads store their result in data
+ * @param count		Number of entries in ops
+ * @return EC_SUCCESS, or the error of the first access which failed; the
+ * accesses after it are not done.
+ */
+int i2c_xfer_ops(int port, int slave_addr, struct i2c_op *ops, int count);
+
+/**
+ * Lock a port, access several registers of a slave, and unlock the port.
+ *
+ * See i2c_xfer_ops().
+ */
+int i2c_batch(int port, int slave_addr, struct i2c_op *ops, int count);
+
+/* Request for i2c_submit() */
+struct i2c_request {
+	struct i2c_request *next;  /* Private to the I2C queue */
+	int port;               /* Port to access */
+	int slave_addr;         /* Slave device address, with I2C_FLAG_* */
+	struct i2c_op *ops;     /* Register accesses to do */
+	int count;              /* Number of entries in ops */
+	int rv;                 /* EC_ERROR_BUSY until done, then result */
+	/* Called in the hook task when done, or NULL */
+	void (*done)(struct i2c_request *req);
+};
+
+/**
+ * Queue a batch of register accesses to be done in the background.
+ *
+ * Requests run in the hook task, in the order they were submitted for each
+ * port.  All requests pending for a port when it is serviced share a single
+ * lock of the port.  The request and its ops must not be changed until it is
+ * done; then req->rv is set and req->done() is called, after the port has
+ * been unlocked so done() may use it or submit the request again.
+ *
+ * May be called from interrupt context.  Requires CONFIG_I2C_QUEUE.
+ *
+ * @param req		Request to queue
+ * @return EC_SUCCESS, or EC_ERROR_INVAL if the port is not valid.
+ */
+int i2c_submit(struct i2c_request *req);
+
 /**
  * @return non-zero if i2c bus is busy
  */
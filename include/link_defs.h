@@ -53,6 +53,10 @@ extern const struct hook_data __hooks_tick_end[];
 extern const struct hook_data __hooks_second[];
 extern const struct hook_data __hooks_second_end[];
 
+/* Hook dispatch order and run time histograms; RAM reserved by the linker */
+extern uint16_t __hook_order[];
+extern uint8_t __hook_hist[];
+
 /* Deferrable functions */
 extern const struct deferred_data __deferred_funcs[];
 extern const struct deferred_data __deferred_funcs_end[];
@@ -77,6 +81,10 @@ extern const struct test_i2c_read_string_dev __test_i2c_read_string_end[];
 extern const struct host_command __hcmds[];
 extern const struct host_command __hcmds_end[];
 
+/* Host command dispatch order and counters; RAM reserved by the linker */
+extern uint8_t __hcmd_order[];
+extern struct host_command_stats __hcmd_stats[];
+
 /* MKBP events */
 extern const struct mkbp_event_source __mkbp_evt_srcs[];
 extern const struct mkbp_event_source __mkbp_evt_srcs_end[];
@@ -112,6 +112,55 @@ fp_t cosine_of_angle_diff(const vector_3_t v1, const vector_3_t v2);
  */
 void rotate(const vector_3_t v, const matrix_3x3_t R, vector_3_t res);
 
+/**
+ * Rotate an array of vectors by the same rotation matrix.
+ *
+ * @param v Vectors to be rotated.
+ * @param R Rotation matrix.
+ * @param res Resultant vectors; may be the same array as v.
+ * @param n Number of vectors.
+ */
+void rotate_n(const vector_3_t *v, const matrix_3x3_t R, vector_3_t *res,
+	      int n);
+
+/* Number of fractional bits of the components of a unit vector */
+#define UNIT_VECTOR_BITS 15
+
+/**
+ * Scale an array of vectors to unit length.
+ *
+ * The components of the results have UNIT_VECTOR_BITS fractional bits.  A
+ * zero vector stays zero.  Components must be below 2^30.
+ *
+ * @param v Vectors to scale.
+ * @param res Unit vectors; may be the same array as v.
+ * @param n Number of vectors.
+ */
+void unit_vectors(const vector_3_t *v, vector_3_t *res, int n);
+
+/**
+ * Find the cosine of the angle between two unit vectors.
+ *
+ * Much cheaper than cosine_of_angle_diff() when a vector is compared with
+ * several others, since each is only scaled once by unit_vectors().
+ *
+ * @param u1 Unit vector, from unit_vectors() or rotate() of one.
+ * @param u2 Unit vector, from unit_vectors() or rotate() of one.
+ *
+ * @return Cosine of the angle between u1 and u2.
+ */
+fp_t cosine_of_unit_vectors(const vector_3_t u1, const vector_3_t u2);
 
+/**
+ * Integer square root, rounded down.
+ *
+ * @return sqrt(x), 0 if x is negative, capped at 0x7fffffff.
+ */
+int int_sqrtf(int64_t x);
+
+/**
+ * Magnitude of a vector, rounded down.
+ */
+int vector_magnitude(const vector_3_t v);
 
 #endif /* __CROS_EC_MATH_UTIL_H */
@@ -49,8 +49,13 @@
  * Special format codes:
  *   - "%T" - current time in seconds - interpreted as "%.6T" for precision.
  *           This does NOT use up any arguments.
+ *
+ * A width or precision over MAX_FORMAT, or a bad format code, prints "ERROR"
+ * in place of the rest of the format.
  */
 
+#define MAX_FORMAT 1024  /* Maximum chars in a single format field */
+
 /**
  * Print formatted output to a function, like vfprintf()
  *
@@ -61,6 +61,16 @@ struct queue_state {
 	 *
 	 * Full:
 	 *     head - tail == buffer_units
+	 *
+	 * Only the consumer writes head and only the producer writes tail, so
+	 * a queue with one producer and one consumer (for example an interrupt
+	 * handler and a task) needs no locking.  The producer writes the
+	 * buffer before it publishes the new tail, and the consumer reads the
+	 * buffer before it publishes the new head; each side also reads the
+	 * other's index before touching the buffer.  Since the EC is single
+	 * core, compiler barriers are enough to keep those accesses in order.
+	 * Several producers or several consumers must still serialize among
+	 * themselves.
 	 */
 	size_t head; /* head: next to dequeue */
 	size_t tail; /* tail: next to enqueue */
@@ -133,6 +143,46 @@ size_t queue_remove_memcpy(struct queue const *q,
 					   const void *src,
 					   size_t n));
 
+/*
+ * Contiguous region of a queue's buffer, as returned by the span functions
+ * below.  length is in units, and buffer is NULL if length is zero.
+ */
+struct queue_chunk {
+	size_t length;
+	void *buffer;
+};
+
+/*
+ * Return the largest contiguous free region at the tail of the queue, so the
+ * producer can fill it in place (for example by DMA) instead of copying in
+ * from a separate buffer.  It may be shorter than queue_space() when the free
+ * space wraps around the end of the buffer.  Nothing is added until
+ * queue_commit_write() is called.
+ */
+struct queue_chunk queue_begin_write(struct queue const *q);
+
+/*
+ * Add count units, previously written in place at the start of the region
+ * returned by queue_begin_write(), to the queue.  Returns the number of units
+ * added, which is clamped to the free space.
+ */
+size_t queue_commit_write(struct queue const *q, size_t count);
+
+/*
+ * Return the largest contiguous region of stored units at the head of the
+ * queue, so the consumer can use them in place.  It may be shorter than
+ * queue_count() when the stored units wrap around the end of the buffer.
+ * Nothing is removed until queue_commit_read() is called.
+ */
+struct queue_chunk queue_begin_read(struct queue const *q);
+
+/*
+ * Remove count units, previously used in place from the region returned by
+ * queue_begin_read(), from the queue.  Returns the number of units removed,
+ * which is clamped to the number stored.
+ */
+size_t queue_commit_read(struct queue const *q, size_t count);
+
 /* Peek (return but don't remove) the count elements starting with the i'th. */
 size_t queue_peek_units(struct queue const *q,
 			void *dest,
@@ -214,9 +214,27 @@ void task_trigger_irq(int irq);
  */
 void task_clear_pending_irq(int irq);
 
+#ifdef CONFIG_MUTEX_STATS
+struct mutex_stats {
+	struct mutex *next;     /* Next mutex which has been locked */
+	uint32_t locks;         /* Number of times locked */
+	uint32_t contentions;   /* Number of locks which had to wait */
+	uint32_t timeouts;      /* Number of mutex_lock_timeout() failures */
+	uint32_t wait_max;      /* Longest wait for the lock, in us */
+	uint32_t hold_max;      /* Longest time held, in us */
+	uint64_t wait_total;    /* Total time spent waiting, in us */
+	uint64_t hold_total;    /* Total time held, in us */
+	uint64_t locked_at;     /* Time the current owner got the lock */
+};
+#endif
+
 struct mutex {
 	uint32_t lock;
 	uint32_t waiters;
+	task_id_t owner;        /* Task holding the lock, if locked */
+#ifdef CONFIG_MUTEX_STATS
+	struct mutex_stats stats;
+#endif
 };
 
 /**
@@ -224,16 +242,64 @@ struct mutex {
  *
  * This tries to lock the mutex mtx.  If the mutex is already locked by another
  * task, de-schedules the current task until the mutex is again unlocked.
+ * Events other than TASK_EVENT_MUTEX received while waiting are kept for the
+ * next task_wait_event().
+ *
+ * On cores which support it, a task waiting for the mutex lends its priority
+ * to the task holding it, so that a lower priority owner is not held off by
+ * tasks of intermediate priority.
  *
  * Must not be used in interrupt context!
  */
 void mutex_lock(struct mutex *mtx);
 
+/**
+ * Lock a mutex, giving up after a timeout.
+ *
+ * Like mutex_lock(), but waits at most timeout_us.
+ *
+ * @param mtx		Mutex to lock
+ * @param timeout_us	Time to wait; 0 to only try once, negative to wait
+ *			forever
+ *
+ * @return EC_SUCCESS if locked, EC_ERROR_TIMEOUT if not.
+ */
+int mutex_lock_timeout(struct mutex *mtx, int timeout_us);
+
 /**
  * Release a mutex previously locked by the same task.
  */
 void mutex_unlock(struct mutex *mtx);
 
+#ifdef CONFIG_MUTEX_STATS
+/**
+ * Record that the current task has locked a mutex.
+ *
+ * Called by the core's mutex code.
+ *
+ * @param mtx		Mutex which was locked
+ * @param wait_start	Time the task started waiting for it
+ * @param contended	Non-zero if the task had to wait
+ */
+void mutex_stats_locked(struct mutex *mtx, uint64_t wait_start,
+			int contended);
+
+/**
+ * Record that a mutex is about to be unlocked.
+ */
+void mutex_stats_unlocked(struct mutex *mtx);
+
+/**
+ * Record that mutex_lock_timeout() gave up on a mutex.
+ */
+void mutex_stats_timeout(struct mutex *mtx);
+#else
+static inline void mutex_stats_locked(struct mutex *mtx, uint64_t wait_start,
+				      int contended) { }
+static inline void mutex_stats_unlocked(struct mutex *mtx) { }
+static inline void mutex_stats_timeout(struct mutex *mtx) { }
+#endif
+
 struct irq_priority {
 	uint8_t irq;
 	uint8_t priority;
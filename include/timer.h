@@ -48,6 +48,37 @@ int timer_arm(timestamp_t tstamp, task_id_t tskid);
  */
 void timer_cancel(task_id_t tskid);
 
+/**
+ * Allocate a software timer.
+ *
+ * Software timers are independent from the per-task timer used by usleep()
+ * and task_wait_event(), so a task can have several of them running at once.
+ * There are CONFIG_SW_TIMER_COUNT of them, and they cannot be freed.
+ *
+ * Must be called from task context.
+ *
+ * @param tskid		Task to notify when the timer expires
+ * @param event		Event bit(s) to set on the task when the timer expires
+ *
+ * @return the timer id, or -1 if there are no more software timers.
+ */
+int sw_timer_alloc(task_id_t tskid, uint32_t event);
+
+/**
+ * Launch a one-shot software timer, or move its deadline if it is running.
+ *
+ * @param timer		Timer id from sw_timer_alloc()
+ * @param tstamp	Expiration timestamp for timer
+ */
+void sw_timer_arm(int timer, timestamp_t tstamp);
+
+/**
+ * Cancel a running software timer.
+ *
+ * @param timer		Timer id from sw_timer_alloc()
+ */
+void sw_timer_cancel(int timer);
+
 /**
  * Check if a timestamp has passed / expired
  *
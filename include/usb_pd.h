@@ -18,7 +18,22 @@
  * Define PD_PORT_TO_TASK_ID() and TASK_ID_TO_PD_PORT() macros to
  * go between PD port number and task ID.
  */
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+/* The PD task services every port */
+#define PD_PORT_TO_TASK_ID(port) TASK_ID_PD
+#ifdef CONFIG_USB_PD_TCPC
+/* An internal TCPC keeps a task per port, GoodCRC cannot wait on the others */
 #if CONFIG_USB_PD_PORT_COUNT == 1
+#define TCPC_PORT_TO_TASK_ID(port) TASK_ID_TCPC_C0
+#define TASK_ID_TO_TCPC_PORT(id)   0
+#elif CONFIG_USB_PD_PORT_COUNT == 2
+#define TCPC_PORT_TO_TASK_ID(port) ((port) ? TASK_ID_TCPC_C1 : TASK_ID_TCPC_C0)
+#define TASK_ID_TO_TCPC_PORT(id)   ((id) == TASK_ID_TCPC_C0 ? 0 : 1)
+#else
+#error "CONFIG_USB_PD_SINGLE_TASK with CONFIG_USB_PD_TCPC supports 2 ports"
+#endif
+#endif
+#elif CONFIG_USB_PD_PORT_COUNT == 1
 #ifdef HAS_TASK_PD
 #define PD_PORT_TO_TASK_ID(port) TASK_ID_PD
 #elif defined(HAS_TASK_PD_C0)
@@ -31,6 +46,28 @@
 #define PD_PORT_TO_TASK_ID(port) ((port) ? TASK_ID_PD_C1 : TASK_ID_PD_C0)
 #define TASK_ID_TO_PD_PORT(id)   ((id) == TASK_ID_PD_C0 ? 0 : 1)
 #endif
+
+#ifndef TCPC_PORT_TO_TASK_ID
+/* The TCPC of a port runs in its PD task */
+#define TCPC_PORT_TO_TASK_ID(port) PD_PORT_TO_TASK_ID(port)
+#define TASK_ID_TO_TCPC_PORT(id)   TASK_ID_TO_PD_PORT(id)
+#endif
+
+/**
+ * Post an event to the state machine of a PD port.
+ *
+ * Use this rather than task_set_event() on PD_PORT_TO_TASK_ID(port), so
+ * that with CONFIG_USB_PD_SINGLE_TASK the PD task knows which port to run.
+ *
+ * @param port		USB-C port number
+ * @param event		Event bits to post (PD_EVENT_*, TASK_EVENT_WAKE)
+ */
+#ifdef CONFIG_USB_PD_SINGLE_TASK
+void pd_task_set_event(int port, uint32_t event);
+#else
+#define pd_task_set_event(port, event) \
+	task_set_event(PD_PORT_TO_TASK_ID(port), (event), 0)
+#endif
 #endif /* CONFIG_USB_PD_PORT_COUNT */
 
 enum pd_rx_errors {
@@ -1234,6 +1271,8 @@ void pd_send_hpd(int port, enum hpd_event hpd);
  * Enable USB Billboard Device.
  */
 void pd_usb_billboard_deferred(void);
+extern const struct deferred_data pd_usb_billboard_deferred_data;
+
 /* --- Physical layer functions : chip specific --- */
 
 /* Packet preparation/retrieval */
@@ -1518,6 +1557,36 @@ void pd_prepare_sysjump(void);
  */
 void pd_set_new_power_request(int port);
 
+/* ----- Timing ----- */
+#ifdef CONFIG_USB_PD_TIMING
+/**
+ * Note that a message started arriving on a port.
+ *
+ * Called by the TCPC from the RX interrupt, or before a blocking read.
+ *
+ * @param port USB-C port number
+ */
+void pd_timing_rx(int port);
+
+/**
+ * Note that the TCPC sent the GoodCRC for the message it received.
+ *
+ * @param port USB-C port number
+ */
+void pd_timing_goodcrc(int port);
+
+/**
+ * Note that the TCPC sends a message again for lack of a GoodCRC.
+ *
+ * @param port USB-C port number
+ */
+void pd_timing_tx_retry(int port);
+#else  /* CONFIG_USB_PD_TIMING */
+static inline void pd_timing_rx(int port) {}
+static inline void pd_timing_goodcrc(int port) {}
+static inline void pd_timing_tx_retry(int port) {}
+#endif /* CONFIG_USB_PD_TIMING */
+
 /* ----- Logging ----- */
 #ifdef CONFIG_USB_PD_LOGGING
 /**
@@ -0,0 +1,253 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test BMI160 FIFO frame decoding.
+ */
+
+#include "accelgyro.h"
+#include "common.h"
+#include "driver/accelgyro_bmi160.h"
+#include "hwtimer.h"
+#include "i2c.h"
+#include "motion_sense.h"
+#include "test_util.h"
+#include "util.h"
+
+/* Frame headers */
+#define HDR_ACC  (BMI160_EMPTY | (1 << BMI160_FH_PARM_OFFSET))
+#define HDR_GYR  (BMI160_EMPTY | (2 << BMI160_FH_PARM_OFFSET))
+#define HDR_MAG  (BMI160_EMPTY | (4 << BMI160_FH_PARM_OFFSET))
+
+int bmi160_decode_fifo(struct motion_sensor_t *s, uint8_t *bp, int len,
+		       uint32_t t0, uint32_t period);
+
+struct motion_sensor_t motion_sensors[] = {
+	{
+		.name = "Accel",
+		.type = MOTIONSENSE_TYPE_ACCEL,
+		.drv_data = &g_bmi160_data,
+	},
+	{
+		.name = "Gyro",
+		.type = MOTIONSENSE_TYPE_GYRO,
+		.drv_data = &g_bmi160_data,
+	},
+	{
+		.name = "Mag",
+		.type = MOTIONSENSE_TYPE_MAG,
+		.drv_data = &g_bmi160_data,
+	},
+};
+const unsigned int motion_sensor_count = ARRAY_SIZE(motion_sensors);
+
+/* Units added to the motion sense FIFO */
+static struct {
+	int sensor;
+	struct ec_response_motion_sensor_data data;
+} units[32];
+static int unit_count;
+
+/* Mock functions */
+
+/* The FIFO burst reads are not exercised here */
+int i2c_xfer(int port, int slave_addr, const uint8_t *out, int out_size,
+	     uint8_t *in, int in_size, int flags)
+{
+	return EC_ERROR_UNIMPLEMENTED;
+}
+
+uint32_t __hw_clock_source_read(void)
+{
+	return 0;
+}
+
+void motion_sense_fifo_add_unit(struct ec_response_motion_sensor_data *data,
+				const struct motion_sensor_t *sensor)
+{
+	if (unit_count == ARRAY_SIZE(units))
+		return;
+	units[unit_count].sensor = sensor - motion_sensors;
+	units[unit_count].data = *data;
+	unit_count++;
+}
+
+/* Test utilities */
+
+/* Check a timestamp unit */
+static int is_time(int n, uint32_t t)
+{
+	return units[n].data.flags == MOTIONSENSE_SENSOR_FLAG_TIMESTAMP &&
+	       units[n].data.timestamp == t;
+}
+
+/* Check a data unit, whose axes are x, x + 1 and x + 2 once normalized */
+static int is_data(int n, int sensor, int x)
+{
+	return units[n].sensor == sensor && units[n].data.flags == 0 &&
+	       units[n].data.data[X] == x &&
+	       units[n].data.data[Y] == x + 1 &&
+	       units[n].data.data[Z] == x + 2;
+}
+
+/* Append 3 little-endian axes x, x + 1 and x + 2 */
+static uint8_t *put_axes(uint8_t *bp, int x)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		*bp++ = (x + i) & 0xff;
+		*bp++ = (x + i) >> 8;
+	}
+	return bp;
+}
+
+static void reset(void)
+{
+	unit_count = 0;
+	memset(units, 0, sizeof(units));
+}
+
+/* Tests */
+
+static int test_data_frames(void)
+{
+	uint8_t fifo[64], *bp = fifo;
+
+	reset();
+	/* Accel and gyro, then accel alone */
+	*bp++ = HDR_ACC | HDR_GYR;
+	bp = put_axes(bp, 100);
+	bp = put_axes(bp, 200);
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 300);
+
+	TEST_ASSERT(bmi160_decode_fifo(NULL, fifo, bp - fifo, 0, 0) == 2);
+	TEST_ASSERT(unit_count == 0);
+
+	TEST_ASSERT(bmi160_decode_fifo(motion_sensors, fifo, bp - fifo,
+				       1000, 50) == 2);
+	TEST_ASSERT(unit_count == 5);
+	/* Each frame is timestamped, and the gyro data comes first */
+	TEST_ASSERT(is_time(0, 1000));
+	TEST_ASSERT(is_data(1, MOTIONSENSE_TYPE_GYRO, 100));
+	TEST_ASSERT(is_data(2, MOTIONSENSE_TYPE_ACCEL, 200));
+	TEST_ASSERT(is_time(3, 1050));
+	TEST_ASSERT(is_data(4, MOTIONSENSE_TYPE_ACCEL, 300));
+
+	return EC_SUCCESS;
+}
+
+static int test_mag_frame(void)
+{
+	uint8_t fifo[64], *bp = fifo;
+
+	reset();
+	*bp++ = HDR_ACC | HDR_MAG;
+	/* Magnetometer data is 8 bytes, hall resistance last */
+	bp = put_axes(bp, 10);
+	*bp++ = 0;
+	*bp++ = 0;
+	bp = put_axes(bp, 20);
+
+	TEST_ASSERT(bmi160_decode_fifo(motion_sensors, fifo, bp - fifo,
+				       0, 0) == 1);
+	TEST_ASSERT(unit_count == 3);
+	TEST_ASSERT(is_data(1, MOTIONSENSE_TYPE_MAG, 10));
+	TEST_ASSERT(is_data(2, MOTIONSENSE_TYPE_ACCEL, 20));
+
+	return EC_SUCCESS;
+}
+
+static int test_control_frames(void)
+{
+	uint8_t fifo[64], *bp = fifo;
+
+	reset();
+	/* Skip and config frames carry no data and take no timestamp */
+	*bp++ = BMI160_SKIP;
+	*bp++ = 3;
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 1);
+	*bp++ = BMI160_CONFIG;
+	*bp++ = 0x01;
+	/* Sensor time frame, not requested but skipped */
+	*bp++ = BMI160_TIME;
+	*bp++ = 0x11;
+	*bp++ = 0x22;
+	*bp++ = 0x33;
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 2);
+
+	TEST_ASSERT(bmi160_decode_fifo(motion_sensors, fifo, bp - fifo,
+				       500, 10) == 2);
+	TEST_ASSERT(unit_count == 4);
+	TEST_ASSERT(is_time(0, 500));
+	TEST_ASSERT(is_data(1, MOTIONSENSE_TYPE_ACCEL, 1));
+	TEST_ASSERT(is_time(2, 510));
+	TEST_ASSERT(is_data(3, MOTIONSENSE_TYPE_ACCEL, 2));
+
+	return EC_SUCCESS;
+}
+
+static int test_partial_frames(void)
+{
+	uint8_t fifo[64], *bp = fifo;
+
+	reset();
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 7);
+	/* A frame cut short by the end of the read is left for next time */
+	*bp++ = HDR_ACC | HDR_GYR;
+	bp = put_axes(bp, 8);
+
+	TEST_ASSERT(bmi160_decode_fifo(NULL, fifo, bp - fifo, 0, 0) == 1);
+	TEST_ASSERT(bmi160_decode_fifo(motion_sensors, fifo, bp - fifo,
+				       0, 0) == 1);
+	TEST_ASSERT(unit_count == 2);
+	TEST_ASSERT(is_data(1, MOTIONSENSE_TYPE_ACCEL, 7));
+
+	/* So is a control frame missing its parameter */
+	fifo[0] = BMI160_SKIP;
+	TEST_ASSERT(bmi160_decode_fifo(NULL, fifo, 1, 0, 0) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_empty_frame(void)
+{
+	uint8_t fifo[64], *bp = fifo;
+
+	reset();
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 5);
+	/* Reading past the FIFO content returns empty frames */
+	*bp++ = BMI160_EMPTY;
+	*bp++ = HDR_ACC;
+	bp = put_axes(bp, 6);
+
+	TEST_ASSERT(bmi160_decode_fifo(motion_sensors, fifo, bp - fifo,
+				       0, 0) == 1);
+	TEST_ASSERT(unit_count == 2);
+	TEST_ASSERT(is_data(1, MOTIONSENSE_TYPE_ACCEL, 5));
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	/* Full scale ranges that leave the raw values unchanged */
+	g_bmi160_data.saved_data[MOTIONSENSE_TYPE_ACCEL].range = 32;
+	g_bmi160_data.saved_data[MOTIONSENSE_TYPE_GYRO].range = 256;
+	g_bmi160_data.saved_data[MOTIONSENSE_TYPE_MAG].range = 1;
+
+	RUN_TEST(test_data_frames);
+	RUN_TEST(test_mag_frame);
+	RUN_TEST(test_control_frames);
+	RUN_TEST(test_partial_frames);
+	RUN_TEST(test_empty_frame);
+
+	test_print_result();
+}
@@ -40,42 +40,81 @@ test-list-host+=sbs_charging host_command
 test-list-host+=bklight_lid bklight_passthru interrupt timer_dos button
 test-list-host+=motion_lid math_util sbs_charging_v2 battery_get_params_smart
 test-list-host+=lightbar inductive_charging usb_pd fan charge_manager
-test-list-host+=charge_ramp
+test-list-host+=charge_ramp crc32 sha256 sha256_unrolled
+test-list-host+=rsa rsa_optimized rsa3072 rsa3072_unoptimized
+test-list-host+=uart_tx console_binlog task_trace i2c_batch
+test-list-host+=usb_pd_rx usb_pd_loopback usb_pd_loopback_single_task
+test-list-host+=usb_pd_single_task pd_log
+test-list-host+=bmi160_fifo timer_heap
 
 battery_get_params_smart-y=battery_get_params_smart.o
+bmi160_fifo-y=bmi160_fifo.o
 bklight_lid-y=bklight_lid.o
 bklight_passthru-y=bklight_passthru.o
 button-y=button.o
 charge_manager-y=charge_manager.o
 charge_ramp-y+=charge_ramp.o
+console_binlog-y=console_binlog.o
+console_binlog-real-time=y
 console_edit-y=console_edit.o
+crc32-y=crc32.o
+crc32-real-time=y
 extpwr_gpio-y=extpwr_gpio.o
 flash-y=flash.o
 hooks-y=hooks.o
 host_command-y=host_command.o
+i2c_batch-y=i2c_batch.o
 inductive_charging-y=inductive_charging.o
 interrupt-y=interrupt.o
+interrupt-real-time=y
 interrupt-scale=10
 kb_8042-y=kb_8042.o
 kb_mkbp-y=kb_mkbp.o
 kb_scan-y=kb_scan.o
 lid_sw-y=lid_sw.o
 math_util-y=math_util.o
+math_util-real-time=y
 motion_lid-y=motion_lid.o
 mutex-y=mutex.o
+pd_log-y=pd_log.o
 pingpong-y=pingpong.o
 power_button-y=power_button.o
 powerdemo-y=powerdemo.o
 queue-y=queue.o
+queue-real-time=y
+rsa-y=rsa.o
+rsa-real-time=y
+rsa3072-y=rsa.o
+rsa3072-real-time=y
+rsa3072_unoptimized-y=rsa.o
+rsa3072_unoptimized-real-time=y
+rsa_optimized-y=rsa.o
+rsa_optimized-real-time=y
 sbs_charging-y=sbs_charging.o
 sbs_charging_v2-y=sbs_charging_v2.o
+sha256-y=sha256.o
+sha256-real-time=y
+sha256_unrolled-y=sha256.o
+sha256_unrolled-real-time=y
 stress-y=stress.o
 system-y=system.o
+task_trace-y=task_trace.o
 thermal-y=thermal.o
 timer_calib-y=timer_calib.o
 timer_dos-y=timer_dos.o
+timer_heap-y=timer_heap.o
+uart_tx-y=uart_tx.o
+uart_tx-real-time=y
 usb_pd-y=usb_pd.o
+usb_pd_loopback-y=usb_pd_loopback.o
+usb_pd_loopback-real-time=y
+usb_pd_loopback_single_task-y=usb_pd_loopback.o
+usb_pd_loopback_single_task-real-time=y
+usb_pd_rx-y=usb_pd_rx.o
+usb_pd_rx-real-time=y
+usb_pd_single_task-y=usb_pd.o
 utils-y=utils.o
+utils-real-time=y
 battery_get_params_smart-y=battery_get_params_smart.o
 lightbar-y=lightbar.o
 fan-y=fan.o
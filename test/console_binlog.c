@@ -0,0 +1,261 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the binary console log.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "printf.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+/* Messages per benchmark, and between flushes of the log */
+#define BENCH_LINES 2000
+#define BENCH_BURST 4
+
+static char expect[256];
+
+static void start_capture(void)
+{
+	cflush();
+	test_capture_console(1);
+}
+
+static const char *captured(void)
+{
+	cflush();
+	test_capture_console(0);
+	return test_get_captured_console();
+}
+
+/* Parse the "[sec.usec " prefix of a line; return the text after it */
+static const char *parse_time(const char *line, uint64_t *t)
+{
+	*t = 0;
+	if (*line++ != '[')
+		return NULL;
+	for (; *line != ' '; line++) {
+		if (*line == '.')
+			continue;
+		if (*line < '0' || *line > '9')
+			return NULL;
+		*t = *t * 10 + *line - '0';
+	}
+	return line + 1;
+}
+
+/* Return non-zero if str contains sub */
+static int contains(const char *str, const char *sub)
+{
+	int len = strlen(sub);
+
+	for (; *str; str++)
+		if (!memcmp(str, sub, len))
+			return 1;
+	return 0;
+}
+
+/* Check that the captured line is "[<time> " + expect + "]\n" */
+static int check_line(const char *out)
+{
+	uint64_t t;
+	int len = strlen(expect);
+
+	out = parse_time(out, &t);
+	TEST_ASSERT(out);
+	TEST_ASSERT(strlen(out) == len + 3);
+	TEST_ASSERT(memcmp(out, expect, len) == 0);
+	TEST_ASSERT(memcmp(out + len, "]\r\n", 3) == 0);
+
+	return EC_SUCCESS;
+}
+
+#define CHECK_FORMAT(format, args...) \
+	do { \
+		snprintf(expect, sizeof(expect), format, ## args); \
+		start_capture(); \
+		TEST_ASSERT(cprints(CC_SYSTEM, format, ## args) == \
+			    EC_SUCCESS); \
+		TEST_ASSERT(check_line(captured()) == EC_SUCCESS); \
+	} while (0)
+
+static int test_binlog_formats(void)
+{
+	static const uint8_t bytes[] = {0x01, 0x23, 0xab, 0xcd, 0xef};
+	uint64_t big = 0x123456789abcdefULL;
+
+	CHECK_FORMAT("no arguments");
+	CHECK_FORMAT("%d %u %x %X %b", -5, 7, 0xbeef, 0xbeef, 5);
+	CHECK_FORMAT("%08x|%-6s|%5d|%c|100%%", 0x1234, "ab", 42, 'z');
+	CHECK_FORMAT("%.3d %.6d", 12345, -7);
+	CHECK_FORMAT("%ld %lx %d", big, big, 3);
+	CHECK_FORMAT("%*d|%-*s|%.*d", 6, 1, 4, "x", 2, 314);
+	CHECK_FORMAT("%.5h %.*h", bytes, 2, bytes + 3);
+	CHECK_FORMAT("%s %s %s", "", "abcd", "abcdefgh");
+	CHECK_FORMAT("%s", (const char *)NULL);
+	CHECK_FORMAT("a long message with some text before the conversion %d "
+		     "and some more text after it, then %s", 99, "the end");
+
+	return EC_SUCCESS;
+}
+
+static int test_binlog_bad_formats(void)
+{
+	static const uint8_t bytes[] = {0x01, 0x23};
+
+	/* Output matches vfnprintf(), which prints "ERROR" and stops */
+	CHECK_FORMAT("%2000d|%d", 1, 2);
+	CHECK_FORMAT("a %*d|%d", -1, 1, 2);
+	CHECK_FORMAT("b %.*d|%d", 2000, 1, 2);
+	CHECK_FORMAT("c %h|%d", bytes, 2);
+	CHECK_FORMAT("d %q|%d", 1, 2);
+	CHECK_FORMAT("e %-5c|%d", 'z', 2);
+	CHECK_FORMAT("f %ls|%d", "ab", 2);
+	CHECK_FORMAT("g %d %5", 1);
+	CHECK_FORMAT("%0000000005d|%.00000003d", 7, 1234);
+
+	return EC_SUCCESS;
+}
+
+static int test_binlog_deferred(void)
+{
+	char buf[8] = "before";
+	const char *out;
+
+	/* Nothing is formatted until the log is flushed */
+	start_capture();
+	cprints(CC_SYSTEM, "%s", buf);
+	test_capture_console(0);
+	TEST_ASSERT(strlen(test_get_captured_console()) == 0);
+
+	/* The string argument was copied at the call */
+	strzcpy(buf, "after", sizeof(buf));
+	snprintf(expect, sizeof(expect), "before");
+	test_capture_console(1);
+	out = captured();
+	TEST_ASSERT(check_line(out) == EC_SUCCESS);
+
+	/* The HOOKS task formats the log without an explicit flush */
+	start_capture();
+	cprints(CC_SYSTEM, "%s", buf);
+	msleep(10);
+	test_capture_console(0);
+	TEST_ASSERT(contains(test_get_captured_console(), " after]\r\n"));
+
+	return EC_SUCCESS;
+}
+
+static int test_binlog_timestamp(void)
+{
+	uint64_t t0, t1, t2;
+	const char *out;
+
+	/* The time printed is when cprints() was called, not when formatted */
+	start_capture();
+	t0 = get_time().val;
+	cprints(CC_SYSTEM, "%T");
+	t1 = get_time().val;
+	udelay(5000);
+	out = captured();
+
+	out = parse_time(out, &t2);
+	TEST_ASSERT(out);
+	TEST_ASSERT(t2 >= t0 && t2 <= t1);
+
+	/* %T in the message prints the same time as the prefix */
+	snprintf(expect, sizeof(expect), "%.6lu", t2);
+	TEST_ASSERT(check_line(test_get_captured_console()) == EC_SUCCESS);
+
+	return EC_SUCCESS;
+}
+
+static int test_binlog_overflow(void)
+{
+	static char data[1024];
+	char text[101];
+	const char *out;
+	uint64_t t;
+	int i;
+
+	memset(text, 'x', sizeof(text) - 1);
+	text[sizeof(text) - 1] = '\0';
+
+	/* Fill the log until messages are dropped */
+	start_capture();
+	for (i = 0; i < 10; i++)
+		if (cprints(CC_SYSTEM, "%s", text) != EC_SUCCESS)
+			break;
+	TEST_ASSERT(i > 0 && i < 10);
+	TEST_ASSERT(cprints(CC_SYSTEM, "%s", text) != EC_SUCCESS);
+
+	/* The kept messages are printed, then the number dropped */
+	out = captured();
+	for (; i; i--) {
+		out = parse_time(out, &t);
+		TEST_ASSERT(out);
+		TEST_ASSERT(memcmp(out, text, sizeof(text) - 1) == 0);
+		out += sizeof(text) - 1;
+		TEST_ASSERT(memcmp(out, "]\r\n", 3) == 0);
+		out += 3;
+	}
+	out = parse_time(out, &t);
+	TEST_ASSERT(out);
+	TEST_ASSERT(memcmp(out, "binlog: 2 dropped]\r\n", 21) == 0);
+
+	/* A message too large for the whole log is dropped too */
+	start_capture();
+	TEST_ASSERT(cprints(CC_SYSTEM, "%.*h", sizeof(data), data) !=
+		    EC_SUCCESS);
+	out = captured();
+	TEST_ASSERT(parse_time(out, &t));
+
+	return EC_SUCCESS;
+}
+
+static int test_binlog_speed(void)
+{
+	timestamp_t t0, t1;
+	int direct = 0, binary = 0;
+	int i, j;
+
+	ccprintf("\n");
+	for (i = 0; i < BENCH_LINES; i += BENCH_BURST) {
+		t0 = get_time();
+		for (j = 0; j < BENCH_BURST; j++)
+			cprintf(CC_SYSTEM, "[%T port %d: state %s, %d mV]\n",
+				j, "SNK_READY", 5000);
+		t1 = get_time();
+		direct += t1.val - t0.val;
+		cflush();
+
+		t0 = get_time();
+		for (j = 0; j < BENCH_BURST; j++)
+			cprints(CC_SYSTEM, "port %d: state %s, %d mV",
+				j, "SNK_READY", 5000);
+		t1 = get_time();
+		binary += t1.val - t0.val;
+		cflush();
+	}
+	ccprintf("%d messages: formatted %d us, binary %d us\n",
+		 BENCH_LINES, direct, binary);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_binlog_formats);
+	RUN_TEST(test_binlog_bad_formats);
+	RUN_TEST(test_binlog_deferred);
+	RUN_TEST(test_binlog_timestamp);
+	RUN_TEST(test_binlog_overflow);
+	RUN_TEST(test_binlog_speed);
+
+	test_print_result();
+}
@@ -0,0 +1,160 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test CRC-32 implementation.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "crc.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define BENCH_MAX_SIZE (64 * 1024)
+
+/* Bytes hashed per buffer size in the benchmark */
+#define BENCH_BYTES (512 * 1024)
+
+static uint8_t buf[BENCH_MAX_SIZE + 8];
+
+/* Byte-at-a-time reference, equivalent to the original crc32_hash() */
+static uint32_t ref_tab[256];
+
+static void ref_init(void)
+{
+	uint32_t c;
+	int n, k;
+
+	for (n = 0; n < 256; n++) {
+		c = n;
+		for (k = 0; k < 8; k++)
+			c = (c & 1) ? (c >> 1) ^ 0xedb88320 : c >> 1;
+		ref_tab[n] = c;
+	}
+}
+
+static uint32_t ref_crc32(const uint8_t *p, int size)
+{
+	uint32_t crc = 0xffffffff;
+
+	while (size--) {
+		crc ^= *p++;
+		crc = ref_tab[crc & 0xff] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xffffffff;
+}
+
+static uint32_t buf_crc32(const uint8_t *p, int size)
+{
+	crc32_init();
+	crc32_hash_buf(p, size);
+	return crc32_result();
+}
+
+static int test_crc32_check_value(void)
+{
+	/* Standard CRC-32 check value */
+	TEST_ASSERT(buf_crc32((const uint8_t *)"123456789", 9) == 0xcbf43926);
+	TEST_ASSERT(buf_crc32(buf, 0) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_crc32_words(void)
+{
+	uint32_t data[3] = {0x12345678, 0xdeadbeef, 0x00c0ffee};
+	uint16_t header = 0x1161;
+	uint32_t crc;
+	int i;
+
+	/* Word and half-word hashing must match hashing the raw bytes */
+	crc32_init();
+	crc32_hash16(header);
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		crc32_hash32(data[i]);
+	crc = crc32_result();
+
+	memcpy(buf, &header, sizeof(header));
+	memcpy(buf + sizeof(header), data, sizeof(data));
+	TEST_ASSERT(crc == ref_crc32(buf, sizeof(header) + sizeof(data)));
+
+	return EC_SUCCESS;
+}
+
+static int test_crc32_alignment(void)
+{
+	int offset, size;
+
+	for (size = 0; size < 64; size++)
+		for (offset = 0; offset < 8; offset++)
+			TEST_ASSERT(buf_crc32(buf + offset, size) ==
+				    ref_crc32(buf + offset, size));
+
+	return EC_SUCCESS;
+}
+
+static int test_crc32_streaming(void)
+{
+	int split;
+	uint32_t expected = ref_crc32(buf + 1, 1000);
+
+	/* Splitting the input at any point must not change the result */
+	for (split = 0; split <= 1000; split += 37) {
+		crc32_init();
+		crc32_hash_buf(buf + 1, split);
+		crc32_hash_buf(buf + 1 + split, 1000 - split);
+		TEST_ASSERT(crc32_result() == expected);
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_crc32_speed(void)
+{
+	timestamp_t t0, t1, t2;
+	uint32_t ref = 0, crc = 0;
+	int size, i, iterations;
+
+	ccprintf("\n");
+	for (size = 4; size <= BENCH_MAX_SIZE; size *= 4) {
+		iterations = BENCH_BYTES / size;
+
+		t0 = get_time();
+		for (i = 0; i < iterations; i++)
+			ref = ref_crc32(buf, size);
+		t1 = get_time();
+		for (i = 0; i < iterations; i++)
+			crc = buf_crc32(buf, size);
+		t2 = get_time();
+
+		TEST_ASSERT(crc == ref);
+		ccprintf("  %5d B x %6d: byte %6d us, buf %6d us\n",
+			 size, iterations, (int)(t1.val - t0.val),
+			 (int)(t2.val - t1.val));
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	int i;
+
+	test_reset();
+
+	ref_init();
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (i * 7 + (i >> 8)) & 0xff;
+
+	RUN_TEST(test_crc32_check_value);
+	RUN_TEST(test_crc32_words);
+	RUN_TEST(test_crc32_alignment);
+	RUN_TEST(test_crc32_streaming);
+	RUN_TEST(test_crc32_speed);
+
+	test_print_result();
+}
@@ -8,6 +8,7 @@
 #include "common.h"
 #include "console.h"
 #include "hooks.h"
+#include "link_defs.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
@@ -20,6 +21,11 @@ static timestamp_t tick_time[2];
 static int second_hook_count;
 static timestamp_t second_time[2];
 static int deferred_call_count;
+static int deferred_order[3];
+static int deferred_order_count;
+static int deferred_resched_count;
+static int prio_order[5];
+static int prio_order_count;
 
 static void init_hook(void)
 {
@@ -51,6 +57,45 @@ static void second_hook(void)
 }
 DECLARE_HOOK(HOOK_SECOND, second_hook, HOOK_PRIO_DEFAULT);
 
+static void record_prio_order(int id)
+{
+	if (prio_order_count < ARRAY_SIZE(prio_order))
+		prio_order[prio_order_count] = id;
+	prio_order_count++;
+}
+
+/* Declared out of priority order; hook_notify() must sort them */
+static void prio_hook_default_plus_one(void)
+{
+	record_prio_order(3);
+}
+DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, prio_hook_default_plus_one,
+	     HOOK_PRIO_DEFAULT + 1);
+
+static void prio_hook_default_a(void)
+{
+	record_prio_order(1);
+}
+DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, prio_hook_default_a, HOOK_PRIO_DEFAULT);
+
+static void prio_hook_last(void)
+{
+	record_prio_order(4);
+}
+DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, prio_hook_last, HOOK_PRIO_LAST);
+
+static void prio_hook_first(void)
+{
+	record_prio_order(0);
+}
+DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, prio_hook_first, HOOK_PRIO_FIRST);
+
+static void prio_hook_default_b(void)
+{
+	record_prio_order(2);
+}
+DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, prio_hook_default_b, HOOK_PRIO_DEFAULT);
+
 static void deferred_func(void)
 {
 	deferred_call_count++;
@@ -61,6 +106,44 @@ static void non_deferred_func(void)
 {
 	deferred_call_count++;
 }
+/* Looks like deferred data, but is not in the deferred function table */
+static const struct deferred_data non_deferred_func_data = {
+	non_deferred_func
+};
+
+static void record_deferred_order(int id)
+{
+	if (deferred_order_count < ARRAY_SIZE(deferred_order))
+		deferred_order[deferred_order_count] = id;
+	deferred_order_count++;
+}
+
+static void deferred_order1(void)
+{
+	record_deferred_order(1);
+}
+DECLARE_DEFERRED(deferred_order1);
+
+static void deferred_order2(void)
+{
+	record_deferred_order(2);
+}
+DECLARE_DEFERRED(deferred_order2);
+
+static void deferred_order3(void)
+{
+	record_deferred_order(3);
+}
+DECLARE_DEFERRED(deferred_order3);
+
+static void deferred_resched(void);
+DECLARE_DEFERRED(deferred_resched);
+
+static void deferred_resched(void)
+{
+	if (++deferred_resched_count < 5)
+		hook_call_deferred(&deferred_resched_data, 5 * MSEC);
+}
 
 static int test_init_hook(void)
 {
@@ -101,28 +184,63 @@ static int test_priority(void)
 	return EC_SUCCESS;
 }
 
+static int test_notify_order(void)
+{
+	int i;
+
+	prio_order_count = 0;
+	hook_notify(HOOK_BATTERY_SOC_CHANGE);
+	TEST_ASSERT(prio_order_count == ARRAY_SIZE(prio_order));
+	/* Equal priorities are called in the order they were declared */
+	for (i = 0; i < ARRAY_SIZE(prio_order); i++)
+		TEST_ASSERT(prio_order[i] == i);
+
+	return EC_SUCCESS;
+}
+
+static int test_notify_hist(void)
+{
+	const struct hook_data *p;
+	const uint8_t *hist;
+	int i, runs;
+
+	for (p = __hooks_battery_soc_change; p->routine != prio_hook_first; p++)
+		;
+
+	hook_notify(HOOK_BATTERY_SOC_CHANGE);
+	hook_notify(HOOK_BATTERY_SOC_CHANGE);
+
+	/* One run from test_notify_order() and two from here */
+	hist = __hook_hist + (p - __hooks_init) * 8;
+	for (i = runs = 0; i < 8; i++)
+		runs += hist[i];
+	TEST_ASSERT(runs == 3);
+
+	return EC_SUCCESS;
+}
+
 static int test_deferred(void)
 {
 	deferred_call_count = 0;
-	hook_call_deferred(deferred_func, 50 * MSEC);
+	hook_call_deferred(&deferred_func_data, 50 * MSEC);
 	usleep(100 * MSEC);
 	TEST_ASSERT(deferred_call_count == 1);
 
-	hook_call_deferred(deferred_func, 50 * MSEC);
+	hook_call_deferred(&deferred_func_data, 50 * MSEC);
 	usleep(25 * MSEC);
-	hook_call_deferred(deferred_func, -1);
+	hook_call_deferred(&deferred_func_data, -1);
 	usleep(75 * MSEC);
 	TEST_ASSERT(deferred_call_count == 1);
 
-	hook_call_deferred(deferred_func, 50 * MSEC);
+	hook_call_deferred(&deferred_func_data, 50 * MSEC);
 	usleep(25 * MSEC);
-	hook_call_deferred(deferred_func, -1);
+	hook_call_deferred(&deferred_func_data, -1);
 	usleep(15 * MSEC);
-	hook_call_deferred(deferred_func, 25 * MSEC);
+	hook_call_deferred(&deferred_func_data, 25 * MSEC);
 	usleep(50 * MSEC);
 	TEST_ASSERT(deferred_call_count == 2);
 
-	TEST_ASSERT(hook_call_deferred(non_deferred_func, 50 * MSEC) !=
+	TEST_ASSERT(hook_call_deferred(&non_deferred_func_data, 50 * MSEC) !=
 		    EC_SUCCESS);
 	usleep(100 * MSEC);
 	TEST_ASSERT(deferred_call_count == 2);
@@ -130,6 +248,43 @@ static int test_deferred(void)
 	return EC_SUCCESS;
 }
 
+static int test_deferred_order(void)
+{
+	/* Routines must run in deadline order, not declaration order */
+	deferred_order_count = 0;
+	hook_call_deferred(&deferred_order2_data, 60 * MSEC);
+	hook_call_deferred(&deferred_order3_data, 20 * MSEC);
+	hook_call_deferred(&deferred_order1_data, 40 * MSEC);
+	usleep(100 * MSEC);
+	TEST_ASSERT(deferred_order_count == 3);
+	TEST_ASSERT(deferred_order[0] == 3);
+	TEST_ASSERT(deferred_order[1] == 1);
+	TEST_ASSERT(deferred_order[2] == 2);
+
+	/* Rescheduling one routine must not affect the others */
+	deferred_order_count = 0;
+	hook_call_deferred(&deferred_order1_data, 20 * MSEC);
+	hook_call_deferred(&deferred_order2_data, 40 * MSEC);
+	hook_call_deferred(&deferred_order1_data, 60 * MSEC);
+	usleep(100 * MSEC);
+	TEST_ASSERT(deferred_order_count == 2);
+	TEST_ASSERT(deferred_order[0] == 2);
+	TEST_ASSERT(deferred_order[1] == 1);
+
+	return EC_SUCCESS;
+}
+
+static int test_deferred_resched(void)
+{
+	/* A routine may schedule itself again from its own call */
+	deferred_resched_count = 0;
+	hook_call_deferred(&deferred_resched_data, 0);
+	usleep(100 * MSEC);
+	TEST_ASSERT(deferred_resched_count == 5);
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	test_reset();
@@ -137,7 +292,11 @@ void run_test(void)
 	RUN_TEST(test_init_hook);
 	RUN_TEST(test_ticks);
 	RUN_TEST(test_priority);
+	RUN_TEST(test_notify_order);
+	RUN_TEST(test_notify_hist);
 	RUN_TEST(test_deferred);
+	RUN_TEST(test_deferred_order);
+	RUN_TEST(test_deferred_resched);
 
 	test_print_result();
 }
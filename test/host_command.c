@@ -8,6 +8,7 @@
 #include "common.h"
 #include "console.h"
 #include "host_command.h"
+#include "link_defs.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -167,6 +168,110 @@ static int test_hostcmd_invalid_checksum(void)
 	return EC_SUCCESS;
 }
 
+static int test_hostcmd_dispatch(void)
+{
+	const struct host_command *cmd, *first;
+	struct ec_params_get_cmd_versions_v1 vp;
+	struct ec_response_get_cmd_versions vr;
+
+	/* Every registered command is found, first registration first */
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		for (first = __hcmds; first->command != cmd->command; first++)
+			;
+		vp.cmd = cmd->command;
+		TEST_ASSERT(test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 1,
+						   &vp, sizeof(vp), &vr,
+						   sizeof(vr)) ==
+			    EC_RES_SUCCESS);
+		TEST_ASSERT(vr.version_mask == first->version_mask);
+	}
+
+	/* Numbers between and after registered commands are not found */
+	for (vp.cmd = 0; vp.cmd < 0x400; vp.cmd++) {
+		for (cmd = __hcmds; cmd < __hcmds_end; cmd++)
+			if (cmd->command == vp.cmd)
+				break;
+		if (cmd < __hcmds_end)
+			continue;
+		TEST_ASSERT(test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 1,
+						   &vp, sizeof(vp), &vr,
+						   sizeof(vr)) ==
+			    EC_RES_INVALID_PARAM);
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Read all the statistics, optionally clearing them */
+static int read_cmd_stats(struct ec_cmd_stats_entry *entries, int flags)
+{
+	struct ec_params_get_cmd_stats sp;
+	uint8_t buf[sizeof(struct ec_response_get_cmd_stats) +
+		    4 * sizeof(struct ec_cmd_stats_entry)];
+	struct ec_response_get_cmd_stats *sr = (void *)buf;
+	int n = 0;
+
+	/* Use a small buffer, so the entries are read in several pages */
+	do {
+		sp.index = n;
+		sp.flags = flags;
+		if (test_send_host_command(EC_CMD_GET_CMD_STATS, 0, &sp,
+					   sizeof(sp), buf, sizeof(buf)))
+			return -1;
+		memcpy(entries + n, sr->entries,
+		       sr->count * sizeof(sr->entries[0]));
+		n += sr->count;
+	} while (sr->count && n < sr->total);
+
+	return n;
+}
+
+static int test_hostcmd_stats(void)
+{
+	static struct ec_cmd_stats_entry stats[256];
+	struct ec_params_get_cmd_stats sp = { 0, 0 };
+	uint8_t small[2];
+	int total = __hcmds_end - __hcmds;
+	int i, found = 0;
+
+	TEST_ASSERT(read_cmd_stats(stats, EC_CMD_STATS_FLAG_RESET) == total);
+
+	/* Three good requests and one with a bad version */
+	for (i = 0; i < 3; i++) {
+		hostcmd_fill_in_default();
+		hostcmd_send();
+		TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+	}
+	hostcmd_fill_in_default();
+	req->command_version = 1;
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_INVALID_VERSION);
+
+	TEST_ASSERT(read_cmd_stats(stats, 0) == total);
+	for (i = 0; i < total; i++) {
+		/* Entries are in command order */
+		if (i)
+			TEST_ASSERT(stats[i].command >= stats[i - 1].command);
+
+		if (stats[i].command == EC_CMD_HELLO) {
+			TEST_ASSERT(stats[i].count == 4);
+			TEST_ASSERT(stats[i].errors == 1);
+			TEST_ASSERT(stats[i].avg_us <= stats[i].max_us);
+			found = 1;
+		} else if (stats[i].command != EC_CMD_GET_CMD_STATS) {
+			TEST_ASSERT(stats[i].count == 0);
+		}
+	}
+	TEST_ASSERT(found);
+
+	/* A response buffer too small even for the header is rejected */
+	TEST_ASSERT(test_send_host_command(EC_CMD_GET_CMD_STATS, 0, &sp,
+					   sizeof(sp), small, sizeof(small)) ==
+		    EC_RES_RESPONSE_TOO_BIG);
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	wait_for_task_started();
@@ -180,6 +285,8 @@ void run_test(void)
 	RUN_TEST(test_hostcmd_wrong_command_version);
 	RUN_TEST(test_hostcmd_wrong_struct_version);
 	RUN_TEST(test_hostcmd_invalid_checksum);
+	RUN_TEST(test_hostcmd_dispatch);
+	RUN_TEST(test_hostcmd_stats);
 
 	test_print_result();
 }
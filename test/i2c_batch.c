@@ -0,0 +1,210 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test I2C batches and the background I2C queue.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "i2c.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define TEST_PORT 1
+#define TEST_ADDR 0x40
+
+/* Registers of the mock device */
+static uint8_t regs[16];
+
+/* Offsets accessed, in order */
+static int access_log[16];
+static int access_count;
+
+static void log_access(int offset)
+{
+	if (access_count < ARRAY_SIZE(access_log))
+		access_log[access_count++] = offset;
+}
+
+static int mock_read8(int port, int slave_addr, int offset, int *data)
+{
+	if (port != TEST_PORT || slave_addr != TEST_ADDR)
+		return EC_ERROR_INVAL;
+	if (offset >= sizeof(regs))
+		return EC_ERROR_UNKNOWN;
+	log_access(offset);
+	*data = regs[offset];
+	return EC_SUCCESS;
+}
+DECLARE_TEST_I2C_READ8(mock_read8);
+
+static int mock_write8(int port, int slave_addr, int offset, int data)
+{
+	if (port != TEST_PORT || slave_addr != TEST_ADDR)
+		return EC_ERROR_INVAL;
+	if (offset >= sizeof(regs))
+		return EC_ERROR_UNKNOWN;
+	log_access(offset);
+	regs[offset] = data;
+	return EC_SUCCESS;
+}
+DECLARE_TEST_I2C_WRITE8(mock_write8);
+
+static int mock_read16(int port, int slave_addr, int offset, int *data)
+{
+	if (port != TEST_PORT || slave_addr != TEST_ADDR)
+		return EC_ERROR_INVAL;
+	if (offset + 1 >= sizeof(regs))
+		return EC_ERROR_UNKNOWN;
+	log_access(offset);
+	*data = regs[offset] | (regs[offset + 1] << 8);
+	return EC_SUCCESS;
+}
+DECLARE_TEST_I2C_READ16(mock_read16);
+
+static int mock_write16(int port, int slave_addr, int offset, int data)
+{
+	if (port != TEST_PORT || slave_addr != TEST_ADDR)
+		return EC_ERROR_INVAL;
+	if (offset + 1 >= sizeof(regs))
+		return EC_ERROR_UNKNOWN;
+	log_access(offset);
+	regs[offset] = data & 0xff;
+	regs[offset + 1] = (data >> 8) & 0xff;
+	return EC_SUCCESS;
+}
+DECLARE_TEST_I2C_WRITE16(mock_write16);
+
+static void reset_mock(void)
+{
+	memset(regs, 0, sizeof(regs));
+	access_count = 0;
+}
+
+static int test_batch(void)
+{
+	struct i2c_op ops[] = {
+		{I2C_OP_WRITE8, 2, 0x12},
+		{I2C_OP_WRITE16, 4, 0x3456},
+		{I2C_OP_READ8, 5, 0},
+		{I2C_OP_READ16, 2, 0},
+	};
+
+	reset_mock();
+	TEST_ASSERT(i2c_batch(TEST_PORT, TEST_ADDR, ops, ARRAY_SIZE(ops)) ==
+		    EC_SUCCESS);
+	TEST_ASSERT(ops[2].data == 0x34);
+	TEST_ASSERT(ops[3].data == 0x0012);
+	TEST_ASSERT(access_count == 4);
+	TEST_ASSERT(access_log[0] == 2 && access_log[1] == 4);
+	TEST_ASSERT(access_log[2] == 5 && access_log[3] == 2);
+
+	return EC_SUCCESS;
+}
+
+static int test_batch_error(void)
+{
+	struct i2c_op ops[] = {
+		{I2C_OP_WRITE8, 1, 0x55},
+		{I2C_OP_WRITE8, 16, 0x66},  /* Out of range */
+		{I2C_OP_WRITE8, 3, 0x77},
+	};
+
+	/* Stops at the first failure */
+	reset_mock();
+	TEST_ASSERT(i2c_batch(TEST_PORT, TEST_ADDR, ops, ARRAY_SIZE(ops)) ==
+		    EC_ERROR_UNKNOWN);
+	TEST_ASSERT(regs[1] == 0x55);
+	TEST_ASSERT(regs[3] == 0);
+
+	/* And fails up front for a missing device */
+	reset_mock();
+	TEST_ASSERT(test_detach_i2c(TEST_PORT, TEST_ADDR) == EC_SUCCESS);
+	TEST_ASSERT(i2c_batch(TEST_PORT, TEST_ADDR, ops, 1) != EC_SUCCESS);
+	TEST_ASSERT(test_attach_i2c(TEST_PORT, TEST_ADDR) == EC_SUCCESS);
+	TEST_ASSERT(access_count == 0);
+
+	return EC_SUCCESS;
+}
+
+static struct i2c_op write_ops[] = {
+	{I2C_OP_WRITE8, 7, 0xa5},
+	{I2C_OP_WRITE8, 8, 0x5a},
+};
+static struct i2c_op read_ops[] = {
+	{I2C_OP_READ8, 7, 0},
+	{I2C_OP_READ8, 8, 0},
+};
+static struct i2c_op bad_ops[] = {
+	{I2C_OP_READ8, 16, 0},
+};
+static struct i2c_request write_req, read_req, bad_req;
+static int done_count;
+static int resubmit;
+
+static void request_done(struct i2c_request *req)
+{
+	done_count++;
+
+	/* Read again, from the callback */
+	if (req == &read_req && resubmit) {
+		resubmit = 0;
+		i2c_submit(req);
+	}
+}
+
+static void init_request(struct i2c_request *req, struct i2c_op *ops,
+			 int count)
+{
+	req->port = TEST_PORT;
+	req->slave_addr = TEST_ADDR;
+	req->ops = ops;
+	req->count = count;
+	req->done = request_done;
+}
+
+static int test_queue(void)
+{
+	reset_mock();
+	done_count = 0;
+	resubmit = 1;
+	init_request(&write_req, write_ops, ARRAY_SIZE(write_ops));
+	init_request(&read_req, read_ops, ARRAY_SIZE(read_ops));
+	init_request(&bad_req, bad_ops, ARRAY_SIZE(bad_ops));
+
+	TEST_ASSERT(i2c_submit(&write_req) == EC_SUCCESS);
+	TEST_ASSERT(i2c_submit(&read_req) == EC_SUCCESS);
+	TEST_ASSERT(i2c_submit(&bad_req) == EC_SUCCESS);
+	TEST_ASSERT(write_req.rv == EC_ERROR_BUSY);
+
+	msleep(10);
+
+	/* Run in order; the read sees the write */
+	TEST_ASSERT(done_count == 4);
+	TEST_ASSERT(write_req.rv == EC_SUCCESS);
+	TEST_ASSERT(read_req.rv == EC_SUCCESS);
+	TEST_ASSERT(bad_req.rv == EC_ERROR_UNKNOWN);
+	TEST_ASSERT(read_ops[0].data == 0xa5 && read_ops[1].data == 0x5a);
+	TEST_ASSERT(access_count == 6);
+	TEST_ASSERT(access_log[0] == 7 && access_log[1] == 8);
+	TEST_ASSERT(access_log[2] == 7 && access_log[3] == 8);
+
+	/* Invalid port */
+	write_req.port = I2C_PORT_COUNT;
+	TEST_ASSERT(i2c_submit(&write_req) == EC_ERROR_INVAL);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_batch);
+	RUN_TEST(test_batch_error);
+	RUN_TEST(test_queue);
+
+	test_print_result();
+}
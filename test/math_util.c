@@ -8,9 +8,11 @@
 #include <math.h>
 #include <stdio.h>
 #include "common.h"
+#include "console.h"
 #include "math_util.h"
 #include "motion_sense.h"
 #include "test_util.h"
+#include "timer.h"
 #include "util.h"
 
 /*****************************************************************************/
@@ -45,11 +47,216 @@ static int test_acos(void)
 	return EC_SUCCESS;
 }
 
+static int test_int_sqrtf(void)
+{
+	static const int64_t edges[] = {
+		0, 1, 2, 3, 4, 0xfffe0001, 0xfffe0002, 0xffffffff,
+		0x100000000ll, 0x3fffffff00000001ll, 0x3fffffff00000000ll,
+		0x7fffffffffffffffll, -1, -0x7fffffffffffffffll,
+	};
+	int64_t x;
+	int i, r;
+
+	for (i = 0; i < ARRAY_SIZE(edges); i++) {
+		x = edges[i];
+		r = int_sqrtf(x);
+		if (x <= 0) {
+			TEST_ASSERT(r == 0);
+			continue;
+		}
+		/* r is the floor of the root, or capped */
+		TEST_ASSERT((int64_t)r * r <= x);
+		TEST_ASSERT(r == 0x7fffffff ||
+			    ((int64_t)r + 1) * ((int64_t)r + 1) > x);
+	}
+
+	/* Squares and their neighbours across the whole range */
+	for (x = 1; x < 0x7fffffff; x = x * 3 / 2 + 1) {
+		TEST_ASSERT(int_sqrtf(x * x) == x);
+		TEST_ASSERT(int_sqrtf(x * x - 1) == x - 1);
+		TEST_ASSERT(int_sqrtf(x * x + 1) == x);
+	}
+
+	for (x = 0; x < 100000; x += 7)
+		TEST_ASSERT(int_sqrtf(x) == (int)sqrt(x));
+
+	return EC_SUCCESS;
+}
+
+/* Accelerometer-sized test vectors, in mg */
+static const vector_3_t test_vectors[] = {
+	{0, 0, 1024}, {1024, 0, 0}, {0, -1024, 0}, {700, -700, 30},
+	{-5, 12, -1000}, {300, 400, 900}, {-1020, 90, 15}, {1, 1, 1},
+	{16000, -12000, 3000}, {0, 0, 0},
+};
+
+#define NUM_TEST_VECTORS ARRAY_SIZE(test_vectors)
+
+/* 90 degrees around the y axis */
+static const matrix_3x3_t test_rot = {
+	{0, 0, FLOAT_TO_FP(-1)},
+	{0, FLOAT_TO_FP(1), 0},
+	{FLOAT_TO_FP(1), 0, 0},
+};
+
+static int test_rotate_n(void)
+{
+	vector_3_t v[NUM_TEST_VECTORS], r;
+	int i;
+
+	memcpy(v, test_vectors, sizeof(v));
+
+	/* In place, as calculate_lid_angle() does */
+	rotate_n(v, test_rot, v, NUM_TEST_VECTORS);
+
+	for (i = 0; i < NUM_TEST_VECTORS; i++) {
+		rotate(test_vectors[i], test_rot, r);
+		TEST_ASSERT_ARRAY_EQ(v[i], r, 3);
+		TEST_ASSERT(r[0] == test_vectors[i][2]);
+		TEST_ASSERT(r[1] == test_vectors[i][1]);
+		TEST_ASSERT(r[2] == -test_vectors[i][0]);
+	}
+
+	return EC_SUCCESS;
+}
+
+#define COSINE_TOLERANCE 0.001f
+
+static float float_cosine(const vector_3_t a, const vector_3_t b)
+{
+	float dot = (float)a[0] * b[0] + (float)a[1] * b[1] +
+		(float)a[2] * b[2];
+	float mag = sqrtf((float)a[0] * a[0] + (float)a[1] * a[1] +
+			  (float)a[2] * a[2]) *
+		sqrtf((float)b[0] * b[0] + (float)b[1] * b[1] +
+		      (float)b[2] * b[2]);
+
+	return mag ? dot / mag : 0.0f;
+}
+
+static int test_unit_vectors(void)
+{
+	vector_3_t u[NUM_TEST_VECTORS];
+	float a, b;
+	int i, j, mag;
+
+	unit_vectors(test_vectors, u, NUM_TEST_VECTORS);
+
+	for (i = 0; i < NUM_TEST_VECTORS; i++) {
+		mag = vector_magnitude(u[i]);
+		if (i == NUM_TEST_VECTORS - 1)
+			TEST_ASSERT(mag == 0);
+		else
+			TEST_ASSERT(IS_FLOAT_EQUAL(mag, 1 << UNIT_VECTOR_BITS,
+						   4));
+
+		for (j = 0; j < NUM_TEST_VECTORS; j++) {
+			a = FP_TO_FLOAT(cosine_of_unit_vectors(u[i], u[j]));
+			b = float_cosine(test_vectors[i], test_vectors[j]);
+			TEST_ASSERT(IS_FLOAT_EQUAL(a, b, COSINE_TOLERANCE));
+
+			/*
+			 * Agrees with the general version, which is less
+			 * precise since it rounds magnitudes down to integers.
+			 */
+			if (vector_magnitude(test_vectors[i]) < 1000 ||
+			    vector_magnitude(test_vectors[j]) < 1000)
+				continue;
+			b = FP_TO_FLOAT(cosine_of_angle_diff(test_vectors[i],
+							     test_vectors[j]));
+			TEST_ASSERT(IS_FLOAT_EQUAL(a, b,
+						   2 * COSINE_TOLERANCE));
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Calls per benchmark */
+#define BENCH_CALLS 100000
+
+/* Keeps the benchmarked results alive */
+static volatile int bench_sink;
+
+static void print_bench(const char *name, timestamp_t t0, timestamp_t t1,
+			int calls)
+{
+	ccprintf("  %-28s %5d ns/call\n", name,
+		 (int)((t1.val - t0.val) * 1000 / calls));
+	cflush();
+}
+
+static int test_math_speed(void)
+{
+	vector_3_t v[NUM_TEST_VECTORS], u[NUM_TEST_VECTORS];
+	timestamp_t t0, t1;
+	int i, j, sum = 0;
+
+	ccprintf("\n");
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS; i++)
+		sum += arc_cos(FLOAT_TO_FP(-1.0) + (i & 0x1ffff));
+	t1 = get_time();
+	print_bench("arc_cos", t0, t1, BENCH_CALLS);
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS; i++)
+		sum += int_sqrtf(i * 40503);
+	t1 = get_time();
+	print_bench("int_sqrtf 32-bit", t0, t1, BENCH_CALLS);
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS; i++)
+		sum += int_sqrtf((int64_t)i << 33);
+	t1 = get_time();
+	print_bench("int_sqrtf 64-bit", t0, t1, BENCH_CALLS);
+
+	/* Each sample is compared against all the others, as by the lid */
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS / NUM_TEST_VECTORS; i++)
+		for (j = 0; j < NUM_TEST_VECTORS; j++)
+			sum += cosine_of_angle_diff(test_vectors[0],
+						    test_vectors[j]);
+	t1 = get_time();
+	print_bench("cosine_of_angle_diff", t0, t1, BENCH_CALLS);
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS / NUM_TEST_VECTORS; i++) {
+		unit_vectors(test_vectors, u, NUM_TEST_VECTORS);
+		for (j = 0; j < NUM_TEST_VECTORS; j++)
+			sum += cosine_of_unit_vectors(u[0], u[j]);
+	}
+	t1 = get_time();
+	print_bench("unit_vectors + cosine", t0, t1, BENCH_CALLS);
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS / NUM_TEST_VECTORS; i++)
+		for (j = 0; j < NUM_TEST_VECTORS; j++)
+			rotate(test_vectors[j], test_rot, v[j]);
+	t1 = get_time();
+	print_bench("rotate", t0, t1, BENCH_CALLS);
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_CALLS / NUM_TEST_VECTORS; i++)
+		rotate_n(test_vectors, test_rot, v, NUM_TEST_VECTORS);
+	t1 = get_time();
+	print_bench("rotate_n", t0, t1, BENCH_CALLS);
+
+	bench_sink = sum + v[0][0];
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	test_reset();
 
 	RUN_TEST(test_acos);
+	RUN_TEST(test_int_sqrtf);
+	RUN_TEST(test_rotate_n);
+	RUN_TEST(test_unit_vectors);
+	RUN_TEST(test_math_speed);
 
 	test_print_result();
 }
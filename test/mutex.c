@@ -14,6 +14,15 @@
 #include "util.h"
 
 static struct mutex mtx;
+/* Never locked before the inheritance tests */
+static struct mutex fresh_mtx;
+/* Mutex the MTX3x tasks lock */
+static struct mutex *random_mtx = &mtx;
+
+/* Number of times MTX2 has run since the simple contention test */
+static int mtx2_runs;
+/* If set, MTX2 sends an event to MTX1 and wakes MTX3A when it runs */
+static int mtx2_poke;
 
 /* period between 50us and 3.2ms */
 #define PERIOD_US(num) (((num % 64) + 1) * 50)
@@ -28,11 +37,11 @@ int mutex_random_task(void *unused)
 	while (1) {
 		task_wait_event(0);
 		ccprintf("%c+\n", letter);
-		mutex_lock(&mtx);
+		mutex_lock(random_mtx);
 		ccprintf("%c=\n", letter);
 		task_wait_event(0);
 		ccprintf("%c-\n", letter);
-		mutex_unlock(&mtx);
+		mutex_unlock(random_mtx);
 	}
 
 	task_wait_event(0);
@@ -54,11 +63,126 @@ int mutex_second_task(void *unused)
 	ccprintf("MTX2: unlocking...\n");
 	mutex_unlock(&mtx);
 
-	task_wait_event(0);
+	while (1) {
+		task_wait_event(0);
+		mtx2_runs++;
+		if (mtx2_poke) {
+			mtx2_poke = 0;
+			task_set_event(TASK_ID_MTX1, TASK_EVENT_CUSTOM(1), 0);
+			task_wake(TASK_ID_MTX3A);
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Wake MTX3A and let it lock the mutex */
+static void lock_from_mtx3a(void)
+{
+	task_wake(TASK_ID_MTX3A);
+	usleep(1000);
+}
+
+static int test_timeout(void)
+{
+	timestamp_t t0;
+
+	lock_from_mtx3a();
+
+	/* Try once */
+	TEST_ASSERT(mutex_lock_timeout(&mtx, 0) == EC_ERROR_TIMEOUT);
+
+	/* Give up after the timeout */
+	t0 = get_time();
+	TEST_ASSERT(mutex_lock_timeout(&mtx, 2000) == EC_ERROR_TIMEOUT);
+	TEST_ASSERT(get_time().val - t0.val >= 2000);
+	TEST_ASSERT(!(mtx.waiters & (1 << TASK_ID_MTX1)));
+
+	/* Get it once MTX3A lets go */
+	task_wake(TASK_ID_MTX3A);
+	TEST_ASSERT(mutex_lock_timeout(&mtx, 10000) == EC_SUCCESS);
+	TEST_ASSERT(mtx.owner == TASK_ID_MTX1);
+	mutex_unlock(&mtx);
+
+#ifdef CONFIG_MUTEX_STATS
+	TEST_ASSERT(mtx.stats.timeouts == 2);
+#endif
+
+	return EC_SUCCESS;
+}
+
+static int test_event_preserved(void)
+{
+	lock_from_mtx3a();
+
+	/* MTX2 sends us an event while we wait, then releases MTX3A */
+	mtx2_poke = 1;
+	task_wake(TASK_ID_MTX2);
+	mutex_lock(&mtx);
+	mutex_unlock(&mtx);
+
+	TEST_ASSERT(task_wait_event_mask(TASK_EVENT_CUSTOM(1), 1000) ==
+		    TASK_EVENT_CUSTOM(1));
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Only the host emulator and Cortex-M lend the priority of a waiter to the
+ * owner of the mutex.
+ */
+#if defined(CORE_HOST) || defined(CORE_CORTEX_M)
+static int test_priority_inheritance(void)
+{
+	int runs;
+
+	lock_from_mtx3a();
+
+	/*
+	 * Both MTX2 and the owner MTX3A are ready.  While we wait, MTX3A
+	 * inherits our priority, so it releases the mutex and we get it
+	 * before the intermediate priority MTX2 runs.
+	 */
+	runs = mtx2_runs;
+	task_wake(TASK_ID_MTX2);
+	task_wake(TASK_ID_MTX3A);
+	mutex_lock(&mtx);
+	TEST_ASSERT(mtx2_runs == runs);
+	mutex_unlock(&mtx);
+
+	/* Now let MTX2 run */
+	usleep(1000);
+	TEST_ASSERT(mtx2_runs == runs + 1);
 
 	return EC_SUCCESS;
 }
 
+static int test_inheritance_first_lock(void)
+{
+	int runs;
+
+	/*
+	 * Same through a mutex locked for the first time, whose owner field
+	 * started out as 0, the ID of the idle task.
+	 */
+	random_mtx = &fresh_mtx;
+	lock_from_mtx3a();
+
+	runs = mtx2_runs;
+	task_wake(TASK_ID_MTX2);
+	task_wake(TASK_ID_MTX3A);
+	mutex_lock(&fresh_mtx);
+	TEST_ASSERT(mtx2_runs == runs);
+	mutex_unlock(&fresh_mtx);
+	random_mtx = &mtx;
+
+	usleep(1000);
+	TEST_ASSERT(mtx2_runs == runs + 1);
+
+	return EC_SUCCESS;
+}
+#endif
+
 int mutex_main_task(void *unused)
 {
 	task_id_t id = task_get_current();
@@ -90,6 +214,16 @@ int mutex_main_task(void *unused)
 	ccprintf("MTX1: get lock\n");
 	mutex_unlock(&mtx);
 
+	/* Give MTX2 time to unlock and wait for its next wake-up */
+	usleep(1000);
+
+	RUN_TEST(test_timeout);
+	RUN_TEST(test_event_preserved);
+#if defined(CORE_HOST) || defined(CORE_CORTEX_M)
+	RUN_TEST(test_priority_inheritance);
+	RUN_TEST(test_inheritance_first_lock);
+#endif
+
 	/* --- mass lock-unlocking from several tasks --- */
 	ccprintf("Massive locking/unlocking :\n");
 	for (i = 0; i < 500; i++) {
@@ -103,7 +237,7 @@ int mutex_main_task(void *unused)
 		rdelay = prng(rdelay);
 	}
 
-	test_pass();
+	test_print_result();
 	task_wait_event(0);
 
 	return EC_SUCCESS;
@@ -111,6 +245,7 @@ int mutex_main_task(void *unused)
 
 void run_test(void)
 {
+	test_reset();
 	wait_for_task_started();
 	task_wake(TASK_ID_MTX1);
 }
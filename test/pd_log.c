@@ -0,0 +1,228 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test PD event log storage and host commands.
+ */
+
+#include "common.h"
+#include "ec_commands.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_pd.h"
+#include "util.h"
+
+/* Port of the emulated accessory, or -1 if none */
+static int accessory_port = -1;
+/* Age of the entry the accessory sends back */
+static uint32_t accessory_age;
+
+/* Mock functions */
+
+void charge_manager_save_log(int port)
+{
+}
+
+uint16_t pd_get_identity_vid(int port)
+{
+	return port == accessory_port ? USB_VID_GOOGLE : 0;
+}
+
+int pd_fetch_acc_log_entry(int port)
+{
+	uint32_t payload[7];
+	struct ec_response_pd_log *r = (void *)&payload[1];
+
+	/* The accessory has a single entry */
+	payload[0] = VDO_SRC_RESPONDER;
+	r->timestamp = accessory_age;
+	r->type = PD_EVENT_ACC_RW_FAIL;
+	r->size_port = PD_LOG_PORT_SIZE(0, 0);
+	r->data = 0x1234;
+	pd_log_recv_vdm(port, 3, payload);
+	accessory_port = -1;
+
+	return EC_RES_SUCCESS;
+}
+
+/* Test utilities */
+
+static uint8_t response[64];
+
+/* Log an event whose payload is size bytes of value id */
+static void log_event(int id, int size)
+{
+	uint8_t payload[PD_LOG_SIZE_MASK];
+
+	memset(payload, id, size);
+	pd_log_event(PD_EVENT_MCU_BOARD_CUSTOM, PD_LOG_PORT_SIZE(1, size),
+		     id, payload);
+}
+
+/* Check that an entry is the one logged by log_event() */
+static int check_entry(const struct ec_response_pd_log *e, int id)
+{
+	int i;
+
+	if (e->type != PD_EVENT_MCU_BOARD_CUSTOM || e->data != id ||
+	    PD_LOG_PORT(e->size_port) != 1)
+		return 0;
+	for (i = 0; i < PD_LOG_SIZE(e->size_port); i++)
+		if (e->payload[i] != id)
+			return 0;
+	return 1;
+}
+
+/* Read the log in one response, return the number of entries */
+static int read_entries(void)
+{
+	struct ec_response_pd_log_entries *r = (void *)response;
+
+	if (test_send_host_command(EC_CMD_PD_GET_LOG_ENTRIES, 0, NULL, 0,
+				   response, sizeof(response)))
+		return -1;
+	return r->count;
+}
+
+/* Tests */
+
+static int test_bulk_drain(void)
+{
+	struct ec_response_pd_log_entries *r = (void *)response;
+	const struct ec_response_pd_log *e;
+	uint32_t age = 0xffffffff;
+	int id = 0, pages = 0;
+	int i, n;
+
+	for (i = 0; i < 12; i++)
+		log_event(i, i % 5);
+
+	/* The entries come back in order, packed in a few responses */
+	while ((n = read_entries()) > 0) {
+		e = (void *)r->entries;
+		for (i = 0; i < n; i++) {
+			TEST_ASSERT(check_entry(e, id++));
+			TEST_ASSERT(e->timestamp <= age);
+			age = e->timestamp;
+			e = (void *)(e->payload + PD_LOG_SIZE(e->size_port));
+		}
+		TEST_ASSERT(r->dropped == 0);
+		pages++;
+	}
+	TEST_ASSERT(n == 0);
+	TEST_ASSERT(id == 12);
+	TEST_ASSERT(pages < 12);
+
+	return EC_SUCCESS;
+}
+
+static int test_timestamps(void)
+{
+	struct ec_response_pd_log_entries *r = (void *)response;
+	const struct ec_response_pd_log *e;
+
+	/* A gap long enough for a multi-byte delta */
+	log_event(1, 0);
+	usleep(300 * MSEC);
+	log_event(2, 0);
+	usleep(100 * MSEC);
+
+	TEST_ASSERT(read_entries() == 2);
+	e = (void *)r->entries;
+	TEST_ASSERT(check_entry(e, 1));
+	TEST_ASSERT(e->timestamp >= 390 && e->timestamp < 500);
+	e++;
+	TEST_ASSERT(check_entry(e, 2));
+	TEST_ASSERT(e->timestamp >= 97 && e->timestamp < 150);
+
+	return EC_SUCCESS;
+}
+
+static int test_overflow(void)
+{
+	struct ec_response_pd_log_entries *r = (void *)response;
+	const struct ec_response_pd_log *e;
+	int id = -1, total = 0;
+	int dropped = 0;
+	int i, n;
+
+	/* Far more than the log holds */
+	for (i = 0; i < 100; i++)
+		log_event(i, 4);
+
+	/* Only the newest entries are left, and the loss is reported */
+	while ((n = read_entries()) > 0) {
+		e = (void *)r->entries;
+		if (id < 0)
+			id = e->data;
+		for (i = 0; i < n; i++) {
+			TEST_ASSERT(check_entry(e, id++));
+			e = (void *)(e->payload + PD_LOG_SIZE(e->size_port));
+		}
+		dropped += r->dropped;
+		total += n;
+	}
+	TEST_ASSERT(id == 100);
+	TEST_ASSERT(total > 10);
+	TEST_ASSERT(dropped + total == 100);
+
+	/* The count is cleared once read */
+	TEST_ASSERT(read_entries() == 0);
+	TEST_ASSERT(r->dropped == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_single_entry(void)
+{
+	struct ec_response_pd_log *e = (void *)response;
+
+	log_event(3, 2);
+	TEST_ASSERT(test_send_host_command(EC_CMD_PD_GET_LOG_ENTRY, 0,
+					   NULL, 0, response,
+					   sizeof(response)) == EC_RES_SUCCESS);
+	TEST_ASSERT(check_entry(e, 3));
+
+	TEST_ASSERT(test_send_host_command(EC_CMD_PD_GET_LOG_ENTRY, 0,
+					   NULL, 0, response,
+					   sizeof(response)) == EC_RES_SUCCESS);
+	TEST_ASSERT(e->type == PD_EVENT_NO_ENTRY);
+
+	return EC_SUCCESS;
+}
+
+static int test_accessory(void)
+{
+	struct ec_response_pd_log_entries *r = (void *)response;
+	const struct ec_response_pd_log *e;
+
+	/* The accessory entry is older than the last one in the log */
+	log_event(4, 0);
+	TEST_ASSERT(read_entries() == 1);
+
+	accessory_port = 1;
+	accessory_age = 5000;
+	TEST_ASSERT(read_entries() == 1);
+	e = (void *)r->entries;
+	TEST_ASSERT(e->type == PD_EVENT_ACC_RW_FAIL);
+	TEST_ASSERT(PD_LOG_PORT(e->size_port) == 1);
+	TEST_ASSERT(e->data == 0x1234);
+	TEST_ASSERT(e->timestamp >= 5000 && e->timestamp < 5050);
+
+	TEST_ASSERT(read_entries() == 0);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_bulk_drain);
+	RUN_TEST(test_timestamps);
+	RUN_TEST(test_overflow);
+	RUN_TEST(test_single_entry);
+	RUN_TEST(test_accessory);
+
+	test_print_result();
+}
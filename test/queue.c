@@ -15,6 +15,13 @@
 static struct queue const test_queue8 = QUEUE_NULL(8, char);
 static struct queue const test_queue2 = QUEUE_NULL(2, int16_t);
 
+/* Benchmark: bytes moved through a queue of BENCH_QUEUE_SIZE units */
+#define BENCH_QUEUE_SIZE 256
+#define BENCH_BLOCK 64
+#define BENCH_BYTES (256 * 1024)
+
+static struct queue const bench_queue = QUEUE_NULL(BENCH_QUEUE_SIZE, uint8_t);
+
 static int test_queue8_empty(void)
 {
 	char dummy = 1;
@@ -153,6 +160,162 @@ static int test_queue2_odd_even(void)
 	return EC_SUCCESS;
 }
 
+static int test_queue8_chunk(void)
+{
+	char buf1[5] = {1, 2, 3, 4, 5};
+	char buf2[5];
+	struct queue_chunk chunk;
+
+	queue_init(&test_queue8);
+
+	/* Empty queue: whole buffer writable, nothing readable */
+	chunk = queue_begin_read(&test_queue8);
+	TEST_ASSERT(chunk.length == 0 && chunk.buffer == NULL);
+	chunk = queue_begin_write(&test_queue8);
+	TEST_ASSERT(chunk.length == 8);
+
+	/* Fill in place, and read back through the copying interface */
+	memcpy(chunk.buffer, buf1, 5);
+	TEST_ASSERT(queue_commit_write(&test_queue8, 5) == 5);
+	TEST_ASSERT(queue_count(&test_queue8) == 5);
+	TEST_ASSERT(queue_remove_units(&test_queue8, buf2, 3) == 3);
+	TEST_ASSERT_ARRAY_EQ(buf1, buf2, 3);
+	/* 4, 5 */
+
+	/* Free space wraps: only the part up to the end is contiguous */
+	chunk = queue_begin_write(&test_queue8);
+	TEST_ASSERT(chunk.length == 3);
+	memcpy(chunk.buffer, buf1, 3);
+	TEST_ASSERT(queue_commit_write(&test_queue8, 3) == 3);
+	chunk = queue_begin_write(&test_queue8);
+	TEST_ASSERT(chunk.length == 3);
+	memcpy(chunk.buffer, buf1 + 3, 2);
+	TEST_ASSERT(queue_commit_write(&test_queue8, 2) == 2);
+	/* 4, 5, 1, 2, 3, 4, 5 */
+
+	/* Stored units wrap the same way when reading in place */
+	chunk = queue_begin_read(&test_queue8);
+	TEST_ASSERT(chunk.length == 5);
+	TEST_ASSERT_ARRAY_EQ((char *)chunk.buffer, buf1 + 3, 2);
+	TEST_ASSERT_ARRAY_EQ((char *)chunk.buffer + 2, buf1, 3);
+	TEST_ASSERT(queue_commit_read(&test_queue8, 5) == 5);
+	chunk = queue_begin_read(&test_queue8);
+	TEST_ASSERT(chunk.length == 2);
+	TEST_ASSERT_ARRAY_EQ((char *)chunk.buffer, buf1 + 3, 2);
+	TEST_ASSERT(queue_commit_read(&test_queue8, 2) == 2);
+	TEST_ASSERT(queue_is_empty(&test_queue8));
+
+	return EC_SUCCESS;
+}
+
+static int test_queue2_chunk_commit(void)
+{
+	struct queue_chunk chunk;
+
+	queue_init(&test_queue2);
+
+	/* Commits are clamped to the space or units available */
+	chunk = queue_begin_write(&test_queue2);
+	TEST_ASSERT(chunk.length == 2);
+	((int16_t *)chunk.buffer)[0] = 0x1234;
+	((int16_t *)chunk.buffer)[1] = -2;
+	TEST_ASSERT(queue_commit_write(&test_queue2, 3) == 2);
+	TEST_ASSERT(queue_space(&test_queue2) == 0);
+	chunk = queue_begin_write(&test_queue2);
+	TEST_ASSERT(chunk.length == 0 && chunk.buffer == NULL);
+
+	chunk = queue_begin_read(&test_queue2);
+	TEST_ASSERT(chunk.length == 2);
+	TEST_ASSERT(((int16_t *)chunk.buffer)[0] == 0x1234);
+	TEST_ASSERT(((int16_t *)chunk.buffer)[1] == -2);
+	TEST_ASSERT(queue_commit_read(&test_queue2, 1) == 1);
+	TEST_ASSERT(queue_commit_read(&test_queue2, 2) == 1);
+	TEST_ASSERT(queue_is_empty(&test_queue2));
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Benchmark producers generate bytes (as a peripheral would) and consumers
+ * checksum them.  Copy mode stages each block in a local buffer and copies it
+ * through the queue; span mode produces and consumes in the queue buffer.
+ */
+static void bench_fill(uint8_t *p, size_t n, uint8_t *seq)
+{
+	while (n--)
+		*p++ = (*seq)++;
+}
+
+static uint32_t bench_sum(const uint8_t *p, size_t n, uint32_t sum)
+{
+	while (n--)
+		sum = (sum << 1 | sum >> 31) ^ *p++;
+	return sum;
+}
+
+static uint32_t bench_copy(void)
+{
+	uint8_t block[BENCH_BLOCK];
+	uint8_t seq = 0;
+	uint32_t sum = 0;
+	size_t n, total;
+
+	queue_init(&bench_queue);
+	for (total = 0; total < BENCH_BYTES; total += BENCH_BLOCK) {
+		bench_fill(block, BENCH_BLOCK, &seq);
+		queue_add_units(&bench_queue, block, BENCH_BLOCK);
+		while ((n = queue_remove_units(&bench_queue, block,
+					       BENCH_BLOCK)))
+			sum = bench_sum(block, n, sum);
+	}
+
+	return sum;
+}
+
+static uint32_t bench_span(void)
+{
+	struct queue_chunk chunk;
+	uint8_t seq = 0;
+	uint32_t sum = 0;
+	size_t n, total;
+
+	queue_init(&bench_queue);
+	for (total = 0; total < BENCH_BYTES; total += BENCH_BLOCK) {
+		for (n = BENCH_BLOCK; n; n -= chunk.length) {
+			chunk = queue_begin_write(&bench_queue);
+			chunk.length = MIN(chunk.length, n);
+			bench_fill(chunk.buffer, chunk.length, &seq);
+			queue_commit_write(&bench_queue, chunk.length);
+		}
+		while ((chunk = queue_begin_read(&bench_queue)).length) {
+			sum = bench_sum(chunk.buffer, chunk.length, sum);
+			queue_commit_read(&bench_queue, chunk.length);
+		}
+	}
+
+	return sum;
+}
+
+static int test_queue_speed(void)
+{
+	timestamp_t t0, t1, t2;
+	uint32_t copy_sum, span_sum;
+
+	t0 = get_time();
+	copy_sum = bench_copy();
+	t1 = get_time();
+	span_sum = bench_span();
+	t2 = get_time();
+
+	TEST_ASSERT(copy_sum == span_sum);
+	ccprintf("\n  %d KB in %d B blocks: copy %d us, span %d us\n",
+		 BENCH_BYTES / 1024, BENCH_BLOCK, (int)(t1.val - t0.val),
+		 (int)(t2.val - t1.val));
+	cflush();
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	test_reset();
@@ -164,6 +327,9 @@ void run_test(void)
 	RUN_TEST(test_queue8_removal);
 	RUN_TEST(test_queue8_peek);
 	RUN_TEST(test_queue2_odd_even);
+	RUN_TEST(test_queue8_chunk);
+	RUN_TEST(test_queue2_chunk_commit);
+	RUN_TEST(test_queue_speed);
 
 	test_print_result();
 }
@@ -0,0 +1,78 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test RSA signature verification.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#if CONFIG_RSA_KEY_SIZE == 3072
+#include "rsa3072-f4.h"
+#else
+#include "rsa2048-f4.h"
+#endif
+
+#define BENCH_ITERATIONS 20
+
+static uint32_t rsa_workbuf[3 * RSANUMWORDS];
+static uint8_t digest[SHA256_DIGEST_SIZE];
+
+static int test_rsa_verify(void)
+{
+	uint8_t bad_sig[RSANUMBYTES];
+	uint8_t bad_digest[SHA256_DIGEST_SIZE];
+
+	TEST_ASSERT(rsa_verify(&pkey, sig, digest, rsa_workbuf));
+
+	/* A corrupted signature or digest must be rejected */
+	memcpy(bad_sig, sig, RSANUMBYTES);
+	bad_sig[RSANUMBYTES / 2] ^= 0x10;
+	TEST_ASSERT(!rsa_verify(&pkey, bad_sig, digest, rsa_workbuf));
+
+	memcpy(bad_digest, digest, SHA256_DIGEST_SIZE);
+	bad_digest[0] ^= 0x01;
+	TEST_ASSERT(!rsa_verify(&pkey, sig, bad_digest, rsa_workbuf));
+
+	return EC_SUCCESS;
+}
+
+static int test_rsa_speed(void)
+{
+	timestamp_t t0, t1;
+	int i, good = 1;
+
+	t0 = get_time();
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+		good &= rsa_verify(&pkey, sig, digest, rsa_workbuf);
+	t1 = get_time();
+
+	TEST_ASSERT(good);
+	ccprintf(" (%d-bit: %d us per verify)", CONFIG_RSA_KEY_SIZE,
+		 (int)((t1.val - t0.val) / BENCH_ITERATIONS));
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	struct sha256_ctx ctx;
+
+	test_reset();
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, (const uint8_t *)test_message,
+		      strlen(test_message));
+	memcpy(digest, SHA256_final(&ctx), SHA256_DIGEST_SIZE);
+
+	RUN_TEST(test_rsa_verify);
+	RUN_TEST(test_rsa_speed);
+
+	test_print_result();
+}
@@ -0,0 +1,76 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/*
+ * 2048-bit RSA test key (exponent F4) and a PKCS#1 v1.5 SHA-256 signature of
+ * test_message with the matching private key.
+ */
+
+#ifndef __CROS_EC_RSA2048_F4_H
+#define __CROS_EC_RSA2048_F4_H
+
+static const char test_message[] =
+	"The quick brown fox jumps over the lazy dog";
+
+static const struct rsa_public_key pkey = {
+	.n = {
+		0x05cbadf1, 0xb5dc3372, 0xcebb8029, 0x1ad4b588, 0x6aa63bf2,
+		0x667e87e8, 0x727f007a, 0x3236d837, 0xfa284918, 0x0b9390de,
+		0x4079e02d, 0xa95349a8, 0x0bfc31f4, 0x56968ffd, 0x2c45f8dd,
+		0x5053adf4, 0x86bf81fc, 0x37f6d111, 0x8a80345f, 0xde2e2db5,
+		0x8ea2b56a, 0xd42a20b9, 0xe654fd87, 0xede1df80, 0x8d0dff0a,
+		0xd40572b1, 0x79e74da4, 0x014167d2, 0x97f33e0c, 0xc5b3f474,
+		0xb7c0360c, 0x810f07e4, 0xbf3fbcbd, 0x8ad5ea42, 0xb57edc41,
+		0x7b3041f4, 0xfeec3f23, 0xd9f27d72, 0xd312522c, 0xc1a57a80,
+		0xe17b099a, 0x55869666, 0x27738520, 0xebf00486, 0xfeba0370,
+		0x15f0f460, 0xb003e0fe, 0xc6da73d0, 0xc4da7f01, 0x13625db8,
+		0xed1cc3a3, 0xee08345b, 0xf454573d, 0x0242d67b, 0xf5ff3288,
+		0xe5071fa8, 0xc11e5254, 0x7f3f59a5, 0x375176cb, 0x20108848,
+		0x1b15feb2, 0xa65a064b, 0xbf12d5a2, 0xc9efd5e2
+	},
+	.rr = {
+		0x484cb174, 0x1bd47b53, 0xa644732a, 0x9e17c8d5, 0x85431078,
+		0xc92c96e4, 0xc9e1986e, 0xc4b0c2ec, 0xd5ded20b, 0xc505f63c,
+		0x858016fd, 0xd7b7fed5, 0x7b5f063f, 0xd4911965, 0x350ea639,
+		0x2a1484bc, 0x19acf01a, 0x3d70a0c5, 0x02065a8d, 0x25e08c5d,
+		0x64fe1038, 0xc3a59ff8, 0x3560f011, 0xf8a8910c, 0x41049946,
+		0x46aafc95, 0x8f5b6b7d, 0xb2e764e7, 0xe4aad864, 0xbaa35f72,
+		0x3ef3db3c, 0xf17edead, 0xe4b2ddd3, 0xbe194270, 0xee1c1da5,
+		0x6e42f1d8, 0x0df87c52, 0x3ed42bed, 0xb78f959d, 0xa55d5a04,
+		0x2bed2115, 0xbf91808d, 0x44fcf66e, 0xbd6085e5, 0xa5e63b8c,
+		0x6b71ad92, 0xbd82e2e4, 0x1b126bd0, 0x34e67414, 0x8ed4afab,
+		0x743ba037, 0x6794e05e, 0xb55b8501, 0xe25e90f4, 0x6c70be66,
+		0xa5590aee, 0xdfbc821d, 0xa18ef59b, 0x40b34c04, 0x9f1718b0,
+		0xeb24e31d, 0x5bf2924e, 0xd8c94009, 0x7e64db4d
+	},
+	.n0inv = 0x6bb65cef
+};
+
+static const uint8_t sig[] = {
+	0x78, 0x52, 0x50, 0xfb, 0x9b, 0x68, 0xb0, 0x85, 0x64, 0x2e, 0x56, 0x3c,
+	0x7b, 0x04, 0xfc, 0xdb, 0x2a, 0x87, 0x88, 0x03, 0x8b, 0xa8, 0x47, 0x46,
+	0x2e, 0xec, 0x5a, 0x9f, 0x3d, 0xba, 0x7a, 0xf2, 0x99, 0x79, 0x57, 0x60,
+	0xcf, 0xe3, 0x37, 0x44, 0x11, 0x93, 0xbe, 0x95, 0xa9, 0x32, 0x3d, 0x93,
+	0xb8, 0x8a, 0x0b, 0x02, 0xe9, 0x9b, 0x7d, 0x1d, 0x16, 0x8f, 0xe8, 0xb2,
+	0x98, 0xcd, 0xec, 0x14, 0xf0, 0x94, 0x62, 0x57, 0x4d, 0x84, 0x5d, 0x40,
+	0xeb, 0x63, 0x52, 0x89, 0x94, 0x68, 0xc6, 0xa1, 0x87, 0xd4, 0x51, 0xc2,
+	0x47, 0x6c, 0x4f, 0x7d, 0x69, 0xa1, 0x1d, 0x8e, 0x4a, 0x80, 0xaa, 0xfe,
+	0xe0, 0x62, 0x2d, 0x51, 0xf1, 0x92, 0x32, 0x07, 0x5a, 0x3f, 0xf6, 0xd7,
+	0x31, 0xc7, 0xdc, 0x7d, 0x81, 0x8b, 0x57, 0xcf, 0xed, 0x6d, 0x1b, 0xa6,
+	0xa7, 0xa6, 0x0c, 0x5e, 0x9a, 0x54, 0xaa, 0x3d, 0x36, 0x27, 0xc9, 0x1f,
+	0x0a, 0x82, 0x36, 0x6e, 0x53, 0x29, 0xdf, 0x4d, 0x6d, 0x59, 0xbe, 0x0a,
+	0x60, 0x17, 0xa6, 0x21, 0x99, 0x75, 0xa4, 0xee, 0x98, 0x10, 0xbf, 0xf5,
+	0x38, 0x8f, 0x4a, 0xc1, 0x2e, 0xa3, 0x11, 0xb7, 0x43, 0x50, 0x73, 0x6c,
+	0x95, 0xf2, 0x29, 0xd1, 0x38, 0xb4, 0x6f, 0x50, 0xe9, 0x47, 0xeb, 0x7d,
+	0x81, 0x42, 0x6a, 0x77, 0x00, 0x39, 0x5b, 0x40, 0x65, 0x7c, 0x57, 0x20,
+	0x6b, 0xd3, 0x90, 0x51, 0x70, 0x52, 0x7c, 0xe9, 0x84, 0x4f, 0x41, 0xbb,
+	0x12, 0x2f, 0x99, 0x7b, 0x7d, 0xe8, 0x0b, 0xab, 0xba, 0x10, 0xf0, 0xa3,
+	0x60, 0x58, 0xfc, 0xb0, 0xff, 0xdf, 0x5a, 0x3f, 0x54, 0xc3, 0x8d, 0x87,
+	0x7f, 0x12, 0xa9, 0x23, 0xfb, 0x69, 0x04, 0xb6, 0x46, 0x54, 0x63, 0x5b,
+	0x13, 0x2f, 0xcc, 0x52, 0x7e, 0xec, 0xc3, 0xd6, 0x3b, 0x90, 0xb4, 0x5a,
+	0x6a, 0xd8, 0xa2, 0xb0
+};
+
+#endif /* __CROS_EC_RSA2048_F4_H */
@@ -0,0 +1,100 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/*
+ * 3072-bit RSA test key (exponent F4) and a PKCS#1 v1.5 SHA-256 signature of
+ * test_message with the matching private key.
+ */
+
+#ifndef __CROS_EC_RSA3072_F4_H
+#define __CROS_EC_RSA3072_F4_H
+
+static const char test_message[] =
+	"The quick brown fox jumps over the lazy dog";
+
+static const struct rsa_public_key pkey = {
+	.n = {
+		0xfed6c303, 0x85a9e7e8, 0x3d3b9413, 0x3c5525b0, 0x88c94eb1,
+		0xc67becbd, 0xd7779640, 0x145d6e98, 0x9e5bff20, 0xbfc51864,
+		0x4c857ca1, 0xdb0fff7d, 0x407741ba, 0x926b0f2b, 0x8bf5ac4e,
+		0x56616ebb, 0x72dc790f, 0xfca79e38, 0xe41f0c66, 0x31240878,
+		0xaebcc203, 0x38d38ae4, 0xbf9a18db, 0x2353392a, 0x88a3d456,
+		0x3d9eacc0, 0xd1448dbb, 0x5749db3c, 0x75e9bb8b, 0x800cc87c,
+		0x71a3b037, 0xd947d877, 0x0efde0d5, 0x25ea7621, 0x167c710a,
+		0x68d62a79, 0x88183b04, 0x818332eb, 0x93432943, 0xe6d0dd62,
+		0xfc62349d, 0xa9c8356b, 0x5bf72aac, 0xa396e299, 0x5522656a,
+		0x909852cf, 0xaad3759a, 0xc8fb2749, 0x39ec5aee, 0x6166f3f8,
+		0x192d0dd7, 0x1ee3cdaa, 0xc9397ad5, 0x01ad132c, 0xf5e572ed,
+		0x9a5e477f, 0xc5359465, 0x627d2b5b, 0x26cfba41, 0x83efe00c,
+		0x75902069, 0xbb27ff0e, 0x63295bd6, 0x3f21c113, 0x2651772e,
+		0xee79423e, 0x77d66718, 0xc90c7db8, 0xcda9de6a, 0x5d8185a6,
+		0x340c0781, 0x30d038d7, 0xa9f8e10d, 0xae9db5db, 0xe4f1a496,
+		0xef08e685, 0x9cd1f71c, 0xf1d43b96, 0xe71c46fd, 0x0370cf0a,
+		0x595321f8, 0x9d05e7b7, 0xcc6affc1, 0x94141f92, 0xebec13d4,
+		0xe4dcac73, 0xb1a39919, 0xa702d8a2, 0x09564f11, 0x7e702499,
+		0x591c7e85, 0xb1eeef20, 0xbcd22bc3, 0x231e48e8, 0x65ff1826,
+		0x942cbeda
+	},
+	.rr = {
+		0x8e8371ac, 0x5927ef01, 0x551934de, 0xbef3bc2a, 0xa035dd8a,
+		0x9eef4f11, 0x742866c9, 0x96f282de, 0x457240d3, 0x9ea69b28,
+		0x38553717, 0xe7cfad2a, 0x8a13386f, 0xfa2d6fd3, 0x7820985c,
+		0xecb09329, 0x0d94b465, 0x72a88927, 0x66b5c5ab, 0xc2eb7a10,
+		0xd0062c55, 0x01be840c, 0xdf830fbe, 0xbf372f8a, 0xf655be5c,
+		0xd3b5a914, 0xcc42ea37, 0x98257f85, 0x0fced18c, 0xf69f636a,
+		0x419f9fae, 0xc4b7c493, 0x9557af2c, 0x315ea417, 0x743650e9,
+		0x1b79dcac, 0xea1e233a, 0x17a6b645, 0xe5a52df5, 0x0bca5721,
+		0xad5e28c3, 0xe5beb373, 0xbe9ad997, 0xd369f2de, 0x2e4bd44c,
+		0xf62236d9, 0x3d25dbda, 0xdc6abf5b, 0x048244ed, 0x90dabcfd,
+		0xafc42dd4, 0xe8fd0331, 0xcc38defd, 0x0e3e5b71, 0x61cf9a18,
+		0x9a704a2d, 0x916455af, 0x69aa15a0, 0xfb9c0222, 0x1b2b5cf6,
+		0xb02c14ba, 0x86ac704c, 0xea62e270, 0x7adee176, 0x913964f3,
+		0x2f9ffaaa, 0xd5d985e5, 0x741157ca, 0x18c59f9d, 0xd55a481e,
+		0xe68848e0, 0x72c82169, 0x318b9ffc, 0xfe6a70a5, 0x4a13eff4,
+		0x2bac65d5, 0xec803754, 0x6ea7a6f5, 0xa4626875, 0x7ade6209,
+		0x9073cee0, 0x43222b25, 0xe00681fc, 0x480e180a, 0xb9c98110,
+		0xb290782c, 0xf03c72c1, 0xf96d89de, 0x040ab99d, 0x31faee00,
+		0xa9a63a01, 0x875982ab, 0x20e50f05, 0xbbf68e93, 0x162a885e,
+		0x75330f39
+	},
+	.n0inv = 0x0b25c055
+};
+
+static const uint8_t sig[] = {
+	0x61, 0x88, 0xd2, 0x02, 0xb3, 0x86, 0x10, 0x2f, 0xf1, 0x62, 0xed, 0x91,
+	0x49, 0x28, 0xa2, 0x53, 0x61, 0x29, 0xf7, 0x93, 0x85, 0x74, 0xff, 0x38,
+	0xcd, 0xb1, 0x75, 0x3e, 0xd3, 0x8f, 0xb0, 0xef, 0x47, 0x8e, 0xa0, 0x3f,
+	0xd8, 0x00, 0xa3, 0x6b, 0x02, 0xd8, 0x49, 0x89, 0xb9, 0xec, 0xce, 0x89,
+	0x4d, 0x03, 0x1f, 0x20, 0x6a, 0xde, 0xb9, 0xb0, 0xe9, 0x8e, 0x85, 0x11,
+	0x34, 0x3b, 0x55, 0x7e, 0x8a, 0x99, 0x66, 0xee, 0x11, 0x36, 0x53, 0xb4,
+	0x13, 0x9b, 0x2b, 0xc9, 0xd4, 0x82, 0xc8, 0x9a, 0x00, 0xd8, 0x3a, 0x9f,
+	0xc4, 0x93, 0x0f, 0xe6, 0x87, 0xf5, 0x06, 0x1f, 0xdd, 0x0c, 0x4c, 0xa1,
+	0x20, 0x81, 0xa3, 0xd9, 0x59, 0xc3, 0x9b, 0x53, 0x0d, 0x89, 0x89, 0x3f,
+	0xd3, 0xe5, 0x3b, 0x69, 0x83, 0xe3, 0xc1, 0x4b, 0x56, 0x80, 0xbe, 0xc8,
+	0xe4, 0x96, 0xa1, 0x3c, 0xe9, 0xda, 0x3a, 0xcb, 0x18, 0x4e, 0x61, 0x7b,
+	0xe3, 0xc9, 0x7d, 0x78, 0x6a, 0xc6, 0x4f, 0xb1, 0xd6, 0x3c, 0xff, 0x0f,
+	0x47, 0x96, 0xc4, 0x24, 0x92, 0xbf, 0xe0, 0xc3, 0xe0, 0x50, 0x16, 0x0b,
+	0xc8, 0x0b, 0x6b, 0xc6, 0x85, 0xd1, 0xfc, 0xef, 0xb0, 0x6e, 0xe8, 0x74,
+	0x39, 0x61, 0x99, 0xde, 0x9e, 0x75, 0x73, 0xa2, 0x8c, 0xb2, 0x8c, 0xdf,
+	0xc0, 0x2c, 0x86, 0xb7, 0x8e, 0xd8, 0x04, 0x2c, 0x84, 0xbb, 0xe0, 0x42,
+	0x1f, 0x7e, 0x9b, 0xf3, 0x28, 0x41, 0xd0, 0xf1, 0xa5, 0x8d, 0x23, 0x25,
+	0xda, 0x25, 0xa8, 0xc0, 0xb0, 0xd9, 0x25, 0x9a, 0x12, 0xc2, 0x78, 0xfb,
+	0x1f, 0xba, 0xd0, 0xfc, 0xf6, 0x0c, 0x21, 0xba, 0xb7, 0x74, 0xb9, 0x2b,
+	0xd7, 0x01, 0x0e, 0x45, 0x18, 0x36, 0x7a, 0x75, 0xce, 0xd5, 0x29, 0x33,
+	0x9a, 0xec, 0x48, 0xc0, 0xad, 0xba, 0xb5, 0x75, 0xfe, 0x64, 0xd8, 0xee,
+	0x18, 0xc1, 0x04, 0xe9, 0xaa, 0x75, 0x03, 0x56, 0x4e, 0x3d, 0x23, 0x9b,
+	0x1e, 0x03, 0x45, 0xe5, 0xe6, 0x8c, 0x1b, 0xab, 0xf0, 0xb8, 0x40, 0xc6,
+	0x15, 0xf8, 0x67, 0x58, 0x10, 0x4d, 0xb2, 0x75, 0x08, 0x50, 0x61, 0x10,
+	0xe3, 0x1a, 0xfb, 0x35, 0x3b, 0x3b, 0x7c, 0xa3, 0x64, 0xa2, 0x72, 0x7b,
+	0x72, 0x07, 0x47, 0x9a, 0x31, 0xab, 0x3c, 0xff, 0x8e, 0xec, 0x07, 0x2b,
+	0x87, 0x2c, 0xc3, 0x56, 0x2e, 0x9c, 0x76, 0x44, 0x3c, 0x4d, 0xdc, 0x97,
+	0x6d, 0xa7, 0xfa, 0x81, 0xff, 0x50, 0x37, 0x73, 0x19, 0x7b, 0x1a, 0x55,
+	0x2b, 0xb1, 0xf4, 0x22, 0x6e, 0x97, 0xa2, 0xa4, 0xac, 0xc9, 0xe3, 0x3e,
+	0x14, 0xfc, 0x38, 0x5e, 0x45, 0x12, 0xaa, 0x8e, 0xf0, 0x21, 0x17, 0xcd,
+	0x3c, 0xcb, 0xc7, 0xfe, 0xe9, 0x6a, 0x4e, 0xd0, 0x2e, 0x7f, 0x45, 0x52,
+	0x39, 0x56, 0x47, 0x1d, 0xc4, 0xed, 0x19, 0x02, 0x87, 0x7e, 0xdf, 0x91
+};
+
+#endif /* __CROS_EC_RSA3072_F4_H */
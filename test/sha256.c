@@ -0,0 +1,143 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test SHA-256 implementation.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "sha256.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define BENCH_SIZE (64 * 1024)
+#define BENCH_ITERATIONS 8
+
+static uint8_t buf[BENCH_SIZE + 4];
+
+/* FIPS 180-2 test vectors */
+static const uint8_t abc_digest[SHA256_DIGEST_SIZE] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+static const uint8_t two_block_digest[SHA256_DIGEST_SIZE] = {
+	0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+	0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+	0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+	0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1
+};
+
+static const uint8_t million_a_digest[SHA256_DIGEST_SIZE] = {
+	0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+	0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+	0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+	0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+};
+
+static int test_sha256_vectors(void)
+{
+	struct sha256_ctx ctx;
+	const char *two_block =
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	uint8_t *digest;
+	int i;
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, (const uint8_t *)"abc", 3);
+	digest = SHA256_final(&ctx);
+	TEST_ASSERT_ARRAY_EQ(digest, abc_digest, SHA256_DIGEST_SIZE);
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, (const uint8_t *)two_block, strlen(two_block));
+	digest = SHA256_final(&ctx);
+	TEST_ASSERT_ARRAY_EQ(digest, two_block_digest, SHA256_DIGEST_SIZE);
+
+	memset(buf, 'a', 1000);
+	SHA256_init(&ctx);
+	for (i = 0; i < 1000; i++)
+		SHA256_update(&ctx, buf, 1000);
+	digest = SHA256_final(&ctx);
+	TEST_ASSERT_ARRAY_EQ(digest, million_a_digest, SHA256_DIGEST_SIZE);
+
+	return EC_SUCCESS;
+}
+
+static int test_sha256_chunking(void)
+{
+	struct sha256_ctx ctx;
+	uint8_t expected[SHA256_DIGEST_SIZE];
+	uint8_t *digest;
+	int i, chunk, offset, len;
+
+	for (i = 0; i < 1024 + 4; i++)
+		buf[i] = (i * 13 + (i >> 5)) & 0xff;
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, buf, 1024);
+	memcpy(expected, SHA256_final(&ctx), SHA256_DIGEST_SIZE);
+
+	/*
+	 * Feeding the same data in pieces of any size, from an aligned or
+	 * misaligned source, must give the same digest.
+	 */
+	for (offset = 0; offset < 4; offset++) {
+		memmove(buf + offset, buf + (offset ? offset - 1 : 0), 1024);
+		for (chunk = 1; chunk <= 200; chunk += 9) {
+			SHA256_init(&ctx);
+			for (i = 0; i < 1024; i += len) {
+				len = MIN(chunk, 1024 - i);
+				SHA256_update(&ctx, buf + offset + i, len);
+			}
+			digest = SHA256_final(&ctx);
+			TEST_ASSERT_ARRAY_EQ(digest, expected,
+					     SHA256_DIGEST_SIZE);
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_sha256_speed(void)
+{
+	struct sha256_ctx ctx;
+	timestamp_t t0, t1;
+	uint64_t bytes = (uint64_t)BENCH_SIZE * BENCH_ITERATIONS;
+	int i, offset;
+
+	for (offset = 0; offset < 2; offset++) {
+		SHA256_init(&ctx);
+		t0 = get_time();
+		for (i = 0; i < BENCH_ITERATIONS; i++)
+			SHA256_update(&ctx, buf + offset, BENCH_SIZE);
+		SHA256_final(&ctx);
+		t1 = get_time();
+
+		ccprintf(" (%s: %d us, %d KB/s)", offset ? "unaligned" :
+			 "aligned", (int)(t1.val - t0.val),
+			 (int)(bytes * 1000000 / 1024 / (t1.val - t0.val + 1)));
+	}
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+#ifdef CONFIG_SHA256_UNROLLED
+	ccprintf("SHA-256 backend: unrolled\n");
+#else
+	ccprintf("SHA-256 backend: compact\n");
+#endif
+
+	RUN_TEST(test_sha256_vectors);
+	RUN_TEST(test_sha256_chunking);
+	RUN_TEST(test_sha256_speed);
+
+	test_print_result();
+}
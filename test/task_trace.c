@@ -0,0 +1,211 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test emulator task accounting and scheduling trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "console.h"
+#include "host_task.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+#define PING_COUNT 10
+
+static int pong_count;
+static int irq_pending;
+static char trace[32768];
+static char expect[64];
+
+int task_pong(void *data)
+{
+	while (1) {
+		task_wait_event(-1);
+		pong_count++;
+		task_wake(TASK_ID_TEST_RUNNER);
+	}
+
+	return EC_SUCCESS;
+}
+
+static void pong_isr(void)
+{
+	task_wake(TASK_ID_PONG);
+}
+
+void interrupt_generator(void)
+{
+	while (1) {
+		udelay(1000);
+		if (irq_pending) {
+			irq_pending = 0;
+			task_trigger_test_interrupt(pong_isr);
+		}
+	}
+}
+
+static void trace_clear(void)
+{
+	UART_INJECT("tasktrace clear\n");
+	msleep(50);
+}
+
+/* Save the trace and read it back into trace[] */
+static int trace_read(void)
+{
+	char path[] = "/tmp/ec_task_trace_XXXXXX";
+	FILE *f;
+	int fd, size;
+
+	fd = mkstemp(path);
+	TEST_ASSERT(fd >= 0);
+	f = fdopen(fd, "r");
+	TEST_ASSERT(f);
+
+	TEST_ASSERT(task_trace_save(path) == EC_SUCCESS);
+
+	size = fread(trace, 1, sizeof(trace) - 1, f);
+	fclose(f);
+	remove(path);
+
+	TEST_ASSERT(size > 0 && size < sizeof(trace) - 1);
+	trace[size] = '\0';
+
+	return EC_SUCCESS;
+}
+
+/* Return the first place sub appears in str, or NULL */
+static const char *find(const char *str, const char *sub)
+{
+	int len = strlen(sub);
+
+	for (; *str; str++)
+		if (!memcmp(str, sub, len))
+			return str;
+	return NULL;
+}
+
+/* Return the number of times sub appears in str */
+static int count(const char *str, const char *sub)
+{
+	int len = strlen(sub);
+	int n = 0;
+
+	for (; *str; str++)
+		if (!memcmp(str, sub, len))
+			n++;
+	return n;
+}
+
+static int ping(int times)
+{
+	int i;
+
+	for (i = 0; i < times; i++) {
+		task_wake(TASK_ID_PONG);
+		task_wait_event(-1);
+	}
+
+	return pong_count;
+}
+
+static int test_trace_switches(void)
+{
+	pong_count = 0;
+	trace_clear();
+
+	TEST_ASSERT(ping(PING_COUNT) == PING_COUNT);
+	TEST_ASSERT(trace_read() == EC_SUCCESS);
+
+	/* Each ping sets an event, and switches to and from the pong task */
+	snprintf(expect, sizeof(expect), "\"name\":\"set PONG\","
+		 "\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%d,",
+		 TASK_ID_TEST_RUNNER);
+	TEST_ASSERT(count(trace, expect) == PING_COUNT);
+	snprintf(expect, sizeof(expect), "\"name\":\"PONG\",\"ph\":\"B\","
+		 "\"pid\":0,\"tid\":%d,", TASK_ID_PONG);
+	TEST_ASSERT(count(trace, expect) == PING_COUNT);
+	snprintf(expect, sizeof(expect), "\"name\":\"PONG\",\"ph\":\"E\","
+		 "\"pid\":0,\"tid\":%d,", TASK_ID_PONG);
+	TEST_ASSERT(count(trace, expect) == PING_COUNT);
+	TEST_ASSERT(count(trace, "\"dropped\":0}") == 1);
+
+	return EC_SUCCESS;
+}
+
+static int test_trace_irq(void)
+{
+	pong_count = 0;
+	trace_clear();
+
+	irq_pending = 1;
+	while (!pong_count)
+		msleep(1);
+	TEST_ASSERT(trace_read() == EC_SUCCESS);
+
+	/* The event was set on the interrupt timeline */
+	TEST_ASSERT(count(trace, "\"name\":\"irq\",\"ph\":\"B\"") >= 1);
+	TEST_ASSERT(count(trace, "\"name\":\"irq\",\"ph\":\"B\"") ==
+		    count(trace, "\"name\":\"irq\",\"ph\":\"E\""));
+	snprintf(expect, sizeof(expect), "\"name\":\"set PONG\","
+		 "\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%d,",
+		 TASK_ID_COUNT);
+	TEST_ASSERT(count(trace, expect) == 1);
+
+	return EC_SUCCESS;
+}
+
+static int test_trace_wrap(void)
+{
+	trace_clear();
+
+	/* Overflow the buffer; the oldest entries are dropped */
+	ping(CONFIG_TASK_TRACE_SIZE);
+	TEST_ASSERT(trace_read() == EC_SUCCESS);
+
+	TEST_ASSERT(count(trace, "\"dropped\":0}") == 0);
+	TEST_ASSERT(count(trace, "\"ts\":") == CONFIG_TASK_TRACE_SIZE);
+
+	return EC_SUCCESS;
+}
+
+static int test_task_info(void)
+{
+	const char *out;
+	int runs;
+
+	cflush();
+	test_capture_console(1);
+	task_print_list();
+	cflush();
+	test_capture_console(0);
+	out = test_get_captured_console();
+
+	/* Pong was switched to once per ping */
+	snprintf(expect, sizeof(expect), "%4d   PONG ", TASK_ID_PONG);
+	out = find(out, expect);
+	TEST_ASSERT(out);
+	TEST_ASSERT(sscanf(out, "%*d %*s %*x %*s %d", &runs) == 1);
+	TEST_ASSERT(runs >= PING_COUNT + 1 + CONFIG_TASK_TRACE_SIZE);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_trace_switches);
+	RUN_TEST(test_trace_irq);
+	RUN_TEST(test_trace_wrap);
+	RUN_TEST(test_task_info);
+
+	test_print_result();
+}
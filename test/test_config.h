@@ -23,6 +23,30 @@
 #define CONFIG_BACKLIGHT_REQ_GPIO GPIO_PCH_BKLTEN
 #endif
 
+#ifdef TEST_BMI160_FIFO
+#define CONFIG_ACCELGYRO_BMI160
+#define CONFIG_ACCEL_FIFO 256
+#define I2C_PORT_ACCEL 0
+#endif
+
+#ifdef TEST_CONSOLE_BINLOG
+#define CONFIG_CONSOLE_BINARY_LOG
+#undef CONFIG_CONSOLE_BINARY_LOG_SIZE
+#define CONFIG_CONSOLE_BINARY_LOG_SIZE 256
+#endif
+
+#ifdef TEST_HOOKS
+#define CONFIG_HOOK_DEBUG
+#endif
+
+#ifdef TEST_HOST_COMMAND
+#define CONFIG_HOST_COMMAND_STATS
+#endif
+
+#ifdef TEST_I2C_BATCH
+#define CONFIG_I2C_QUEUE
+#endif
+
 #ifdef TEST_KB_8042
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #endif
@@ -41,6 +65,34 @@
 #define CONFIG_LID_ANGLE_SENSOR_LID 1
 #endif
 
+#ifdef TEST_MUTEX
+#define CONFIG_MUTEX_STATS
+#endif
+
+#ifdef TEST_RSA
+#define CONFIG_RSA
+#define CONFIG_SHA256
+#endif
+
+#ifdef TEST_RSA_OPTIMIZED
+#define CONFIG_RSA
+#define CONFIG_RSA_OPTIMIZED
+#define CONFIG_SHA256
+#endif
+
+#ifdef TEST_RSA3072
+#define CONFIG_RSA
+#define CONFIG_RSA_KEY_SIZE 3072
+#define CONFIG_RSA_OPTIMIZED
+#define CONFIG_SHA256
+#endif
+
+#ifdef TEST_RSA3072_UNOPTIMIZED
+#define CONFIG_RSA
+#define CONFIG_RSA_KEY_SIZE 3072
+#define CONFIG_SHA256
+#endif
+
 #ifdef TEST_SBS_CHARGING
 #define CONFIG_BATTERY_MOCK
 #define CONFIG_BATTERY_SMART
@@ -68,12 +120,36 @@ int board_discharge_on_ac(int enabled);
 #define I2C_PORT_CHARGER 1
 #endif
 
+#ifdef TEST_SHA256
+#define CONFIG_SHA256
+#endif
+
+#ifdef TEST_SHA256_UNROLLED
+#define CONFIG_SHA256
+#define CONFIG_SHA256_UNROLLED
+#endif
+
+#ifdef TEST_TASK_TRACE
+#define CONFIG_TASK_TRACE
+#undef CONFIG_TASK_TRACE_SIZE
+#define CONFIG_TASK_TRACE_SIZE 256
+#endif
+
 #ifdef TEST_THERMAL
 #define CONFIG_CHIPSET_CAN_THROTTLE
 #define CONFIG_FANS 1
 #define CONFIG_TEMP_SENSOR
 #endif
 
+#ifdef TEST_TIMER_HEAP
+#define CONFIG_SW_TIMER_COUNT 4
+#endif
+
+#ifdef TEST_CRC32
+#define CONFIG_SW_CRC
+#define CONFIG_SW_CRC_SLICE8
+#endif
+
 #ifdef TEST_FAN
 #define CONFIG_FANS 1
 #endif
@@ -107,6 +183,61 @@ int board_discharge_on_ac(int enabled);
 #define CONFIG_SW_CRC
 #endif
 
+#ifdef TEST_USB_PD_SINGLE_TASK
+#define CONFIG_USB_POWER_DELIVERY
+#define CONFIG_USB_PD_CUSTOM_VDM
+#define CONFIG_USB_PD_DUAL_ROLE
+#define CONFIG_USB_PD_PORT_COUNT 2
+#define CONFIG_USB_PD_SINGLE_TASK
+#define CONFIG_USB_PD_TCPC
+#define CONFIG_USB_PD_TCPM_STUB
+#define CONFIG_SHA256
+#define CONFIG_SW_CRC
+#endif
+
+#ifdef TEST_USB_PD_LOOPBACK
+#define CONFIG_USB_POWER_DELIVERY
+#define CONFIG_USB_PD_CUSTOM_VDM
+#define CONFIG_USB_PD_DUAL_ROLE
+#define CONFIG_USB_PD_PORT_COUNT 2
+#define CONFIG_USB_PD_TCPC
+#define CONFIG_USB_PD_TCPM_STUB
+#define CONFIG_USB_PD_TIMING
+#define CONFIG_SHA256
+#define CONFIG_SW_CRC
+#endif
+
+#ifdef TEST_USB_PD_LOOPBACK_SINGLE_TASK
+#define CONFIG_USB_POWER_DELIVERY
+#define CONFIG_USB_PD_CUSTOM_VDM
+#define CONFIG_USB_PD_DUAL_ROLE
+#define CONFIG_USB_PD_PORT_COUNT 2
+#define CONFIG_USB_PD_SINGLE_TASK
+#define CONFIG_USB_PD_TCPC
+#define CONFIG_USB_PD_TCPM_STUB
+#define CONFIG_USB_PD_TIMING
+#define CONFIG_SHA256
+#define CONFIG_SW_CRC
+#endif
+
+#ifdef TEST_USB_PD_RX
+#define CONFIG_USB_POWER_DELIVERY
+#define CONFIG_USB_PD_CUSTOM_VDM
+#define CONFIG_USB_PD_DUAL_ROLE
+#define CONFIG_USB_PD_PORT_COUNT 2
+#define CONFIG_USB_PD_RX_TABLE
+#define CONFIG_USB_PD_TCPC
+#define CONFIG_USB_PD_TCPM_STUB
+#define CONFIG_SHA256
+#define CONFIG_SW_CRC
+#endif
+
+#ifdef TEST_PD_LOG
+#define CONFIG_USB_PD_LOGGING
+#define CONFIG_USB_PD_LOG_SIZE 128
+#define CONFIG_USB_PD_PORT_COUNT 2
+#endif
+
 #ifdef TEST_CHARGE_MANAGER
 #define CONFIG_CHARGE_MANAGER
 #define CONFIG_USB_PD_DUAL_ROLE
@@ -0,0 +1,256 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the timer heap of common/timer.c against a simulated hardware timer.
+ */
+
+#include "common.h"
+#include "test_util.h"
+
+/*
+ * The emulator has a timer module of its own, so build the common one in
+ * here with its entry points renamed.  Waking tasks and triggering the timer
+ * interrupt are recorded by the test instead.
+ */
+#define get_time		heap_get_time
+#define force_time		heap_force_time
+#define usleep			heap_usleep
+#define udelay			heap_udelay
+#define timestamp_expired	heap_timestamp_expired
+#define timer_init		heap_timer_init
+#define timer_arm		heap_timer_arm
+#define timer_cancel		heap_timer_cancel
+#define timer_print_info	heap_timer_print_info
+#define process_timers		heap_process_timers
+#define sw_timer_alloc		heap_sw_timer_alloc
+#define sw_timer_arm		heap_sw_timer_arm
+#define sw_timer_cancel		heap_sw_timer_cancel
+#define task_set_event		heap_task_set_event
+#define task_trigger_irq	heap_task_trigger_irq
+#define task_get_event_bitmap	heap_task_get_event_bitmap
+#define __con_cmd_waitms	__con_cmd_heap_waitms
+#define __con_cmd_gettime	__con_cmd_heap_gettime
+
+#include "../common/timer.c"
+
+/* Simulated hardware timer */
+static uint32_t hw_clock;
+static uint32_t hw_event;
+static int irq_pending;
+
+/* Run once from the next clock read, like an interrupt preempting us */
+static void (*preempt)(void);
+
+/* Events set by expiring timers, for each task */
+static uint32_t events[TASK_ID_COUNT];
+
+uint32_t __hw_clock_source_read(void)
+{
+	void (*isr)(void) = preempt;
+
+	if (isr) {
+		preempt = NULL;
+		isr();
+	}
+	return hw_clock;
+}
+
+void __hw_clock_source_set(uint32_t ts)
+{
+	hw_clock = ts;
+}
+
+void __hw_clock_event_set(uint32_t deadline)
+{
+	hw_event = deadline;
+}
+
+uint32_t __hw_clock_event_get(void)
+{
+	return hw_event;
+}
+
+void __hw_clock_event_clear(void)
+{
+	hw_event = 0xffffffff;
+}
+
+int __hw_clock_source_init(uint32_t start_t)
+{
+	hw_clock = start_t;
+	return 0;
+}
+
+uint32_t heap_task_set_event(task_id_t tskid, uint32_t event, int wait)
+{
+	events[tskid] |= event;
+	return 0;
+}
+
+uint32_t *heap_task_get_event_bitmap(task_id_t tskid)
+{
+	return events + tskid;
+}
+
+void heap_task_trigger_irq(int irq)
+{
+	irq_pending = 1;
+}
+
+/* Move the clock and run the timer interrupt */
+static void run_until(uint32_t t)
+{
+	hw_clock = t;
+	irq_pending = 0;
+	heap_process_timers(0);
+}
+
+static timestamp_t at(uint32_t t)
+{
+	timestamp_t ts;
+
+	ts.val = t;
+	return ts;
+}
+
+static uint32_t read_events(void)
+{
+	uint32_t evt = events[TASK_ID_TEST_RUNNER];
+
+	events[TASK_ID_TEST_RUNNER] = 0;
+	return evt;
+}
+
+static int sw_timer[CONFIG_SW_TIMER_COUNT];
+
+/* Timer 0 re-armed later by an interrupt, once the heap has been updated */
+static void rearm_later(void)
+{
+	heap_sw_timer_cancel(sw_timer[0]);
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 500));
+}
+
+static void cancel(void)
+{
+	heap_sw_timer_cancel(sw_timer[0]);
+}
+
+static int test_alloc(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_SW_TIMER_COUNT; i++) {
+		sw_timer[i] = heap_sw_timer_alloc(TASK_ID_TEST_RUNNER,
+						  TASK_EVENT_CUSTOM(1 << i));
+		TEST_ASSERT(sw_timer[i] == TASK_ID_COUNT + i);
+	}
+	TEST_ASSERT(heap_sw_timer_alloc(TASK_ID_TEST_RUNNER, 1) == -1);
+
+	return EC_SUCCESS;
+}
+
+static int test_expire_in_order(void)
+{
+	heap_sw_timer_arm(sw_timer[2], at(hw_clock + 300));
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 100));
+	heap_sw_timer_arm(sw_timer[1], at(hw_clock + 200));
+	TEST_ASSERT(irq_pending);
+	run_until(hw_clock);
+	TEST_ASSERT(hw_event == hw_clock + 100);
+
+	run_until(hw_clock + 100);
+	TEST_ASSERT(read_events() == TASK_EVENT_CUSTOM(1));
+	TEST_ASSERT(hw_event == hw_clock + 100);
+	run_until(hw_clock + 200);
+	TEST_ASSERT(read_events() == (TASK_EVENT_CUSTOM(2) |
+				      TASK_EVENT_CUSTOM(4)));
+	TEST_ASSERT(hw_event == 0xffffffff);
+	TEST_ASSERT(!timer_heap_size);
+
+	return EC_SUCCESS;
+}
+
+static int test_cancel(void)
+{
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 100));
+	heap_sw_timer_arm(sw_timer[1], at(hw_clock + 200));
+	run_until(hw_clock);
+
+	heap_sw_timer_cancel(sw_timer[0]);
+	run_until(hw_clock + 150);
+	TEST_ASSERT(!read_events());
+	run_until(hw_clock + 50);
+	TEST_ASSERT(read_events() == TASK_EVENT_CUSTOM(2));
+	TEST_ASSERT(!timer_heap_size);
+
+	return EC_SUCCESS;
+}
+
+static int test_rearm(void)
+{
+	/* Move a running timer later, then earlier */
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 100));
+	run_until(hw_clock);
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 300));
+	run_until(hw_clock + 100);
+	TEST_ASSERT(!read_events());
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 50));
+	run_until(hw_clock + 50);
+	TEST_ASSERT(read_events() == TASK_EVENT_CUSTOM(1));
+	TEST_ASSERT(!timer_heap_size);
+
+	return EC_SUCCESS;
+}
+
+static int test_rearm_while_expiring(void)
+{
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 100));
+	run_until(hw_clock);
+
+	/*
+	 * The timer is due, and re-armed from an interrupt after the heap has
+	 * been brought up to date: the stale entry must not expire it.
+	 */
+	preempt = rearm_later;
+	run_until(hw_clock + 100);
+	TEST_ASSERT(!read_events());
+	TEST_ASSERT(timer_running & (1 << sw_timer[0]));
+	TEST_ASSERT(hw_event == hw_clock + 500);
+
+	run_until(hw_clock + 500);
+	TEST_ASSERT(read_events() == TASK_EVENT_CUSTOM(1));
+	TEST_ASSERT(!timer_heap_size);
+
+	return EC_SUCCESS;
+}
+
+static int test_cancel_while_expiring(void)
+{
+	heap_sw_timer_arm(sw_timer[0], at(hw_clock + 100));
+	run_until(hw_clock);
+
+	preempt = cancel;
+	run_until(hw_clock + 100);
+	TEST_ASSERT(!read_events());
+	TEST_ASSERT(!(timer_running & (1 << sw_timer[0])));
+	TEST_ASSERT(!timer_heap_size);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	heap_timer_init();
+
+	RUN_TEST(test_alloc);
+	RUN_TEST(test_expire_in_order);
+	RUN_TEST(test_cancel);
+	RUN_TEST(test_rearm);
+	RUN_TEST(test_rearm_while_expiring);
+	RUN_TEST(test_cancel_while_expiring);
+
+	test_print_result();
+}
@@ -0,0 +1,119 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test UART transmit buffering.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+/* Lines logged per benchmark, and between drains of the transmit buffer */
+#define BENCH_LINES 2000
+#define BENCH_BURST 8
+
+static const char *captured(void)
+{
+	cflush();
+	test_capture_console(0);
+	return test_get_captured_console();
+}
+
+static int test_uart_tx_newlines(void)
+{
+	const char *out;
+
+	test_capture_console(1);
+	cprintf(CC_SYSTEM, "a\nbc %d\n", 42);
+	cputs(CC_SYSTEM, "x\ny");
+	uart_putc('\n');
+	out = captured();
+	TEST_ASSERT(strlen(out) == 16);
+	TEST_ASSERT(memcmp(out, "a\r\nbc 42\r\nx\r\ny\r\n", 16) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_uart_tx_long(void)
+{
+	static char line[201];
+	const char *out;
+	int i;
+
+	for (i = 0; i < sizeof(line) - 1; i++)
+		line[i] = 'a' + i % 26;
+
+	test_capture_console(1);
+	uart_printf("%s\n", line);
+	out = captured();
+	TEST_ASSERT(strlen(out) == sizeof(line) + 1);
+	TEST_ASSERT(memcmp(out, line, sizeof(line) - 1) == 0);
+	TEST_ASSERT(memcmp(out + sizeof(line) - 1, "\r\n", 2) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_uart_tx_overflow(void)
+{
+	const char *out;
+	int i;
+
+	/* Without draining, output beyond the buffer size is dropped */
+	test_capture_console(1);
+	uart_disable_interrupt();
+	for (i = 0; i < CONFIG_UART_TX_BUF_SIZE / 10 + 1; i++)
+		uart_printf("%09d\n", i);
+	TEST_ASSERT(uart_puts("dropped") == EC_ERROR_OVERFLOW);
+	uart_enable_interrupt();
+	out = captured();
+
+	TEST_ASSERT(strlen(out) == CONFIG_UART_TX_BUF_SIZE - 1);
+	TEST_ASSERT(memcmp(out, "000000000\r\n000000001\r\n", 22) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_uart_tx_speed(void)
+{
+	timestamp_t t0;
+	uint64_t printf_time = 0, puts_time = 0;
+	int i, j;
+
+	for (i = 0; i < BENCH_LINES; i += BENCH_BURST) {
+		/* Only time adding output, not draining it */
+		uart_disable_interrupt();
+		t0 = get_time();
+		for (j = 0; j < BENCH_BURST / 2; j++)
+			uart_printf("[%T PD TCPC p%d state %d: %s]\n", 1, i + j,
+				    "SNK_DISCOVERY");
+		printf_time += get_time().val - t0.val;
+		t0 = get_time();
+		for (j = 0; j < BENCH_BURST / 2; j++)
+			uart_puts("Battery 100% / 8500 mAh, charging\n");
+		puts_time += get_time().val - t0.val;
+		uart_enable_interrupt();
+		cflush();
+	}
+
+	ccprintf("\n%d lines: printf %d us, puts %d us\n", BENCH_LINES,
+		 (int)printf_time, (int)puts_time);
+	cflush();
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_uart_tx_newlines);
+	RUN_TEST(test_uart_tx_long);
+	RUN_TEST(test_uart_tx_overflow);
+	RUN_TEST(test_uart_tx_speed);
+
+	test_print_result();
+}
@@ -156,7 +156,7 @@ static void unplug(int port)
 {
 	pd_port[port].has_vbus = 0;
 	pd_port[port].partner_role = -1;
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 	usleep(30 * MSEC);
 }
 
@@ -165,7 +165,7 @@ static int test_request(void)
 	uint32_t expected_rdo = RDO_FIXED(1, 900, 900, RDO_CAP_MISMATCH);
 
 	plug_in_source(0, 0);
-	task_wake(PD_PORT_TO_TASK_ID(0));
+	pd_task_set_event(0, TASK_EVENT_WAKE);
 	task_wait_event(2 * PD_T_CC_DEBOUNCE + 100 * MSEC);
 	TEST_ASSERT(pd_port[0].polarity == 0);
 
@@ -174,8 +174,8 @@ static int test_request(void)
 	task_wait_event(30 * MSEC);
 	TEST_ASSERT(verify_goodcrc(0, PD_ROLE_SINK, pd_port[0].msg_rx_id));
 
-	/* Wait for the power request */
-	task_wake(PD_PORT_TO_TASK_ID(0));
+	/* Let the TCPC finish the GoodCRC, then wait for the power request */
+	task_wake(TCPC_PORT_TO_TASK_ID(0));
 	task_wait_event(35 * MSEC); /* tSenderResponse: 24~30 ms */
 	inc_rx_id(0);
 
@@ -199,7 +199,7 @@ static int test_sink(void)
 	int i;
 
 	plug_in_sink(1, 1);
-	task_wake(PD_PORT_TO_TASK_ID(1));
+	pd_task_set_event(1, TASK_EVENT_WAKE);
 	task_wait_event(250 * MSEC); /* tTypeCSinkWaitCap: 210~250 ms */
 	TEST_ASSERT(pd_port[1].polarity == 1);
 
@@ -216,7 +216,7 @@ static int test_sink(void)
 
 	/* Looks good. Ack the source cap. */
 	simulate_goodcrc(1, PD_ROLE_SINK, pd_port[1].msg_tx_id);
-	task_wake(PD_PORT_TO_TASK_ID(1));
+	task_wake(TCPC_PORT_TO_TASK_ID(1));
 	usleep(30 * MSEC);
 	inc_tx_id(1);
 
@@ -0,0 +1,319 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Two PD ports negotiating with each other over the emulated loopback link.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_pd.h"
+#include "usb_pd_test_util.h"
+#include "util.h"
+
+/* Requests in the VDM burst and the data role swap storm */
+#define VDM_BURST 200
+#define SWAP_STORM 50
+
+/* Longest wait for one step of the protocol */
+#define STEP_TIMEOUT (500 * MSEC)
+
+static int cable_attached;
+static int host_mode[CONFIG_USB_PD_PORT_COUNT];
+
+/* Protocol events seen by the policy of each port */
+static int contracts;
+static int sink_port;
+static int data_swaps[CONFIG_USB_PD_PORT_COUNT];
+static int vdm_requests[CONFIG_USB_PD_PORT_COUNT];
+static int vdm_responses[CONFIG_USB_PD_PORT_COUNT];
+static uint32_t vdm_reply[CONFIG_USB_PD_PORT_COUNT];
+
+/* Mock functions */
+
+int pd_adc_read(int port, int cc)
+{
+	int partner_src = host_mode[port ^ 1];
+
+	/* The cable connects CC1 of both ports; CC2 stays open */
+	if (!cable_attached || cc)
+		return host_mode[port] ? 3000 : 0;
+
+	if (host_mode[port])
+		/* we pull up: Rd if the partner is a sink */
+		return partner_src ? 3000 : 400;
+
+	/* we pull down: Rp if the partner is a source */
+	return partner_src ? 1700 : 0;
+}
+
+int pd_snk_is_vbus_provided(int port)
+{
+	return cable_attached && host_mode[port ^ 1];
+}
+
+void pd_set_host_mode(int port, int enable)
+{
+	host_mode[port] = enable;
+}
+
+void pd_set_input_current_limit(int port, uint32_t max_ma,
+				uint32_t supply_voltage)
+{
+	if (max_ma) {
+		contracts++;
+		sink_port = port;
+	}
+}
+
+void pd_execute_data_swap(int port, int data_role)
+{
+	data_swaps[port]++;
+}
+
+int pd_custom_vdm(int port, int cnt, uint32_t *payload, uint32_t **rpayload)
+{
+	if (payload[0] & VDO_SRC_RESPONDER) {
+		vdm_responses[port]++;
+		return 0;
+	}
+
+	/* Answer each request with its own header */
+	vdm_requests[port]++;
+	vdm_reply[port] = payload[0] | VDO_SRC_RESPONDER;
+	*rpayload = &vdm_reply[port];
+	return 1;
+}
+
+/* Test utilities */
+
+/* Wait until *count reaches target; return non-zero on timeout */
+static int wait_count(const int *count, int target)
+{
+	uint64_t deadline = get_time().val + STEP_TIMEOUT;
+
+	while (*count < target) {
+		if (get_time().val > deadline)
+			return 1;
+		usleep(100);
+	}
+	return 0;
+}
+
+static void print_stats(const char *name, timestamp_t t0, int exchanges)
+{
+	struct pd_loopback_stats s[2];
+	int us = get_time().val - t0.val;
+	int msgs;
+
+	pd_test_loopback_stats(0, &s[0]);
+	pd_test_loopback_stats(1, &s[1]);
+	msgs = s[0].msgs + s[1].msgs;
+
+	ccprintf("\n  %s: %d in %d us, %d msg/s\n", name, exchanges, us,
+		 (int)(msgs * 1000000ull / MAX(us, 1)));
+	ccprintf("  port  msgs  dropped  retries  GoodCRC max us\n");
+	ccprintf("     0 %5d    %5d    %5d           %5d\n", s[0].msgs,
+		 s[0].dropped, s[0].retries, s[0].goodcrc_max_us);
+	ccprintf("     1 %5d    %5d    %5d           %5d\n", s[1].msgs,
+		 s[1].dropped, s[1].retries, s[1].goodcrc_max_us);
+	cflush();
+}
+
+/* Tests */
+
+static int test_contract(void)
+{
+	timestamp_t t0;
+
+	pd_test_loopback_clear_stats();
+	t0 = get_time();
+
+	/*
+	 * Both ports toggle between source and sink in step.  Hold port 1
+	 * suspended while port 0 starts, so that it comes back as a source
+	 * while port 0 is a sink, then plug the cable in.
+	 */
+	pd_set_suspend(1, 1);
+	pd_set_dual_role(PD_DRP_TOGGLE_ON);
+	usleep(PD_T_DRP_SNK / 2);
+	/* A suspended port ignores its events */
+	pd_task_set_event(1, TASK_EVENT_WAKE);
+	usleep(PD_T_DRP_SNK / 2);
+	TEST_ASSERT(!host_mode[1]);
+	pd_set_suspend(1, 0);
+	/* A resumed port waits for its next event before it starts toggling */
+	usleep(MSEC);
+	pd_task_set_event(1, TASK_EVENT_WAKE);
+	cable_attached = 1;
+
+	/* The sink takes power once the contract is in place */
+	TEST_ASSERT(!wait_count(&contracts, 1));
+	TEST_ASSERT(pd_get_role(sink_port) == PD_ROLE_SINK);
+	TEST_ASSERT(pd_get_role(sink_port ^ 1) == PD_ROLE_SOURCE);
+	TEST_ASSERT(pd_is_connected(0) && pd_is_connected(1));
+
+	print_stats("contract", t0, 1);
+	return EC_SUCCESS;
+}
+
+static int test_vdm_burst(void)
+{
+	timestamp_t t0;
+	int i, port, tries;
+
+	/* Let the discovery after the contract finish */
+	usleep(100 * MSEC);
+	pd_test_loopback_clear_stats();
+	t0 = get_time();
+
+	/*
+	 * Alternate the initiator; each request waits for its answer.  A
+	 * port has a single VDM slot, so a request queued while the policy
+	 * is still sending its own discovery VDMs can be replaced: send it
+	 * again if no answer comes back.
+	 */
+	for (i = 0; i < VDM_BURST; i++) {
+		port = i & 1;
+		for (tries = 0; tries < 3; tries++) {
+			pd_send_vdm(port, USB_VID_GOOGLE, VDO_CMD_VERSION,
+				    NULL, 0);
+			if (!wait_count(&vdm_responses[port], i / 2 + 1))
+				break;
+		}
+		TEST_ASSERT(tries < 3);
+	}
+	TEST_ASSERT(vdm_responses[0] == VDM_BURST / 2);
+	TEST_ASSERT(vdm_responses[1] == VDM_BURST / 2);
+	TEST_ASSERT(vdm_requests[0] >= VDM_BURST / 2);
+	TEST_ASSERT(vdm_requests[1] >= VDM_BURST / 2);
+
+	print_stats("VDM burst", t0, VDM_BURST);
+	return EC_SUCCESS;
+}
+
+static int test_swap_storm(void)
+{
+	timestamp_t t0;
+	int i;
+	/* The data role set on connection counts as a swap too */
+	int swaps0 = data_swaps[0], swaps1 = data_swaps[1];
+
+	pd_test_loopback_clear_stats();
+	t0 = get_time();
+
+	/* Either side may ask for the swap */
+	for (i = 0; i < SWAP_STORM; i++) {
+		pd_request_data_swap(i & 1);
+		TEST_ASSERT(!wait_count(&data_swaps[0], swaps0 + i + 1));
+		TEST_ASSERT(!wait_count(&data_swaps[1], swaps1 + i + 1));
+	}
+	TEST_ASSERT(pd_is_connected(0) && pd_is_connected(1));
+
+	print_stats("data role swaps", t0, SWAP_STORM);
+	return EC_SUCCESS;
+}
+
+/* Sum of the counts in the GoodCRC or the reply timing histogram */
+static int hist_total(const struct ec_response_usb_pd_timing *r, int reply)
+{
+	int i, total = 0;
+
+	for (i = 0; i < EC_USB_PD_TIMING_BUCKETS; i++)
+		total += reply ? r->rx_reply[i] : r->rx_goodcrc[i];
+	return total;
+}
+
+/* Read the timing of a port a few states at a time */
+static int read_timing(int port, int flags,
+		       struct ec_response_usb_pd_timing *r,
+		       struct ec_usb_pd_timing_state *states)
+{
+	struct ec_params_usb_pd_timing p;
+	uint8_t buf[sizeof(*r) + 4 * sizeof(r->states[0])];
+	struct ec_response_usb_pd_timing *page = (void *)buf;
+	int n = 0;
+
+	p.port = port;
+	p.flags = 0;
+	p.reserved = 0;
+	do {
+		p.state = n;
+		if (test_send_host_command(EC_CMD_USB_PD_TIMING, 0, &p,
+					   sizeof(p), buf, sizeof(buf)))
+			return 1;
+		memcpy(states + n, page->states,
+		       page->state_count * sizeof(page->states[0]));
+		n += page->state_count;
+	} while (page->state_count && n < page->state_total);
+	memcpy(r, page, sizeof(*r));
+
+	/* Reset once everything has been read */
+	if (flags) {
+		p.flags = flags;
+		if (test_send_host_command(EC_CMD_USB_PD_TIMING, 0, &p,
+					   sizeof(p), buf, sizeof(buf)))
+			return 1;
+	}
+	return n != PD_STATE_COUNT;
+}
+
+static int test_timing(void)
+{
+	struct ec_response_usb_pd_timing r;
+	struct ec_usb_pd_timing_state states[PD_STATE_COUNT];
+	int port;
+
+	for (port = 0; port < CONFIG_USB_PD_PORT_COUNT; port++) {
+		TEST_ASSERT(!read_timing(port, EC_USB_PD_TIMING_FLAG_RESET,
+					 &r, states));
+		TEST_ASSERT(r.state_total == PD_STATE_COUNT);
+
+		/* Every message of the storms was acknowledged */
+		TEST_ASSERT(hist_total(&r, 0) > SWAP_STORM);
+		TEST_ASSERT(r.rx_goodcrc_max_us > 0);
+		TEST_ASSERT(r.tx_errors == 0);
+
+		/* Each port answered swap requests and went back to ready */
+		TEST_ASSERT(hist_total(&r, 1) >= SWAP_STORM / 2);
+		TEST_ASSERT(states[PD_STATE_SRC_READY].entries +
+			    states[PD_STATE_SNK_READY].entries > 0);
+		TEST_ASSERT(states[PD_STATE_SRC_READY].total_ms +
+			    states[PD_STATE_SNK_READY].total_ms > 0);
+
+		/* The reset cleared everything */
+		TEST_ASSERT(!read_timing(port, 0, &r, states));
+		TEST_ASSERT(hist_total(&r, 0) == 0);
+		TEST_ASSERT(hist_total(&r, 1) == 0);
+		TEST_ASSERT(states[PD_STATE_SRC_READY].entries == 0);
+		TEST_ASSERT(states[PD_STATE_SNK_READY].entries == 0);
+	}
+
+	/* Out of range port */
+	r.state_total = 0;
+	TEST_ASSERT(read_timing(CONFIG_USB_PD_PORT_COUNT, 0, &r, states));
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	/* Keep the ports apart until the link is up */
+	pd_set_dual_role(PD_DRP_FORCE_SINK);
+	pd_test_loopback(1);
+	/* Let the PD task(s) bring the ports up */
+	usleep(10 * MSEC);
+
+	RUN_TEST(test_contract);
+	RUN_TEST(test_vdm_burst);
+	RUN_TEST(test_swap_storm);
+	RUN_TEST(test_timing);
+
+	test_print_result();
+}
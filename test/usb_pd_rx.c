@@ -0,0 +1,231 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test and benchmark the USB PD receive decoder.
+ */
+
+#include <time.h>
+
+#include "common.h"
+#include "console.h"
+#include "crc.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_pd.h"
+#include "usb_pd_test_util.h"
+#include "util.h"
+
+/* Messages decoded per benchmark */
+#define BENCH_MSGS 20000
+
+/* A PD message has up to 7 data objects */
+#define MAX_DATA_OBJECTS 7
+
+/* Times a port 0 decode is preempted by one on port 1 */
+#define PREEMPT_COUNT 100
+
+static const uint32_t test_payload[MAX_DATA_OBJECTS] = {
+	0x0801912c, 0x0002d0c8, 0x8004b064, 0x12345678, 0xdeadbeef,
+	0x00000000, 0xffffffff,
+};
+
+/* Port 1 decodes from an interrupt, while enabled */
+static volatile int preempt_rx;
+static volatile int preempt_count;
+static int preempt_error;
+static uint16_t preempt_header;
+
+/* Mock functions */
+
+int pd_adc_read(int port, int cc)
+{
+	/* Nothing attached */
+	return 0;
+}
+
+int pd_snk_is_vbus_provided(int port)
+{
+	return 0;
+}
+
+void pd_set_host_mode(int port, int enable)
+{
+}
+
+void pd_select_polarity(int port, int polarity)
+{
+}
+
+int pd_vdm(int port, int cnt, uint32_t *payload, uint32_t **rpayload)
+{
+	return 0;
+}
+
+/* Tests */
+
+/*
+ * Queue a message on the RX line of the port, optionally with one bit of
+ * the payload flipped after the CRC is computed.
+ */
+static void queue_rx_msg(int port, uint16_t header, int cnt,
+			 const uint32_t *data, uint32_t flip)
+{
+	int i;
+
+	pd_test_rx_msg_reset(port);
+	pd_test_rx_set_preamble(port, 1);
+	pd_test_rx_msg_append_sop(port);
+	pd_test_rx_msg_append_short(port, header);
+
+	crc32_init();
+	crc32_hash16(header);
+	for (i = 0; i < cnt; ++i) {
+		pd_test_rx_msg_append_word(port, data[i] ^ (i ? 0 : flip));
+		crc32_hash32(data[i]);
+	}
+	pd_test_rx_msg_append_word(port, crc32_result());
+
+	pd_test_rx_msg_append_eop(port);
+	pd_test_rx_msg_append_last_edge(port);
+
+	/* Decode straight from the test, instead of from the PD task */
+	pd_rx_start(port);
+}
+
+static int test_rx_decode(void)
+{
+	uint32_t payload[MAX_DATA_OBJECTS];
+	uint16_t header;
+	int cnt;
+
+	for (cnt = 0; cnt <= MAX_DATA_OBJECTS; cnt++) {
+		header = PD_HEADER(cnt ? PD_DATA_VENDOR_DEF : PD_CTRL_ACCEPT,
+				   PD_ROLE_SOURCE, PD_ROLE_DFP, cnt % 8, cnt);
+		queue_rx_msg(0, header, cnt, test_payload, 0);
+		memset(payload, 0, sizeof(payload));
+		TEST_ASSERT(pd_analyze_rx(0, payload) == header);
+		TEST_ASSERT_ARRAY_EQ(payload, test_payload, cnt);
+	}
+	pd_rx_complete(0);
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_crc_error(void)
+{
+	uint32_t payload[MAX_DATA_OBJECTS];
+	uint16_t header = PD_HEADER(PD_DATA_VENDOR_DEF, PD_ROLE_SOURCE,
+				    PD_ROLE_DFP, 0, 2);
+
+	queue_rx_msg(1, header, 2, test_payload, 1 << 9);
+	TEST_ASSERT(pd_analyze_rx(1, payload) == PD_RX_ERR_CRC);
+	pd_rx_complete(1);
+
+	return EC_SUCCESS;
+}
+
+static void rx_port1_isr(void)
+{
+	uint32_t payload[MAX_DATA_OBJECTS];
+
+	if (pd_analyze_rx(1, payload) != preempt_header ||
+	    memcmp(payload, test_payload + 4, 3 * sizeof(uint32_t)))
+		preempt_error = 1;
+	preempt_count++;
+}
+
+void interrupt_generator(void)
+{
+	/* Sleep on the host, so the decoder benchmark keeps the CPU */
+	const struct timespec period = { 0, 50000 };
+
+	while (1) {
+		nanosleep(&period, NULL);
+		if (preempt_rx && preempt_count < PREEMPT_COUNT)
+			task_trigger_test_interrupt(rx_port1_isr);
+	}
+}
+
+/*
+ * Decode on port 0 over and over while port 1 decodes from an interrupt,
+ * which lands anywhere in the port 0 decode, CRC included.  Each port must
+ * keep its own state.
+ */
+static int test_rx_ports_interleaved(void)
+{
+	uint32_t payload[MAX_DATA_OBJECTS];
+	uint16_t head0 = PD_HEADER(PD_DATA_VENDOR_DEF, PD_ROLE_SOURCE,
+				   PD_ROLE_DFP, 1, 7);
+	uint16_t head1 = PD_HEADER(PD_DATA_SOURCE_CAP, PD_ROLE_SOURCE,
+				   PD_ROLE_DFP, 2, 3);
+	timestamp_t deadline;
+
+	queue_rx_msg(0, head0, 7, test_payload, 0);
+	queue_rx_msg(1, head1, 3, test_payload + 4, 0);
+	preempt_header = head1;
+	preempt_count = 0;
+	preempt_error = 0;
+
+	deadline.val = get_time().val + 5 * SECOND;
+	preempt_rx = 1;
+	while (preempt_count < PREEMPT_COUNT &&
+	       !timestamp_expired(deadline, NULL)) {
+		TEST_ASSERT(pd_analyze_rx(0, payload) == head0);
+		TEST_ASSERT_ARRAY_EQ(payload, test_payload, 7);
+	}
+	preempt_rx = 0;
+	pd_rx_complete(0);
+	pd_rx_complete(1);
+
+	TEST_ASSERT(preempt_count == PREEMPT_COUNT);
+	TEST_ASSERT(!preempt_error);
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_speed(void)
+{
+	uint32_t payload[MAX_DATA_OBJECTS];
+	timestamp_t t0, t1;
+	uint16_t header;
+	int cnt, i, rv = 0;
+
+	ccprintf("\n");
+	for (cnt = 0; cnt <= MAX_DATA_OBJECTS; cnt += 7) {
+		header = PD_HEADER(cnt ? PD_DATA_VENDOR_DEF : PD_CTRL_GOOD_CRC,
+				   PD_ROLE_SOURCE, PD_ROLE_DFP, 0, cnt);
+		queue_rx_msg(0, header, cnt, test_payload, 0);
+
+		t0 = get_time();
+		for (i = 0; i < BENCH_MSGS; i++)
+			rv |= pd_analyze_rx(0, payload) ^ header;
+		t1 = get_time();
+
+		TEST_ASSERT(rv == 0);
+		ccprintf("  %d data objects: %5d ns/message\n", cnt,
+			 (int)((t1.val - t0.val) * 1000 / BENCH_MSGS));
+		cflush();
+	}
+	pd_rx_complete(0);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	/* Keep both ports unattached sinks, so they leave the PHY alone */
+	pd_set_dual_role(PD_DRP_FORCE_SINK);
+	/* Let the PD tasks initialize the PHY */
+	usleep(10 * MSEC);
+
+	RUN_TEST(test_rx_decode);
+	RUN_TEST(test_rx_crc_error);
+	RUN_TEST(test_rx_ports_interleaved);
+	RUN_TEST(test_rx_speed);
+
+	test_print_result();
+}
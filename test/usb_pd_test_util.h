@@ -9,6 +9,7 @@
 #define __TEST_USB_PD_TEST_UTIL_H
 
 /* Simulate Rx message */
+void pd_test_rx_msg_reset(int port);
 void pd_test_rx_set_preamble(int port, int has_preamble);
 void pd_test_rx_msg_append_bits(int port, uint32_t bits, int nb);
 void pd_test_rx_msg_append_kcode(int port, uint8_t kcode);
@@ -29,4 +30,20 @@ int pd_test_tx_msg_verify_short(int port, uint16_t val);
 int pd_test_tx_msg_verify_word(int port, uint32_t val);
 int pd_test_tx_msg_verify_crc(int port);
 
+/* Statistics of messages sent by a port over the loopback link */
+struct pd_loopback_stats {
+	uint32_t msgs;		/* Messages sent, GoodCRC included */
+	uint32_t dropped;	/* Messages the other port was not reading */
+	uint32_t retries;	/* Messages sent again with the same header */
+	int goodcrc_max_us;	/* Worst time from RX to sending GoodCRC */
+};
+
+/*
+ * Wire the TX of port 0 to the RX of port 1 and the other way round, so
+ * two PD tasks negotiate with each other instead of with the test.
+ */
+void pd_test_loopback(int enable);
+void pd_test_loopback_stats(int port, struct pd_loopback_stats *stats);
+void pd_test_loopback_clear_stats(void);
+
 #endif  /* __TEST_USB_PD_TEST_UTIL_H */
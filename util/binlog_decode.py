@@ -0,0 +1,280 @@
+#!/usr/bin/env python
+# Copyright 2015 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Binary console log decoder.
+
+Renders the output of the EC 'binlog dump' console command as the text the EC
+would have printed, using the ELF image the EC was built from to look up the
+format strings.  The input may contain other console output; only the lines
+written by 'binlog dump' are used.
+
+  Example:
+    util/binlog_decode.py build/samus_pd/RW/ec.RW.elf < console.log
+"""
+
+from __future__ import print_function
+import argparse
+import struct
+import sys
+
+ANCHOR_SYMBOL = 'dump_anchor'
+MAX_FORMAT = 1024
+ERROR_STR = 'ERROR'
+
+
+class Elf(object):
+  """Minimal little-endian ELF reader for loaded strings and symbols."""
+
+  def __init__(self, path):
+    with open(path, 'rb') as f:
+      self.data = f.read()
+    if self.data[:4] != b'\x7fELF':
+      raise ValueError('%s is not an ELF file' % path)
+    if self.data[4:5] == b'\x01':
+      self.is_64 = False
+      shoff, = struct.unpack_from('<I', self.data, 0x20)
+      shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2e)
+    else:
+      self.is_64 = True
+      shoff, = struct.unpack_from('<Q', self.data, 0x28)
+      shentsize, shnum = struct.unpack_from('<HH', self.data, 0x3a)
+
+    self.sections = []
+    for i in range(shnum):
+      off = shoff + i * shentsize
+      if self.is_64:
+        (_, sh_type, flags, addr, offset, size, link, _, _,
+         entsize) = struct.unpack_from('<IIQQQQIIQQ', self.data, off)
+      else:
+        (_, sh_type, flags, addr, offset, size, link, _, _,
+         entsize) = struct.unpack_from('<IIIIIIIIII', self.data, off)
+      self.sections.append((sh_type, flags, addr, offset, size, link,
+                            entsize))
+
+  def read_string(self, addr):
+    """Return the null-terminated string loaded at addr, or None."""
+    for sh_type, flags, base, offset, size, _, _ in self.sections:
+      # Allocated sections with file contents (not SHT_NOBITS)
+      if not flags & 2 or sh_type == 8:
+        continue
+      if base <= addr < base + size:
+        start = offset + addr - base
+        end = self.data.index(b'\0', start)
+        return self.data[start:end].decode('latin-1')
+    return None
+
+  def find_symbol(self, name):
+    """Return the value of the symbol called name, or None."""
+    for sh_type, _, _, offset, size, link, entsize in self.sections:
+      if sh_type != 2:  # SHT_SYMTAB
+        continue
+      strtab = self.sections[link][3]
+      for off in range(offset, offset + size, entsize):
+        if self.is_64:
+          st_name, = struct.unpack_from('<I', self.data, off)
+          value, = struct.unpack_from('<Q', self.data, off + 8)
+        else:
+          st_name, value = struct.unpack_from('<II', self.data, off)
+        end = self.data.index(b'\0', strtab + st_name)
+        if self.data[strtab + st_name:end].decode('latin-1') == name:
+          return value
+    return None
+
+
+class Args(object):
+  """Argument words of one record, consumed in format string order."""
+
+  def __init__(self, data):
+    self.data = data
+    self.pos = 0
+
+  def word(self):
+    if self.pos + 4 > len(self.data):
+      return 0
+    value, = struct.unpack_from('<I', self.data, self.pos)
+    self.pos += 4
+    return value
+
+  def signed(self):
+    value = self.word()
+    return value - (1 << 32) if value & 0x80000000 else value
+
+  def bytes(self, length):
+    value = self.data[self.pos:self.pos + length]
+    self.pos += (length + 3) & ~3
+    return value
+
+  def string(self):
+    end = self.data.find(b'\0', self.pos)
+    if end < 0:
+      end = len(self.data)
+    value = self.data[self.pos:end].decode('latin-1')
+    self.pos += (end - self.pos) // 4 * 4 + 4
+    return value
+
+
+def format_int(value, conv, is_64, precision):
+  """Convert an integer the way the EC vfnprintf() does."""
+  bits = 64 if is_64 else 32
+  negative = False
+  if conv == 'd' and value & (1 << (bits - 1)):
+    negative = True
+    value = (1 << bits) - value
+  base = {'x': 16, 'X': 16, 'p': 16, 'b': 2}.get(conv, 10)
+  precision = min(precision, 31)
+
+  digits = ''
+  for _ in range(precision):
+    digits = str(value % 10) + digits
+    value //= 10
+  if precision:
+    digits = '.' + digits
+  if not value:
+    digits = '0' + digits
+  while value:
+    digit = value % base
+    value //= base
+    if digit < 10:
+      digits = chr(ord('0') + digit) + digits
+    elif conv == 'X':
+      digits = chr(ord('A') + digit - 10) + digits
+    else:
+      digits = chr(ord('a') + digit - 10) + digits
+  if negative:
+    digits = '-' + digits
+  return digits
+
+
+def render(fmt, args, time_us):
+  """Render a format string and its recorded arguments as text."""
+  out = []
+  i = 0
+  while i < len(fmt):
+    c = fmt[i]
+    i += 1
+    if c != '%':
+      out.append(c)
+      continue
+
+    c = fmt[i] if i < len(fmt) else ''
+    i += 1
+    if c in ('%', ''):
+      out.append('%')
+      continue
+    if c == 'c':
+      out.append(chr(args.word() & 0xff))
+      continue
+
+    left = zero = False
+    if c == '-':
+      left = True
+      c, i = fmt[i:i + 1], i + 1
+    if c == '0':
+      zero = True
+      c, i = fmt[i:i + 1], i + 1
+
+    pad_width = 0
+    if c == '*':
+      pad_width = args.signed()
+      c, i = fmt[i:i + 1], i + 1
+    else:
+      while c.isdigit():
+        pad_width = pad_width * 10 + int(c)
+        c, i = fmt[i:i + 1], i + 1
+    if pad_width < 0 or pad_width > MAX_FORMAT:
+      out.append(ERROR_STR)
+      break
+
+    precision = 0
+    if c == '.':
+      c, i = fmt[i:i + 1], i + 1
+      if c == '*':
+        precision = args.signed()
+        c, i = fmt[i:i + 1], i + 1
+      else:
+        while c.isdigit():
+          precision = precision * 10 + int(c)
+          c, i = fmt[i:i + 1], i + 1
+      if precision < 0 or precision > MAX_FORMAT:
+        out.append(ERROR_STR)
+        break
+
+    if c == 's':
+      vstr = args.string()
+    elif c == 'h':
+      if not precision:
+        out.append(ERROR_STR)
+        break
+      out.append(''.join('%02x' % b for b in bytearray(args.bytes(precision))))
+      continue
+    else:
+      is_64 = False
+      if c == 'l':
+        is_64 = True
+        c, i = fmt[i:i + 1], i + 1
+      if c == 'T':
+        value, is_64, precision = time_us, True, 6
+      elif is_64:
+        value = args.word()
+        value |= args.word() << 32
+      else:
+        value = args.word()
+      if c not in 'duTxXpb' or not c:
+        out.append(ERROR_STR)
+        break
+      vstr = format_int(value, c, is_64, precision)
+      precision = 0
+
+    vlen = len(vstr)
+    if precision > 0 and pad_width > precision:
+      pad_width = precision
+    if not precision:
+      precision = max(vlen, pad_width)
+    if not left and vlen < pad_width:
+      out.append(('0' if zero else ' ') * (pad_width - vlen))
+    out.append(vstr[:precision])
+    if left and vlen < pad_width:
+      out.append(' ' * (pad_width - vlen))
+
+  return ''.join(out)
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+  parser.add_argument('elf', help='ELF image the EC was built from')
+  parser.add_argument('log', nargs='?', type=argparse.FileType('r'),
+                      default=sys.stdin,
+                      help="Console output of 'binlog dump' (default stdin)")
+  args = parser.parse_args()
+
+  elf = Elf(args.elf)
+  anchor = elf.find_symbol(ANCHOR_SYMBOL)
+  bias = 0
+
+  for line in args.log:
+    fields = line.split()
+    if not fields:
+      continue
+
+    # Position independent images may be loaded away from their link address
+    if fields[0] == 'BLANCHOR' and len(fields) == 2 and anchor is not None:
+      bias = (int(fields[1], 16) - anchor) & 0xffffffff
+      continue
+    if fields[0] != 'BL' or len(fields) not in (4, 5):
+      continue
+
+    addr = (int(fields[1], 16) - bias) & 0xffffffff
+    time_us = int(fields[2])
+    data = bytearray.fromhex(fields[4]) if len(fields) == 5 else bytearray()
+
+    fmt = elf.read_string(addr)
+    if fmt is None:
+      text = '<unknown format 0x%08x: %s>' % (addr, fields[4:])
+    else:
+      text = render(fmt, Args(bytes(data)), time_us)
+    print('[%s %s]' % (format_int(time_us, 'T', True, 6), text))
+
+
+if __name__ == '__main__':
+  main()
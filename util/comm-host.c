@@ -28,6 +28,7 @@ static int command_offset;
 int comm_init_dev(const char *device_name) __attribute__((weak));
 int comm_init_lpc(void) __attribute__((weak));
 int comm_init_i2c(void) __attribute__((weak));
+int comm_init_socket(void) __attribute__((weak));
 
 static int fake_readmem(int offset, int bytes, void *dest)
 {
@@ -104,6 +105,11 @@ int comm_init(int interfaces, const char *device_name)
 	if ((interfaces & COMM_I2C) && comm_init_i2c && !comm_init_i2c())
 		goto init_ok;
 
+	/* Fallback to the EC emulator */
+	if ((interfaces & COMM_SOCKET) && comm_init_socket &&
+	    !comm_init_socket())
+		goto init_ok;
+
 	/* Give up */
 	fprintf(stderr, "Unable to establish host communication\n");
 	return 1;
@@ -120,12 +126,16 @@ int comm_init(int interfaces, const char *device_name)
 	/* read max request / response size from ec for protocol v3+ */
 	if (ec_command(EC_CMD_GET_PROTOCOL_INFO, 0, NULL, 0, &info,
 		sizeof(info)) == sizeof(info)) {
-		if ((allow_large_buffer) ||
-		    (info.max_request_packet_size < ec_max_outsize))
-			ec_max_outsize = info.max_request_packet_size;
-		if ((allow_large_buffer) ||
-		    (info.max_request_packet_size < ec_max_insize))
-			ec_max_insize = info.max_response_packet_size;
+		/* Packet sizes include the request / response headers */
+		int outsize = info.max_request_packet_size -
+			sizeof(struct ec_host_request);
+		int insize = info.max_response_packet_size -
+			sizeof(struct ec_host_response);
+
+		if ((allow_large_buffer) || (outsize < ec_max_outsize))
+			ec_max_outsize = outsize;
+		if ((allow_large_buffer) || (insize < ec_max_insize))
+			ec_max_insize = insize;
 
 		ec_outbuf = realloc(ec_outbuf, ec_max_outsize);
 		ec_inbuf = realloc(ec_inbuf, ec_max_insize);
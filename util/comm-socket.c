@@ -0,0 +1,155 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Host command transport to the EC emulator, over the Unix socket named by
+ * EC_HOSTCMD_SOCKET (see chip/host/host_socket.c).
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "comm-host.h"
+#include "ec_commands.h"
+
+#define SOCKET_ENV "EC_HOSTCMD_SOCKET"
+
+/* Packet size to use until the EC reports its own */
+#define SOCKET_PACKET_SIZE 256
+
+static int fd = -1;
+
+/* Request and response packet buffers */
+static uint8_t *req_buf;
+static uint8_t *resp_buf;
+static int buf_size;
+
+static int ec_command_socket(int command, int version,
+			     const void *outdata, int outsize,
+			     void *indata, int insize)
+{
+	struct ec_host_request *rq;
+	struct ec_host_response *rs;
+	uint8_t csum = 0;
+	int req_len = sizeof(*rq) + outsize;
+	int size = MAX(sizeof(*rq) + ec_max_outsize,
+		       sizeof(*rs) + ec_max_insize);
+	int i, r;
+
+	/* Buffers grow when comm_init() learns the EC's max packet size */
+	if (buf_size < size) {
+		buf_size = size;
+		req_buf = realloc(req_buf, buf_size);
+		resp_buf = realloc(resp_buf, buf_size);
+		if (!req_buf || !resp_buf)
+			return -EC_RES_ERROR;
+	}
+
+	if (req_len > buf_size)
+		return -EC_RES_REQUEST_TRUNCATED;
+
+	/* Fill in request packet */
+	rq = (struct ec_host_request *)req_buf;
+	rq->struct_version = EC_HOST_REQUEST_VERSION;
+	rq->checksum = 0;
+	rq->command = command;
+	rq->command_version = version;
+	rq->reserved = 0;
+	rq->data_len = outsize;
+	memcpy(req_buf + sizeof(*rq), outdata, outsize);
+
+	/* Write checksum field so the entire packet sums to 0 */
+	for (i = 0; i < req_len; i++)
+		csum += req_buf[i];
+	rq->checksum = (uint8_t)(-csum);
+
+	if (send(fd, req_buf, req_len, 0) != req_len) {
+		fprintf(stderr, "Error sending to EC: %s\n", strerror(errno));
+		return -EC_RES_ERROR;
+	}
+
+	r = recv(fd, resp_buf, buf_size, 0);
+	if (r <= 0) {
+		fprintf(stderr, "No response from EC\n");
+		return -EC_RES_ERROR;
+	}
+
+	rs = (struct ec_host_response *)resp_buf;
+	if (r < sizeof(*rs) || r < sizeof(*rs) + rs->data_len) {
+		fprintf(stderr, "EC response truncated\n");
+		return -EC_RES_INVALID_RESPONSE;
+	}
+
+	if (rs->struct_version != EC_HOST_RESPONSE_VERSION) {
+		fprintf(stderr, "EC response version mismatch\n");
+		return -EC_RES_INVALID_RESPONSE;
+	}
+
+	if (rs->reserved) {
+		fprintf(stderr, "EC response reserved != 0\n");
+		return -EC_RES_INVALID_RESPONSE;
+	}
+
+	/* Verify checksum */
+	csum = 0;
+	for (i = 0; i < sizeof(*rs) + rs->data_len; i++)
+		csum += resp_buf[i];
+	if (csum) {
+		fprintf(stderr, "EC response has invalid checksum\n");
+		return -EC_RES_INVALID_CHECKSUM;
+	}
+
+	if (rs->result) {
+		fprintf(stderr, "EC returned error result code %d\n",
+			rs->result);
+		return -EECRESULT - rs->result;
+	}
+
+	if (rs->data_len > insize) {
+		fprintf(stderr, "EC returned too much data\n");
+		return -EC_RES_RESPONSE_TOO_BIG;
+	}
+
+	memcpy(indata, resp_buf + sizeof(*rs), rs->data_len);
+
+	/* Return actual amount of data received */
+	return rs->data_len;
+}
+
+int comm_init_socket(void)
+{
+	const char *path = getenv(SOCKET_ENV);
+	struct sockaddr_un addr;
+
+	if (!path || strlen(path) >= sizeof(addr.sun_path))
+		return 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (fd < 0)
+		return 2;
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		fd = -1;
+		return 3;
+	}
+
+	ec_command_proto = ec_command_socket;
+
+	/* Temporary sizes; comm_init() updates them from the EC */
+	ec_max_outsize = SOCKET_PACKET_SIZE - sizeof(struct ec_host_request);
+	ec_max_insize = SOCKET_PACKET_SIZE - sizeof(struct ec_host_response);
+
+	return 0;
+}
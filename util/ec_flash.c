@@ -8,9 +8,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "comm-host.h"
 #include "misc_util.h"
+#include "sha256.h"
+
+/*
+ * Each EC hash costs a host command round trip, so ec_flash_write_diff()
+ * compares at least this many bytes at a time, rounded up to a whole number
+ * of erase blocks.
+ */
+#define DIFF_BLOCK_MIN 4096
 
 int ec_flash_read(uint8_t *buf, int offset, int size)
 {
@@ -65,15 +75,16 @@ int ec_flash_verify(const uint8_t *buf, int offset, int size)
 	return 0;
 }
 
-int ec_flash_write(const uint8_t *buf, int offset, int size)
+/**
+ * Return the number of bytes to send per EC_CMD_FLASH_WRITE, or negative if
+ * error.  This is a multiple of the write block size which fits into the host
+ * parameter buffer.
+ */
+static int flash_write_step(const struct ec_response_flash_info *info)
 {
-	struct ec_params_flash_write *p =
-		(struct ec_params_flash_write *)ec_outbuf;
-	struct ec_response_flash_info info;
-	int pdata_max_size = (int)(ec_max_outsize - sizeof(*p));
+	int pdata_max_size = (int)(ec_max_outsize -
+				   sizeof(struct ec_params_flash_write));
 	int step;
-	int rv;
-	int i;
 
 	/*
 	 * Determine whether we can use version 1 of the command with more
@@ -82,24 +93,26 @@ int ec_flash_write(const uint8_t *buf, int offset, int size)
 	if (!ec_cmd_version_supported(EC_CMD_FLASH_WRITE, EC_VER_FLASH_WRITE))
 		pdata_max_size = EC_FLASH_WRITE_VER0_SIZE;
 
-	/*
-	 * Determine step size.  This must be a multiple of the write block
-	 * size, and must also fit into the host parameter buffer.
-	 */
-	rv = ec_command(EC_CMD_FLASH_INFO, 0, NULL, 0, &info, sizeof(info));
-	if (rv < 0)
-		return rv;
-
-	step = (pdata_max_size / info.write_block_size) * info.write_block_size;
+	step = (pdata_max_size / info->write_block_size) *
+		info->write_block_size;
 
 	if (!step) {
 		fprintf(stderr, "Write block size %d > max param size %d\n",
-			info.write_block_size, pdata_max_size);
+			info->write_block_size, pdata_max_size);
 		return -1;
 	}
 
-	/* Write data in chunks */
-	printf("Write size %d...\n", step);
+	return step;
+}
+
+/* Write data in chunks of step bytes */
+static int flash_write_chunks(const uint8_t *buf, int offset, int size,
+			      int step)
+{
+	struct ec_params_flash_write *p =
+		(struct ec_params_flash_write *)ec_outbuf;
+	int rv;
+	int i;
 
 	for (i = 0; i < size; i += step) {
 		p->offset = offset + i;
@@ -116,6 +129,26 @@ int ec_flash_write(const uint8_t *buf, int offset, int size)
 	return 0;
 }
 
+int ec_flash_write(const uint8_t *buf, int offset, int size)
+{
+	struct ec_response_flash_info info;
+	int step;
+	int rv;
+
+	rv = ec_command(EC_CMD_FLASH_INFO, 0, NULL, 0, &info, sizeof(info));
+	if (rv < 0)
+		return rv;
+
+	step = flash_write_step(&info);
+	if (step < 0)
+		return step;
+
+	/* Write data in chunks */
+	printf("Write size %d...\n", step);
+
+	return flash_write_chunks(buf, offset, size, step);
+}
+
 int ec_flash_erase(int offset, int size)
 {
 	struct ec_params_flash_erase p;
@@ -125,3 +158,216 @@ int ec_flash_erase(int offset, int size)
 
 	return ec_command(EC_CMD_FLASH_ERASE, 0, &p, sizeof(p), NULL, 0);
 }
+
+/**
+ * Stop any hash the EC is computing, such as the one of RW it starts at boot,
+ * so that it will accept a new hash request.
+ *
+ * @return 0 if success, negative if error.
+ */
+static int flash_hash_stop(void)
+{
+	struct ec_params_vboot_hash p;
+	struct ec_response_vboot_hash r;
+	int tries;
+	int rv;
+
+	memset(&p, 0, sizeof(p));
+	for (tries = 0; tries < 100; tries++) {
+		p.cmd = EC_VBOOT_HASH_GET;
+		rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+		if (r.status != EC_VBOOT_HASH_STATUS_BUSY)
+			return 0;
+
+		/* Takes effect when the EC hashes its next chunk */
+		p.cmd = EC_VBOOT_HASH_ABORT;
+		rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p), NULL, 0);
+		if (rv < 0)
+			return rv;
+		usleep(10000);
+	}
+
+	fprintf(stderr, "EC hash did not stop\n");
+	return -1;
+}
+
+int ec_flash_hash(uint8_t *digest, int offset, int size)
+{
+	struct ec_params_vboot_hash p;
+	struct ec_response_vboot_hash r;
+	int rv;
+
+	memset(&p, 0, sizeof(p));
+	p.cmd = EC_VBOOT_HASH_RECALC;
+	p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	p.offset = offset;
+	p.size = size;
+
+	rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p), &r, sizeof(r));
+	if (rv < 0)
+		return rv;
+
+	if (r.status != EC_VBOOT_HASH_STATUS_DONE ||
+	    r.hash_type != EC_VBOOT_HASH_TYPE_SHA256 ||
+	    r.digest_size != SHA256_DIGEST_SIZE ||
+	    r.offset != offset || r.size != size) {
+		fprintf(stderr, "EC hash of offset %d failed (status %d)\n",
+			offset, r.status);
+		return -1;
+	}
+
+	memcpy(digest, r.hash_digest, SHA256_DIGEST_SIZE);
+	return 0;
+}
+
+/**
+ * Compare buf with EC flash at offset, using a hash computed by the EC.
+ *
+ * @return 1 if they match, 0 if they differ, negative if error.
+ */
+static int flash_hash_matches(const uint8_t *buf, int offset, int size)
+{
+	struct sha256_ctx ctx;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	int rv;
+
+	rv = ec_flash_hash(digest, offset, size);
+	if (rv < 0)
+		return rv;
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, buf, size);
+
+	return !memcmp(SHA256_final(&ctx), digest, SHA256_DIGEST_SIZE);
+}
+
+int ec_flash_verify_hash(const uint8_t *buf, int offset, int size)
+{
+	int rv;
+
+	rv = flash_hash_stop();
+	if (rv < 0)
+		return rv;
+
+	rv = flash_hash_matches(buf, offset, size);
+	if (rv < 0)
+		return rv;
+	if (!rv) {
+		fprintf(stderr, "Hash mismatch at offset %d size %d\n",
+			offset, size);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Return the current time in seconds */
+static double flash_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int ec_flash_write_diff(const uint8_t *buf, int offset, int size)
+{
+	struct ec_response_flash_info info;
+	uint8_t *block;
+	int block_size, erase_size;
+	int blocks, changed = 0, written = 0;
+	int step;
+	int rv;
+	int i, n;
+	double start, elapsed;
+
+	rv = ec_command(EC_CMD_FLASH_INFO, 0, NULL, 0, &info, sizeof(info));
+	if (rv < 0)
+		return rv;
+
+	if (!info.erase_block_size || offset % info.erase_block_size) {
+		fprintf(stderr, "Offset %d is not a multiple of the erase "
+			"block size %d\n", offset, info.erase_block_size);
+		return -1;
+	}
+	block_size = ((DIFF_BLOCK_MIN + info.erase_block_size - 1) /
+		      info.erase_block_size) * info.erase_block_size;
+
+	step = flash_write_step(&info);
+	if (step < 0)
+		return step;
+
+	block = malloc(block_size);
+	if (!block) {
+		fprintf(stderr, "Unable to allocate buffer.\n");
+		return -1;
+	}
+
+	rv = flash_hash_stop();
+	if (rv < 0)
+		goto exit;
+
+	blocks = (size + block_size - 1) / block_size;
+	start = flash_time();
+
+	for (i = 0; i < size; i += block_size) {
+		n = MIN(size - i, block_size);
+
+		printf("\rBlock %d/%d, %d changed", i / block_size + 1,
+		       blocks, changed);
+		fflush(stdout);
+
+		rv = flash_hash_matches(buf + i, offset + i, n);
+		if (rv < 0)
+			goto exit;
+		if (rv)
+			continue;
+
+		/*
+		 * The image may end part way into an erase block.  Keep
+		 * whatever follows it in that erase block across the erase.
+		 */
+		erase_size = ((n + info.erase_block_size - 1) /
+			      info.erase_block_size) * info.erase_block_size;
+		memcpy(block, buf + i, n);
+		if (n < erase_size) {
+			rv = ec_flash_read(block + n, offset + i + n,
+					   erase_size - n);
+			if (rv < 0)
+				goto exit;
+		}
+
+		rv = ec_flash_erase(offset + i, erase_size);
+		if (rv < 0) {
+			fprintf(stderr, "\nErase error at offset %d\n", i);
+			goto exit;
+		}
+
+		rv = flash_write_chunks(block, offset + i, erase_size, step);
+		if (rv < 0)
+			goto exit;
+
+		changed++;
+		written += erase_size;
+	}
+
+	printf("\rBlock %d/%d, %d changed\n", blocks, blocks, changed);
+
+	/* Verify the whole image with one hash instead of reading it back */
+	printf("Verifying...\n");
+	rv = ec_flash_verify_hash(buf, offset, size);
+	if (rv < 0)
+		goto exit;
+
+	elapsed = flash_time() - start;
+	printf("Wrote %d of %d blocks (%d bytes) in %.3f s, %.0f B/s "
+	       "effective\n", changed, blocks, written, elapsed,
+	       elapsed > 0 ? size / elapsed : 0);
+
+exit:
+	free(block);
+	return rv;
+}
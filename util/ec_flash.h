@@ -49,4 +49,46 @@ int ec_flash_write(const uint8_t *buf, int offset, int size);
  */
 int ec_flash_erase(int offset, int size);
 
+/**
+ * Have the EC compute the SHA-256 digest of part of its flash
+ *
+ * Fails if the EC is still computing an earlier hash.
+ *
+ * @param digest	Destination for the SHA256_DIGEST_SIZE byte digest
+ * @param offset	Offset in EC flash to hash
+ * @param size		Number of bytes to hash
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_hash(uint8_t *digest, int offset, int size);
+
+/**
+ * Verify EC flash memory against a hash computed by the EC
+ *
+ * Unlike ec_flash_verify(), this does not read the flash back to the host.
+ *
+ * @param buf		Source buffer to verify against EC flash
+ * @param offset	Offset in EC flash to check
+ * @param size		Number of bytes to check
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_verify_hash(const uint8_t *buf, int offset, int size);
+
+/**
+ * Update EC flash memory, writing only the erase blocks which differ
+ *
+ * Each erase block is compared with the EC's hash of it; blocks which match
+ * are skipped, others are erased and rewritten.  The result is verified with
+ * ec_flash_verify_hash().  Progress and throughput are printed to stdout.
+ *
+ * @param buf		Source buffer
+ * @param offset	Offset in EC flash to write; must be a multiple of
+ *			the erase block size
+ * @param size		Number of bytes to write
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_write_diff(const uint8_t *buf, int offset, int size);
+
 #endif
@@ -55,6 +55,8 @@ const char help_str[] =
 	"      Cut off battery output power\n"
 	"  batteryparam\n"
 	"      Read or write board-specific battery parameter\n"
+	"  bench [count [size...]]\n"
+	"      Measure host command latency and throughput\n"
 	"  boardversion\n"
 	"      Prints the board version\n"
 	"  chargecurrentlimit\n"
@@ -67,6 +69,8 @@ const char help_str[] =
 	"      Handle commands related to charge state v2 (and later)\n"
 	"  chipinfo\n"
 	"      Prints chip info\n"
+	"  cmdstats [reset]\n"
+	"      Prints host command counters and handler run times\n"
 	"  cmdversions <cmd>\n"
 	"      Prints supported version mask for a command number\n"
 	"  console\n"
@@ -105,6 +109,8 @@ const char help_str[] =
 	"      Prints or sets EC flash protection state\n"
 	"  flashread <offset> <size> <outfile>\n"
 	"      Reads from EC flash to a file\n"
+	"  flashupdate <offset> <infile>\n"
+	"      Writes only the EC flash erase blocks which differ from a file\n"
 	"  flashwrite <offset> <infile>\n"
 	"      Writes to EC flash from a file\n"
 	"  forcelidopen <enable>\n"
@@ -145,6 +151,8 @@ const char help_str[] =
 	"      Prints the PD event log entries\n"
 	"  pdwritelog <type> <port>\n"
 	"      Writes a PD event log of the given <type>\n"
+	"  pdtiming <port> [reset]\n"
+	"      Prints the USB-PD protocol timing histograms of <port>\n"
 	"  pdgetmode <port>\n"
 	"      Get All USB-PD alternate SVIDs and modes on <port>\n"
 	"  pdsetmode <port> <svid> <opos>\n"
@@ -248,7 +256,7 @@ int parse_bool(const char *s, int *dest)
 
 void print_help(const char *prog, int print_cmds)
 {
-	printf("Usage: %s [--dev=n] [--interface=dev|lpc|i2c] ", prog);
+	printf("Usage: %s [--dev=n] [--interface=dev|lpc|i2c|socket] ", prog);
 	printf("[--name=cros_ec|cros_sh|cros_pd] <command> [params]\n\n");
 	if (print_cmds)
 		puts(help_str);
@@ -370,6 +378,160 @@ int cmd_test(int argc, char *argv[])
 	return rv;
 }
 
+/* Default number of commands sent for each payload size by cmd_bench() */
+#define BENCH_COUNT 1000
+
+static int compare_uint32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static uint32_t bench_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Send one benchmark command carrying size bytes of payload each way.
+ *
+ * Size 0 sends EC_CMD_HELLO.  Otherwise EC_CMD_TEST_PROTOCOL is sent with size
+ * bytes after its fixed parameters; the EC returns size bytes, the first of
+ * which echo the request.  The payload must already be in ec_outbuf.
+ *
+ * @return the number of bytes sent and received, or negative on error.
+ */
+static int bench_command(int size)
+{
+	struct ec_params_test_protocol *p = ec_outbuf;
+	struct ec_response_test_protocol *r = ec_inbuf;
+	struct ec_params_hello hp;
+	struct ec_response_hello hr;
+	int header = __builtin_offsetof(struct ec_params_test_protocol, buf);
+	int rv;
+
+	if (!size) {
+		hp.in_data = 0xa0b0c0d0;
+		rv = ec_command(EC_CMD_HELLO, 0, &hp, sizeof(hp),
+				&hr, sizeof(hr));
+		if (rv < 0)
+			return rv;
+		if (hr.out_data != 0xa1b2c3d4)
+			return -EC_RES_INVALID_RESPONSE;
+		return sizeof(hp) + sizeof(hr);
+	}
+
+	p->ec_result = EC_RES_SUCCESS;
+	p->ret_len = size;
+	rv = ec_command(EC_CMD_TEST_PROTOCOL, 0, p, header + size,
+			ec_inbuf, ec_max_insize);
+	if (rv < 0)
+		return rv;
+	if (rv != size || memcmp(r->buf, p->buf, MIN(size, sizeof(r->buf))))
+		return -EC_RES_INVALID_RESPONSE;
+	return header + size + rv;
+}
+
+int cmd_bench(int argc, char *argv[])
+{
+	int header = __builtin_offsetof(struct ec_params_test_protocol, buf);
+	uint8_t *payload = (uint8_t *)ec_outbuf + header;
+	int max_size = MIN(ec_max_outsize - header, ec_max_insize);
+	int count = BENCH_COUNT;
+	int sizes[16];
+	int num_sizes = 0;
+	int parse_error = 0;
+	uint32_t *lat;
+	uint32_t start, t, total;
+	uint64_t bytes;
+	int errors, retries, done;
+	int i, n, rv;
+	char *e;
+
+	if (argc > 1) {
+		count = strtol(argv[1], &e, 0);
+		if ((e && *e) || count <= 0)
+			parse_error = 1;
+	}
+	for (i = 2; i < argc && !parse_error; i++) {
+		n = strtol(argv[i], &e, 0);
+		if ((e && *e) || n < 0 || n > max_size ||
+		    num_sizes == ARRAY_SIZE(sizes))
+			parse_error = 1;
+		else
+			sizes[num_sizes++] = n;
+	}
+	if (parse_error) {
+		fprintf(stderr, "Usage: %s [count [size...]]\n"
+			"  size is 0 to %d bytes\n", argv[0], max_size);
+		return -1;
+	}
+
+	/* Default to a range of sizes up to the largest the interface takes */
+	if (!num_sizes) {
+		sizes[num_sizes++] = 0;
+		for (n = 16; n < max_size; n *= 4)
+			sizes[num_sizes++] = n;
+		sizes[num_sizes++] = max_size;
+	}
+
+	lat = malloc(count * sizeof(*lat));
+	if (!lat) {
+		fprintf(stderr, "Unable to allocate buffer.\n");
+		return -1;
+	}
+
+	for (n = 0; n < max_size; n++)
+		payload[n] = n;
+
+	printf("%d commands per size, max request %d bytes, "
+	       "max response %d bytes\n", count, ec_max_outsize,
+	       ec_max_insize);
+	printf(" Size  Errors Retries  p50 us  p99 us  max us       B/s\n");
+
+	for (i = 0; i < num_sizes; i++) {
+		errors = retries = done = 0;
+		bytes = 0;
+
+		start = bench_time_us();
+		for (n = 0; n < count; n++) {
+			t = bench_time_us();
+			rv = bench_command(sizes[i]);
+			if (rv < 0) {
+				/* Resend once, as a driver would */
+				retries++;
+				rv = bench_command(sizes[i]);
+			}
+			if (rv < 0) {
+				errors++;
+				continue;
+			}
+			lat[done++] = bench_time_us() - t;
+			bytes += rv;
+		}
+		total = bench_time_us() - start;
+
+		if (!done) {
+			printf("%5d %7d %7d       -       -       -         0\n",
+			       sizes[i], errors, retries);
+			continue;
+		}
+
+		qsort(lat, done, sizeof(*lat), compare_uint32);
+		printf("%5d %7d %7d %7u %7u %7u %9" PRIu64 "\n", sizes[i],
+		       errors, retries, lat[done / 2], lat[done * 99 / 100],
+		       lat[done - 1],
+		       total ? bytes * 1000000 / total : (uint64_t)0);
+	}
+
+	free(lat);
+	return 0;
+}
+
 int cmd_s5(int argc, char *argv[])
 {
 	struct ec_params_get_set_value p;
@@ -480,6 +642,51 @@ int cmd_cmdversions(int argc, char *argv[])
 	return 0;
 }
 
+int cmd_cmd_stats(int argc, char *argv[])
+{
+	struct ec_params_get_cmd_stats p;
+	struct ec_response_get_cmd_stats *r = ec_inbuf;
+	const struct ec_cmd_stats_entry *e;
+	int index = 0;
+	int i, rv;
+
+	if (argc > 2 || (argc == 2 && strcasecmp(argv[1], "reset"))) {
+		fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+		return -1;
+	}
+
+	printf("Command   Count  Errors  Max us  Avg us\n");
+	do {
+		p.index = index;
+		p.flags = 0;
+		rv = ec_command(EC_CMD_GET_CMD_STATS, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+
+		for (i = 0; i < r->count; i++) {
+			e = r->entries + i;
+			if (!e->count)
+				continue;
+			printf("0x%04x %8u %7u %7u %7u\n", e->command,
+			       e->count, e->errors, e->max_us, e->avg_us);
+		}
+		index += r->count;
+	} while (r->count && index < r->total);
+
+	/* Only clear the counters once they have all been read */
+	if (argc == 2) {
+		p.index = index;
+		p.flags = EC_CMD_STATS_FLAG_RESET;
+		rv = ec_command(EC_CMD_GET_CMD_STATS, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+	}
+
+	return 0;
+}
+
 int cmd_version(int argc, char *argv[])
 {
 	struct ec_response_get_version r;
@@ -749,6 +956,43 @@ int cmd_flash_write(int argc, char *argv[])
 	return 0;
 }
 
+int cmd_flash_update(int argc, char *argv[])
+{
+	int offset, size;
+	int rv;
+	char *e;
+	char *buf;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <offset> <filename>\n", argv[0]);
+		return -1;
+	}
+
+	offset = strtol(argv[1], &e, 0);
+	if ((e && *e) || offset < 0 || offset > 0x100000) {
+		fprintf(stderr, "Bad offset.\n");
+		return -1;
+	}
+
+	/* Read the input file */
+	buf = read_file(argv[2], &size);
+	if (!buf)
+		return -1;
+
+	printf("Updating %d bytes at offset %d...\n", size, offset);
+
+	/* Erase and write the blocks which differ, then verify */
+	rv = ec_flash_write_diff(buf, offset, size);
+
+	free(buf);
+
+	if (rv < 0)
+		return rv;
+
+	printf("done.\n");
+	return 0;
+}
+
 int cmd_flash_erase(int argc, char *argv[])
 {
 	int offset, size;
@@ -6177,20 +6421,115 @@ int cmd_charge_port_override(int argc, char *argv[])
 	return 0;
 }
 
+static void print_pd_log_entry(const struct ec_response_pd_log *r,
+			       time_t now)
+{
+	struct mcdp_info minfo;
+	struct ec_response_usb_pd_power_info pinfo;
+	unsigned long long milliseconds;
+	unsigned seconds;
+	struct tm ltime;
+	char time_str[64];
+
+	/* the timestamp is in 1024th of seconds */
+	milliseconds = ((uint64_t)r->timestamp <<
+				 PD_LOG_TIMESTAMP_SHIFT) / 1000;
+	/* the timestamp is the number of milliseconds in the past */
+	seconds = (milliseconds + 999) / 1000;
+	milliseconds -= seconds * 1000;
+	now -= seconds;
+	localtime_r(&now, &ltime);
+	strftime(time_str, sizeof(time_str), "%F %T", &ltime);
+	printf("%s.%03lld P%d ", time_str, -milliseconds,
+		PD_LOG_PORT(r->size_port));
+	if (r->type == PD_EVENT_MCU_CHARGE) {
+		if (r->data & CHARGE_FLAGS_OVERRIDE)
+			printf("override ");
+		if (r->data & CHARGE_FLAGS_DELAYED_OVERRIDE)
+			printf("pending_override ");
+		memcpy(&pinfo.meas, r->payload,
+			sizeof(struct usb_chg_measures));
+		pinfo.dualrole = !!(r->data & CHARGE_FLAGS_DUAL_ROLE);
+		pinfo.role = r->data & CHARGE_FLAGS_ROLE_MASK;
+		pinfo.type = (r->data & CHARGE_FLAGS_TYPE_MASK)
+				>> CHARGE_FLAGS_TYPE_SHIFT;
+		pinfo.max_power = 0;
+		print_pd_power_info(&pinfo);
+	} else if (r->type == PD_EVENT_MCU_CONNECT) {
+		printf("New connection\n");
+	} else if (r->type == PD_EVENT_MCU_BOARD_CUSTOM) {
+		printf("Board-custom event\n");
+	} else if (r->type == PD_EVENT_ACC_RW_FAIL) {
+		printf("RW signature check failed\n");
+	} else if (r->type == PD_EVENT_PS_FAULT) {
+		static const char * const fault_names[] = {
+			"---", "OCP", "fast OCP", "OVP", "Discharge"
+		};
+		const char *fault = r->data < ARRAY_SIZE(fault_names) ?
+				fault_names[r->data] : "???";
+		printf("Power supply fault: %s\n", fault);
+	} else if (r->type == PD_EVENT_VIDEO_DP_MODE) {
+		printf("DP mode %sabled\n", (r->data == 1) ?
+		       "en" : "dis");
+	} else if (r->type == PD_EVENT_VIDEO_CODEC) {
+		memcpy(&minfo, r->payload,
+		       sizeof(struct mcdp_info));
+		printf("HDMI info: family:%04x chipid:%04x "
+		       "irom:%d.%d.%d fw:%d.%d.%d\n",
+		       MCDP_FAMILY(minfo.family),
+		       MCDP_CHIPID(minfo.chipid),
+		       minfo.irom.major, minfo.irom.minor,
+		       minfo.irom.build, minfo.fw.major,
+		       minfo.fw.minor, minfo.fw.build);
+	} else { /* Unknown type */
+		int i;
+		printf("Event %02x (%04x) [", r->type, r->data);
+		for (i = 0; i < PD_LOG_SIZE(r->size_port); i++)
+			printf("%02x ", r->payload[i]);
+		printf("]\n");
+	}
+}
+
+/* Read the log many entries at a time */
+static int cmd_pd_log_entries(void)
+{
+	struct ec_response_pd_log_entries *r = ec_inbuf;
+	const struct ec_response_pd_log *e;
+	time_t now;
+	int i, rv;
+
+	do {
+		now = time(NULL);
+		rv = ec_command(EC_CMD_PD_GET_LOG_ENTRIES, 0,
+				NULL, 0, ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+
+		if (r->dropped)
+			printf("--- %d ENTRIES LOST ---\n", r->dropped);
+		e = (const void *)r->entries;
+		for (i = 0; i < r->count; i++) {
+			print_pd_log_entry(e, now);
+			e = (const void *)(e->payload +
+					   PD_LOG_SIZE(e->size_port));
+		}
+	} while (r->count);
+
+	printf("--- END OF LOG ---\n");
+	return 0;
+}
+
 int cmd_pd_log(int argc, char *argv[])
 {
 	union {
 		struct ec_response_pd_log r;
 		uint32_t words[8]; /* space for the payload */
 	} u;
-	struct mcdp_info minfo;
-	struct ec_response_usb_pd_power_info pinfo;
 	int rv;
-	unsigned long long milliseconds;
-	unsigned seconds;
 	time_t now;
-	struct tm ltime;
-	char time_str[64];
+
+	if (ec_cmd_version_supported(EC_CMD_PD_GET_LOG_ENTRIES, 0))
+		return cmd_pd_log_entries();
 
 	while (1) {
 		now = time(NULL);
@@ -6204,63 +6543,7 @@ int cmd_pd_log(int argc, char *argv[])
 			break;
 		}
 
-		/* the timestamp is in 1024th of seconds */
-		milliseconds = ((uint64_t)u.r.timestamp <<
-					 PD_LOG_TIMESTAMP_SHIFT) / 1000;
-		/* the timestamp is the number of milliseconds in the past */
-		seconds = (milliseconds + 999) / 1000;
-		milliseconds -= seconds * 1000;
-		now -= seconds;
-		localtime_r(&now, &ltime);
-		strftime(time_str, sizeof(time_str), "%F %T", &ltime);
-		printf("%s.%03lld P%d ", time_str, -milliseconds,
-			PD_LOG_PORT(u.r.size_port));
-		if (u.r.type == PD_EVENT_MCU_CHARGE) {
-			if (u.r.data & CHARGE_FLAGS_OVERRIDE)
-				printf("override ");
-			if (u.r.data & CHARGE_FLAGS_DELAYED_OVERRIDE)
-				printf("pending_override ");
-			memcpy(&pinfo.meas, u.r.payload,
-				sizeof(struct usb_chg_measures));
-			pinfo.dualrole = !!(u.r.data & CHARGE_FLAGS_DUAL_ROLE);
-			pinfo.role = u.r.data & CHARGE_FLAGS_ROLE_MASK;
-			pinfo.type = (u.r.data & CHARGE_FLAGS_TYPE_MASK)
-					>> CHARGE_FLAGS_TYPE_SHIFT;
-			pinfo.max_power = 0;
-			print_pd_power_info(&pinfo);
-		} else if (u.r.type == PD_EVENT_MCU_CONNECT) {
-			printf("New connection\n");
-		} else if (u.r.type == PD_EVENT_MCU_BOARD_CUSTOM) {
-			printf("Board-custom event\n");
-		} else if (u.r.type == PD_EVENT_ACC_RW_FAIL) {
-			printf("RW signature check failed\n");
-		} else if (u.r.type == PD_EVENT_PS_FAULT) {
-			static const char * const fault_names[] = {
-				"---", "OCP", "fast OCP", "OVP", "Discharge"
-			};
-			const char *fault = u.r.data < ARRAY_SIZE(fault_names) ?
-					fault_names[u.r.data] : "???";
-			printf("Power supply fault: %s\n", fault);
-		} else if (u.r.type == PD_EVENT_VIDEO_DP_MODE) {
-			printf("DP mode %sabled\n", (u.r.data == 1) ?
-			       "en" : "dis");
-		} else if (u.r.type == PD_EVENT_VIDEO_CODEC) {
-			memcpy(&minfo, u.r.payload,
-			       sizeof(struct mcdp_info));
-			printf("HDMI info: family:%04x chipid:%04x "
-			       "irom:%d.%d.%d fw:%d.%d.%d\n",
-			       MCDP_FAMILY(minfo.family),
-			       MCDP_CHIPID(minfo.chipid),
-			       minfo.irom.major, minfo.irom.minor,
-			       minfo.irom.build, minfo.fw.major,
-			       minfo.fw.minor, minfo.fw.build);
-		} else { /* Unknown type */
-			int i;
-			printf("Event %02x (%04x) [", u.r.type, u.r.data);
-			for (i = 0; i < PD_LOG_SIZE(u.r.size_port); i++)
-				printf("%02x ", u.r.payload[i]);
-			printf("]\n");
-		}
+		print_pd_log_entry(&u.r, now);
 	}
 
 	return 0;
@@ -6296,6 +6579,94 @@ int cmd_pd_write_log(int argc, char *argv[])
 	return ec_command(EC_CMD_PD_WRITE_LOG_ENTRY, 0, &p, sizeof(p), NULL, 0);
 }
 
+static void print_pd_timing_hist(const char *name, const uint16_t *hist,
+				 uint32_t max_us)
+{
+	int i;
+
+	printf("%s (max %u us):\n", name, max_us);
+	for (i = 0; i < EC_USB_PD_TIMING_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		/* The first and last buckets are open-ended */
+		if (i == 0)
+			printf("  %7s<%u us: %u\n", "", 16, hist[i]);
+		else if (i == EC_USB_PD_TIMING_BUCKETS - 1)
+			printf("  %6s>=%u us: %u\n", "", 8 << i, hist[i]);
+		else
+			printf("  %7u-%u us: %u\n", 8 << i, (16 << i) - 1,
+			       hist[i]);
+	}
+}
+
+int cmd_pd_timing(int argc, char *argv[])
+{
+	struct ec_params_usb_pd_timing p;
+	struct ec_response_usb_pd_timing *r = ec_inbuf;
+	struct ec_response_usb_pd_timing first;
+	const struct ec_usb_pd_timing_state *s;
+	uint16_t hist[EC_USB_PD_TIMING_BUCKETS];
+	int state = 0;
+	int i, rv;
+	char *e;
+
+	if (argc < 2 || argc > 3 ||
+	    (argc == 3 && strcasecmp(argv[2], "reset"))) {
+		fprintf(stderr, "Usage: %s <port> [reset]\n", argv[0]);
+		return -1;
+	}
+
+	p.port = strtol(argv[1], &e, 0);
+	if (e && *e) {
+		fprintf(stderr, "Bad port parameter.\n");
+		return -1;
+	}
+	p.flags = 0;
+	p.reserved = 0;
+
+	printf("State  Entries  Max ms  Total ms\n");
+	do {
+		p.state = state;
+		rv = ec_command(EC_CMD_USB_PD_TIMING, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+		if (!state)
+			memcpy(&first, r, sizeof(first));
+
+		for (i = 0; i < r->state_count; i++) {
+			s = r->states + i;
+			if (!s->entries && !s->total_ms)
+				continue;
+			printf("%5d %8u %7u %9u\n", state + i, s->entries,
+			       s->max_ms, s->total_ms);
+		}
+		state += r->state_count;
+	} while (r->state_count && state < r->state_total);
+
+	/* The counters come from the first page, closest to the states */
+	memcpy(hist, first.rx_goodcrc, sizeof(hist));
+	print_pd_timing_hist("RX to GoodCRC", hist, first.rx_goodcrc_max_us);
+	memcpy(hist, first.rx_reply, sizeof(hist));
+	print_pd_timing_hist("RX to reply", hist, first.rx_reply_max_us);
+	printf("State timeouts: %u\n", first.state_timeouts);
+	printf("VDM timeouts:   %u\n", first.vdm_timeouts);
+	printf("TX retries:     %u\n", first.tx_retries);
+	printf("TX errors:      %u\n", first.tx_errors);
+
+	/* Only clear the counters once they have all been read */
+	if (argc == 3) {
+		p.state = state;
+		p.flags = EC_USB_PD_TIMING_FLAG_RESET;
+		rv = ec_command(EC_CMD_USB_PD_TIMING, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+	}
+
+	return 0;
+}
+
 /* NULL-terminated list of commands */
 const struct command commands[] = {
 	{"extpwrcurrentlimit", cmd_ext_power_current_limit},
@@ -6304,12 +6675,14 @@ const struct command commands[] = {
 	{"battery", cmd_battery},
 	{"batterycutoff", cmd_battery_cut_off},
 	{"batteryparam", cmd_battery_vendor_param},
+	{"bench", cmd_bench},
 	{"boardversion", cmd_board_version},
 	{"chargecurrentlimit", cmd_charge_current_limit},
 	{"chargecontrol", cmd_charge_control},
 	{"chargeoverride", cmd_charge_port_override},
 	{"chargestate", cmd_charge_state},
 	{"chipinfo", cmd_chipinfo},
+	{"cmdstats", cmd_cmd_stats},
 	{"cmdversions", cmd_cmdversions},
 	{"console", cmd_console},
 	{"echash", cmd_ec_hash},
@@ -6327,6 +6700,7 @@ const struct command commands[] = {
 	{"flasherase", cmd_flash_erase},
 	{"flashprotect", cmd_flash_protect},
 	{"flashread", cmd_flash_read},
+	{"flashupdate", cmd_flash_update},
 	{"flashwrite", cmd_flash_write},
 	{"flashinfo", cmd_flash_info},
 	{"flashpd", cmd_flash_pd},
@@ -6353,6 +6727,7 @@ const struct command commands[] = {
 	{"pdsetmode", cmd_pd_set_amode},
 	{"port80read", cmd_port80_read},
 	{"pdlog", cmd_pd_log},
+	{"pdtiming", cmd_pd_timing},
 	{"pdwritelog", cmd_pd_write_log},
 	{"powerinfo", cmd_power_info},
 	{"protoinfo", cmd_proto_info},
@@ -6423,6 +6798,8 @@ int main(int argc, char *argv[])
 				interfaces = COMM_LPC;
 			} else if (!strcasecmp(optarg, "i2c")) {
 				interfaces = COMM_I2C;
+			} else if (!strcasecmp(optarg, "socket")) {
+				interfaces = COMM_SOCKET;
 			} else {
 				fprintf(stderr, "Invalid --interface\n");
 				parse_error = 1;
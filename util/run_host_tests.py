@@ -0,0 +1,264 @@
+#!/usr/bin/env python
+# Copyright 2015 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Run emulator unit tests in parallel.
+
+Runs the host test executables built by 'make hosttests', several at a time,
+each with its own persistent storage directory.  The test list and each
+test's time scale are read from test/build.mk; a test with <test>-scale=N
+gets N times the default timeout.  Optionally writes a JSON and/or JUnit XML
+report with the result and run time of every test, and compares the run
+against an earlier JSON report to show tests which got slower.
+
+  Example:
+    make -j hosttests
+    util/run_host_tests.py -j 8 --json build/host/tests.json
+"""
+
+from __future__ import print_function
+import argparse
+import json
+import multiprocessing
+import os
+import re
+import select
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from xml.sax import saxutils
+
+BUILD_MK = 'test/build.mk'
+EXE_PATH = 'build/host/{0}/{0}.exe'
+PERSIST_DIR_ENV = 'EC_PERSIST_DIR'
+
+DEFAULT_TIMEOUT = 10
+
+RESULT_PASS = 'pass'
+RESULT_FAIL = 'fail'
+RESULT_TIMEOUT = 'timeout'
+RESULT_EOF = 'eof'
+RESULT_MISSING = 'missing'
+
+# Tests which are slower than in the baseline by both of these are reported
+SLOWER_RATIO = 1.5
+SLOWER_SECONDS = 0.1
+
+
+def read_build_mk(path):
+  """Return the host test list and the time scale of each test."""
+  tests = []
+  scales = {}
+  with open(path) as f:
+    for line in f:
+      m = re.match(r'test-list-host\+?=(.*)', line)
+      if m:
+        tests.extend(m.group(1).split())
+        continue
+      m = re.match(r'([\w.-]+)-scale=(\d+)', line)
+      if m:
+        scales[m.group(1)] = int(m.group(2))
+  return tests, scales
+
+
+class Result(object):
+  """Outcome of one test run."""
+
+  def __init__(self, name, timeout):
+    self.name = name
+    self.timeout = timeout
+    self.result = RESULT_MISSING
+    self.seconds = 0.0
+    self.output = b''
+
+  def passed(self):
+    return self.result == RESULT_PASS
+
+  def to_dict(self):
+    return {'name': self.name, 'result': self.result,
+            'seconds': round(self.seconds, 3), 'timeout': self.timeout}
+
+
+def run_test(name, timeout):
+  """Run one test executable and wait for it to pass, fail or time out."""
+  res = Result(name, timeout)
+  exe = EXE_PATH.format(name)
+  if not os.path.exists(exe):
+    res.output = b'%s not found; run make hosttests first\n' % exe.encode()
+    return res
+
+  persist_dir = tempfile.mkdtemp(prefix='ec_%s_' % name)
+  env = dict(os.environ)
+  env[PERSIST_DIR_ENV] = persist_dir
+
+  start = time.time()
+  # The emulator re-executes itself on reboot, so put it in its own process
+  # group and read its output from a pipe which survives the exec.
+  child = subprocess.Popen([exe], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                           stderr=subprocess.STDOUT, env=env,
+                           preexec_fn=os.setsid)
+  fd = child.stdout.fileno()
+  output = b''
+  res.result = RESULT_TIMEOUT
+  try:
+    while True:
+      left = start + timeout - time.time()
+      if left <= 0:
+        break
+      ready, _, _ = select.select([fd], [], [], left)
+      if not ready:
+        continue
+      data = os.read(fd, 65536)
+      if not data:
+        res.result = RESULT_EOF
+        break
+      output += data
+      # The emulator often writes one character at a time
+      tail = output[-len(data) - 8:]
+      if b'Pass!' in tail:
+        res.result = RESULT_PASS
+        break
+      if b'Fail!' in tail:
+        res.result = RESULT_FAIL
+        break
+  finally:
+    res.seconds = time.time() - start
+    try:
+      os.killpg(child.pid, signal.SIGKILL)
+    except OSError:
+      pass
+    child.wait()
+    child.stdout.close()
+    child.stdin.close()
+    shutil.rmtree(persist_dir, ignore_errors=True)
+
+  res.output = output
+  return res
+
+
+def run_all(tests, scales, jobs, base_timeout, verbose):
+  """Run tests on a pool of worker threads; return results in test order."""
+  results = [None] * len(tests)
+  pending = list(enumerate(tests))
+  lock = threading.Lock()
+
+  def worker():
+    while True:
+      with lock:
+        if not pending:
+          return
+        index, name = pending.pop(0)
+      res = run_test(name, base_timeout * scales.get(name, 1))
+      with lock:
+        results[index] = res
+        print('%-8s %-28s %7.3f s' % (res.result.upper(), name, res.seconds))
+        if verbose or not res.passed():
+          sys.stdout.write(res.output.decode('utf-8', 'replace'))
+          print()
+        sys.stdout.flush()
+
+  threads = [threading.Thread(target=worker) for _ in range(jobs)]
+  for t in threads:
+    t.start()
+  for t in threads:
+    t.join()
+
+  return results
+
+
+def write_json(path, results, total):
+  report = {'total_seconds': round(total, 3),
+            'tests': [r.to_dict() for r in results]}
+  with open(path, 'w') as f:
+    json.dump(report, f, indent=2, sort_keys=True)
+    f.write('\n')
+
+
+def write_junit(path, results, total):
+  failures = [r for r in results if not r.passed()]
+  with open(path, 'w') as f:
+    f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    f.write('<testsuite name="host_tests" tests="%d" failures="%d" '
+            'time="%.3f">\n' % (len(results), len(failures), total))
+    for r in results:
+      f.write('  <testcase classname="host" name=%s time="%.3f"' %
+              (saxutils.quoteattr(r.name), r.seconds))
+      if r.passed():
+        f.write('/>\n')
+        continue
+      f.write('>\n    <failure message=%s>%s</failure>\n  </testcase>\n' %
+              (saxutils.quoteattr(r.result),
+               saxutils.escape(r.output.decode('utf-8', 'replace'))))
+    f.write('</testsuite>\n')
+
+
+def compare(path, results):
+  """Print the tests which regressed against the JSON report at path."""
+  with open(path) as f:
+    old = dict((t['name'], t) for t in json.load(f)['tests'])
+
+  for r in results:
+    prev = old.get(r.name)
+    if not prev:
+      continue
+    if prev['result'] == RESULT_PASS and not r.passed():
+      print('REGRESSED %-27s %s -> %s' % (r.name, prev['result'], r.result))
+    elif (r.seconds > prev['seconds'] * SLOWER_RATIO and
+          r.seconds - prev['seconds'] > SLOWER_SECONDS):
+      print('SLOWER    %-27s %7.3f s -> %7.3f s' %
+            (r.name, prev['seconds'], r.seconds))
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+  parser.add_argument('tests', nargs='*',
+                      help='Tests to run (default: test-list-host)')
+  parser.add_argument('-j', '--jobs', type=int,
+                      default=multiprocessing.cpu_count(),
+                      help='Number of tests to run at once')
+  parser.add_argument('-t', '--timeout', type=int, default=DEFAULT_TIMEOUT,
+                      help='Timeout in seconds for a test with scale 1')
+  parser.add_argument('--shard', type=int, default=0,
+                      help='Index of the shard of the test list to run')
+  parser.add_argument('--total-shards', type=int, default=1,
+                      help='Number of shards the test list is split into')
+  parser.add_argument('--json', help='Write a JSON report to this file')
+  parser.add_argument('--junit', help='Write a JUnit XML report to this file')
+  parser.add_argument('--baseline',
+                      help='Compare run times with this earlier JSON report')
+  parser.add_argument('-v', '--verbose', action='store_true',
+                      help='Print the output of passing tests too')
+  args = parser.parse_args()
+
+  all_tests, scales = read_build_mk(BUILD_MK)
+  tests = args.tests or all_tests
+  if args.total_shards < 1 or not 0 <= args.shard < args.total_shards:
+    parser.error('shard must be in 0..total-shards-1')
+  tests = tests[args.shard::args.total_shards]
+
+  start = time.time()
+  results = run_all(tests, scales, max(args.jobs, 1), args.timeout,
+                    args.verbose)
+  total = time.time() - start
+
+  failed = [r.name for r in results if not r.passed()]
+  print('%d tests, %d failed, %.3f s' % (len(results), len(failed), total))
+  if failed:
+    print('Failed: %s' % ' '.join(failed))
+
+  if args.json:
+    write_json(args.json, results, total)
+  if args.junit:
+    write_junit(args.junit, results, total)
+  if args.baseline:
+    compare(args.baseline, results)
+
+  return 1 if failed else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())